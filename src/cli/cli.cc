@@ -91,7 +91,7 @@ namespace PeterDB {
 
             ////////////////////////////////////////////
             // create table <tableName> (col1=type1, col2=type2, ...)
-            // create index <columnName> on <tableName>
+            // create index <columnName>[, <columnName>]* on <tableName>
             // create catalog
             ////////////////////////////////////////////
             if (expect(tokenizer, "create")) {
@@ -165,6 +165,13 @@ namespace PeterDB {
                     code = error("I expect <tableName>");
             }
 
+                ////////////////////////////////////////////
+                // analyze <tableName>
+                ////////////////////////////////////////////
+            else if (expect(tokenizer, "analyze")) {
+                code = analyze();
+            }
+
                 ///////////////////////////////////////////////////////////////
                 // insert into <tableName> tuple(attr1=val1, attr2=value2, ...)
                 ///////////////////////////////////////////////////////////////
@@ -763,25 +770,31 @@ namespace PeterDB {
         return 0;
     }
 
-    // create index <columnName> on <tableName>
+    // create index <columnName>[, <columnName>]* on <tableName>
     RC CLI::createIndex() {
+        std::vector<std::string> columnNames;
         char *tokenizer = next();
-        std::string columnName = std::string(tokenizer);
-
-        tokenizer = next();
-        if (!expect(tokenizer, "on")) {
+        while (tokenizer != NULL && !expect(tokenizer, "on")) {
+            columnNames.push_back(std::string(tokenizer));
+            tokenizer = next();
+        }
+        if (columnNames.empty() || tokenizer == NULL) {
             return error("syntax error: expecting \"on\"");
         }
 
         tokenizer = next();
         std::string tableName = std::string(tokenizer);
 
-        // check if columnName, tableName is valid
-        RID rid;
-        if (this->checkAttribute(tableName, columnName, rid) == false)
-            return error("Given tableName-columnName does not exist");
+        // check if columnNames, tableName are valid
+        std::string columnName;
+        for (auto &name : columnNames) {
+            RID rid;
+            if (this->checkAttribute(tableName, name, rid) == false)
+                return error("Given tableName-columnName does not exist");
+            columnName += (columnName.empty() ? "" : ",") + name;
+        }
 
-        if (rm.createIndex(tableName, columnName) != 0) {
+        if (rm.createIndex(tableName, columnNames) != 0) {
             return error("cannot create index on column(" + columnName + ") , ixManager error");
         }
 
@@ -1438,6 +1451,53 @@ namespace PeterDB {
         return this->printOutputBuffer(outputBuffer, 2);
     }
 
+    // a statistics value (in the key format) as text
+    static std::string statisticsValueToString(AttrType type, const std::string &value) {
+        if (value.empty()) {
+            return "NULL";
+        }
+        switch (type) {
+            case TypeInt:
+                return std::to_string(*(const int *) value.data());
+            case TypeReal:
+                return std::to_string(*(const float *) value.data());
+            case TypeVarChar:
+                return value.substr(sizeof(uint32_t));
+        }
+        return "";
+    }
+
+    RC CLI::analyze() {
+        char *tokenizer = next();
+        if (tokenizer == NULL) {
+            return error("I expect tableName to analyze");
+        }
+        std::string tableName = std::string(tokenizer);
+
+        TableStatistics stats;
+        if (rm.analyze(tableName) != 0 || rm.getStatistics(tableName, stats) != 0)
+            return error("error in analyze");
+
+        std::cout << "rows: " << stats.rowCount << ", pages: " << stats.pageCount << ", avg record size: "
+                  << stats.avgRecordSize << (stats.sampled ? " (sampled)" : "") << std::endl;
+
+        std::vector <std::string> outputBuffer;
+        outputBuffer.emplace_back("column");
+        outputBuffer.emplace_back("null fraction");
+        outputBuffer.emplace_back("distinct");
+        outputBuffer.emplace_back("min");
+        outputBuffer.emplace_back("max");
+        for (auto &column : stats.columns) {
+            outputBuffer.push_back(column.name);
+            outputBuffer.push_back(std::to_string(column.nullFraction));
+            outputBuffer.push_back(std::to_string(column.distinctCount));
+            outputBuffer.push_back(statisticsValueToString(column.type, column.minValue));
+            outputBuffer.push_back(statisticsValueToString(column.type, column.maxValue));
+        }
+
+        return this->printOutputBuffer(outputBuffer, 5);
+    }
+
 // print every tuples in given tableName
     RC CLI::printTable(const std::string& tableName) {
         std::vector <Attribute> attributes;
@@ -1487,7 +1547,7 @@ namespace PeterDB {
         if (input == "create") {
             std::cout << "\tcreate table <tableName> (col1 = type1, col2 = type2, ...): creates table with given properties"
                  << std::endl;
-            std::cout << "\tcreate index <columnName> on <tableName>: creates index for <columnName> in table <tableName>"
+            std::cout << "\tcreate index <columnName>[, <columnName>]* on <tableName>: creates index for <columnName>(s) in table <tableName>"
                  << std::endl;
             std::cout << "\tcreate catalog" << std::endl;
         } else if (input == "add") {
@@ -1507,6 +1567,8 @@ namespace PeterDB {
         } else if (input == "load") {
             std::cout << "\tload <tableName> \"fileName\"";
             std::cout << ": loads given filName to given table" << std::endl;
+        } else if (input == "analyze") {
+            std::cout << "\tanalyze <tableName>: gathers and prints the statistics of given table" << std::endl;
         } else if (input == "help") {
             std::cout << "\thelp <commandName>: print help for given command" << std::endl;
             std::cout << "\thelp: show help for all commands" << std::endl;
@@ -1539,6 +1601,7 @@ namespace PeterDB {
             help("print");
             help("insert");
             help("load");
+            help("analyze");
             help("help");
             help("query");
             help("quit");
@@ -0,0 +1,121 @@
+#ifndef _async_relation_manager_h_
+#define _async_relation_manager_h_
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "src/include/rm.h"
+
+# define ASYNC_RM_WORKERS 8             // worker threads of an AsyncRelationManager, by default one per
+                                        // hardware thread up to this many
+# define ASYNC_RM_MAX_BATCH 64          // reads of a table one worker serves with one call, at most
+
+namespace PeterDB {
+
+    // Asynchronous calls of RelationManager, run by a pool of worker threads.
+    //
+    // Each call returns right away, with a future getting the rc of the call once a worker ran it.
+    // Requests run in no particular order: wait for the future of a request before making one that
+    // depends on it. Buffers passed in (data, rid) must stay valid until then. Every call is a
+    // transaction of its own, whatever transaction the calling thread is in.
+    //
+    // Reads are batched: a worker taking a read also takes the other reads of the same table waiting
+    // in the queue, whole pages at a time (up to the max batch), and serves them all with one
+    // RelationManager::readTuples(), which reads each page once for all the tuples in it. Requests made
+    // while a worker is being woken up don't wake up another one, they pile up for the woken worker to
+    // take, which makes for larger batches.
+    //
+    // Reads of a table with no partitions hold RelationManager's latch shared once its catalog entry is
+    // cached, and the latch of its file shared: workers read side by side, and alongside writers.
+    // A request costs a queue round trip and a promise on top of the call itself: on a single core,
+    // where workers can only take turns with the caller, reads are slower than made synchronously even
+    // when batched. Workers pay off with cores to run on, or calls waiting for locks or for the disk.
+    class AsyncRelationManager {
+    public:
+        // workers: 0 for one per hardware thread, up to ASYNC_RM_WORKERS. more workers than cores split
+        // the queued reads into smaller batches
+        explicit AsyncRelationManager(unsigned workers = 0,
+                                      RelationManager &rm = RelationManager::instance());
+
+        // runs what is queued still, then stops the workers
+        ~AsyncRelationManager();
+
+        std::future<RC> readTupleAsync(const std::string &tableName, const RID &rid, void *data);
+
+        std::future<RC> readAttributeAsync(const std::string &tableName, const RID &rid,
+                                           const std::string &attributeName, void *data);
+
+        std::future<RC> insertTupleAsync(const std::string &tableName, const void *data, RID &rid);
+
+        std::future<RC> updateTupleAsync(const std::string &tableName, const void *data, const RID &rid);
+
+        std::future<RC> deleteTupleAsync(const std::string &tableName, const RID &rid);
+
+        // runs call on a worker, then done with its rc, on the same worker
+        void submit(const std::function<RC(RelationManager &)> &call, const std::function<void(RC)> &done);
+
+        // returns once every request made so far is done
+        void drain();
+
+        // reads served per readTuples() call, 1 turns batching off
+        void setMaxBatch(unsigned maxBatch);
+
+        // readTuples() calls made to serve reads, and the reads they served
+        unsigned long getBatchCount();
+
+        unsigned long getBatchedReadCount();
+
+    private:
+        struct Request {
+            // a read when call is empty
+            std::function<RC(RelationManager &)> call;
+            std::string tableName;
+            RID rid;
+            void *data = nullptr;
+
+            std::function<void(RC)> done;
+            std::shared_ptr<std::promise<RC> > promise;     // to set instead, when there is no done
+        };
+
+        RelationManager &m_rm;
+        std::vector<std::thread> m_workers;
+
+        std::mutex m_mutex;
+        std::condition_variable m_queued;
+        std::condition_variable m_idle;
+        std::deque<Request> m_queue;
+        unsigned m_running = 0;             // requests taken by workers, not done yet
+        bool m_wakeUpPending = false;       // a worker was woken up for the queue, and didn't take from it yet
+        bool m_stop = false;
+        unsigned m_maxBatch = ASYNC_RM_MAX_BATCH;
+        unsigned long m_batches = 0;
+        unsigned long m_batchedReads = 0;
+
+        std::future<RC> enqueue(Request &request);
+
+        void push(Request &request);
+
+        void workerLoop();
+
+        // the requests to run next: the first one queued, along with the reads of its table if it is a read,
+        // its page first, then the pages after it. a page's reads are never split across batches if they fit
+        void takeBatch(std::vector<Request> &batch);
+
+        void runBatch(std::vector<Request> &batch);
+
+        static void finish(Request &request, RC rc);
+
+        AsyncRelationManager(const AsyncRelationManager &);
+        AsyncRelationManager &operator=(const AsyncRelationManager &);
+    };
+
+} // namespace PeterDB
+
+#endif // _async_relation_manager_h_
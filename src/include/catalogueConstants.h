@@ -13,12 +13,32 @@ namespace PeterDB {
         static const std::string ATTRIBUTES_TABLE_NAME;
         static const std::string TABLES_FILE_NAME;
         static const std::string ATTRIBUTES_FILE_NAME;
+        static const std::string INDEXES_TABLE_NAME;
+        static const std::string INDEXES_FILE_NAME;
+        static const std::string STATISTICS_TABLE_NAME;
+        static const std::string STATISTICS_FILE_NAME;
+        static const std::string PARTITIONS_TABLE_NAME;
+        static const std::string PARTITIONS_FILE_NAME;
+        static const std::string TABLESPACES_TABLE_NAME;
+        static const std::string TABLESPACES_FILE_NAME;
+        static const std::string AGGREGATES_TABLE_NAME;
+        static const std::string AGGREGATES_FILE_NAME;
 
         static const unsigned int TABLES_TABLE_ID;
         static const unsigned int ATTRIBUTES_TABLE_ID;
+        static const unsigned int INDEXES_TABLE_ID;
+        static const unsigned int STATISTICS_TABLE_ID;
+        static const unsigned int PARTITIONS_TABLE_ID;
+        static const unsigned int TABLESPACES_TABLE_ID;
+        static const unsigned int AGGREGATES_TABLE_ID;
 
         static const std::vector<Attribute> tablesTableAttributes;
         static const std::vector<Attribute> attributesTableAttributes;
+        static const std::vector<Attribute> indexesTableAttributes;
+        static const std::vector<Attribute> statisticsTableAttributes;
+        static const std::vector<Attribute> partitionsTableAttributes;
+        static const std::vector<Attribute> tablespacesTableAttributes;
+        static const std::vector<Attribute> aggregatesTableAttributes;
     };
 }
 
@@ -3,6 +3,7 @@
 
 #include "rbfm.h"
 #include "attributeAndValue.h"
+#include "statistics.h"
 #include <vector>
 
 #define INTEGER_ATTRIBUTE_LENGTH 4
@@ -15,6 +16,44 @@
 #define ATTRIBUTES_ATTR_NAME_ATTR_TYPE "column-type"
 #define ATTRIBUTES_ATTR_NAME_ATTR_LENGTH "column-length"
 #define ATTRIBUTES_ATTR_NAME_POSITION "column-position"
+#define ATTRIBUTES_ATTR_NAME_ADDED "column-added"
+#define ATTRIBUTES_ATTR_NAME_DROPPED "column-dropped"
+#define INDEXES_ATTR_NAME_TABLE_ID "table-id"
+#define INDEXES_ATTR_NAME_ATTR_NAME "column-name"
+#define INDEXES_ATTR_NAME_FNAME "file-name"
+#define INDEXES_ATTR_NAME_INCLUDED "included-columns"
+#define INDEX_FILE_NAME_MAX_LENGTH 110 // <table-name>_<column-name>_index.idx
+#define INDEX_INCLUDED_COLUMNS_MAX_LENGTH 255 // <column-name>,<column-name>,...
+#define STATISTICS_ATTR_NAME_TABLE_ID "table-id"
+#define STATISTICS_ATTR_NAME_ATTR_NAME "column-name"
+#define STATISTICS_ATTR_NAME_ROW_COUNT "row-count"
+#define STATISTICS_ATTR_NAME_PAGE_COUNT "page-count"
+#define STATISTICS_ATTR_NAME_AVG_RECORD_SIZE "avg-record-size"
+#define STATISTICS_ATTR_NAME_SAMPLED "sampled"
+#define STATISTICS_ATTR_NAME_NULL_FRACTION "null-fraction"
+#define STATISTICS_ATTR_NAME_DISTINCT_COUNT "distinct-count"
+#define STATISTICS_ATTR_NAME_MIN_VALUE "min-value"
+#define STATISTICS_ATTR_NAME_MAX_VALUE "max-value"
+#define STATISTICS_ATTR_NAME_HISTOGRAM "histogram"
+#define STATISTICS_VALUE_MAX_LENGTH (4 + STATS_VALUE_MAX_LENGTH) // a value in the key format
+#define STATISTICS_HISTOGRAM_MAX_LENGTH ((STATS_HISTOGRAM_BUCKETS + 1) * (4 + STATISTICS_VALUE_MAX_LENGTH)) // [length][value] per bound
+#define PARTITIONS_ATTR_NAME_TABLE_ID "table-id"
+#define PARTITIONS_ATTR_NAME_ATTR_NAME "column-name"
+#define PARTITIONS_ATTR_NAME_METHOD "partition-method"
+#define PARTITIONS_ATTR_NAME_COUNT "partition-count"
+#define PARTITIONS_ATTR_NAME_BOUNDS "partition-bounds"
+#define PARTITION_BOUNDS_MAX_LENGTH 2048 // [length][value] per bound
+#define TABLESPACES_ATTR_NAME_NAME "tablespace-name"
+#define TABLESPACES_ATTR_NAME_DIRECTORY "directory"
+#define TABLESPACES_ATTR_NAME_POSITION "directory-position"
+#define TABLESPACE_NAME_MAX_LENGTH 16 // "@<tablespace-name>/<file-name>" goes into the file-name of Tables
+#define TABLESPACE_DIRECTORY_MAX_LENGTH 255
+#define AGGREGATES_ATTR_NAME_TABLE_ID "table-id"
+#define AGGREGATES_ATTR_NAME_VIEW_NAME "view-name"
+#define AGGREGATES_ATTR_NAME_BASE_TABLE "base-table-name"
+#define AGGREGATES_ATTR_NAME_ATTR_NAME "column-name"
+#define AGGREGATES_ATTR_NAME_GROUP_ATTR_NAME "group-column-name"
+#define AGGREGATES_ATTR_NAME_OPS "aggregate-ops" // one bit per AggregateOp
 
 namespace PeterDB {
 
@@ -30,8 +69,16 @@ namespace PeterDB {
         // Attributes and values to insert into "Tables" table
         static void buildTablesTableAttributeAndValues(std::vector<AttributeAndValue>&);
         static void buildAttributesTableAttributeAndValues(std::vector<AttributeAndValue>&);
+        static void buildIndexesTableAttributeAndValues(std::vector<AttributeAndValue>&);
+        static void buildStatisticsTableAttributeAndValues(std::vector<AttributeAndValue>&);
+        static void buildPartitionsTableAttributeAndValues(std::vector<AttributeAndValue>&);
+        static void buildTablespacesTableAttributeAndValues(std::vector<AttributeAndValue>&);
+        static void buildAggregatesTableAttributeAndValues(std::vector<AttributeAndValue>&);
     };
 
+    // the Columns table has one row per attribute a table ever had, with the schema version it was
+    // added in (0 for the ones the table was created with) and the one it was dropped in (0 while
+    // it is still there). Every addAttribute()/dropAttribute() makes a new schema version
     class AttributesAttributeConstants {
     public:
         static const Attribute TABLE_ID;
@@ -39,6 +86,66 @@ namespace PeterDB {
         static const Attribute ATTRIBUTE_TYPE;
         static const Attribute ATTRIBUTE_LENGTH;
         static const Attribute ATTRIBUTE_POSITION;
+        static const Attribute SCHEMA_VERSION_ADDED;
+        static const Attribute SCHEMA_VERSION_DROPPED;
+    };
+
+    class IndexesAttributeConstants {
+    public:
+        static const Attribute TABLE_ID;
+        static const Attribute ATTRIBUTE_NAME;
+        static const Attribute FILE_NAME;
+        static const Attribute INCLUDED_COLUMNS;
+    };
+
+    // the Statistics table has one row per analyzed table (with an empty column-name) holding
+    // the table-wide numbers, and one row per column of it holding the column's numbers
+    class StatisticsAttributeConstants {
+    public:
+        static const Attribute TABLE_ID;
+        static const Attribute ATTRIBUTE_NAME;
+        static const Attribute ROW_COUNT;
+        static const Attribute PAGE_COUNT;
+        static const Attribute AVG_RECORD_SIZE;
+        static const Attribute SAMPLED;
+        static const Attribute NULL_FRACTION;
+        static const Attribute DISTINCT_COUNT;
+        static const Attribute MIN_VALUE;
+        static const Attribute MAX_VALUE;
+        static const Attribute HISTOGRAM;
+    };
+
+    // the Partitions table has one row per partitioned table, with the partition key (column-name),
+    // the PartitionMethod, the number of partitions and, for range partitioning, their bounds
+    class PartitionsAttributeConstants {
+    public:
+        static const Attribute TABLE_ID;
+        static const Attribute ATTRIBUTE_NAME;
+        static const Attribute METHOD;
+        static const Attribute COUNT;
+        static const Attribute BOUNDS;
+    };
+
+    // the Tablespaces table has one row per directory of a tablespace, position being the place of the
+    // directory in the tablespace (see RelationManager::createTablespace())
+    class TablespacesAttributeConstants {
+    public:
+        static const Attribute NAME;
+        static const Attribute DIRECTORY;
+        static const Attribute POSITION;
+    };
+
+    // the Aggregates table has one row per materialized aggregate (see
+    // RelationManager::createMaterializedAggregate()) and table keeping it up to date: its base table, and
+    // each partition of a partitioned base table
+    class AggregatesAttributeConstants {
+    public:
+        static const Attribute TABLE_ID;
+        static const Attribute VIEW_NAME;
+        static const Attribute BASE_TABLE;
+        static const Attribute ATTRIBUTE_NAME;
+        static const Attribute GROUP_ATTRIBUTE_NAME;
+        static const Attribute OPS;
     };
 }
 
@@ -73,6 +73,8 @@ namespace PeterDB {
 
         RC printIndex();
 
+        RC analyze();
+
         RC help(const std::string& input);
 
         RC history();
@@ -0,0 +1,45 @@
+#ifndef _composite_key_h_
+#define _composite_key_h_
+
+#include <string>
+#include <vector>
+
+#include "src/include/rbfm.h"
+
+# define COMPOSITE_KEY_MAX_SIZE 1024  // bytes the encoded values of a composite key can take at most
+
+namespace PeterDB {
+
+    // Keys of indexes on several attributes. The values of the attributes are encoded one after the
+    // other into a single varchar key, such that comparing two keys byte by byte orders them by the
+    // first attribute, then by the second one, and so on:
+    //   int     sign bit flipped, big endian
+    //   real    sign bit flipped for positive numbers, all bits flipped for negative ones, big endian
+    //   varchar the characters, with 0x00 escaped as 0x00 0xFF, then 0x00 0x00
+    // A key built from the values of the first attributes only is a prefix of the keys of all the
+    // entries starting with those values, which is what prefix range scans are built on.
+    class CompositeKey {
+    public:
+        // the attribute to hand over to IndexManager for an index on attrs
+        static Attribute keyAttribute(const std::vector<Attribute> &attrs);
+
+        // size of the encoded values of attrs at most, that is without the length of the varchar key
+        static unsigned maxEncodedSize(const std::vector<Attribute> &attrs);
+
+        // values[i] is the value of attrs[i], in the same format as in IndexManager::insertEntry().
+        // There can be fewer values than attrs, for a key prefix. key gets the key in the
+        // IndexManager::insertEntry() format of keyAttribute(attrs), the size of which is returned
+        static unsigned encode(const std::vector<Attribute> &attrs, const std::vector<const void *> &values,
+                               void *key);
+
+        // the other way round, for a key built from all the attrs: values gets the value of each attribute,
+        // one after the other like in RelationManager::insertTuple() data (without the null indicator).
+        // returns the size of the values
+        static unsigned decode(const std::vector<Attribute> &attrs, const void *key, void *values);
+
+        // the smallest key greater than every key starting with prefixKey, false if there is none
+        static bool prefixEnd(const void *prefixKey, void *endKey);
+    };
+} // namespace PeterDB
+
+#endif // _composite_key_h_
@@ -0,0 +1,82 @@
+#ifndef _external_sorter_h_
+#define _external_sorter_h_
+
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "ix.h"
+
+# define EXTERNAL_SORT_MEMORY_BYTES (64 * 1024 * 1024)  // entries held in memory before a sorted run is spilled
+# define EXTERNAL_SORT_MAX_FAN_IN 128                   // runs merged at once (each one keeps a file open)
+
+namespace PeterDB {
+
+    // Sorts (key, RID) index entries, and their payloads, which may not fit into memory, e.g. to bulk load an index.
+    // Entries are buffered up to the memory budget, then sorted and written out to a temporary run
+    // file. finish() merges the runs, after which the entries are read back in (key, RID) order.
+    // Keys follow the same format as in IndexManager::insertEntry().
+    class ExternalSorter : public IX_EntryStream {
+    public:
+        // run files are named <runFilePrefix>.run<n>, and are removed once the sorter is destroyed
+        ExternalSorter(const Attribute &keyAttribute, const std::string &runFilePrefix,
+                       size_t memoryBytes = EXTERNAL_SORT_MEMORY_BYTES);
+
+        ~ExternalSorter() override;
+
+        RC addEntry(const void *key, const RID &rid, const std::string &payload = "");
+
+        // no more entries can be added after this
+        RC finish();
+
+        RC getNextEntry(RID &rid, void *key) override;
+
+        RC getNextEntry(RID &rid, void *key, std::string &payload) override;
+
+        // sorted runs written to disk so far, 0 if everything fit into memory
+        unsigned getNumRuns() const;
+
+    private:
+        Attribute m_keyAttribute;
+        std::string m_runFilePrefix;
+        size_t m_memoryBytes;
+        bool m_finished = false;
+
+        // entries not spilled yet, and their (approximate) size in memory
+        std::vector<RidAndKey> m_entries;
+        size_t m_entriesBytes = 0;
+        unsigned m_nextEntry = 0;
+
+        std::vector<std::string> m_runFileNames;
+        unsigned m_runsCreated = 0;
+
+        // runs being merged by getNextEntry, along with the entry each one is at
+        std::vector<FILE *> m_mergeFiles;
+        std::vector<RidAndKey> m_mergeHeads;
+        std::vector<unsigned> m_mergeHeap;      // positions in m_mergeFiles, smallest head first
+
+        bool isLess(const RidAndKey &first, const RidAndKey &second) const;
+
+        RidAndKey toEntry(const void *key, const RID &rid) const;
+
+        void toKey(const RidAndKey &entry, void *key) const;
+
+        RC spillRun();
+
+        RC writeEntry(FILE *file, const RidAndKey &entry) const;
+
+        // false at the end of the file
+        bool readEntry(FILE *file, RidAndKey &entry) const;
+
+        RC openMerge(const std::vector<std::string> &runFileNames);
+
+        bool nextMergedEntry(RidAndKey &entry);
+
+        void closeMerge();
+
+        // merges the first count runs into a new run, until few enough are left to merge at once
+        RC mergeRuns(unsigned count);
+    };
+} // namespace PeterDB
+
+#endif // _external_sorter_h_
@@ -13,12 +13,30 @@
 #include "pageDeserializer.h"
 
 # define IX_EOF (-1)  // end of the index scan
+# define IX_DEFAULT_FILL_FACTOR 0.9f  // share of each page filled by bulkLoad, the rest is left for later inserts
+# define IX_MAX_PAYLOAD_SIZE 1024     // bytes an entry can carry along with its key
 
 namespace PeterDB {
     class IX_ScanIterator;
 
     class IXFileHandle;
 
+    // A source of (key, RID) entries, e.g. the output of a sort.
+    // "key" follows the same format as in IndexManager::insertEntry()
+    class IX_EntryStream {
+    public:
+        virtual ~IX_EntryStream() = default;
+
+        // returns IX_EOF once there are no more entries
+        virtual RC getNextEntry(RID &rid, void *key) = 0;
+
+        // same, along with the payload of the entry (see IndexManager::insertEntry), none by default
+        virtual RC getNextEntry(RID &rid, void *key, std::string &payload) {
+            payload.clear();
+            return getNextEntry(rid, key);
+        }
+    };
+
     class IndexManager {
 
     protected:
@@ -31,6 +49,9 @@ namespace PeterDB {
         PageSerializer* serializer = nullptr;
         std::unordered_map<std::string, bool> m_indexesCreated;
 
+        // index files created by an earlier process are known once they are opened or destroyed
+        bool isIndexFile(const std::string &fileName);
+
     public:
         static IndexManager &instance();
 
@@ -46,12 +67,37 @@ namespace PeterDB {
         // Close an ixFileHandle for an index.
         RC closeFile(IXFileHandle &ixFileHandle);
 
+        // Write out what an open ixFileHandle holds in memory (root pointer, page counters)
+        // without closing it.
+        RC flushFile(IXFileHandle &ixFileHandle);
+
         // Insert an entry into the given index that is indicated by the given ixFileHandle.
-        RC insertEntry(IXFileHandle &ixFileHandle, const Attribute &attribute, const void *key, const RID &rid);
+        // The entry can carry a payload of up to IX_MAX_PAYLOAD_SIZE bytes, stored next to the key in the leaf
+        // and returned by IX_ScanIterator::getPayload(). Either all entries of an index have a payload or none.
+        RC insertEntry(IXFileHandle &ixFileHandle, const Attribute &attribute, const void *key, const RID &rid,
+                       const std::string &payload = "");
 
         // Delete an entry from the given index that is indicated by the given ixFileHandle.
         RC deleteEntry(IXFileHandle &ixFileHandle, const Attribute &attribute, const void *key, const RID &rid);
 
+        // Insert many entries, keys[i] pointing to rids[i]. Entries are applied in key order, and the
+        // ones landing in the same leaf are added to it together, with one read and one write of the leaf.
+        // payloads, if given, are the payloads of the entries, as in insertEntry.
+        RC insertEntries(IXFileHandle &ixFileHandle, const Attribute &attribute,
+                         const std::vector<const void *> &keys, const std::vector<RID> &rids,
+                         const std::vector<std::string> &payloads = std::vector<std::string>());
+
+        // Delete many entries, the same way insertEntries inserts them. Fails if any entry was not found,
+        // the other entries are still deleted.
+        RC deleteEntries(IXFileHandle &ixFileHandle, const Attribute &attribute,
+                         const std::vector<const void *> &keys, const std::vector<RID> &rids);
+
+        // Build the B+ tree of an empty index from entries sorted by key (e.g. by an ExternalSorter).
+        // Leaves are written left to right, each filled up to fillFactor of the page, then the levels
+        // above them are built the same way.
+        RC bulkLoad(IXFileHandle &ixFileHandle, const Attribute &attribute, IX_EntryStream &sortedEntries,
+                    float fillFactor = IX_DEFAULT_FILL_FACTOR);
+
         // Initialize and IX_ScanIterator to support a range search
         RC scan(IXFileHandle &ixFileHandle,
                 const Attribute &attribute,
@@ -99,6 +145,11 @@ namespace PeterDB {
 
         static unsigned int getLowerLevelNode(const void *searchKey, const Attribute &attribute, const void* pageData);
 
+        static unsigned int getLowerLevelNode(const void *searchKey, const Attribute &attribute, NonLeafPage &nonLeafPage);
+
+        // positions of the given entries, sorted by key
+        static std::vector<unsigned> sortEntries(const std::vector<RidAndKey> &entries, AttrType keyType);
+
         static RC deleteFromPage(const void *targetKey, const RID &targetRid,
                                  const Attribute &targetKeyAttribute,
                                  PeterDB::LeafPage &leafPage, bool& continueToNextPage);
@@ -131,10 +182,16 @@ namespace PeterDB {
         // Get next matching entry
         RC getNextEntry(RID &rid, void *key);
 
+        // Payload of the entry last returned by getNextEntry, empty if it has none
+        const std::string &getPayload() const;
+
         void init(IXFileHandle *ixFileHandle, unsigned int pageNumBegin,
                   const void* startKey, const bool shouldIncludeStartKey,
                   const void *endKey, bool shouldIncludeEndKey, const Attribute& keyAttribute);
 
+        // for an index without entries, which has no leaf page to start from
+        void initEmpty(IXFileHandle *ixFileHandle);
+
         void loadLeafPage(PageNum pageNum);
 
         // Terminate index scan
@@ -146,6 +203,7 @@ namespace PeterDB {
         LeafPage _currentLeafPage;
         unsigned int _nextElementPositionOnPage; //todo: perhaps special handling for scan-delete keys
         unsigned int _currentPageKeysCount;
+        std::string _payload;
 
         void * _endKey;
         AttrType _keyType;
@@ -179,6 +237,13 @@ namespace PeterDB {
         std::string _fileName;
         unsigned int _rootPageNum = 0;
 
+        // by default the root pointer is read from (and written to) the header page by every
+        // operation. handles kept open for long, e.g. by RelationManager, keep it in memory
+        // instead, and only write it back on flushFile/closeFile
+        bool _cacheRootPageNum = false;
+        bool _rootPageNumLoaded = false;
+        bool _rootPageNumDirty = false;
+
         FileHandle _pfmFileHandle;
 
         // Constructor
@@ -192,6 +257,12 @@ namespace PeterDB {
 
         void fetchRootNodePtrFromDisk();
         void writeRootNodePtrToDisk();
+
+        // keep the root pointer in memory until the handle is flushed or closed
+        void cacheRootPageNum();
+
+        // writes the root pointer to the header page, if it changed since it was read
+        RC flushRootNodePtr();
     };
 }// namespace PeterDB
 #endif // _ix_h_
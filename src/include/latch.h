@@ -0,0 +1,44 @@
+#ifndef _latch_h_
+#define _latch_h_
+
+#include <condition_variable>
+#include <mutex>
+
+namespace PeterDB {
+
+    // Readers-writer latch (there is no std::shared_mutex before C++17). Any number of readers hold it
+    // together, a writer holds it alone. Once a writer waits for it, new readers wait behind the writer,
+    // so a steady stream of readers can't starve writers. Not recursive.
+    class SharedLatch {
+    public:
+        // exclusive, so that std::lock_guard<SharedLatch> works for writers
+        void lock();
+        void unlock();
+
+        void lock_shared();
+        void unlock_shared();
+
+    private:
+        std::mutex m_mutex;
+        std::condition_variable m_released;
+        unsigned m_readers = 0;
+        unsigned m_waitingWriters = 0;
+        bool m_writer = false;
+    };
+
+    // holds a SharedLatch shared for its scope, the counterpart of std::lock_guard for readers
+    class SharedLatchGuard {
+    public:
+        explicit SharedLatchGuard(SharedLatch &latch);
+        ~SharedLatchGuard();
+
+    private:
+        SharedLatch &m_latch;
+
+        SharedLatchGuard(const SharedLatchGuard &);
+        SharedLatchGuard &operator=(const SharedLatchGuard &);
+    };
+
+} // namespace PeterDB
+
+#endif // _latch_h_
@@ -12,6 +12,7 @@ namespace PeterDB {
         int _intKey = 0;
         float _floatKey = float(0);
         std::string _stringKey = "";
+        std::string _payload;   // values carried along with the entry, e.g. by covering indexes
 
     public:
         RidAndKey(const RID &rid, int intKey);
@@ -29,6 +30,10 @@ namespace PeterDB {
         float getFloatKey() const;
 
         const std::string& getStringKey() const;
+
+        const std::string& getPayload() const;
+
+        void setPayload(const std::string &payload);
     };
 
     class LeafPage {
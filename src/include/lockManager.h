@@ -0,0 +1,121 @@
+#ifndef _lock_manager_h_
+#define _lock_manager_h_
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <set>
+#include <string>
+
+#include "src/include/rbfm.h"
+
+# define LOCK_WAIT_TIMEOUT_MS 10000     // lock waits longer than this fail, should a deadlock go unnoticed
+
+namespace PeterDB {
+
+    typedef uint64_t TxnId;             // transactions are numbered from 1
+    typedef uint64_t SessionId;         // so are sessions, 0 being none
+
+    // Multi-granularity lock modes. Intention modes are taken on a table (and page) before locking
+    // some of what it holds: IS before reading rows, IX before changing them. SIX reads the whole
+    // table while changing some of its rows
+    typedef enum {
+        IntentionShared = 0, IntentionExclusive, Shared, SharedIntentionExclusive, Exclusive
+    } LockMode;
+
+    // What a lock is taken on: a table, one of its pages, or one of its rows
+    struct LockId {
+        std::string tableName;
+        int pageNum = -1;
+        int slotNum = -1;
+
+        static LockId table(const std::string &tableName);
+
+        static LockId page(const std::string &tableName, PageNum pageNum);
+
+        static LockId row(const std::string &tableName, const RID &rid);
+
+        bool operator<(const LockId &other) const;
+    };
+
+    // Locks held by transactions until they release them all at once (strict two-phase locking).
+    //
+    // A request waits while a lock held by another transaction is incompatible with it. A transaction
+    // asking for a lock it holds already gets the stronger of both modes (e.g. S and IX make SIX).
+    // Before waiting, the wait-for graph (transactions waiting for the ones holding what they asked
+    // for) is checked for a cycle through the requester: the request fails right away then, leaving
+    // the other transactions of the cycle waiting. Waits longer than the wait timeout fail too.
+    //
+    // Transactions of the same session (e.g. a client thread) never wait for each other: a session
+    // couldn't update a table while it has a scan of the table open otherwise, the scan being a
+    // transaction of its own when it isn't part of a bigger one.
+    class LockManager {
+    public:
+        static LockManager &instance();
+
+        SessionId beginSession();
+
+        TxnId beginTransaction(SessionId session = 0);
+
+        // 0 once granted, -1 on a deadlock or timeout (nothing changes then)
+        RC lock(TxnId txn, const LockId &lockId, LockMode mode);
+
+        // the row, after the intention locks on its table and page
+        RC lockRow(TxnId txn, const std::string &tableName, const RID &rid, LockMode mode);
+
+        // releases every lock of the transaction, waking up whoever waits for them
+        void releaseAll(TxnId txn);
+
+        bool holds(TxnId txn, const LockId &lockId, LockMode mode);
+
+        void setWaitTimeout(unsigned milliseconds);
+
+        // requests that failed on a deadlock, and requests that had to wait, since the start
+        unsigned long getDeadlockCount();
+
+        unsigned long getWaitCount();
+
+        static bool compatible(LockMode held, LockMode requested);
+
+        // the weakest mode covering both
+        static LockMode combine(LockMode a, LockMode b);
+
+    protected:
+        LockManager();                                                      // Prevent construction
+        ~LockManager();                                                     // Prevent unwanted destruction
+        LockManager(const LockManager &);                                   // Prevent construction by copying
+        LockManager &operator=(const LockManager &);                        // Prevent assignment
+
+    private:
+        struct WaitingRequest {
+            LockId lockId;
+            LockMode mode;
+        };
+
+        std::mutex m_mutex;
+        std::condition_variable m_released;
+        std::atomic<TxnId> m_nextTxn;
+        std::atomic<SessionId> m_nextSession;
+        unsigned m_waitTimeoutMs = LOCK_WAIT_TIMEOUT_MS;
+        unsigned long m_deadlocks = 0;
+        unsigned long m_waits = 0;
+
+        std::map<LockId, std::map<TxnId, LockMode> > m_locks;    // holders of each lock, and their mode
+        std::map<TxnId, std::set<LockId> > m_held;
+        std::map<TxnId, WaitingRequest> m_waiting;              // the edges of the wait-for graph start here
+        std::map<TxnId, SessionId> m_sessions;                  // of the transactions begun in a session
+
+        // called with m_mutex held
+        bool conflicts(TxnId txn, TxnId holder, LockMode held, LockMode requested);
+
+        bool grantable(TxnId txn, const LockId &lockId, LockMode mode);
+
+        // whether waiting for lockId in mode would make txn wait for itself, through the waits of others
+        bool waitWouldDeadlock(TxnId txn, const LockId &lockId, LockMode mode);
+    };
+
+} // namespace PeterDB
+
+#endif // _lock_manager_h_
@@ -28,6 +28,23 @@ namespace PeterDB {
 
         RC writePage(FileHandle &fileHandle, PageNum pageNum);
 
+        // marks the page in memory as modified without writing it, it is written
+        // back when another page is read into this one, or when flush() is called
+        void markDirty(FileHandle &fileHandle);
+
+        // writes the page back if it was modified since it was last written
+        RC flush();
+
+        // forgets the page held in memory if it belongs to the given file, without
+        // writing it back. used when the file is destroyed
+        void release(const std::string &fileName);
+
+        // the page held in memory is the given page of the given file
+        bool holds(const std::string &fileName, PageNum pageNum);
+
+        // holds the page other holds, as other has it in memory. it isn't dirty here
+        void copyFrom(Page &other);
+
         bool canInsertRecord(unsigned short recordDataLengthBytes);
 
         unsigned short generateSlotForInsertion(unsigned short recordDataLengthBytes);
@@ -53,6 +70,8 @@ namespace PeterDB {
     private:
         std::string m_fileName = "";
         int m_pageNum = -1;
+        bool m_dirty = false;
+        FileHandle *m_dirtyFileHandle = nullptr;
         byte *m_data = new byte[PAGE_SIZE];
         unsigned short* freeByteCount = (unsigned short *) (m_data + PAGE_SIZE - PAGE_METADATA_SIZE) + 1;
         unsigned short* slotCount = (unsigned short *) (m_data + PAGE_SIZE - PAGE_METADATA_SIZE);
@@ -18,13 +18,16 @@ namespace PeterDB {
 
         static AttrType readKeyType(const void *data);
 
+        // whether the entries of a leaf page carry a payload
+        static bool hasPayload(const void *data);
+
         static int readNextPageNum(const void *data);
 
         static unsigned int readNumKeys(const void *data);
 
         static void readPageNumAndKeyPairs(NonLeafPage &nonLeafPage, const void *data, unsigned int numKeys);
 
-        static void readKeyAndRidPairs(LeafPage &leafPage, const void *data, unsigned int numKeys);
+        static void readKeyAndRidPairs(LeafPage &leafPage, const void *data, unsigned int numKeys, bool hasPayload);
     };
 }
 
@@ -5,17 +5,67 @@
 #define PAGE_OCCUPANCY_METADATA_PAGE 0
 #define PAGE_OCCUPANCY_FIRST_PAGE 1
 
+// set in the trailer of files whose metadata page holds the directory of OccupancyPageSummary.
+// files without it have the older layout, [uint32 count][uint32 pageNum...] of the hidden pages
+#define PAGE_OCCUPANCY_DIRECTORY_FORMAT 0x31445350
+
 #include "pfm.h"
 
 #include <map>
+#include <set>
 #include <vector>
 #include <algorithm>
 
 namespace PeterDB {
 
+// availableSpace never goes past PAGE_SIZE, so it shares the 4 bytes it was first given with
+// recordCount. the upper half was always 0 before, it's recounted (see PageSelectorTrailer) then
 struct PageOccupancy {
     unsigned pageNum;
-    unsigned availableSpace;
+    uint16_t availableSpace;
+    uint16_t recordCount;           // records of the page, tombstones included but not the copies they forward to
+};
+
+// min and max value of the zone map attribute over the records of one data page.
+// values are kept as raw 4 bytes, and interpreted as int or float by the caller
+struct PageZone {
+    unsigned pageNum;
+    unsigned hasValues;     // 0 if no non-null value was inserted into the page yet
+    uint32_t minValue;
+    uint32_t maxValue;
+};
+
+// directory entry for one hidden page holding PageOccupancy (or PageZone) entries. the directory
+// lives in the metadata page (continued in further directory pages if needed), so that opening a
+// file only reads the directory, and a hidden page is read the first time one of its entries is needed.
+// entries are only ever added to the last hidden page, so each one covers a contiguous run of data pages
+struct OccupancyPageSummary {
+    uint32_t pageNum;               // the hidden page
+    uint32_t numEntries;            // entries stored in that page
+    uint32_t firstDataPageNum;      // data page of its first entry, later entries have higher pageNums
+    uint32_t maxAvailableSpace;     // largest availableSpace of its entries, 0 for zone map pages
+};
+
+// a loaded hidden page
+struct OccupancyPage {
+    bool dirty = false;
+    std::vector<PageOccupancy> pageOccupancyArr;    // heap files, kept as a max-heap on availableSpace
+    std::vector<PageZone> pageZones;                // append-only files, in page order
+};
+
+// stored at the end of the metadata page, describes how pages are selected for insertion.
+// a zeroed trailer (files created before this was added) means a regular heap file, whose
+// metadata page is still in the older layout
+struct PageSelectorTrailer {
+    uint32_t recordCountKnown;      // 1 once recordCount and the per-page counts are kept, 0 in older files
+    uint32_t recordCount;           // records in the file, counted as in PageOccupancy
+    uint32_t appendOnly;            // 1 if records are always appended to the tail page
+    uint32_t tailPageNum;           // append-only: page currently being filled, 0 if none yet
+    uint32_t tailAvailableSpace;    // append-only: bytes still free in the tail page
+    uint32_t zoneCount;             // append-only: number of PageZone entries
+    uint32_t zoneAttrIsReal;        // 1 if the zone map attribute is a TypeReal, else TypeInt
+    char zoneAttrName[48];          // attribute the zone map is kept on, empty if none
+    uint32_t directoryFormat;       // PAGE_OCCUPANCY_DIRECTORY_FORMAT, 0 in older files
 };
 
 class PageSelector {
@@ -23,12 +73,38 @@ class PageSelector {
     PageSelector(const std::string& fileName, FileHandle *fileHandle);
     ~PageSelector();
 
-    void readMetadataFromDisk();
+    // hidden pages are read on demand, through whichever handle the file is currently used with
+    void setFileHandle(FileHandle *fileHandle);
+
+    // -1 if the metadata page can't be read, or isn't in a layout known here
+    RC readMetadataFromDisk();
     void writeMetadataToDisk();
     unsigned selectPage(const uint32_t& requiredBytes);
+    // to fill pages in order, e.g. when loading sorted records: pageNum (the page the previous
+    // record went to, -1 if none) while the record fits in it, else a new page appended
+    unsigned selectPageAfter(const int &pageNum, const uint32_t& requiredBytes);
     void decrementAvailableSpace(unsigned pageNum, int diff);
     bool isThisPageAMetadataPage(const PageNum &pageNum);
 
+    // append-only files always insert into the tail page, and keep no per-page free space
+    // entries. instead, the hidden pages hold a zone map (PageZone per data page) on one attribute
+    bool isAppendOnly();
+    void enableAppendOnly(const std::string &zoneAttrName, bool zoneAttrIsReal);
+    std::string getZoneAttrName();
+    void extendZone(const unsigned &pageNum, const void *value);
+    bool getZone(const unsigned &pageNum, PageZone &zone);
+
+    // records in the file, and in each of its data pages (heap files only), kept up to date by
+    // adjustRecordCount() once known. files written before counts were kept have them set once,
+    // from a count of their records, with setPageRecordCount() and setRecordCount()
+    bool isRecordCountKnown();
+    unsigned getRecordCount();
+    void adjustRecordCount(const unsigned &pageNum, int diff);
+    void setRecordCount(const unsigned &recordCount);
+    void setPageRecordCount(const unsigned &pageNum, const unsigned &recordCount);
+    // false when not known, e.g. in append-only files
+    bool getPageRecordCount(const unsigned &pageNum, unsigned &recordCount);
+
     private:
     std::string m_fileName = "";
     FileHandle *m_fileHandle = nullptr;
@@ -39,25 +115,49 @@ class PageSelector {
     // const FileHandle* m_fileHandle = nullptr; // pointer to constant.. can change where we point to
                                                  // but can't change what we're ponting to
 
-    // page occupancy metadata.. contains array of integer
-    // first integer represents how many pages are used currently to store
-    // page occupancy info. if that is n, then next n integers
-    // represent the pageNums of all those n pages
+    // metadata page. layout of the metadata page, and of each directory page after it, is
+    // [uint32 numSummariesInPage][uint32 nextDirectoryPage][OccupancyPageSummary...]
+    // the metadata page additionally ends with the PageSelectorTrailer
     uint32_t *m_pageOccupancyMetadata = nullptr;
 
-    // page occupancy info stored in multiple hidden pages
-    // page occupancy of entire file might not be stored in single hidden page
-    // hence we'll have to store nultiple hidden pages
-    std::map<uint16_t, std::vector<PageOccupancy>> m_pageOccupancyInfo;
+    // directory of all the hidden pages holding page occupancy info (or zones), in page order,
+    // and the pages the directory is stored in (metadata page first)
+    std::vector<OccupancyPageSummary> m_summaries;
+    std::vector<unsigned> m_directoryPages;
+    bool m_directoryDirty = false;
+
+    // heap files: (maxAvailableSpace, index into m_summaries) of every non-empty hidden page,
+    // so the page with the most free space is found without reading any hidden page
+    std::set<std::pair<unsigned, unsigned>> m_summariesBySpace;
+
+    // hidden pages read so far, keyed by index into m_summaries. only dirty ones are written back
+    std::map<unsigned, OccupancyPage> m_occupancyPages;
+
+    // trailer of the metadata page: append-only files, and record counts
+    PageSelectorTrailer *m_trailer = nullptr;
 
-    void readPageOccupancyInfo();
-    std::vector<PageOccupancy> deserializePageOccupancyInfo(const void *data);
+    RC readDirectory();
+    // converts the metadata page of an older file to the directory layout, and writes it back
+    RC convertOlderDirectory();
+    void writeDirectory();
+    unsigned directoryCapacity(const unsigned &directoryIndex);
 
-    void writePageOccupancyInfo();
-    void serializePageOccupancyInfo(const std::vector<PageOccupancy>& pageOccupancyArr, void* serializedData);
+    OccupancyPage* loadOccupancyPage(const unsigned &index);
+    void writeOccupancyPage(const unsigned &index);
+    int findSummaryOfDataPage(const unsigned &pageNum);
+    void updateSummary(const unsigned &index);
 
     unsigned createPageForPageOccupancyInfo();
     void insertNewPageOccupancyInfo(const unsigned &pageNum, const unsigned &availableSpace);
+
+    // the PageOccupancy entry of a data page of a heap file, nullptr if there is none
+    PageOccupancy* findPageOccupancy(const unsigned &pageNum, OccupancyPage *&page);
+
+    unsigned selectTailPage(const uint32_t& requiredBytes);
+
+    // appends a data page to a heap file, with requiredBytes of it taken already
+    unsigned appendDataPage(const uint32_t& requiredBytes);
+
 };
 
 } // namespace PeterDB
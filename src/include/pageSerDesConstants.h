@@ -30,6 +30,13 @@ namespace PeterDB {
         static const unsigned int KEY_TYPE_OFFSET = IS_LEAF_PAGE_OFFSET - KEY_TYPE_VAR_SIZE;
         static const unsigned int NEXT_PAGE_NUM_OFFSET = KEY_TYPE_OFFSET - NEXT_PAGE_NUM_VAR_SIZE;
         static const unsigned int NUM_KEYS_OFFSET = NEXT_PAGE_NUM_OFFSET - NUM_KEYS_VAR_SIZE;
+
+        /*
+         * set in the _keyType field of leaf pages whose entries carry a payload,
+         * which is written right after the key of each entry, as [length][payload]
+         */
+        static const int HAS_PAYLOAD_FLAG = 0x100;
+        static const size_t PAYLOAD_LENGTH_VAR_SIZE = sizeof(uint16_t);
     };
 }
 
@@ -21,7 +21,7 @@ namespace PeterDB {
 
         static void writePageNumAndKeyPairs(NonLeafPage &nonLeafPage, const void *data);
 
-        static void writeKeyAndRidPair(LeafPage &leafPage, void *data);
+        static void writeKeyAndRidPair(LeafPage &leafPage, bool hasPayload, void *data);
 
         static void writeNextPageNum(int nextPageNum, void *data);
 
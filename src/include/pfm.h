@@ -3,9 +3,20 @@
 
 #define PAGE_SIZE 4096
 #define HIDDEN_PAGES 1
-
+#define MEMORY_FILE_PREFIX ":memory:"       // files named so only live in memory
+#define MEMORY_FILE_CHUNK_PAGES 64          // pages allocated at once for a memory file
+#define TABLESPACE_FILE_PREFIX "@"          // files named "@<tablespace>/<file>" are in a tablespace
+#define STRIPE_EXTENT_PAGES 64              // pages in a row a striped file keeps in the same stripe
+#define STRIPE_FILE_SUFFIX ".stripe"
+
+#include <atomic>
+#include <cstdio>
+#include <map>
+#include <memory>
+#include <mutex>
 #include <string>
 #include <set>
+#include <vector>
 
 namespace PeterDB {
 
@@ -14,6 +25,23 @@ namespace PeterDB {
 
     class FileHandle;
 
+    // The pages of a file living in memory, header page included. Pages are allocated in chunks that
+    // never move, pages are read and written under the latch
+    class MemoryFile {
+    public:
+        RC readPage(unsigned physicalPage, void *data);
+
+        // physicalPage is at most the number of pages, appending a page then
+        RC writePage(unsigned physicalPage, const void *data);
+
+        unsigned getNumberOfPages();
+
+    private:
+        std::mutex m_latch;
+        std::vector<std::unique_ptr<char[]> > m_chunks;
+        unsigned m_pageCount = 0;
+    };
+
     class PagedFileManager {
     public:
         static PagedFileManager &instance();                                // Access to the singleton instance
@@ -23,6 +51,45 @@ namespace PeterDB {
         RC openFile(const std::string &fileName, FileHandle &fileHandle);   // Open a file
         RC closeFile(FileHandle &fileHandle);                               // Close a file
 
+        // whether the file is on disk, or in memory for memory files
+        bool fileExists(const std::string &fileName);
+
+        // Memory files have names starting with MEMORY_FILE_PREFIX. They are used through FileHandle as
+        // any other file, their pages being kept in memory only: nothing of them goes to disk nor to
+        // the WriteAheadLog, and they are gone once destroyed or when the process ends
+        static bool isMemoryFile(const std::string &fileName);
+
+        static std::string memoryFileName(const std::string &fileName);
+
+        // the pages of a memory file created before, nullptr if there is none
+        std::shared_ptr<MemoryFile> getMemoryFile(const std::string &fileName);
+
+        // Tablespaces are named lists of directories, e.g. one per device. Files named
+        // "@<tablespace>/<file>" are created in the first directory of the tablespace, the other ones in
+        // the working directory. The upper layers only ever see the names, getPath() gives the file on disk
+        RC setTablespace(const std::string &tablespace, const std::vector<std::string> &directories);
+
+        void removeTablespace(const std::string &tablespace);
+
+        bool hasTablespace(const std::string &tablespace);
+
+        static bool isTablespaceFile(const std::string &fileName);
+
+        // the tablespace a file is in, empty for the working directory
+        static std::string tablespaceOf(const std::string &fileName);
+
+        // the name of the file once moved to the tablespace (to the working directory for an empty one)
+        static std::string tablespaceFileName(const std::string &tablespace, const std::string &fileName);
+
+        // the file on disk, the name as is when it isn't in a tablespace known here
+        std::string getPath(const std::string &fileName);
+
+        // Creates a file whose pages are spread over a file in each directory of its tablespace
+        // ("<directory>/<file>.stripe<n>"), extentPages after extentPages in turn, so that reading many
+        // pages goes to all the devices at once. The header page stays in the file named as usual, which
+        // keeps the names of the stripes: the file is opened, read and written as any other one.
+        RC createStripedFile(const std::string &fileName, unsigned extentPages = STRIPE_EXTENT_PAGES);
+
     protected:
         PagedFileManager();                                                 // Prevent construction
         ~PagedFileManager();                                                // Prevent unwanted destruction
@@ -31,16 +98,29 @@ namespace PeterDB {
 
     private:
         std::set<std::string> m_createdFilenames;
+
+        std::mutex m_memoryFilesLatch;
+        std::map<std::string, std::shared_ptr<MemoryFile> > m_memoryFiles;
+
+        std::mutex m_tablespacesLatch;
+        std::map<std::string, std::vector<std::string> > m_tablespaces;
+
+        // path of the file in a directory of its tablespace
+        std::string getPath(const std::string &fileName, unsigned directory);
     };
 
     class FileHandle {
     public:
-        // variables to keep the counter for each operation
-        unsigned readPageCounter;
-        unsigned writePageCounter;
-        unsigned appendPageCounter;
+        // variables to keep the counter for each operation. pages may be read through the same handle
+        // from several threads at once (pages are read and written with pread/pwrite, which don't
+        // share a file position), writing and appending pages must be serialized by the caller
+        std::atomic<unsigned> readPageCounter;
+        std::atomic<unsigned> writePageCounter;
+        std::atomic<unsigned> appendPageCounter;
 
         FileHandle();                                                       // Default constructor
+        FileHandle(const FileHandle &other);                                // Copies the counter values
+        FileHandle &operator=(const FileHandle &other);
         ~FileHandle();                                                      // Destructor
 
         RC readPage(PageNum pageNum, void *data);                           // Get a specific page
@@ -57,16 +137,41 @@ namespace PeterDB {
         bool isActive();
         RC openFile();
         RC closeFile();
+        RC flush();                                                         // Persist the counters and buffered writes
+                                                                            // (only logs them while the WriteAheadLog is open)
 
         void setHiddenPagesUsed(unsigned n);
 
+        // files the pages of a striped file are spread over, none for other files
+        unsigned getStripeCount();
+
     private:
+        friend class PagedFileManager;
+
         FILE* m_fstream = nullptr;
+        std::shared_ptr<MemoryFile> m_memoryFile;                           // instead of m_fstream, for memory files
         std::string m_fileName = "";
+        std::string m_path = "";                                            // of the file on disk
         unsigned hiddenPagesFromUpperLayer = 0;
 
+        // striped files: extents of m_extentPages pages go to each stripe in turn, the header page aside
+        std::vector<FILE*> m_stripes;
+        std::vector<std::string> m_stripePaths;
+        unsigned m_extentPages = 0;
+
         void loadMetadataFromDisk();
         void writeMetadataToDisk();
+
+        // pages counted from the start of the file, the header page being 0. while the WriteAheadLog
+        // is open, they're written to the log and read from it as long as it holds them (memory files aside)
+        RC readPhysicalPage(unsigned physicalPage, void *data);
+        RC writePhysicalPage(unsigned physicalPage, const void *data);
+
+        // stripes named by the header of the file on disk at path, none if it is not striped
+        static void readStripePaths(const std::string &path, std::vector<std::string> &stripePaths);
+
+        // the file on disk holding a page, and the page in there
+        void locatePage(unsigned physicalPage, FILE *&file, const std::string *&path, unsigned &page);
     };
 
 } // namespace PeterDB
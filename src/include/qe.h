@@ -13,9 +13,6 @@
 namespace PeterDB {
 
 #define QE_EOF (-1)  // end of the index scan
-    typedef enum AggregateOp {
-        MIN = 0, MAX, COUNT, SUM, AVG
-    } AggregateOp;
 
     // The following functions use the following
     // format for the passed data.
@@ -136,6 +133,11 @@ namespace PeterDB {
 
         virtual RC getAttributes(std::vector<Attribute> &attrs) const = 0;
 
+        // the number of tuples left to return, when the iterator can tell without reading them. fails otherwise
+        virtual RC getTupleCount(unsigned & /*count*/) {
+            return -1;
+        }
+
         virtual ~Iterator() = default;
     };
 
@@ -145,13 +147,16 @@ namespace PeterDB {
         RelationManager &rm;
         RM_ScanIterator iter;
         std::string tableName;
+        std::string relationName;   // the table scanned, tableName being its alias
         std::vector<Attribute> attrs;
         std::vector<std::string> attrNames;
         RID rid;
+        bool started = false;       // a tuple was returned since the scan (re)started, counts are off then
     public:
         TableScan(RelationManager &rm, const std::string &tableName, const char *alias = NULL) : rm(rm) {
             //Set members
             this->tableName = tableName;
+            this->relationName = tableName;
 
             // Get Attributes from RM
             rm.getAttributes(tableName, attrs);
@@ -173,12 +178,33 @@ namespace PeterDB {
         void setIterator() {
             iter.close();
             rm.scan(tableName, "", NO_OP, NULL, attrNames, iter);
+            started = false;
         };
 
         RC getNextTuple(void *data) override {
+            started = true;
             return iter.getNextTuple(rid, data);
         };
 
+        // the row count of the table, before the scan returned any tuple. fails after
+        RC getTupleCount(unsigned &count) override {
+            if (started) {
+                return -1;
+            }
+            return rm.getRowCount(relationName, count);
+        };
+
+        // tuples of the table satisfying condition, an attribute of the scan against a value, counted
+        // from the index on the attribute. fails if the attribute has no index, or the scan returned a tuple
+        RC getMatchingTupleCount(const Condition &condition, unsigned &count) {
+            std::string prefix = tableName + ".";
+            if (started || condition.bRhsIsAttr || 0 != condition.lhsAttr.compare(0, prefix.size(), prefix)) {
+                return -1;
+            }
+            return rm.getRowCount(relationName, condition.lhsAttr.substr(prefix.size()), condition.op,
+                                  condition.rhsValue.data, count);
+        };
+
         RC getAttributes(std::vector<Attribute> &attributes) const override {
             attributes.clear();
             attributes = this->attrs;
@@ -203,6 +229,7 @@ namespace PeterDB {
         std::string tableName;
         std::string attrName;
         std::vector<Attribute> attrs;
+        std::vector<std::string> projectedAttrNames;
         char key[PAGE_SIZE];
         RID rid;
     public:
@@ -222,13 +249,41 @@ namespace PeterDB {
             if (alias) this->tableName = alias;
         };
 
+        // Only returns the projected attributes, straight from the index entries when it covers them
+        IndexScan(RelationManager &rm, const std::string &tableName, const std::string &attrName,
+                  const std::vector<std::string> &projectedAttrNames, const char *alias = NULL) : rm(rm) {
+            // Set members
+            this->tableName = tableName;
+            this->attrName = attrName;
+            this->projectedAttrNames = projectedAttrNames;
+
+            // Get Attributes from RM, in the order they are projected
+            std::vector<Attribute> tableAttrs;
+            rm.getAttributes(tableName, tableAttrs);
+            for (const std::string &projectedAttrName : projectedAttrNames) {
+                for (const Attribute &attribute : tableAttrs) {
+                    if (attribute.name == projectedAttrName) attrs.push_back(attribute);
+                }
+            }
+
+            // Call rm indexScan to get iterator
+            rm.indexScan(tableName, attrName, NULL, NULL, true, true, projectedAttrNames, iter);
+
+            // Set alias
+            if (alias) this->tableName = alias;
+        };
+
         // Start a new iterator given the new key range
         void setIterator(void *lowKey, void *highKey, bool lowKeyInclusive, bool highKeyInclusive) {
             iter.close();
-            rm.indexScan(tableName, attrName, lowKey, highKey, lowKeyInclusive, highKeyInclusive, iter);
+            rm.indexScan(tableName, attrName, lowKey, highKey, lowKeyInclusive, highKeyInclusive,
+                         projectedAttrNames, iter);
         };
 
         RC getNextTuple(void *data) override {
+            if (!projectedAttrNames.empty()) {
+                return iter.getNextTuple(rid, data);
+            }
             RC rc = iter.getNextEntry(rid, key);
             if (rc == 0) {
                 rc = rm.readTuple(tableName, rid, data);
@@ -236,6 +291,15 @@ namespace PeterDB {
             return rc;
         };
 
+        // the entries left in the key range, their tuples aren't read
+        RC getTupleCount(unsigned &count) override {
+            count = 0;
+            while (RM_EOF != iter.getNextEntry(rid, key)) {
+                count++;
+            }
+            return 0;
+        };
+
         RC getAttributes(std::vector<Attribute> &attributes) const override {
             attributes.clear();
             attributes = this->attrs;
@@ -276,6 +340,9 @@ namespace PeterDB {
         // For attribute in std::vector<Attribute>, name it as rel.attr
         RC getAttributes(std::vector<Attribute> &attrs) const override;
 
+        // from the index on the attribute of the condition, when filtering a table scan
+        RC getTupleCount(unsigned &count) override;
+
     private:
         Iterator *m_input_iter;
         std::vector<Attribute> m_input_attributes;
@@ -307,6 +374,9 @@ namespace PeterDB {
 
         // For attribute in std::vector<Attribute>, name it as rel.attr
         RC getAttributes(std::vector<Attribute> &attrs) const override;
+
+        // the count of the input, projecting drops no tuple
+        RC getTupleCount(unsigned &count) override;
     };
 
     class BNLJoin : public Iterator {
@@ -386,31 +456,6 @@ namespace PeterDB {
         RC getAttributes(std::vector<Attribute> &attrs) const override;
     };
 
-    typedef struct AggOutput {
-        float cnt = 0;
-        float min = FLT_MAX;
-        float max = FLT_MIN;
-        float sum = 0;
-
-        AggOutput() {}
-
-        double getVal(AggregateOp op) {
-            switch (op) {
-                case COUNT:
-                    return cnt;
-                case MIN:
-                    return min;
-                case MAX:
-                    return max;
-                case SUM:
-                    return sum;
-                case AVG:
-                    return (sum/cnt);
-            }
-            return 0;
-        }
-    } AggOutput;
-
     class Aggregate : public Iterator {
         // Aggregation operator
     private:
@@ -437,7 +482,8 @@ namespace PeterDB {
 
     public:
         // Mandatory
-        // Basic aggregation
+        // Basic aggregation. COUNT takes the tuple count of the input when it has one (see
+        // Iterator::getTupleCount()), e.g. the row count of a table scanned in full, without reading any tuple
         Aggregate(Iterator *input,          // Iterator of input R
                   const Attribute &aggAttr,        // The attribute over which we are computing an aggregate
                   AggregateOp op            // Aggregate operation
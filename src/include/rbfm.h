@@ -1,9 +1,16 @@
 #ifndef _rbfm_h_
 #define _rbfm_h_
 
+#include <atomic>
+#include <cstdint>
 #include <map>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <string>
 #include <vector>
 
+#include "src/include/latch.h"
 #include "src/include/pfm.h"
 #include "src/include/page.h"
 #include "src/include/pageSelector.h"
@@ -43,6 +50,8 @@ namespace PeterDB {
 
     typedef unsigned char byte;
 
+    typedef uint64_t Timestamp;     // of the changes made to records, snapshots included, counted from 1
+
     /********************************************************************
     * The scan iterator is NOT required to be implemented for Project 1 *
     ********************************************************************/
@@ -61,6 +70,14 @@ namespace PeterDB {
     // forward declaration of RecordBasedFileManager
     class RecordBasedFileManager;
 
+    // A page read for one reader: a single call, or a scan across its calls. It is read again once its
+    // file changed since, and a page of the file not written back yet is copied from memory instead
+    struct PageFrame {
+        Page page;
+        unsigned long changeCount = 0;  // of the file, when the page was read
+        std::string record;             // the last record read through the frame, serialized
+    };
+
     class RBFM_ScanIterator {
     public:
         RBFM_ScanIterator() = default;;
@@ -77,7 +94,22 @@ namespace PeterDB {
         void init(RecordBasedFileManager *rbfm, FileHandle *fileHandle,
              const std::vector<Attribute> &recordDescriptor, const std::string &conditionAttribute,
              const CompOp compOp, const void *value, const std::vector<std::string> &attributeNames);
+
+        // restricts the scan to the given (ascending) data pages, used by sampleScan
+        void setSamplePages(const std::vector<PageNum> &samplePages, unsigned dataPageCount);
+
+        // number of data pages the scan visits, and number of data pages in the file.
+        // for a sample scan, an aggregate over the returned records can be scaled up by
+        // getDataPageCount() / getScannedPageCount() to estimate the full-file value
+        unsigned getScannedPageCount() const;
+        unsigned getDataPageCount() const;
+
+        // returns the records as they were at the snapshot, see RecordBasedFileManager::beginSnapshot()
+        void setSnapshot(Timestamp snapshot);
     private:
+        // the page the scan is in, read once for all its records
+        std::unique_ptr<PageFrame> m_frame;
+
         // stores current RID that the scan iterator has returned to the caller
         // when getNextRecord is called, we have to check next record in the same page
         // or if we have scanned through all the records in that page, then give the
@@ -86,6 +118,14 @@ namespace PeterDB {
 
         // boolean flag to indicate whether the scanning has begun already
         bool m_scanStarted = false;
+        bool m_pagesExhausted = false;
+
+        // when sampling, only these pages are visited (in order), m_samplePos
+        // is the index of the next page to be visited
+        bool m_sampling = false;
+        std::vector<PageNum> m_samplePages;
+        size_t m_samplePos = 0;
+        unsigned m_dataPageCount = 0;
 
         bool m_initDone = false;
         RecordBasedFileManager *m_rbfm = nullptr;
@@ -96,10 +136,23 @@ namespace PeterDB {
         void *m_value = nullptr;
         std::vector<std::string> m_attributeNames;
 
+        // 0 returns the records as they are. otherwise, when the record of m_currentRid changed since
+        // the snapshot, m_version holds what it was then
+        Timestamp m_snapshot = 0;
+        bool m_readsVersion = false;
+        std::string m_version;
+
+        // called with the latch of the file held shared
         bool pickNextValidRID();
+        bool moveToNextPage();
         bool recordSatisfiesCondition();
+        RC readCurrentRecord(const std::vector<std::string> &attributeNames, void *data);
     };
 
+    // Operations on different files run concurrently, and so do the ones only reading records of the same
+    // file: each file has a latch, held shared by readers and exclusively by the operations changing it.
+    // Readers read pages into frames of their own. Handles may be shared by threads, except for opening
+    // and closing them
     class RecordBasedFileManager {
     public:
         static RecordBasedFileManager &instance();                          // Access to the singleton instance
@@ -112,6 +165,8 @@ namespace PeterDB {
 
         RC closeFile(FileHandle &fileHandle);                               // Close a record-based file
 
+        RC flushFile(FileHandle &fileHandle);                               // Write out what closeFile would, but keep it open
+
         //  Format of the data passed into the function is the following:
         //  [n byte-null-indicators for y fields] [actual value for the first field] [actual value for the second field] ...
         //  1) For y fields, there is n-byte-null-indicators in the beginning of each record.
@@ -131,10 +186,23 @@ namespace PeterDB {
         RC insertRecord(FileHandle &fileHandle, const std::vector<Attribute> &recordDescriptor, const void *data,
                         RID &rid);
 
+        // Insert many records into a file, rids gets the RID of each one (in the same order).
+        // Every page written to is written once, instead of once per record. inOrder packs the records into
+        // pages in the order given, each page filled before the next one is appended, carrying on from where the
+        // previous call with inOrder left off, e.g. to load sorted records into a new file. otherwise each goes
+        // into the page with the most free space
+        RC insertRecords(FileHandle &fileHandle, const std::vector<Attribute> &recordDescriptor,
+                         const std::vector<const void *> &data, std::vector<RID> &rids, bool inOrder = false);
+
         // Read a record identified by the given rid.
         RC
         readRecord(FileHandle &fileHandle, const std::vector<Attribute> &recordDescriptor, const RID &rid, void *data);
 
+        // Read many records at once, data[i] gets the record of rids[i]. The records are read in page order,
+        // each page once. Fails if any record can't be read, the others are read still
+        RC readRecords(FileHandle &fileHandle, const std::vector<Attribute> &recordDescriptor,
+                       const std::vector<RID> &rids, const std::vector<void *> &data);
+
         RC
         readRecordWithAttrFilter(FileHandle &fileHandle, const std::vector<Attribute> &recordDescriptor,
                                  const std::vector<std::string> &attributeNames, const RID &rid, void *data);
@@ -158,6 +226,16 @@ namespace PeterDB {
         RC updateRecord(FileHandle &fileHandle, const std::vector<Attribute> &recordDescriptor, const void *data,
                         const RID &existingRid);
 
+        // Delete (update) many records at once, in the order of rids. Consecutive records of a page are
+        // changed in memory, and the page is written once for them all: pass rids in page order (as
+        // scans return them) for every page to be written once. Stops at the first record which can't
+        // be deleted (updated), the ones before it stay deleted (updated).
+        RC deleteRecords(FileHandle &fileHandle, const std::vector<Attribute> &recordDescriptor,
+                         const std::vector<RID> &rids);
+
+        RC updateRecords(FileHandle &fileHandle, const std::vector<Attribute> &recordDescriptor,
+                         const std::vector<const void *> &data, const std::vector<RID> &rids);
+
         // Read an attribute given its name and the rid.
         RC readAttribute(FileHandle &fileHandle, const std::vector<Attribute> &recordDescriptor, const RID &rid,
                          const std::string &attributeName, void *data);
@@ -171,6 +249,71 @@ namespace PeterDB {
                 const std::vector<std::string> &attributeNames, // a list of projected attributes
                 RBFM_ScanIterator &rbfm_ScanIterator);
 
+        // Sample scan returns an iterator over the records of randomly chosen data pages only.
+        // fraction (0, 1] is the share of data pages to sample, the same seed picks the same pages.
+        // Metadata pages are never picked, pages are visited in ascending order.
+        RC sampleScan(FileHandle &fileHandle,
+                      const std::vector<Attribute> &recordDescriptor,
+                      double fraction,
+                      unsigned seed,
+                      const std::string &conditionAttribute,
+                      const CompOp compOp,
+                      const void *value,
+                      const std::vector<std::string> &attributeNames,
+                      RBFM_ScanIterator &rbfm_ScanIterator);
+
+        // Same as sampleScan, but samples (at most) numPages data pages
+        RC sampleScanPages(FileHandle &fileHandle,
+                           const std::vector<Attribute> &recordDescriptor,
+                           unsigned numPages,
+                           unsigned seed,
+                           const std::string &conditionAttribute,
+                           const CompOp compOp,
+                           const void *value,
+                           const std::vector<std::string> &attributeNames,
+                           RBFM_ScanIterator &rbfm_ScanIterator);
+
+        // Turns an empty record-based file into an append-only file. Records are always added to
+        // the tail page, which is written when it fills up (or on close), and space is never reused:
+        // deleteRecord and updateRecord fail on such files. If zoneMapAttribute (TypeInt or TypeReal)
+        // is given, the min/max of that attribute is kept per page, and scans with a condition on it
+        // skip the pages which cannot have a match.
+        RC enableAppendOnly(FileHandle &fileHandle, const std::vector<Attribute> &recordDescriptor,
+                            const std::string &zoneMapAttribute);
+
+        bool isAppendOnly(FileHandle &fileHandle);
+
+        // the attribute the zone map is kept on, empty without one
+        std::string getZoneMapAttribute(FileHandle &fileHandle);
+
+        // false if the zone map shows that no record in the page can satisfy the condition
+        bool pageMayMatch(FileHandle &fileHandle, PageNum pageNum, const std::vector<Attribute> &recordDescriptor,
+                          const std::string &conditionAttribute, const CompOp compOp, const void *value);
+
+        // Number of records in the file, kept up to date by every insert and delete (an update moving a
+        // record leaves it as it is), so no record is read. Files written before counts were kept have
+        // their records counted once, the first time.
+        RC getRecordCount(FileHandle &fileHandle, unsigned &count);
+
+        // Schemas the records of the file may have been written with, the last one being the current one.
+        // Records are written with the number of the current version, and read with the attributes of
+        // their own: attributes missing from it read as NULL, the ones not asked for are skipped. Without
+        // versions (or when given none), records are read with the descriptor passed in.
+        void setSchemaVersions(FileHandle &fileHandle, const std::vector<std::vector<Attribute>> &schemaVersions);
+
+        // Snapshots of the records of every file. A scan given one (RBFM_ScanIterator::setSnapshot()) returns
+        // the records as they were when it began, whatever is inserted, updated or deleted meanwhile.
+        // While snapshots are held, each change to a record keeps what the record was before it, in memory:
+        // the versions of a record are chained under its RID, oldest first, and the ones no snapshot held
+        // can see any more are dropped as snapshots end. Versions don't outlive the file being open.
+        Timestamp getTimestamp();
+
+        // the snapshot sees the changes made up to asOf, up to now when 0. it can only be older than now
+        // while a snapshot as old (or older) is held, the versions it needs are gone otherwise
+        Timestamp beginSnapshot(Timestamp asOf = 0);
+
+        void endSnapshot(Timestamp snapshot);
+
         bool isValidRid(FileHandle &fileHandle, const RID &rid);
         bool maxSlotBreached(FileHandle &fileHandle, const RID &rid);
         bool isValidDataPage(FileHandle &fileHandle, PageNum pageNum);
@@ -182,14 +325,121 @@ namespace PeterDB {
         RecordBasedFileManager &operator=(const RecordBasedFileManager &);          // Prevent assignment
 
     private:
-        Page m_page;
-        std::map<std::string, PageSelector*> m_pageSelectors;
-        std::map<std::string, int> m_fileOpenRefCount;
+        friend class RBFM_ScanIterator;
+
+        // what a record was until a change made while snapshots were held
+        struct RecordVersion {
+            Timestamp changedAt;
+            bool existed;                   // false for a change inserting the record
+            std::string image;              // serialized, as the page had it
+        };
+
+        // an open file, shared by all its handles
+        struct OpenFile {
+            PageSelector *pageSelector = nullptr;
+            int refCount = 0;
+
+            SharedLatch latch;
+            std::mutex zoneLatch;           // readers reading the zone map, which is loaded on demand
+            unsigned long changeCount = 0;  // bumped by every change to the records, frames read before are stale
+
+            // page records are written in. it can stay dirty between calls, e.g. the tail page of an
+            // append-only file, and readers then copy it from here
+            Page page;
+            int inOrderPageNum = -1;        // page the last record inserted in order went to, -1 if none
+
+            std::vector<std::vector<Attribute>> schemaVersions;
+
+            // versions of the records, keyed by RID. guarded by a latch of their own, as they are
+            // pruned by whoever ends a snapshot
+            std::mutex versionLatch;
+            std::map<uint64_t, std::vector<RecordVersion>> versions;
+        };
+
+        std::mutex m_openFilesLatch;        // only guards the map, held briefly
+        std::map<std::string, OpenFile*> m_openFiles;
         PagedFileManager *m_pagedFileManager = nullptr;
 
-        unsigned computePageNumForInsertion(unsigned recordLength, FileHandle &fileHandle);
+        std::atomic<Timestamp> m_clock{1};  // every change to a record takes the next timestamp
+        std::mutex m_snapshotsLatch;
+        std::multiset<Timestamp> m_snapshots;
+
+        OpenFile *getOpenFile(FileHandle &fileHandle);
+
+        static uint64_t versionKey(const RID &rid);
+
+        // stamps a change to rid, the record being there before it or not. while snapshots are held, what
+        // the record is (read from its page, so before the change is made) is kept as a version
+        void keepVersion(OpenFile &file, FileHandle &fileHandle, const RID &rid, bool existed);
+
+        // whether the record of rid changed since snapshot. if so, existed tells whether it was there
+        // then, and image what it was
+        bool versionAsOf(OpenFile &file, const RID &rid, Timestamp snapshot, bool &existed, std::string &image);
+
+        // the methods below are called with the latch of the file held, exclusively for the ones changing it
+
+        // the PageSelector of the file, reading any hidden page it needs through fileHandle
+        PageSelector* getPageSelector(OpenFile &file, FileHandle &fileHandle);
+
+        // the version records of the file are written with, 0 without versions
+        uint16_t getSchemaVersion(OpenFile &file);
+
+        // reads pageNum into the frame, unless it holds the page already and the file didn't change since
+        RC loadPage(OpenFile &file, FileHandle &fileHandle, PageNum pageNum, PageFrame &frame);
+
+        RC readRecordInFrame(OpenFile &file, FileHandle &fileHandle, const std::vector<Attribute> &recordDescriptor,
+                             const std::vector<std::string> &attributeNames, const RID &rid, void *data,
+                             PageFrame &frame);
+
+        // the serialized record of rid into frame.record, from wherever its tombstone forwards to
+        RC readSerializedRecord(OpenFile &file, FileHandle &fileHandle, const RID &rid, PageFrame &frame);
+
+        // a serialized record in the api format, read with the schema version it was written with
+        void deserializeRecord(OpenFile &file, const std::vector<Attribute> &recordDescriptor,
+                               const std::vector<std::string> &attributeNames, const void *serializedRecord,
+                               void *data);
+
+        // deletes the copy the tombstone in rid forwards to, if it holds one. file.page is left unspecified
+        RC dropForwardedCopy(OpenFile &file, FileHandle &fileHandle, const RID &rid);
+
+        bool dataPageExists(OpenFile &file, FileHandle &fileHandle, PageNum pageNum);
+
+        // the slot holds a record, or a tombstone forwarding to it. the copy a tombstone forwards to
+        // doesn't count, the record is found through its own RID
+        bool slotHoldsRecord(OpenFile &file, FileHandle &fileHandle, const RID &rid, PageFrame &frame);
+
+        bool slotBeyondPage(OpenFile &file, FileHandle &fileHandle, const RID &rid, PageFrame &frame);
+
+        bool zoneMayMatch(OpenFile &file, FileHandle &fileHandle, PageNum pageNum,
+                          const std::vector<Attribute> &recordDescriptor, const std::string &conditionAttribute,
+                          const CompOp compOp, const void *value);
+
+        // false when the page is known to hold no record. full scans skip those pages
+        bool pageHoldsRecords(OpenFile &file, FileHandle &fileHandle, PageNum pageNum);
+
+        // counts the records of every data page, for files written before counts were kept
+        void countRecords(OpenFile &file, FileHandle &fileHandle);
+
+        // the page with the most free space, or with previousPageNum given (not -1), that page while
+        // the record fits in it, else a new one (see PageSelector::selectPageAfter)
+        unsigned computePageNumForInsertion(OpenFile &file, unsigned recordLength, FileHandle &fileHandle,
+                                            int previousPageNum = -1);
+
+        // adds the record to the page picked for it, leaving that page in file.page, marked dirty
+        void insertRecordIntoPage(OpenFile &file, FileHandle &fileHandle,
+                                  const std::vector<Attribute> &recordDescriptor, const void *data, RID &rid,
+                                  int previousPageNum = -1);
+
+        void appendFreshPage(OpenFile &file, int pageNumber, FileHandle &fileHandle);
+
+        // change the record, leaving its page in file.page, marked dirty
+        RC deleteRecordInPage(OpenFile &file, FileHandle &fileHandle, const RID &rid);
+
+        RC updateRecordInPage(OpenFile &file, FileHandle &fileHandle, const std::vector<Attribute> &recordDescriptor,
+                              const void *data, const RID &existingRid);
 
-        void appendFreshPage(int pageNumber, FileHandle &fileHandle);
+        void pickSamplePages(OpenFile &file, FileHandle &fileHandle, unsigned numPages, unsigned seed,
+                             std::vector<PageNum> &samplePages);
     };
 
 } // namespace PeterDB
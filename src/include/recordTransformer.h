@@ -19,15 +19,22 @@ namespace PeterDB {
 
     class RecordTransformer {
         public:
+        // a record is its attribute count, its schema version when it isn't 0 (the top bit of the
+        // count is set then), the null flags, the end offset of each attribute, then the values.
+        // returns the size of the record, which is only computed when serializedRecord is null
         static uint32_t serialize(const std::vector<Attribute> &recordDescriptor,
                                   const void *recordData,
-                                  void *serializedRecord);
+                                  void *serializedRecord,
+                                  uint16_t schemaVersion = 0);
 
         static void deserialize(const std::vector<Attribute> &recordDescriptor,
                                 const std::vector<std::string> &attributeNames,
                                 const void *serializedRecord,
                                 void *recordData);
 
+        // version of the schema the record was written with
+        static uint16_t getSchemaVersion(const void *serializedRecord);
+
         static void print(const std::vector<Attribute> &recordDescriptor,
                           const void *recordData,
                           std::ostream &stream);
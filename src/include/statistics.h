@@ -0,0 +1,102 @@
+#ifndef _statistics_h_
+#define _statistics_h_
+
+#include <random>
+#include <string>
+#include <vector>
+
+#include "src/include/rbfm.h"
+
+# define STATS_HLL_PRECISION 12             // 2^12 HyperLogLog registers, about 1.6% standard error
+# define STATS_HISTOGRAM_BUCKETS 32
+# define STATS_HISTOGRAM_SAMPLE_SIZE 30000  // values per column kept (reservoir sampled) to build the histogram
+# define STATS_VALUE_MAX_LENGTH 32          // varchar min/max and bucket bounds are cut to this many characters
+# define STATS_SAMPLE_PAGES 1024            // tables with more data pages are analyzed from a sample of pages
+# define STATS_SAMPLE_SEED 42
+
+namespace PeterDB {
+
+    // Estimates the number of distinct values added to it, in a fixed amount of memory
+    class HyperLogLog {
+    public:
+        HyperLogLog();
+
+        void add(const void *value, unsigned length);
+
+        double estimate() const;
+
+    private:
+        std::vector<uint8_t> m_registers;
+    };
+
+    // Statistics of one column. Values (min, max and bucket bounds) follow the key format
+    // of IndexManager::insertEntry()
+    struct ColumnStatistics {
+        std::string name;
+        AttrType type = TypeInt;
+        float nullFraction = 0;
+        unsigned distinctCount = 0;     // among the non-NULL values
+        std::string minValue;           // empty if the column only has NULLs
+        std::string maxValue;
+
+        // equi-depth histogram over the non-NULL values: each of the bounds.size() - 1 buckets holds
+        // about as many rows, bucket i has the values in (bounds[i], bounds[i + 1]]. bounds[0] is the min
+        std::vector<std::string> histogramBounds;
+
+        // estimated fraction of all rows (NULLs included) satisfying "column compOp value"
+        float estimateSelectivity(CompOp compOp, const void *value) const;
+
+        // compares two values of the given type, < 0, 0 or > 0 like strcmp
+        static int compareValues(AttrType type, const std::string &first, const std::string &second);
+
+        // copies a value given in the key format, varchars are cut to STATS_VALUE_MAX_LENGTH characters
+        static std::string toValue(AttrType type, const void *key);
+
+    private:
+        // estimated fraction of the non-NULL values less than value
+        float fractionBelow(const std::string &value) const;
+    };
+
+    struct TableStatistics {
+        unsigned rowCount = 0;
+        unsigned pageCount = 0;
+        float avgRecordSize = 0;        // bytes, in the insertTuple() format
+        bool sampled = false;           // computed from a sample of the pages
+        std::vector<ColumnStatistics> columns;
+
+        // nullptr if the column has no statistics
+        const ColumnStatistics *getColumn(const std::string &name) const;
+    };
+
+    // Builds TableStatistics from the tuples of a table, handed over one by one
+    class StatisticsCollector {
+    public:
+        explicit StatisticsCollector(const std::vector<Attribute> &attrs);
+
+        // data follows the same format as RelationManager::insertTuple()
+        void addTuple(const void *data);
+
+        // rowScale is the number of rows each tuple seen stands for, 1 unless the tuples are a sample
+        void finish(unsigned pageCount, double rowScale, TableStatistics &stats);
+
+    private:
+        struct ColumnCollector {
+            unsigned nullCount = 0;
+            unsigned valueCount = 0;
+            HyperLogLog distinct;
+            std::string minValue;
+            std::string maxValue;
+            std::vector<std::string> reservoir;
+        };
+
+        std::vector<Attribute> m_attrs;
+        std::vector<ColumnCollector> m_columns;
+        unsigned m_tupleCount = 0;
+        unsigned long m_tupleBytes = 0;
+        std::mt19937 m_random;
+
+        void addValue(ColumnCollector &column, AttrType type, const char *key, unsigned keySize);
+    };
+} // namespace PeterDB
+
+#endif // _statistics_h_
@@ -0,0 +1,164 @@
+#ifndef _wal_h_
+#define _wal_h_
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <set>
+#include <string>
+#include <thread>
+
+#include "src/include/pfm.h"
+
+# define WAL_FILE_NAME "peterdb.wal"
+# define WAL_BUFFER_BYTES (1u << 20)            // log records kept in memory before the log writer is woken up
+# define WAL_CHECKPOINT_BYTES (64u << 20)       // log size past which RelationManager checkpoints
+# define WAL_MAX_DIRTY_PAGES 1024               // logged pages of a file kept in memory before they're written back
+
+namespace PeterDB {
+
+    typedef uint64_t LSN;                       // log sequence number, records are numbered from 1
+
+    // Write-ahead log of the page images written through FileHandle, with group commit.
+    //
+    // While the log is open, FileHandle::writePage()/appendPage() (and the file header written on flush
+    // and close) only append a record with the new page image to the log, and keep the page in memory,
+    // where every handle of the file reads it from. The pages are written back to their file lazily: once
+    // more than WAL_MAX_DIRTY_PAGES of a file are held, or at checkpoint(), and never before their log
+    // records are on disk. Record and B+ tree pages (and the hidden pages of both) all go through the same
+    // path, so a full page image per write is all redo needs.
+    //
+    // The pages of an operation, e.g. a call of RelationManager, are logged between beginOperation() and
+    // endOperation(). Once no operation that logged a page is in progress, a commit record is appended:
+    // the records before it are those of finished operations only, and replay goes no further than the
+    // last commit record on disk. Operations left halfway by a crash are dropped as a whole, as are the
+    // pages they had split or merged. A page only reaches its file once a commit record covers its image,
+    // pages of operations in progress stay in memory.
+    //
+    // commit() returns once every record logged so far is covered by a commit record on disk. Records are
+    // appended to an in-memory buffer, a single log writer thread writes the buffer out and fdatasync()s
+    // it; the commits waiting while it is busy are all covered by its next fdatasync().
+    //
+    // open() replays the log left over by a crash, oldest record first, before anything else is logged.
+    class WriteAheadLog {
+    public:
+        static WriteAheadLog &instance();
+
+        // replays the records found in the log, then starts logging into it
+        RC open(const std::string &logFileName = WAL_FILE_NAME);
+
+        // checkpoints, then stops logging. files are written through again afterwards
+        RC close();
+
+        bool isOpen();
+
+        // records that are only replayed when the log is opened after a crash. destroying a file
+        // also drops the pages of it held in memory
+        LSN logCreateFile(const std::string &fileName);
+
+        LSN logDestroyFile(const std::string &fileName);
+
+        // operations nest, only the outermost one of a thread counts
+        void beginOperation();
+
+        void endOperation();
+
+        // waits until the records logged so far are covered by a commit record on disk, i.e. until the
+        // operations in progress meanwhile ended. must not be called from inside an operation
+        RC commit();
+
+        // waits until the log is on disk up to lsn, or up to the last record logged, whether their operations
+        // are over or not
+        RC flush(LSN lsn);
+
+        RC flush();
+
+        // writes back the pages held in memory, syncs the files written since the last checkpoint,
+        // then empties the log. pages must not be written while it runs, and the operation it is called
+        // from, if any, must be at a point it can be committed at
+        RC checkpoint();
+
+        // the log grew past WAL_CHECKPOINT_BYTES since the last checkpoint
+        bool needsCheckpoint();
+
+    protected:
+        WriteAheadLog();                                                    // Prevent construction
+        ~WriteAheadLog();                                                   // Prevent unwanted destruction
+        WriteAheadLog(const WriteAheadLog &);                               // Prevent construction by copying
+        WriteAheadLog &operator=(const WriteAheadLog &);                    // Prevent assignment
+
+    private:
+        friend class FileHandle;
+
+        // on disk, a record is its header, the file name, then the page image for page records
+        enum RecordType : uint32_t {
+            PageRecord = 1,
+            CreateFileRecord = 2,
+            DestroyFileRecord = 3,
+            CommitRecord = 4
+        };
+
+        struct RecordHeader {
+            uint32_t length;            // of the whole record
+            uint32_t checksum;          // of the record after this field
+            uint64_t lsn;
+            uint32_t type;
+            uint32_t physicalPage;
+            uint32_t fileNameLength;
+        };
+
+        std::mutex m_mutex;
+        std::condition_variable m_writerWakeup;
+        std::condition_variable m_durable;
+        std::condition_variable m_committed;
+        std::thread m_writer;
+        bool m_stopWriter = false;
+        std::atomic<bool> m_open;
+
+        int m_fd = -1;
+        std::string m_logFileName;
+        std::string m_buffer;           // records logged, not yet handed over to the log file
+        LSN m_lastLsn = 0;              // of the last record logged
+        LSN m_requestedLsn = 0;         // largest lsn a commit() is waiting for
+        LSN m_durableLsn = 0;           // records up to this one are on disk
+        LSN m_commitLsn = 0;            // of the last commit record
+        unsigned m_operations = 0;      // in progress
+        bool m_writeFailed = false;
+        unsigned long m_logBytes = 0;   // logged since the last checkpoint
+
+        // pages logged but not written back yet, keyed by file name then by page in the file
+        struct DirtyPage {
+            LSN lsn;                    // of the record of this image
+            std::string image;
+        };
+        std::map<std::string, std::map<unsigned, DirtyPage> > m_dirtyPages;
+        std::set<std::string> m_unsyncedFiles;      // written back to since the last checkpoint
+        std::map<std::string, LSN> m_writtenBackAt; // commit lsn of the last write back of a file
+
+        // called with m_mutex held
+        LSN appendRecord(RecordType type, const std::string &fileName, unsigned physicalPage, const void *data);
+
+        void appendCommitRecord();
+
+        RC waitDurable(std::unique_lock<std::mutex> &lock, LSN lsn);
+
+        void writerLoop();
+
+        RC replay();
+
+        RC writeBack(const std::string &fileName);
+
+        // used by FileHandle, physicalPage counts the pages of the file from its start, header page included
+        RC writePage(const std::string &fileName, unsigned physicalPage, const void *data);
+
+        // false if the page isn't held in memory, it is in the file then
+        bool readPage(const std::string &fileName, unsigned physicalPage, void *data);
+
+        bool holdsPage(const std::string &fileName, unsigned physicalPage);
+    };
+
+} // namespace PeterDB
+
+#endif // _wal_h_
@@ -0,0 +1,142 @@
+#include "src/include/compositeKey.h"
+
+namespace PeterDB {
+
+    static const unsigned char ESCAPE_BYTE = 0x00;
+    static const unsigned char ESCAPED_ZERO = 0xFF;
+    static const unsigned char TERMINATOR = 0x00;
+
+    static void appendBigEndian(std::string &encoded, uint32_t bits) {
+        for (int shift = 24; shift >= 0; shift -= 8) {
+            encoded.push_back((char) ((bits >> shift) & 0xFF));
+        }
+    }
+
+    static uint32_t readBigEndian(const unsigned char *data) {
+        return ((uint32_t) data[0] << 24) | ((uint32_t) data[1] << 16) | ((uint32_t) data[2] << 8) | data[3];
+    }
+
+    Attribute CompositeKey::keyAttribute(const std::vector<Attribute> &attrs) {
+        Attribute keyAttr;
+        for (auto &attr : attrs) {
+            keyAttr.name += (keyAttr.name.empty() ? "" : ",") + attr.name;
+        }
+        keyAttr.type = TypeVarChar;
+        keyAttr.length = maxEncodedSize(attrs);
+        return keyAttr;
+    }
+
+    unsigned CompositeKey::maxEncodedSize(const std::vector<Attribute> &attrs) {
+        unsigned size = 0;
+        for (auto &attr : attrs) {
+            size += TypeVarChar == attr.type ? 2 * attr.length + 2 : sizeof(uint32_t);
+        }
+        return size;
+    }
+
+    unsigned CompositeKey::encode(const std::vector<Attribute> &attrs, const std::vector<const void *> &values,
+                                  void *key) {
+        assert(values.size() <= attrs.size());
+
+        std::string encoded;
+        for (unsigned i = 0; i < values.size(); i++) {
+            switch (attrs[i].type) {
+                case TypeInt: {
+                    uint32_t bits;
+                    memcpy(&bits, values[i], sizeof(bits));
+                    appendBigEndian(encoded, bits ^ 0x80000000u);
+                    break;
+                }
+                case TypeReal: {
+                    float value;
+                    memcpy(&value, values[i], sizeof(value));
+                    if (0 == value) {
+                        value = 0;      // -0 and 0 are the same key
+                    }
+                    uint32_t bits;
+                    memcpy(&bits, &value, sizeof(bits));
+                    appendBigEndian(encoded, (bits & 0x80000000u) ? ~bits : bits ^ 0x80000000u);
+                    break;
+                }
+                case TypeVarChar: {
+                    uint32_t length;
+                    memcpy(&length, values[i], sizeof(length));
+                    auto *chars = (const unsigned char *) values[i] + sizeof(length);
+                    for (uint32_t c = 0; c < length; c++) {
+                        encoded.push_back((char) chars[c]);
+                        if (ESCAPE_BYTE == chars[c]) {
+                            encoded.push_back((char) ESCAPED_ZERO);
+                        }
+                    }
+                    encoded.push_back((char) ESCAPE_BYTE);
+                    encoded.push_back((char) TERMINATOR);
+                    break;
+                }
+            }
+        }
+
+        auto encodedLength = (uint32_t) encoded.size();
+        memcpy(key, &encodedLength, sizeof(encodedLength));
+        memcpy((char *) key + sizeof(encodedLength), encoded.data(), encodedLength);
+        return sizeof(encodedLength) + encodedLength;
+    }
+
+    unsigned CompositeKey::decode(const std::vector<Attribute> &attrs, const void *key, void *values) {
+        auto *readPtr = (const unsigned char *) key + sizeof(uint32_t);
+        auto *writePtr = (char *) values;
+
+        for (auto &attr : attrs) {
+            switch (attr.type) {
+                case TypeInt: {
+                    uint32_t bits = readBigEndian(readPtr) ^ 0x80000000u;
+                    memcpy(writePtr, &bits, sizeof(bits));
+                    readPtr += sizeof(bits);
+                    writePtr += sizeof(bits);
+                    break;
+                }
+                case TypeReal: {
+                    uint32_t bits = readBigEndian(readPtr);
+                    bits = (bits & 0x80000000u) ? bits ^ 0x80000000u : ~bits;
+                    memcpy(writePtr, &bits, sizeof(bits));
+                    readPtr += sizeof(bits);
+                    writePtr += sizeof(bits);
+                    break;
+                }
+                case TypeVarChar: {
+                    char *lengthPtr = writePtr;
+                    writePtr += sizeof(uint32_t);
+                    uint32_t length = 0;
+                    while (!(ESCAPE_BYTE == readPtr[0] && TERMINATOR == readPtr[1])) {
+                        *writePtr++ = (char) readPtr[0];
+                        readPtr += ESCAPE_BYTE == readPtr[0] ? 2 : 1;
+                        length++;
+                    }
+                    readPtr += 2;
+                    memcpy(lengthPtr, &length, sizeof(length));
+                    break;
+                }
+            }
+        }
+        return writePtr - (char *) values;
+    }
+
+    bool CompositeKey::prefixEnd(const void *prefixKey, void *endKey) {
+        uint32_t length;
+        memcpy(&length, prefixKey, sizeof(length));
+        std::string encoded((const char *) prefixKey + sizeof(length), length);
+
+        // drop the trailing 0xFF bytes, which can't be incremented, then increment the last byte left
+        while (!encoded.empty() && (char) 0xFF == encoded.back()) {
+            encoded.pop_back();
+        }
+        if (encoded.empty()) {
+            return false;
+        }
+        encoded.back() = (char) ((unsigned char) encoded.back() + 1);
+
+        length = encoded.size();
+        memcpy(endKey, &length, sizeof(length));
+        memcpy((char *) endKey + sizeof(length), encoded.data(), length);
+        return true;
+    }
+} // namespace PeterDB
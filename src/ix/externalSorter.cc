@@ -0,0 +1,335 @@
+#include "src/include/externalSorter.h"
+#include "src/include/varcharSerDes.h"
+
+#include <algorithm>
+
+namespace PeterDB {
+
+    ExternalSorter::ExternalSorter(const Attribute &keyAttribute, const std::string &runFilePrefix,
+                                   size_t memoryBytes)
+            : m_keyAttribute(keyAttribute), m_runFilePrefix(runFilePrefix), m_memoryBytes(memoryBytes) {
+    }
+
+    ExternalSorter::~ExternalSorter() {
+        closeMerge();
+        for (auto &runFileName : m_runFileNames) {
+            remove(runFileName.c_str());
+        }
+    }
+
+    RC ExternalSorter::addEntry(const void *key, const RID &rid, const std::string &payload) {
+        if (m_finished) {
+            ERROR("Cannot add entries to a finished sort\n");
+            return -1;
+        }
+
+        m_entries.push_back(toEntry(key, rid));
+        m_entries.back().setPayload(payload);
+        m_entriesBytes += sizeof(RidAndKey) + m_entries.back().getStringKey().size() + payload.size();
+
+        if (m_entriesBytes >= m_memoryBytes) {
+            return spillRun();
+        }
+        return 0;
+    }
+
+    RC ExternalSorter::finish() {
+        if (m_finished) {
+            return 0;
+        }
+        m_finished = true;
+
+        if (m_runFileNames.empty()) {
+            // everything fit into memory
+            std::sort(m_entries.begin(), m_entries.end(), [this](const RidAndKey &a, const RidAndKey &b) {
+                return isLess(a, b);
+            });
+            m_nextEntry = 0;
+            return 0;
+        }
+
+        if (!m_entries.empty() && 0 != spillRun()) {
+            return -1;
+        }
+
+        while (m_runFileNames.size() > EXTERNAL_SORT_MAX_FAN_IN) {
+            if (0 != mergeRuns(EXTERNAL_SORT_MAX_FAN_IN)) {
+                return -1;
+            }
+        }
+        return openMerge(m_runFileNames);
+    }
+
+    RC ExternalSorter::getNextEntry(RID &rid, void *key) {
+        std::string payload;
+        return getNextEntry(rid, key, payload);
+    }
+
+    RC ExternalSorter::getNextEntry(RID &rid, void *key, std::string &payload) {
+        assert(m_finished);
+
+        if (m_runFileNames.empty()) {
+            if (m_nextEntry >= m_entries.size()) {
+                return IX_EOF;
+            }
+            rid = m_entries[m_nextEntry].getRid();
+            toKey(m_entries[m_nextEntry], key);
+            payload = m_entries[m_nextEntry].getPayload();
+            m_nextEntry++;
+            return 0;
+        }
+
+        RidAndKey entry(RID{0, 0}, 0);
+        if (!nextMergedEntry(entry)) {
+            return IX_EOF;
+        }
+        rid = entry.getRid();
+        toKey(entry, key);
+        payload = entry.getPayload();
+        return 0;
+    }
+
+    unsigned ExternalSorter::getNumRuns() const {
+        return m_runsCreated;
+    }
+
+    bool ExternalSorter::isLess(const RidAndKey &first, const RidAndKey &second) const {
+        switch (m_keyAttribute.type) {
+            case TypeInt:
+                if (first.getIntKey() != second.getIntKey()) {
+                    return first.getIntKey() < second.getIntKey();
+                }
+                break;
+            case TypeReal:
+                if (first.getFloatKey() != second.getFloatKey()) {
+                    return first.getFloatKey() < second.getFloatKey();
+                }
+                break;
+            case TypeVarChar: {
+                int cmp = first.getStringKey().compare(second.getStringKey());
+                if (0 != cmp) {
+                    return cmp < 0;
+                }
+                break;
+            }
+        }
+
+        // equal keys are ordered by RID, so that the order does not depend on how the runs were cut
+        if (first.getRid().pageNum != second.getRid().pageNum) {
+            return first.getRid().pageNum < second.getRid().pageNum;
+        }
+        return first.getRid().slotNum < second.getRid().slotNum;
+    }
+
+    RidAndKey ExternalSorter::toEntry(const void *key, const RID &rid) const {
+        switch (m_keyAttribute.type) {
+            case TypeInt:
+                return RidAndKey(rid, *((const int *) key));
+            case TypeReal:
+                return RidAndKey(rid, *((const float *) key));
+            case TypeVarChar:
+                return RidAndKey(rid, VarcharSerDes::deserialize(key));
+        }
+        assert(0);
+        return RidAndKey(rid, 0);
+    }
+
+    void ExternalSorter::toKey(const RidAndKey &entry, void *key) const {
+        switch (m_keyAttribute.type) {
+            case TypeInt: {
+                int intKey = entry.getIntKey();
+                memcpy(key, &intKey, sizeof(int));
+                break;
+            }
+            case TypeReal: {
+                float floatKey = entry.getFloatKey();
+                memcpy(key, &floatKey, sizeof(float));
+                break;
+            }
+            case TypeVarChar:
+                VarcharSerDes::serialize(entry.getStringKey(), key);
+                break;
+        }
+    }
+
+    RC ExternalSorter::spillRun() {
+        std::sort(m_entries.begin(), m_entries.end(), [this](const RidAndKey &a, const RidAndKey &b) {
+            return isLess(a, b);
+        });
+
+        std::string runFileName = m_runFilePrefix + ".run" + std::to_string(m_runsCreated++);
+        FILE *file = fopen(runFileName.c_str(), "wb");
+        if (nullptr == file) {
+            ERROR("Error while creating the sort run file %s\n", runFileName.c_str());
+            return -1;
+        }
+        m_runFileNames.push_back(runFileName);
+
+        for (auto &entry : m_entries) {
+            if (0 != writeEntry(file, entry)) {
+                fclose(file);
+                return -1;
+            }
+        }
+        fclose(file);
+
+        INFO("Spilled %zu entries into sort run %s\n", m_entries.size(), runFileName.c_str());
+        m_entries.clear();
+        m_entries.shrink_to_fit();
+        m_entriesBytes = 0;
+        return 0;
+    }
+
+    // an entry is written as [RID][key][payload length][payload], the key in the insertEntry() format
+    RC ExternalSorter::writeEntry(FILE *file, const RidAndKey &entry) const {
+        const RID &rid = entry.getRid();
+        if (1 != fwrite(&rid.pageNum, sizeof(rid.pageNum), 1, file) ||
+            1 != fwrite(&rid.slotNum, sizeof(rid.slotNum), 1, file)) {
+            ERROR("Error while writing a sort run\n");
+            return -1;
+        }
+
+        size_t keySize = sizeof(int);
+        if (TypeVarChar == m_keyAttribute.type) {
+            keySize = VarcharSerDes::computeSerializedSize(entry.getStringKey());
+        }
+        std::vector<char> key(keySize);
+        toKey(entry, key.data());
+        if (1 != fwrite(key.data(), keySize, 1, file)) {
+            ERROR("Error while writing a sort run\n");
+            return -1;
+        }
+
+        const std::string &payload = entry.getPayload();
+        auto payloadSize = (uint16_t) payload.size();
+        if (1 != fwrite(&payloadSize, sizeof(payloadSize), 1, file) ||
+            (0 != payloadSize && 1 != fwrite(payload.data(), payloadSize, 1, file))) {
+            ERROR("Error while writing a sort run\n");
+            return -1;
+        }
+        return 0;
+    }
+
+    bool ExternalSorter::readEntry(FILE *file, RidAndKey &entry) const {
+        RID rid;
+        if (1 != fread(&rid.pageNum, sizeof(rid.pageNum), 1, file) ||
+            1 != fread(&rid.slotNum, sizeof(rid.slotNum), 1, file)) {
+            return false;
+        }
+
+        // int and real keys are 4 bytes, varchar keys start with their 4 byte length
+        char keyPrefix[sizeof(uint32_t)];
+        if (1 != fread(keyPrefix, sizeof(keyPrefix), 1, file)) {
+            return false;
+        }
+        if (TypeVarChar != m_keyAttribute.type) {
+            entry = toEntry(keyPrefix, rid);
+        } else {
+            uint32_t keyLength;
+            memcpy(&keyLength, keyPrefix, sizeof(keyLength));
+
+            std::string stringKey(keyLength, '\0');
+            if (0 != keyLength && 1 != fread(&stringKey[0], keyLength, 1, file)) {
+                return false;
+            }
+            entry = RidAndKey(rid, stringKey);
+        }
+
+        uint16_t payloadSize;
+        if (1 != fread(&payloadSize, sizeof(payloadSize), 1, file)) {
+            return false;
+        }
+        std::string payload(payloadSize, '\0');
+        if (0 != payloadSize && 1 != fread(&payload[0], payloadSize, 1, file)) {
+            return false;
+        }
+        entry.setPayload(payload);
+        return true;
+    }
+
+    RC ExternalSorter::openMerge(const std::vector<std::string> &runFileNames) {
+        closeMerge();
+
+        for (auto &runFileName : runFileNames) {
+            FILE *file = fopen(runFileName.c_str(), "rb");
+            if (nullptr == file) {
+                ERROR("Error while opening the sort run file %s\n", runFileName.c_str());
+                return -1;
+            }
+
+            RidAndKey head(RID{0, 0}, 0);
+            if (!readEntry(file, head)) {
+                fclose(file);
+                continue;
+            }
+            m_mergeFiles.push_back(file);
+            m_mergeHeads.push_back(head);
+            m_mergeHeap.push_back(m_mergeFiles.size() - 1);
+        }
+
+        std::make_heap(m_mergeHeap.begin(), m_mergeHeap.end(), [this](unsigned a, unsigned b) {
+            return isLess(m_mergeHeads[b], m_mergeHeads[a]);
+        });
+        return 0;
+    }
+
+    bool ExternalSorter::nextMergedEntry(RidAndKey &entry) {
+        if (m_mergeHeap.empty()) {
+            return false;
+        }
+
+        auto heapOrder = [this](unsigned a, unsigned b) {
+            return isLess(m_mergeHeads[b], m_mergeHeads[a]);
+        };
+
+        std::pop_heap(m_mergeHeap.begin(), m_mergeHeap.end(), heapOrder);
+        unsigned run = m_mergeHeap.back();
+        m_mergeHeap.pop_back();
+
+        entry = m_mergeHeads[run];
+        if (readEntry(m_mergeFiles[run], m_mergeHeads[run])) {
+            m_mergeHeap.push_back(run);
+            std::push_heap(m_mergeHeap.begin(), m_mergeHeap.end(), heapOrder);
+        }
+        return true;
+    }
+
+    void ExternalSorter::closeMerge() {
+        for (auto file : m_mergeFiles) {
+            fclose(file);
+        }
+        m_mergeFiles.clear();
+        m_mergeHeads.clear();
+        m_mergeHeap.clear();
+    }
+
+    RC ExternalSorter::mergeRuns(unsigned count) {
+        std::vector<std::string> toMerge(m_runFileNames.begin(), m_runFileNames.begin() + count);
+        if (0 != openMerge(toMerge)) {
+            return -1;
+        }
+
+        std::string runFileName = m_runFilePrefix + ".run" + std::to_string(m_runsCreated++);
+        FILE *file = fopen(runFileName.c_str(), "wb");
+        if (nullptr == file) {
+            ERROR("Error while creating the sort run file %s\n", runFileName.c_str());
+            closeMerge();
+            return -1;
+        }
+
+        RC rc = 0;
+        RidAndKey entry(RID{0, 0}, 0);
+        while (0 == rc && nextMergedEntry(entry)) {
+            rc = writeEntry(file, entry);
+        }
+        fclose(file);
+        closeMerge();
+
+        for (auto &mergedRun : toMerge) {
+            remove(mergedRun.c_str());
+        }
+        m_runFileNames.erase(m_runFileNames.begin(), m_runFileNames.begin() + count);
+        m_runFileNames.push_back(runFileName);
+        return rc;
+    }
+} // namespace PeterDB
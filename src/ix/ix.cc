@@ -3,6 +3,8 @@
 #include "src/include/pageSerializer.h"
 #include "src/include/varcharSerDes.h"
 
+#include <algorithm>
+
 namespace PeterDB {
     IndexManager &IndexManager::instance() {
         static IndexManager _index_manager = IndexManager();
@@ -28,8 +30,18 @@ namespace PeterDB {
         return 0;
     }
 
-    RC IndexManager::destroyFile(const std::string &fileName) {
+    bool IndexManager::isIndexFile(const std::string &fileName) {
         if (m_indexesCreated.end() == m_indexesCreated.find(fileName)) {
+            if (!_pagedFileManager->fileExists(fileName)) {
+                return false;
+            }
+            m_indexesCreated[fileName] = true;
+        }
+        return true;
+    }
+
+    RC IndexManager::destroyFile(const std::string &fileName) {
+        if (!isIndexFile(fileName)) {
             return -1;
         }
 
@@ -42,7 +54,7 @@ namespace PeterDB {
     }
 
     RC IndexManager::openFile(const std::string &fileName, IXFileHandle &ixFileHandle) {
-        if (m_indexesCreated.end() == m_indexesCreated.find(fileName)) {
+        if (!isIndexFile(fileName)) {
             return -1;
         }
 
@@ -52,6 +64,9 @@ namespace PeterDB {
         }
 
         ixFileHandle._fileName = fileName;
+        ixFileHandle._rootPageNum = 0;
+        ixFileHandle._rootPageNumLoaded = false;
+        ixFileHandle._rootPageNumDirty = false;
         return 0;
     }
 
@@ -61,14 +76,30 @@ namespace PeterDB {
             return -1;
         }
 
+        if (0 != ixFileHandle.flushRootNodePtr()) {
+            return -1;
+        }
+
         if (0 != _pagedFileManager->closeFile(ixFileHandle._pfmFileHandle)) {
             return -1;
         }
 
         ixFileHandle._fileName = "";
+        ixFileHandle._cacheRootPageNum = false;
         return 0;
     }
 
+    RC IndexManager::flushFile(IXFileHandle &ixFileHandle) {
+        if ("" == ixFileHandle._fileName) {
+            return -1;
+        }
+
+        if (0 != ixFileHandle.flushRootNodePtr()) {
+            return -1;
+        }
+        return ixFileHandle._pfmFileHandle.flush();
+    }
+
     RidAndKey createEntryToInsert(const Attribute &attribute, const void *key, const RID &rid) {
         switch (attribute.type) {
             case TypeInt:
@@ -84,7 +115,14 @@ namespace PeterDB {
     }
 
     RC
-    IndexManager::insertEntry(IXFileHandle &ixFileHandle, const Attribute &attribute, const void *key, const RID &rid) {
+    IndexManager::insertEntry(IXFileHandle &ixFileHandle, const Attribute &attribute, const void *key, const RID &rid,
+                              const std::string &payload) {
+        if (payload.size() > IX_MAX_PAYLOAD_SIZE) {
+            ERROR("Payload of %zu bytes is larger than the %d bytes an index entry can carry\n",
+                  payload.size(), IX_MAX_PAYLOAD_SIZE);
+            return -1;
+        }
+
         // if dummy head is not created, create the head, and store the root node pointer
         if (0 == ixFileHandle._pfmFileHandle.getNextPageNum()) {
             void* data = malloc(PAGE_SIZE);
@@ -120,6 +158,7 @@ namespace PeterDB {
         }
 
         RidAndKey entryToInsert = createEntryToInsert(attribute, key, rid);
+        entryToInsert.setPayload(payload);
 
         PageNumAndKey newChild;
         if (0 != insertHelper(ixFileHandle, ixFileHandle._rootPageNum, entryToInsert, newChild)) {
@@ -213,17 +252,366 @@ namespace PeterDB {
             return -1;
         }
         if (rc == 0) {
-            // update freeByteCount
-            unsigned int oldFreeByteCount = leafPage.getFreeByteCount();
-            unsigned int newFreeByteCount = oldFreeByteCount + getKeySize(key, attribute);
-            leafPage.setFreeByteCount(newFreeByteCount);
-
+            // deleteFromPage has already given the space of the entry back
             assert(0 == writePageToDisk(ixFileHandle, leafPage, pageNum));
         }
         free(pageData);
         return rc;
     }
 
+    // guide entry pointing to the rightmost child of a non-leaf page, its key is never compared
+    PageNumAndKey lastGuideEntry(unsigned int pageNum, const AttrType &keyType) {
+        switch (keyType) {
+            case TypeInt:
+                return PageNumAndKey(pageNum, 0);
+            case TypeReal:
+                return PageNumAndKey(pageNum, float(0));
+            case TypeVarChar:
+                return PageNumAndKey(pageNum, "");
+        }
+        assert(0);
+        return PageNumAndKey();
+    }
+
+    // the first key of a page, pointing to that page
+    PageNumAndKey firstKeyOf(const RidAndKey &firstEntry, unsigned int pageNum, const AttrType &keyType) {
+        switch (keyType) {
+            case TypeInt:
+                return PageNumAndKey(pageNum, firstEntry.getIntKey());
+            case TypeReal:
+                return PageNumAndKey(pageNum, firstEntry.getFloatKey());
+            case TypeVarChar:
+                return PageNumAndKey(pageNum, firstEntry.getStringKey());
+        }
+        assert(0);
+        return PageNumAndKey();
+    }
+
+    RC IndexManager::bulkLoad(IXFileHandle &ixFileHandle, const Attribute &attribute, IX_EntryStream &sortedEntries,
+                              float fillFactor) {
+        if ("" == ixFileHandle._fileName ||
+            m_indexesCreated.end() == m_indexesCreated.find(ixFileHandle._fileName)) {
+            return -1;
+        }
+        if (0 != ixFileHandle._pfmFileHandle.getNextPageNum()) {
+            ERROR("Only an empty index can be bulk loaded, %s has entries\n", ixFileHandle._fileName.c_str());
+            return -1;
+        }
+        if (fillFactor <= 0 || fillFactor > 1) {
+            ERROR("Fill factor %f should be in (0, 1]\n", fillFactor);
+            return -1;
+        }
+
+        // dummy head, which stores the root node pointer
+        void* data = malloc(PAGE_SIZE);
+        assert(nullptr != data);
+        memset(data, 0, PAGE_SIZE);
+        if (0 != ixFileHandle._pfmFileHandle.appendPage(data)) {
+            free(data);
+            ERROR("Error while creating head node in index file %s\n", ixFileHandle._fileName.c_str());
+            return -1;
+        }
+
+        // 1) leaves, left to right. a leaf is only written once the next one is started,
+        // which is appended right after it
+        const unsigned int leafCapacity = LeafPage().getFreeByteCount();
+        std::vector<PageNumAndKey> children;    // first key of each page of the level just built
+        LeafPage leafPage;
+        leafPage.setKeyType(attribute.type);
+        LeafPage keyOrder;
+        keyOrder.setKeyType(attribute.type);
+
+        RID rid;
+        std::string payload;
+        while (IX_EOF != sortedEntries.getNextEntry(rid, data, payload)) {
+            if (payload.size() > IX_MAX_PAYLOAD_SIZE) {
+                ERROR("Payload of %zu bytes is larger than the %d bytes an index entry can carry\n",
+                      payload.size(), IX_MAX_PAYLOAD_SIZE);
+                free(data);
+                return -1;
+            }
+            RidAndKey entry = createEntryToInsert(attribute, data, rid);
+            entry.setPayload(payload);
+            std::vector<RidAndKey> &leafEntries = leafPage.getRidAndKeyPairs();
+
+            if (!leafEntries.empty() && keyOrder.compare(entry, leafEntries.back()) < 0) {
+                ERROR("Entries to bulk load into %s are not sorted\n", ixFileHandle._fileName.c_str());
+                free(data);
+                return -1;
+            }
+
+            unsigned int required = leafPage.getRequiredSpace(entry);
+            unsigned int used = leafCapacity - leafPage.getFreeByteCount();
+            if (!leafEntries.empty() && (!leafPage.canInsert(entry) || used + required > fillFactor * leafCapacity)) {
+                PageNum leafPageNum = ixFileHandle._pfmFileHandle.getNextPageNum();
+                leafPage.setNextPageNum(leafPageNum + 1);
+                children.push_back(firstKeyOf(leafEntries.front(), leafPageNum, attribute.type));
+                assert(0 == writePageToDisk(ixFileHandle, leafPage, -1 /* create page and insert */));
+
+                leafPage = LeafPage();
+                leafPage.setKeyType(attribute.type);
+            }
+
+            leafPage.getRidAndKeyPairs().push_back(entry);
+            leafPage.setFreeByteCount(leafPage.getFreeByteCount() - required);
+        }
+        free(data);
+
+        if (leafPage.getRidAndKeyPairs().empty()) {
+            // nothing to load, the root gets created by the first insertEntry
+            return 0;
+        }
+        PageNum leafPageNum = ixFileHandle._pfmFileHandle.getNextPageNum();
+        leafPage.setNextPageNum(-1);
+        children.push_back(firstKeyOf(leafPage.getRidAndKeyPairs().front(), leafPageNum, attribute.type));
+        assert(0 == writePageToDisk(ixFileHandle, leafPage, -1 /* create page and insert */));
+
+        // 2) non-leaf levels, until a level has a single page, the root.
+        // each guide entry points to a child, and holds the first key of the child after it
+        const unsigned int nonLeafCapacity = NonLeafPage().getFreeByteCount();
+        while (children.size() > 1) {
+            std::vector<PageNumAndKey> parents;
+            NonLeafPage node;
+            node.setKeyType(attribute.type);
+            PageNumAndKey nodeFirstKey;
+
+            for (auto &child : children) {
+                std::vector<PageNumAndKey> &guides = node.getPageNumAndKeys();
+                PageNumAndKey lastGuide = lastGuideEntry(child.getPageNum(), attribute.type);
+
+                if (guides.empty()) {
+                    nodeFirstKey = child;
+                    guides.push_back(lastGuide);
+                    continue;
+                }
+
+                // the previous last guide now gets a key, that of this child
+                PageNumAndKey keyedGuide = child;
+                keyedGuide.setPageNum(guides.back().getPageNum());
+                unsigned int used = nonLeafCapacity - node.getFreeByteCount();
+                unsigned int usedAfter = used - node.getRequiredSpace(guides.back())
+                                         + node.getRequiredSpace(keyedGuide) + node.getRequiredSpace(lastGuide);
+
+                if (usedAfter > fillFactor * nonLeafCapacity || usedAfter > nonLeafCapacity) {
+                    node.resetMetadata();
+                    nodeFirstKey.setPageNum(ixFileHandle._pfmFileHandle.getNextPageNum());
+                    parents.push_back(nodeFirstKey);
+                    assert(0 == writePageToDisk(ixFileHandle, node, -1 /* create page and insert */));
+
+                    node = NonLeafPage();
+                    node.setKeyType(attribute.type);
+                    nodeFirstKey = child;
+                    node.getPageNumAndKeys().push_back(lastGuide);
+                    node.resetMetadata();
+                    continue;
+                }
+
+                guides.back() = keyedGuide;
+                guides.push_back(lastGuide);
+                node.resetMetadata();
+            }
+
+            node.resetMetadata();
+            nodeFirstKey.setPageNum(ixFileHandle._pfmFileHandle.getNextPageNum());
+            parents.push_back(nodeFirstKey);
+            assert(0 == writePageToDisk(ixFileHandle, node, -1 /* create page and insert */));
+
+            children = parents;
+        }
+
+        ixFileHandle._rootPageNum = children.front().getPageNum();
+        ixFileHandle.writeRootNodePtrToDisk();
+        return 0;
+    }
+
+    std::vector<unsigned> IndexManager::sortEntries(const std::vector<RidAndKey> &entries, AttrType keyType) {
+        std::vector<unsigned> order(entries.size());
+        for (unsigned i = 0; i < order.size(); i++) {
+            order[i] = i;
+        }
+
+        LeafPage keyOrder;
+        keyOrder.setKeyType(keyType);
+        std::stable_sort(order.begin(), order.end(), [&](unsigned a, unsigned b) {
+            return keyOrder.compare(entries[a], entries[b]) < 0;
+        });
+        return order;
+    }
+
+    RC IndexManager::insertEntries(IXFileHandle &ixFileHandle, const Attribute &attribute,
+                                   const std::vector<const void *> &keys, const std::vector<RID> &rids,
+                                   const std::vector<std::string> &payloads) {
+        assert(keys.size() == rids.size());
+        assert(payloads.empty() || payloads.size() == keys.size());
+        if (1 == keys.size()) {
+            return insertEntry(ixFileHandle, attribute, keys[0], rids[0], payloads.empty() ? "" : payloads[0]);
+        }
+
+        std::vector<RidAndKey> entries;
+        entries.reserve(keys.size());
+        for (unsigned i = 0; i < keys.size(); i++) {
+            entries.push_back(createEntryToInsert(attribute, keys[i], rids[i]));
+            if (!payloads.empty()) {
+                if (payloads[i].size() > IX_MAX_PAYLOAD_SIZE) {
+                    ERROR("Payload of %zu bytes is larger than the %d bytes an index entry can carry\n",
+                          payloads[i].size(), IX_MAX_PAYLOAD_SIZE);
+                    return -1;
+                }
+                entries.back().setPayload(payloads[i]);
+            }
+        }
+        std::vector<unsigned> order = sortEntries(entries, attribute.type);
+
+        void *pageData = malloc(PAGE_SIZE);
+        assert(nullptr != pageData);
+
+        unsigned next = 0;
+        while (next < order.size()) {
+            if (0 != ixFileHandle._pfmFileHandle.getNextPageNum()) {
+                ixFileHandle.fetchRootNodePtrFromDisk();
+            }
+            if (0 == ixFileHandle._pfmFileHandle.getNextPageNum() || 0 == ixFileHandle._rootPageNum) {
+                // the first entry creates the tree
+                if (0 != insertEntry(ixFileHandle, attribute, keys[order[next]], rids[order[next]],
+                                     entries[order[next]].getPayload())) {
+                    free(pageData);
+                    return -1;
+                }
+                next++;
+                continue;
+            }
+
+            // find the leaf of the next entry, remembering the path to it
+            std::vector<NonLeafPage> path;
+            std::vector<PageNum> pathChildren;
+            PageNum pageNum = ixFileHandle._rootPageNum;
+            loadPage(pageNum, pageData, ixFileHandle);
+            while (!PageDeserializer::isLeafPage(pageData)) {
+                NonLeafPage nonLeafPage;
+                PageDeserializer::toNonLeafPage(pageData, nonLeafPage);
+                pageNum = nonLeafPage.findNextPage(entries[order[next]]);
+                path.push_back(nonLeafPage);
+                pathChildren.push_back(pageNum);
+                loadPage(pageNum, pageData, ixFileHandle);
+            }
+
+            LeafPage leafPage;
+            PageDeserializer::toLeafPage(pageData, leafPage);
+
+            // add the following entries too, as long as they belong to the same leaf and fit into it
+            unsigned added = 0;
+            while (next < order.size()) {
+                const RidAndKey &entry = entries[order[next]];
+                bool sameLeaf = true;
+                for (unsigned level = 0; level < path.size() && sameLeaf; level++) {
+                    sameLeaf = (pathChildren[level] == (PageNum) path[level].findNextPage(entry));
+                }
+                if (!sameLeaf || !leafPage.canInsert(entry)) {
+                    break;
+                }
+                leafPage.insertEntry(entry, false);
+                added++;
+                next++;
+            }
+
+            if (0 != added) {
+                assert(0 == writePageToDisk(ixFileHandle, leafPage, pageNum));
+                continue;
+            }
+
+            // the leaf is full, it gets split on the single entry path
+            if (0 != insertEntry(ixFileHandle, attribute, keys[order[next]], rids[order[next]],
+                                 entries[order[next]].getPayload())) {
+                free(pageData);
+                return -1;
+            }
+            next++;
+        }
+
+        free(pageData);
+        return 0;
+    }
+
+    RC IndexManager::deleteEntries(IXFileHandle &ixFileHandle, const Attribute &attribute,
+                                   const std::vector<const void *> &keys, const std::vector<RID> &rids) {
+        assert(keys.size() == rids.size());
+        if (1 == keys.size()) {
+            return deleteEntry(ixFileHandle, attribute, keys[0], rids[0]);
+        }
+        if (0 == ixFileHandle._pfmFileHandle.getNextPageNum()) {
+            return keys.empty() ? 0 : -1;
+        }
+
+        std::vector<RidAndKey> entries;
+        entries.reserve(keys.size());
+        for (unsigned i = 0; i < keys.size(); i++) {
+            entries.push_back(createEntryToInsert(attribute, keys[i], rids[i]));
+        }
+        std::vector<unsigned> order = sortEntries(entries, attribute.type);
+
+        void *pageData = malloc(PAGE_SIZE);
+        assert(nullptr != pageData);
+
+        RC rc = 0;
+        unsigned next = 0;
+        while (next < order.size()) {
+            ixFileHandle.fetchRootNodePtrFromDisk();
+
+            // find the leaf of the next entry, remembering the path to it
+            std::vector<NonLeafPage> path;
+            std::vector<PageNum> pathChildren;
+            PageNum pageNum = ixFileHandle._rootPageNum;
+            loadPage(pageNum, pageData, ixFileHandle);
+            while (!PageDeserializer::isLeafPage(pageData)) {
+                NonLeafPage nonLeafPage;
+                PageDeserializer::toNonLeafPage(pageData, nonLeafPage);
+                pageNum = getLowerLevelNode(keys[order[next]], attribute, nonLeafPage);
+                path.push_back(nonLeafPage);
+                pathChildren.push_back(pageNum);
+                loadPage(pageNum, pageData, ixFileHandle);
+            }
+
+            LeafPage leafPage;
+            PageDeserializer::toLeafPage(pageData, leafPage);
+
+            // delete the following entries too, as long as they are found in the same leaf
+            unsigned deleted = 0;
+            while (next < order.size()) {
+                const void *key = keys[order[next]];
+                bool sameLeaf = true;
+                for (unsigned level = 0; level < path.size() && sameLeaf; level++) {
+                    sameLeaf = (pathChildren[level] == getLowerLevelNode(key, attribute, path[level]));
+                }
+                if (!sameLeaf) {
+                    break;
+                }
+
+                bool continueToNextPage = false;
+                if (0 != deleteFromPage(key, rids[order[next]], attribute, leafPage, continueToNextPage) ||
+                    continueToNextPage) {
+                    // not in this leaf, it may be in one of the next ones (duplicate keys)
+                    break;
+                }
+                deleted++;
+                next++;
+            }
+
+            if (0 != deleted) {
+                assert(0 == writePageToDisk(ixFileHandle, leafPage, pageNum));
+                continue;
+            }
+
+            // follow the single entry path, which also looks into the next leaves
+            if (0 != deleteEntry(ixFileHandle, attribute, keys[order[next]], rids[order[next]])) {
+                rc = -1;
+            }
+            next++;
+        }
+
+        free(pageData);
+        return rc;
+    }
+
     void IndexManager::writePage(const void *pageData, unsigned int pageNum,
                                  IXFileHandle &ixFileHandle) const {
         ixFileHandle._pfmFileHandle.writePage(pageNum, pageData);
@@ -254,10 +642,23 @@ namespace PeterDB {
                 PAGE_SIZE); //todo: migrate to class member, perhaps Suhas has done this already, so wait for his commits
         unsigned int pageNum;
 
+        // an index gets its root with its first entry, until then (e.g. created on an empty table) there's
+        // nothing to scan
+        if (0 == ixFileHandle._pfmFileHandle.getNextPageNum()) {
+            free(pageData);
+            ix_ScanIterator.initEmpty(&ixFileHandle);
+            return 0;
+        }
+
         //todo:
         // 1) get root pageNum and load the root page
         ixFileHandle.fetchRootNodePtrFromDisk();
         pageNum = ixFileHandle._rootPageNum;
+        if (0 == pageNum) {
+            free(pageData);
+            ix_ScanIterator.initEmpty(&ixFileHandle);
+            return 0;
+        }
         loadPage(pageNum, pageData, ixFileHandle);
 
         // 2) recursively search for the leaf node that should contain the given lowKey
@@ -298,7 +699,11 @@ namespace PeterDB {
     IndexManager::getLowerLevelNode(const void *searchKey, const Attribute &attribute, const void* pageData) {
         NonLeafPage nonLeafPage;
         PageDeserializer::toNonLeafPage(pageData, nonLeafPage);
+        return getLowerLevelNode(searchKey, attribute, nonLeafPage);
+    }
 
+    unsigned int
+    IndexManager::getLowerLevelNode(const void *searchKey, const Attribute &attribute, NonLeafPage &nonLeafPage) {
         std::vector<PageNumAndKey> &pageNumAndKeyPairs = nonLeafPage.getPageNumAndKeys();
         if (searchKey == nullptr) {
             // scenario used by scan() (searchKey = null implies traverse to the leftmost leafNode
@@ -325,7 +730,9 @@ namespace PeterDB {
             continueToNextPage = true;
             return 0;
         }
-        else if (keyCompare(targetKey, targetRid, targetKeyAttribute.type, ridAndKeyPairs[numEntries-1]) == 0) {
+        else if (keyCompare(targetKey, targetKeyAttribute.type, ridAndKeyPairs[numEntries-1]) >= 0) {
+            // a key equal to the one separating this leaf from the next one lives in the next leaf
+            // (inserts go right of the separator), and duplicates of a key can span leaves
             continueToNextPage = true;
         }
 
@@ -389,7 +796,7 @@ namespace PeterDB {
             case TypeVarChar: {
                 const std::string keyA = VarcharSerDes::deserialize(searchKey);
                 const std::string& keyB = pageNumAndKeyPair.getStringKey();
-                return strcmp(keyA.data(), keyB.data());
+                return keyA.compare(keyB);
             }
             default:
                 ERROR("Unhandled Attribute type");
@@ -451,7 +858,7 @@ namespace PeterDB {
             case TypeVarChar: {
                 const std::string keyA = VarcharSerDes::deserialize(searchKey);
                 const std::string &keyB = ridAndKeyPair.getStringKey();
-                int strCmpResult = strcmp(keyA.data(), keyB.data());
+                int strCmpResult = keyA.compare(keyB);
                 if (strCmpResult == 0) {
                     return (doRidsMatch) ? 0 : -1;
                 } else {
@@ -521,6 +928,7 @@ namespace PeterDB {
         if (isWithinRange(nextRidAndKey)) {
             // return the next record
             copy(rid, key, nextRidAndKey);
+            _payload = nextRidAndKey.getPayload();
             _nextElementPositionOnPage++;
         } else {
             // else return IX EOF
@@ -530,6 +938,10 @@ namespace PeterDB {
         return 0;
     }
 
+    const std::string &IX_ScanIterator::getPayload() const {
+        return _payload;
+    }
+
     RC IX_ScanIterator::close() {
         return 0;
     }
@@ -557,6 +969,14 @@ namespace PeterDB {
         _nextElementPositionOnPage = getIndex(_currentLeafPage, startKey, shouldIncludeStartKey, _keyType);
     }
 
+    void IX_ScanIterator::initEmpty(IXFileHandle *ixFileHandle) {
+        _ixFileHandle = ixFileHandle;
+        _endKey = nullptr;
+        _currentLeafPage = LeafPage();
+        _nextElementPositionOnPage = 0;
+        _currentPageKeysCount = 0;
+    }
+
     void IX_ScanIterator::copyEndKey(const void *endKey, const Attribute &keyAttribute) {
         if (endKey == nullptr) {
             _endKey = nullptr;
@@ -629,7 +1049,8 @@ namespace PeterDB {
                 return index;
             }
         }
-        assert(1);
+        // every key of the leaf (if any are left) is below the search key, the scan goes on with the next leaf
+        return leafPage.getRidAndKeyPairs().size();
     }
 
     bool IX_ScanIterator::wasPreviouslyReturnedEntryDeleted() {
@@ -656,6 +1077,10 @@ IXFileHandle::~IXFileHandle() {
     }
 
     void IXFileHandle::fetchRootNodePtrFromDisk() {
+        if (_cacheRootPageNum && _rootPageNumLoaded) {
+            return;
+        }
+
         // read page 0 (page 0 is always the page in which we store the
         // page number of the root node of the b+ tree index)
         void* data = malloc(PAGE_SIZE);
@@ -670,10 +1095,17 @@ IXFileHandle::~IXFileHandle() {
         }
 
         _rootPageNum = *( (unsigned int*) data);
+        _rootPageNumLoaded = true;
         free(data);
     }
 
     void IXFileHandle::writeRootNodePtrToDisk() {
+        _rootPageNumLoaded = true;
+        if (_cacheRootPageNum) {
+            _rootPageNumDirty = true;
+            return;
+        }
+
         void* data = malloc(PAGE_SIZE);
         assert(nullptr != data);
         memset(data, 0, PAGE_SIZE);
@@ -689,6 +1121,32 @@ IXFileHandle::~IXFileHandle() {
         free(data);
     }
 
+    void IXFileHandle::cacheRootPageNum() {
+        _cacheRootPageNum = true;
+    }
+
+    RC IXFileHandle::flushRootNodePtr() {
+        if (!_rootPageNumDirty) {
+            return 0;
+        }
+
+        void* data = malloc(PAGE_SIZE);
+        assert(nullptr != data);
+        memset(data, 0, PAGE_SIZE);
+
+        memmove(data, &_rootPageNum, sizeof(unsigned int));
+
+        if (0 != _pfmFileHandle.writePage(0, data)) {
+            ERROR("Error while writing Head pointer of the index file %s\n", _fileName.c_str());
+            free(data);
+            return -1;
+        }
+        free(data);
+
+        _rootPageNumDirty = false;
+        return 0;
+    }
+
     template<typename T>
     RC IndexManager::writePageToDisk(IXFileHandle& fileHandle, T& page, int pageNum) {
         void* data = malloc(PAGE_SIZE);
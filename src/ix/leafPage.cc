@@ -22,8 +22,9 @@ namespace PeterDB {
     RidAndKey& RidAndKey::operator=(const RidAndKey& other) {
         _rid = other.getRid();
         _intKey = other.getIntKey();
-        _floatKey = other.getIntKey();
+        _floatKey = other.getFloatKey();
         _stringKey = other.getStringKey();
+        _payload = other.getPayload();
         return *this;
     }
 
@@ -43,6 +44,14 @@ namespace PeterDB {
         return _stringKey;
     }
 
+    const std::string& RidAndKey::getPayload() const {
+        return _payload;
+    }
+
+    void RidAndKey::setPayload(const std::string &payload) {
+        _payload = payload;
+    }
+
     /*
      * To be used to create a fresh leafPage in-memory
      */
@@ -123,6 +132,9 @@ namespace PeterDB {
             default:
                 assert(0);
         }
+        if (!entry.getPayload().empty()) {
+            reqSpace += PageSerDesConstants::PAYLOAD_LENGTH_VAR_SIZE + entry.getPayload().size();
+        }
         return reqSpace;
     }
 
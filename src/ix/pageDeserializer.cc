@@ -32,7 +32,7 @@ namespace PeterDB {
         leafPage.setNextPageNum(readNextPageNum(data));
 
         unsigned int numKeys = readNumKeys(data);
-        readKeyAndRidPairs(leafPage, data, numKeys);
+        readKeyAndRidPairs(leafPage, data, numKeys, hasPayload(data));
     }
 
     unsigned int PageDeserializer::readFreeByteCount(const void *data) {
@@ -50,10 +50,20 @@ namespace PeterDB {
         memcpy((void *) &keyType,
                (void *) readPtr,
                PageSerDesConstants::KEY_TYPE_VAR_SIZE);
+        keyType &= ~PageSerDesConstants::HAS_PAYLOAD_FLAG;
         assert(0 <= keyType && keyType <= 2);
         return static_cast<AttrType>(keyType);
     }
 
+    bool PageDeserializer::hasPayload(const void *data) {
+        int keyType;
+        byte *readPtr = (byte *) data + PageSerDesConstants::KEY_TYPE_OFFSET;
+        memcpy((void *) &keyType,
+               (void *) readPtr,
+               PageSerDesConstants::KEY_TYPE_VAR_SIZE);
+        return 0 != (keyType & PageSerDesConstants::HAS_PAYLOAD_FLAG);
+    }
+
     int PageDeserializer::readNextPageNum(const void *data) {
         int nextPageNum;
         byte *readPtr = (byte *) data + PageSerDesConstants::NEXT_PAGE_NUM_OFFSET;
@@ -125,7 +135,8 @@ namespace PeterDB {
         }
     }
 
-    void PageDeserializer::readKeyAndRidPairs(LeafPage &leafPage, const void *data, unsigned int numKeys) {
+    void PageDeserializer::readKeyAndRidPairs(LeafPage &leafPage, const void *data, unsigned int numKeys,
+                                              bool hasPayload) {
         byte *readPtr = (byte *) data;
         const size_t ridSize = sizeof(RID);
 
@@ -175,6 +186,15 @@ namespace PeterDB {
                     ERROR("Illegal Attribute type");
                     assert(1);
             }
+
+            // read payload from file
+            if (hasPayload) {
+                uint16_t payloadSize;
+                memcpy((void *) &payloadSize, (void *) readPtr, PageSerDesConstants::PAYLOAD_LENGTH_VAR_SIZE);
+                readPtr += PageSerDesConstants::PAYLOAD_LENGTH_VAR_SIZE;
+                leafPage.getRidAndKeyPairs().back().setPayload(std::string((const char *) readPtr, payloadSize));
+                readPtr += payloadSize;
+            }
         }
     }
 }
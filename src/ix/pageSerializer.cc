@@ -17,13 +17,18 @@ namespace PeterDB {
     }
 
     void PageSerializer::toBytes(LeafPage &leafPage, void *data) {
+        bool hasPayload = false;
+        for (const auto &ridAndKeyPair: leafPage.getRidAndKeyPairs()) {
+            hasPayload = hasPayload || !ridAndKeyPair.getPayload().empty();
+        }
+
         writeFreeByteCount(leafPage.getFreeByteCount(), data);
         writeIsLeafPage(true, data);
-        writeKeyType(leafPage.getKeyType(), data);
+        writeKeyType(leafPage.getKeyType() | (hasPayload ? PageSerDesConstants::HAS_PAYLOAD_FLAG : 0), data);
         writeNextPageNum(leafPage.getNextPageNum(), data);
         writeNumKeys(leafPage.getNumKeys(), data);
 
-        writeKeyAndRidPair(leafPage, data);
+        writeKeyAndRidPair(leafPage, hasPayload, data);
     }
 
     void PageSerializer::writeFreeByteCount(const unsigned int freeByteCount, const void *data) {
@@ -102,7 +107,7 @@ namespace PeterDB {
         }
     }
 
-    void PageSerializer::writeKeyAndRidPair(LeafPage &leafPage, void *data) {
+    void PageSerializer::writeKeyAndRidPair(LeafPage &leafPage, bool hasPayload, void *data) {
         byte *writePtr = (byte *) data;
         const size_t ridSize = sizeof(RID);
 
@@ -139,6 +144,16 @@ namespace PeterDB {
                     ERROR("Illegal Attribute type");
                     assert(1);
             }
+
+            // write payload to file
+            if (hasPayload) {
+                const std::string &payload = ridAndKeyPair.getPayload();
+                const uint16_t payloadSize = payload.size();
+                memcpy((void *) writePtr, (void *) &payloadSize, PageSerDesConstants::PAYLOAD_LENGTH_VAR_SIZE);
+                writePtr += PageSerDesConstants::PAYLOAD_LENGTH_VAR_SIZE;
+                memcpy((void *) writePtr, (void *) payload.data(), payloadSize);
+                writePtr += payloadSize;
+            }
         }
     }
 }
@@ -1,6 +1,9 @@
 #include "src/include/pfm.h"
 #include "src/include/util.h"
+#include "src/include/wal.h"
 
+#include <algorithm>
+#include <cerrno>
 #include <cstring>
 
 namespace PeterDB {
@@ -13,13 +16,189 @@ namespace PeterDB {
 
     PagedFileManager::~PagedFileManager() = default;
 
-    PagedFileManager::PagedFileManager(const PagedFileManager &) = default;
+    RC MemoryFile::readPage(unsigned physicalPage, void *data) {
+        std::lock_guard<std::mutex> guard(m_latch);
+        if (physicalPage >= m_pageCount) {
+            return -1;
+        }
+        memcpy(data, m_chunks[physicalPage / MEMORY_FILE_CHUNK_PAGES].get() +
+                     (size_t) PAGE_SIZE * (physicalPage % MEMORY_FILE_CHUNK_PAGES), PAGE_SIZE);
+        return 0;
+    }
+
+    RC MemoryFile::writePage(unsigned physicalPage, const void *data) {
+        std::lock_guard<std::mutex> guard(m_latch);
+        if (physicalPage > m_pageCount) {
+            return -1;
+        }
+        if (physicalPage == m_pageCount) {
+            if (0 == m_pageCount % MEMORY_FILE_CHUNK_PAGES) {
+                m_chunks.emplace_back(new char[(size_t) PAGE_SIZE * MEMORY_FILE_CHUNK_PAGES]);
+            }
+            m_pageCount++;
+        }
+        memcpy(m_chunks[physicalPage / MEMORY_FILE_CHUNK_PAGES].get() +
+               (size_t) PAGE_SIZE * (physicalPage % MEMORY_FILE_CHUNK_PAGES), data, PAGE_SIZE);
+        return 0;
+    }
+
+    unsigned MemoryFile::getNumberOfPages() {
+        std::lock_guard<std::mutex> guard(m_latch);
+        return m_pageCount;
+    }
+
+    bool PagedFileManager::isMemoryFile(const std::string &fileName) {
+        return 0 == fileName.compare(0, strlen(MEMORY_FILE_PREFIX), MEMORY_FILE_PREFIX);
+    }
+
+    std::string PagedFileManager::memoryFileName(const std::string &fileName) {
+        return isMemoryFile(fileName) ? fileName : MEMORY_FILE_PREFIX + fileName;
+    }
+
+    std::shared_ptr<MemoryFile> PagedFileManager::getMemoryFile(const std::string &fileName) {
+        std::lock_guard<std::mutex> guard(m_memoryFilesLatch);
+        auto it = m_memoryFiles.find(fileName);
+        return m_memoryFiles.end() == it ? nullptr : it->second;
+    }
+
+    bool PagedFileManager::fileExists(const std::string &fileName) {
+        return isMemoryFile(fileName) ? nullptr != getMemoryFile(fileName) : file_exists(getPath(fileName));
+    }
+
+    RC PagedFileManager::setTablespace(const std::string &tablespace, const std::vector<std::string> &directories) {
+        if (tablespace.empty() || std::string::npos != tablespace.find('/') || directories.empty()) {
+            ERROR("PagedFileManager::setTablespace - invalid tablespace '%s'", tablespace.c_str());
+            return -1;
+        }
+        std::lock_guard<std::mutex> guard(m_tablespacesLatch);
+        m_tablespaces[tablespace] = directories;
+        return 0;
+    }
+
+    void PagedFileManager::removeTablespace(const std::string &tablespace) {
+        std::lock_guard<std::mutex> guard(m_tablespacesLatch);
+        m_tablespaces.erase(tablespace);
+    }
+
+    bool PagedFileManager::hasTablespace(const std::string &tablespace) {
+        std::lock_guard<std::mutex> guard(m_tablespacesLatch);
+        return m_tablespaces.end() != m_tablespaces.find(tablespace);
+    }
+
+    bool PagedFileManager::isTablespaceFile(const std::string &fileName) {
+        return 0 == fileName.compare(0, strlen(TABLESPACE_FILE_PREFIX), TABLESPACE_FILE_PREFIX) &&
+               std::string::npos != fileName.find('/');
+    }
+
+    std::string PagedFileManager::tablespaceOf(const std::string &fileName) {
+        if (!isTablespaceFile(fileName)) {
+            return "";
+        }
+        size_t prefixLength = strlen(TABLESPACE_FILE_PREFIX);
+        return fileName.substr(prefixLength, fileName.find('/') - prefixLength);
+    }
+
+    std::string PagedFileManager::tablespaceFileName(const std::string &tablespace, const std::string &fileName) {
+        std::string name = isTablespaceFile(fileName) ? fileName.substr(fileName.find('/') + 1) : fileName;
+        return tablespace.empty() ? name : TABLESPACE_FILE_PREFIX + tablespace + "/" + name;
+    }
+
+    std::string PagedFileManager::getPath(const std::string &fileName) {
+        return getPath(fileName, 0);
+    }
+
+    std::string PagedFileManager::getPath(const std::string &fileName, unsigned directory) {
+        if (!isTablespaceFile(fileName)) {
+            return fileName;
+        }
+        std::lock_guard<std::mutex> guard(m_tablespacesLatch);
+        auto tablespace = m_tablespaces.find(tablespaceOf(fileName));
+        if (m_tablespaces.end() == tablespace || directory >= tablespace->second.size()) {
+            return fileName;
+        }
+        return tablespace->second[directory] + "/" + fileName.substr(fileName.find('/') + 1);
+    }
 
-    PagedFileManager &PagedFileManager::operator=(const PagedFileManager &) = default;
+    // the stripes a header page names, none for files which are not striped (see FileHandle::writeMetadataToDisk())
+    static void readStripes(const unsigned *metadata, unsigned &extentPages, std::vector<std::string> &stripePaths) {
+        extentPages = metadata[6];
+        stripePaths.clear();
+        const char *name = (const char *) (metadata + 7);
+        const char *end = (const char *) metadata + PAGE_SIZE;
+        for (unsigned i = 0; i < metadata[5] && name < end; i++) {
+            stripePaths.push_back(std::string(name, strnlen(name, end - name)));
+            name += stripePaths.back().size() + 1;
+        }
+    }
+
+    RC PagedFileManager::createStripedFile(const std::string &fileName, unsigned extentPages) {
+        std::vector<std::string> stripePaths;
+        unsigned directoryCount = 0;
+        if (isTablespaceFile(fileName)) {
+            std::lock_guard<std::mutex> guard(m_tablespacesLatch);
+            auto tablespace = m_tablespaces.find(tablespaceOf(fileName));
+            directoryCount = m_tablespaces.end() == tablespace ? 0 : tablespace->second.size();
+        }
+        size_t namesLength = 0;
+        for (unsigned i = 0; i < directoryCount; i++) {
+            stripePaths.push_back(getPath(fileName, i) + STRIPE_FILE_SUFFIX + std::to_string(i));
+            namesLength += stripePaths.back().size() + 1;
+        }
+        if (stripePaths.empty() || 0 == extentPages || namesLength > PAGE_SIZE - 7 * sizeof(unsigned)) {
+            ERROR("PagedFileManager::createStripedFile - file '%s' can't be striped", fileName.c_str());
+            return -1;
+        }
+        for (auto &stripePath : stripePaths) {
+            if (file_exists(stripePath)) {
+                ERROR("PagedFileManager::createStripedFile - file '%s' already exists", stripePath.c_str());
+                return -1;
+            }
+        }
+
+        if (0 != createFile(fileName)) {
+            return -1;
+        }
+        WriteAheadLog &wal = WriteAheadLog::instance();
+        for (unsigned i = 0; i < stripePaths.size(); i++) {
+            FILE *fstream = fopen(stripePaths[i].c_str(), "wb+");
+            if (nullptr == fstream || 0 != fclose(fstream)) {
+                ERROR("PagedFileManager::createStripedFile - error while creating file '%s'", stripePaths[i].c_str());
+                while (i-- > 0) {
+                    file_delete(stripePaths[i]);
+                }
+                destroyFile(fileName);
+                return -1;
+            }
+            if (wal.isOpen()) {
+                wal.logCreateFile(stripePaths[i]);
+            }
+        }
+
+        // the header, written as the file is first opened, names the stripes
+        FileHandle fileHandle;
+        fileHandle.setFileName(fileName);
+        fileHandle.m_stripePaths = stripePaths;
+        fileHandle.m_extentPages = extentPages;
+        if (0 != fileHandle.openFile()) {
+            return -1;
+        }
+        return fileHandle.closeFile();
+    }
 
     RC PagedFileManager::createFile(const std::string &fileName) {
+        if (isMemoryFile(fileName)) {
+            std::lock_guard<std::mutex> guard(m_memoryFilesLatch);
+            if (m_memoryFiles.end() != m_memoryFiles.find(fileName)) {
+                ERROR("PagedFileManager::createFile - file '%s' already exists", fileName.c_str());
+                return -1;
+            }
+            m_memoryFiles[fileName] = std::make_shared<MemoryFile>();
+            return 0;
+        }
+
         // check if the file with the same name is already present
-        if (file_exists(fileName)) {
+        std::string path = getPath(fileName);
+        if (file_exists(path)) {
             ERROR("PagedFileManager::createFile - file '%s' already exists", fileName.c_str());
             return -1;
         }
@@ -29,7 +208,7 @@ namespace PeterDB {
             return -1;
         }
 
-        FILE *fstream = fopen(fileName.c_str(), "wb+");
+        FILE *fstream = fopen(path.c_str(), "wb+");
         if (nullptr == fstream) {
             ERROR("PagedFileManager::createFile - error while creating file '%s'", fileName.c_str());
             return -1;
@@ -41,16 +220,41 @@ namespace PeterDB {
         }
 
         m_createdFilenames.insert(fileName);
+
+        WriteAheadLog &wal = WriteAheadLog::instance();
+        if (wal.isOpen()) {
+            wal.logCreateFile(path);
+        }
         return 0;
     }
 
     RC PagedFileManager::destroyFile(const std::string &fileName) {
+        if (isMemoryFile(fileName)) {
+            // handles still open keep the pages until they're closed
+            std::lock_guard<std::mutex> guard(m_memoryFilesLatch);
+            return 0 == m_memoryFiles.erase(fileName) ? -1 : 0;
+        }
+
         m_createdFilenames.erase(fileName);
 
-        if (!file_exists(fileName)) {
+        std::string path = getPath(fileName);
+        if (!file_exists(path)) {
             return -1;
         }
-        file_delete(fileName);
+
+        // the stripes of a striped file go along with it
+        std::vector<std::string> paths;
+        FileHandle::readStripePaths(path, paths);
+        paths.push_back(path);
+
+        // redo must not bring back the pages logged for the files
+        WriteAheadLog &wal = WriteAheadLog::instance();
+        for (auto &filePath : paths) {
+            if (wal.isOpen() && 0 != wal.flush(wal.logDestroyFile(filePath))) {
+                return -1;
+            }
+            file_delete(filePath);
+        }
         return 0;
     }
 
@@ -78,10 +282,29 @@ namespace PeterDB {
         appendPageCounter = 0;
     }
 
+    FileHandle::FileHandle(const FileHandle &other) {
+        *this = other;
+    }
+
+    FileHandle &FileHandle::operator=(const FileHandle &other) {
+        readPageCounter = other.readPageCounter.load();
+        writePageCounter = other.writePageCounter.load();
+        appendPageCounter = other.appendPageCounter.load();
+        m_fstream = other.m_fstream;
+        m_memoryFile = other.m_memoryFile;
+        m_fileName = other.m_fileName;
+        m_path = other.m_path;
+        hiddenPagesFromUpperLayer = other.hiddenPagesFromUpperLayer;
+        m_stripes = other.m_stripes;
+        m_stripePaths = other.m_stripePaths;
+        m_extentPages = other.m_extentPages;
+        return *this;
+    }
+
     FileHandle::~FileHandle() = default;
 
     bool FileHandle::isActive() {
-        return (nullptr != m_fstream);
+        return nullptr != m_fstream || nullptr != m_memoryFile;
     }
 
     std::string FileHandle::getFileName() {
@@ -96,23 +319,19 @@ namespace PeterDB {
         void *data = malloc(PAGE_SIZE);
         memset(data, 0, PAGE_SIZE);
 
-        if (0 != fseek(m_fstream, 0, SEEK_SET)) {
-            free(data);
-            ERROR("FileHandle::loadMetadataFromDisk - Error while seeking to start of the file. err - %s\n", std::strerror(ferror(m_fstream)));
-            return;
-        }
-        if (1 != fread(data, PAGE_SIZE, 1, m_fstream)) {
+        if (0 != readPhysicalPage(0, data)) {
             free(data);
-            ERROR("FileHandle::loadMetadataFromDisk - Error while reading metadata. err - %s\n", std::strerror(ferror(m_fstream)));
+            ERROR("FileHandle::loadMetadataFromDisk - Error while reading metadata of file '%s'\n", m_fileName.c_str());
             return;
         }
 
         unsigned *metadata = (unsigned *) data;
-        if (metadata[0] == (metadata[1] ^ metadata[2] ^ metadata[3] ^ metadata[4])) {
+        if (metadata[0] == (metadata[1] ^ metadata[2] ^ metadata[3] ^ metadata[4] ^ metadata[5] ^ metadata[6])) {
             readPageCounter = metadata[1];
             writePageCounter = metadata[2];
             appendPageCounter = metadata[3];
             hiddenPagesFromUpperLayer = metadata[4];
+            readStripes(metadata, m_extentPages, m_stripePaths);
         } else {
             ERROR("Error while reading metadata\n");
         }
@@ -127,46 +346,90 @@ namespace PeterDB {
         data[3] = appendPageCounter;
         data[4] = hiddenPagesFromUpperLayer;
 
-        data[0] = (data[1] ^ data[2] ^ data[3] ^ data[4]);
-
-        if (0 != fseek(m_fstream, 0, SEEK_SET)) {
-            ERROR("FileHandle::writeMetadataToDisk - Error while seeking to start of the file. err - %s\n", std::strerror(ferror(m_fstream)));
-            free(data);
-            return;
+        // striped files: the number of stripes, the pages of an extent, then the stripe names one after the other
+        data[5] = m_stripePaths.size();
+        data[6] = m_extentPages;
+        char *name = (char *) (data + 7);
+        for (auto &stripePath : m_stripePaths) {
+            memcpy(name, stripePath.c_str(), stripePath.size() + 1);
+            name += stripePath.size() + 1;
         }
-        if (1 != fwrite(data, PAGE_SIZE, 1, m_fstream)) {
-            ERROR("FileHandle::writeMetadataToDisk - Error while writing metadata - %s\n", std::strerror(ferror(m_fstream)));
-            free(data);
-            return;
+
+        data[0] = (data[1] ^ data[2] ^ data[3] ^ data[4] ^ data[5] ^ data[6]);
+
+        if (0 != writePhysicalPage(0, data)) {
+            ERROR("FileHandle::writeMetadataToDisk - Error while writing metadata of file '%s'\n", m_fileName.c_str());
         }
         free(data);
     }
 
     RC FileHandle::openFile() {
         assert(0 != m_fileName.length());
-        assert(nullptr == m_fstream);
+        assert(!isActive());
+
+        if (PagedFileManager::isMemoryFile(m_fileName)) {
+            m_memoryFile = PagedFileManager::instance().getMemoryFile(m_fileName);
+            if (nullptr == m_memoryFile) {
+                ERROR("FileHandle::openFile - unable to open file '%s'", m_fileName.c_str());
+                return -1;
+            }
+            if (0 == m_memoryFile->getNumberOfPages()) {
+                writeMetadataToDisk();
+            }
+            loadMetadataFromDisk();
+            return 0;
+        }
 
-        m_fstream = fopen(m_fileName.c_str(), "rb+");
+        m_path = PagedFileManager::instance().getPath(m_fileName);
+        m_fstream = fopen(m_path.c_str(), "rb+");
         if (nullptr == m_fstream) {
             ERROR("FileHandle::openFile - unable to open file '%s'", m_fileName.c_str());
             return -1;
         }
 
-        if (0 == file_size(m_fileName)) {
+        // a new file, unless its header is still only in the log
+        if (0 == file_size(m_path) && !WriteAheadLog::instance().holdsPage(m_path, 0)) {
             writeMetadataToDisk();
         }
         loadMetadataFromDisk();
 
+        for (auto &stripePath : m_stripePaths) {
+            FILE *stripe = fopen(stripePath.c_str(), "rb+");
+            if (nullptr == stripe) {
+                ERROR("FileHandle::openFile - unable to open stripe '%s' of file '%s'", stripePath.c_str(),
+                      m_fileName.c_str());
+                for (auto openStripe : m_stripes) {
+                    fclose(openStripe);
+                }
+                m_stripes.clear();
+                fclose(m_fstream);
+                m_fstream = nullptr;
+                return -1;
+            }
+            m_stripes.push_back(stripe);
+        }
+
         return 0;
     }
 
     RC FileHandle::closeFile() {
+        if (nullptr != m_memoryFile) {
+            writeMetadataToDisk();
+            m_memoryFile = nullptr;
+            return 0;
+        }
         if (nullptr == m_fstream) {
             return 0;
         }
 
         writeMetadataToDisk();
 
+        for (auto stripe : m_stripes) {
+            if (0 != fclose(stripe)) {
+                WARNING("FileHandle::closeFile - couldn't properly close a stripe of the file '%s'\n", m_fileName.c_str());
+            }
+        }
+        m_stripes.clear();
         if (0 != fclose(m_fstream)) {
             WARNING("FileHandle::closeFile - couldn't properly close the file '%s'. err - %s\n", m_fileName.c_str(), std::strerror(ferror(m_fstream)));
         }
@@ -175,6 +438,30 @@ namespace PeterDB {
         return 0;
     }
 
+    RC FileHandle::flush() {
+        if (nullptr != m_memoryFile) {
+            writeMetadataToDisk();
+            return 0;
+        }
+        if (nullptr == m_fstream) {
+            return -1;
+        }
+
+        writeMetadataToDisk();
+
+        if (0 != fflush(m_fstream)) {
+            ERROR("FileHandle::flush - error while flushing file '%s'. err - %s\n", m_fileName.c_str(), std::strerror(ferror(m_fstream)));
+            return -1;
+        }
+        for (auto stripe : m_stripes) {
+            if (0 != fflush(stripe)) {
+                ERROR("FileHandle::flush - error while flushing a stripe of file '%s'\n", m_fileName.c_str());
+                return -1;
+            }
+        }
+        return 0;
+    }
+
     RC FileHandle::readPage(PageNum pageNum, void *data) {
         // pageNum should be less than the number of pages present
         // pages are 0 indexed from user pov, so if pageNum is 0, then
@@ -185,17 +472,10 @@ namespace PeterDB {
         }
 
         assert(nullptr != data);
-        assert(nullptr != m_fstream);
+        assert(isActive());
 
-        if (0 != fseek(m_fstream,
-                       PAGE_SIZE * (HIDDEN_PAGES + pageNum),
-                       SEEK_SET)) {
-            ERROR("FileHandle::readPage - error while trying to seek to page '%d' in file '%s'. err - %s\n", pageNum, m_fileName.c_str(), std::strerror(ferror(m_fstream)));
-            return -1;
-        }
-
-        if (1 != fread(data, PAGE_SIZE, 1, m_fstream)) {
-            ERROR("FileHandle::readPage - error while reading '%d' page from file '%s'. err - %s\n", pageNum, m_fileName.c_str(), std::strerror(ferror(m_fstream)));
+        if (0 != readPhysicalPage(HIDDEN_PAGES + pageNum, data)) {
+            ERROR("FileHandle::readPage - error while reading '%d' page from file '%s'\n", pageNum, m_fileName.c_str());
             return -1;
         }
 
@@ -205,22 +485,15 @@ namespace PeterDB {
 
     RC FileHandle::writePage(PageNum pageNum, const void *data) {
         assert(nullptr != data);
-        assert(nullptr != m_fstream);
+        assert(isActive());
 
         if (pageNum >= appendPageCounter) {
             ERROR("FileHandle::writePage - page %d not found", pageNum);
             return -1;
         }
 
-        if (0 != fseek(m_fstream,
-                       PAGE_SIZE * (HIDDEN_PAGES + pageNum),
-                       SEEK_SET)) {
-            ERROR("FileHandle::writePage - error while trying to seek to page '%d' in file '%s'. err - %s\n", pageNum, m_fileName.c_str(), std::strerror(ferror(m_fstream)));
-            return -1;
-        }
-
-        if (1 != fwrite(data, PAGE_SIZE, 1, m_fstream)) {
-            ERROR("FileHandle::writePage - error while writing '%d' page from file '%s'. err - %s\n", pageNum, m_fileName.c_str(), std::strerror(ferror(m_fstream)));
+        if (0 != writePhysicalPage(HIDDEN_PAGES + pageNum, data)) {
+            ERROR("FileHandle::writePage - error while writing '%d' page from file '%s'\n", pageNum, m_fileName.c_str());
             return -1;
         }
 
@@ -230,15 +503,11 @@ namespace PeterDB {
 
     RC FileHandle::appendPage(const void *data) {
         assert(nullptr != data);
-        assert(nullptr != m_fstream);
+        assert(isActive());
 
-        if (0 != fseek(m_fstream, 0, SEEK_END)) {
-            ERROR("FileHandle::appendPage - error while trying to seek to end of file '%s'. err - %s\n", m_fileName.c_str(), std::strerror(ferror(m_fstream)));
-            return -1;
-        }
-
-        if (1 != fwrite(data, PAGE_SIZE, 1, m_fstream)) {
-            ERROR("FileHandle::appendPage - error while appending page to file '%s'. err - %s\n", m_fileName.c_str(), std::strerror(ferror(m_fstream)));
+        // the end of the file is where the counter says, pages logged but not written back aren't in it yet
+        if (0 != writePhysicalPage(HIDDEN_PAGES + appendPageCounter, data)) {
+            ERROR("FileHandle::appendPage - error while appending page to file '%s'\n", m_fileName.c_str());
             return -1;
         }
 
@@ -266,4 +535,95 @@ namespace PeterDB {
         hiddenPagesFromUpperLayer = n;
     }
 
+    void FileHandle::readStripePaths(const std::string &path, std::vector<std::string> &stripePaths) {
+        std::vector<char> header(PAGE_SIZE, 0);
+        WriteAheadLog &wal = WriteAheadLog::instance();
+        if (!wal.isOpen() || !wal.readPage(path, 0, header.data())) {
+            FILE *fstream = fopen(path.c_str(), "rb");
+            if (nullptr != fstream) {
+                if (1 != fread(header.data(), PAGE_SIZE, 1, fstream)) {
+                    std::fill(header.begin(), header.end(), 0);
+                }
+                fclose(fstream);
+            }
+        }
+        const unsigned *metadata = (const unsigned *) header.data();
+        if (metadata[0] == (metadata[1] ^ metadata[2] ^ metadata[3] ^ metadata[4] ^ metadata[5] ^ metadata[6])) {
+            unsigned extentPages;
+            readStripes(metadata, extentPages, stripePaths);
+        }
+    }
+
+    unsigned FileHandle::getStripeCount() {
+        return m_stripePaths.size();
+    }
+
+    void FileHandle::locatePage(unsigned physicalPage, FILE *&file, const std::string *&path, unsigned &page) {
+        if (m_stripes.empty() || physicalPage < HIDDEN_PAGES) {
+            file = m_fstream;
+            path = &m_path;
+            page = physicalPage;
+            return;
+        }
+        unsigned dataPage = physicalPage - HIDDEN_PAGES;
+        unsigned extent = dataPage / m_extentPages;
+        unsigned stripe = extent % m_stripes.size();
+        file = m_stripes[stripe];
+        path = &m_stripePaths[stripe];
+        page = extent / m_stripes.size() * m_extentPages + dataPage % m_extentPages;
+    }
+
+    RC FileHandle::readPhysicalPage(unsigned physicalPage, void *data) {
+        if (nullptr != m_memoryFile) {
+            if (0 != m_memoryFile->readPage(physicalPage, data)) {
+                ERROR("FileHandle::readPhysicalPage - page '%u' not found in file '%s'\n", physicalPage, m_fileName.c_str());
+                return -1;
+            }
+            return 0;
+        }
+
+        FILE *file;
+        const std::string *path;
+        unsigned page;
+        locatePage(physicalPage, file, path, page);
+
+        WriteAheadLog &wal = WriteAheadLog::instance();
+        if (wal.isOpen() && wal.readPage(*path, page, data)) {
+            return 0;
+        }
+
+        // pread doesn't move the file position, so readers of the same handle don't race on it
+        if (PAGE_SIZE != pread(fileno(file), data, PAGE_SIZE, (off_t) PAGE_SIZE * page)) {
+            ERROR("FileHandle::readPhysicalPage - error while reading page '%u' from file '%s'. err - %s\n", physicalPage, m_fileName.c_str(), std::strerror(errno));
+            return -1;
+        }
+        return 0;
+    }
+
+    RC FileHandle::writePhysicalPage(unsigned physicalPage, const void *data) {
+        if (nullptr != m_memoryFile) {
+            if (0 != m_memoryFile->writePage(physicalPage, data)) {
+                ERROR("FileHandle::writePhysicalPage - page '%u' is past the end of file '%s'\n", physicalPage, m_fileName.c_str());
+                return -1;
+            }
+            return 0;
+        }
+
+        FILE *file;
+        const std::string *path;
+        unsigned page;
+        locatePage(physicalPage, file, path, page);
+
+        WriteAheadLog &wal = WriteAheadLog::instance();
+        if (wal.isOpen()) {
+            return wal.writePage(*path, page, data);
+        }
+
+        if (PAGE_SIZE != pwrite(fileno(file), data, PAGE_SIZE, (off_t) PAGE_SIZE * page)) {
+            ERROR("FileHandle::writePhysicalPage - error while writing page '%u' to file '%s'. err - %s\n", physicalPage, m_fileName.c_str(), std::strerror(errno));
+            return -1;
+        }
+        return 0;
+    }
+
 } // namespace PeterDB
@@ -0,0 +1,518 @@
+#include "src/include/wal.h"
+#include "src/include/util.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstddef>
+#include <cstring>
+#include <iterator>
+#include <map>
+#include <vector>
+
+namespace PeterDB {
+
+    // FNV-1a, enough to tell a torn or garbage record at the end of the log
+    static uint32_t checksumOf(const char *data, size_t length) {
+        uint32_t hash = 2166136261u;
+        for (size_t i = 0; i < length; i++) {
+            hash ^= (unsigned char) data[i];
+            hash *= 16777619u;
+        }
+        return hash;
+    }
+
+    static bool writeFully(int fd, const char *data, size_t length) {
+        while (length > 0) {
+            ssize_t written = ::write(fd, data, length);
+            if (written < 0) {
+                if (EINTR == errno) {
+                    continue;
+                }
+                return false;
+            }
+            data += written;
+            length -= written;
+        }
+        return true;
+    }
+
+    // operations the calling thread is in the middle of, and whether the outermost one is counted
+    // in m_operations, from the first record it logs on: operations only reading keep no commit waiting
+    static thread_local unsigned t_operationDepth = 0;
+    static thread_local bool t_operationCounted = false;
+
+    WriteAheadLog &WriteAheadLog::instance() {
+        static WriteAheadLog _write_ahead_log;
+        return _write_ahead_log;
+    }
+
+    WriteAheadLog::WriteAheadLog() : m_open(false) {
+    }
+
+    WriteAheadLog::~WriteAheadLog() {
+        close();
+    }
+
+    bool WriteAheadLog::isOpen() {
+        return m_open;
+    }
+
+    RC WriteAheadLog::open(const std::string &logFileName) {
+        if (m_open) {
+            ERROR("WriteAheadLog::open - log '%s' is already open\n", m_logFileName.c_str());
+            return -1;
+        }
+
+        m_logFileName = logFileName;
+        if (file_exists(m_logFileName) && 0 != replay()) {
+            return -1;
+        }
+
+        m_fd = ::open(m_logFileName.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_APPEND, 0644);
+        if (m_fd < 0) {
+            ERROR("WriteAheadLog::open - unable to open log '%s'. err - %s\n", m_logFileName.c_str(), std::strerror(errno));
+            return -1;
+        }
+
+        m_buffer.clear();
+        m_requestedLsn = m_durableLsn = m_commitLsn = m_lastLsn;
+        m_operations = 0;
+        m_writtenBackAt.clear();
+        m_writeFailed = false;
+        m_stopWriter = false;
+        m_logBytes = 0;
+        m_open = true;
+        m_writer = std::thread(&WriteAheadLog::writerLoop, this);
+        return 0;
+    }
+
+    RC WriteAheadLog::close() {
+        if (!m_open) {
+            return 0;
+        }
+
+        RC rc = checkpoint();
+
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_stopWriter = true;
+        }
+        m_writerWakeup.notify_one();
+        m_writer.join();
+        m_open = false;
+
+        ::close(m_fd);
+        m_fd = -1;
+        if (0 == rc) {
+            // everything is in the files, nothing is left to replay
+            file_delete(m_logFileName);
+        }
+        return rc;
+    }
+
+    LSN WriteAheadLog::logCreateFile(const std::string &fileName) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return appendRecord(CreateFileRecord, fileName, 0, nullptr);
+    }
+
+    LSN WriteAheadLog::logDestroyFile(const std::string &fileName) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_dirtyPages.erase(fileName);
+        m_unsyncedFiles.erase(fileName);
+        m_writtenBackAt.erase(fileName);
+        return appendRecord(DestroyFileRecord, fileName, 0, nullptr);
+    }
+
+    RC WriteAheadLog::writePage(const std::string &fileName, unsigned physicalPage, const void *data) {
+        bool writeBackFile;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            DirtyPage &page = m_dirtyPages[fileName][physicalPage];
+            page.lsn = appendRecord(PageRecord, fileName, physicalPage, data);
+            page.image.assign((const char *) data, PAGE_SIZE);
+            // only the pages committed since the last write back of the file can go
+            writeBackFile = m_dirtyPages[fileName].size() > WAL_MAX_DIRTY_PAGES &&
+                            m_writtenBackAt[fileName] < m_commitLsn;
+        }
+        return writeBackFile ? writeBack(fileName) : 0;
+    }
+
+    bool WriteAheadLog::readPage(const std::string &fileName, unsigned physicalPage, void *data) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto file = m_dirtyPages.find(fileName);
+        if (m_dirtyPages.end() == file) {
+            return false;
+        }
+        auto page = file->second.find(physicalPage);
+        if (file->second.end() == page) {
+            return false;
+        }
+        memcpy(data, page->second.image.data(), PAGE_SIZE);
+        return true;
+    }
+
+    bool WriteAheadLog::holdsPage(const std::string &fileName, unsigned physicalPage) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto file = m_dirtyPages.find(fileName);
+        return m_dirtyPages.end() != file && file->second.end() != file->second.find(physicalPage);
+    }
+
+    RC WriteAheadLog::writeBack(const std::string &fileName) {
+        std::map<unsigned, DirtyPage> pages;
+        LSN commitLsn;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            auto file = m_dirtyPages.find(fileName);
+            if (m_dirtyPages.end() == file) {
+                return 0;
+            }
+            // the images of operations in progress are not written back, a crash drops them
+            commitLsn = m_commitLsn;
+            for (auto &page : file->second) {
+                if (page.second.lsn <= commitLsn) {
+                    pages.insert(page);
+                }
+            }
+            m_writtenBackAt[fileName] = commitLsn;
+        }
+
+        // write-ahead rule: a page reaches its file only after its log record, and the commit record
+        // covering it, are on disk
+        if (0 != flush(commitLsn)) {
+            return -1;
+        }
+
+        FILE *file = fopen(fileName.c_str(), "rb+");
+        if (nullptr == file) {
+            ERROR("WriteAheadLog::writeBack - unable to open file '%s'\n", fileName.c_str());
+            return -1;
+        }
+        RC rc = 0;
+        for (auto &page : pages) {
+            if (0 != fseek(file, (long) PAGE_SIZE * page.first, SEEK_SET) ||
+                1 != fwrite(page.second.image.data(), PAGE_SIZE, 1, file)) {
+                ERROR("WriteAheadLog::writeBack - error while writing page %u of file '%s'\n", page.first, fileName.c_str());
+                rc = -1;
+                break;
+            }
+        }
+        if (0 != fclose(file) || 0 != rc) {
+            return -1;
+        }
+
+        // pages logged again meanwhile stay until their newer image is written back
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto dirtyFile = m_dirtyPages.find(fileName);
+        if (m_dirtyPages.end() != dirtyFile) {
+            for (auto &page : pages) {
+                auto held = dirtyFile->second.find(page.first);
+                if (dirtyFile->second.end() != held && held->second.lsn == page.second.lsn) {
+                    dirtyFile->second.erase(held);
+                }
+            }
+            if (dirtyFile->second.empty()) {
+                m_dirtyPages.erase(dirtyFile);
+            }
+        }
+        m_unsyncedFiles.insert(fileName);
+        return 0;
+    }
+
+    LSN WriteAheadLog::appendRecord(RecordType type, const std::string &fileName, unsigned physicalPage,
+                                    const void *data) {
+        if (CommitRecord != type && 0 != t_operationDepth && !t_operationCounted) {
+            m_operations++;
+            t_operationCounted = true;
+        }
+
+        RecordHeader header;
+        memset(&header, 0, sizeof(header));
+        header.length = sizeof(header) + fileName.size() + (nullptr == data ? 0 : PAGE_SIZE);
+        header.type = type;
+        header.physicalPage = physicalPage;
+        header.fileNameLength = fileName.size();
+
+        std::string record;
+        record.reserve(header.length);
+        record.append((const char *) &header, sizeof(header));
+        record.append(fileName);
+        if (nullptr != data) {
+            record.append((const char *) data, PAGE_SIZE);
+        }
+
+        header.lsn = ++m_lastLsn;
+        memcpy(&record[offsetof(RecordHeader, lsn)], &header.lsn, sizeof(header.lsn));
+        header.checksum = checksumOf(record.data() + offsetof(RecordHeader, lsn),
+                                     record.size() - offsetof(RecordHeader, lsn));
+        memcpy(&record[offsetof(RecordHeader, checksum)], &header.checksum, sizeof(header.checksum));
+
+        m_buffer.append(record);
+        m_logBytes += record.size();
+        if (m_buffer.size() >= WAL_BUFFER_BYTES) {
+            m_writerWakeup.notify_one();
+        }
+        return header.lsn;
+    }
+
+    void WriteAheadLog::appendCommitRecord() {
+        m_commitLsn = appendRecord(CommitRecord, "", 0, nullptr);
+        m_committed.notify_all();
+    }
+
+    void WriteAheadLog::beginOperation() {
+        t_operationDepth++;
+    }
+
+    void WriteAheadLog::endOperation() {
+        assert(0 != t_operationDepth);
+        if (0 != --t_operationDepth || !t_operationCounted) {
+            return;
+        }
+        t_operationCounted = false;
+        std::lock_guard<std::mutex> lock(m_mutex);
+        // the last operation in progress ended: what was logged until now is consistent
+        if (0 == --m_operations && m_open && m_commitLsn < m_lastLsn) {
+            appendCommitRecord();
+        }
+    }
+
+    RC WriteAheadLog::waitDurable(std::unique_lock<std::mutex> &lock, LSN lsn) {
+        if (m_durableLsn < lsn && !m_writeFailed) {
+            m_requestedLsn = std::max(m_requestedLsn, lsn);
+            m_writerWakeup.notify_one();
+            m_durable.wait(lock, [this, lsn] { return m_durableLsn >= lsn || m_writeFailed; });
+        }
+        return m_writeFailed ? -1 : 0;
+    }
+
+    RC WriteAheadLog::commit() {
+        assert(0 == t_operationDepth);
+        std::unique_lock<std::mutex> lock(m_mutex);
+        if (!m_open) {
+            return 0;
+        }
+
+        // records logged outside of any operation are committed right away, those of operations in
+        // progress once the last of them ends
+        LSN lsn = m_lastLsn;
+        if (0 == m_operations && m_commitLsn < lsn) {
+            appendCommitRecord();
+        }
+        m_committed.wait(lock, [this, lsn] { return m_commitLsn >= lsn || !m_open; });
+        return waitDurable(lock, m_commitLsn);
+    }
+
+    RC WriteAheadLog::flush(LSN lsn) {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        if (!m_open) {
+            return 0;
+        }
+        return waitDurable(lock, lsn);
+    }
+
+    RC WriteAheadLog::flush() {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        if (!m_open) {
+            return 0;
+        }
+        return waitDurable(lock, m_lastLsn);
+    }
+
+    void WriteAheadLog::writerLoop() {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        while (true) {
+            m_writerWakeup.wait(lock, [this] {
+                return m_stopWriter ||
+                       (!m_writeFailed && (m_requestedLsn > m_durableLsn || m_buffer.size() >= WAL_BUFFER_BYTES));
+            });
+            if (m_stopWriter && (m_buffer.empty() || m_writeFailed)) {
+                return;
+            }
+
+            // every record logged until now goes out with this write, and commits arriving while
+            // it is on its way are batched into the next one
+            std::string records;
+            records.swap(m_buffer);
+            LSN lastLsn = m_lastLsn;
+            lock.unlock();
+
+            bool written = writeFully(m_fd, records.data(), records.size()) && 0 == fdatasync(m_fd);
+
+            lock.lock();
+            if (written) {
+                m_durableLsn = lastLsn;
+            } else {
+                ERROR("WriteAheadLog - error while writing log '%s'. err - %s\n", m_logFileName.c_str(), std::strerror(errno));
+                m_writeFailed = true;
+            }
+            m_durable.notify_all();
+        }
+    }
+
+    RC WriteAheadLog::checkpoint() {
+        if (!m_open) {
+            return 0;
+        }
+
+        RC rc = 0;
+        std::vector<std::string> dirtyFiles;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (m_commitLsn < m_lastLsn) {
+                appendCommitRecord();
+            }
+            for (auto &file : m_dirtyPages) {
+                dirtyFiles.push_back(file.first);
+            }
+        }
+        for (auto &fileName : dirtyFiles) {
+            if (0 != writeBack(fileName)) {
+                rc = -1;
+            }
+        }
+
+        std::set<std::string> unsyncedFiles;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            unsyncedFiles.swap(m_unsyncedFiles);
+        }
+        for (auto &fileName : unsyncedFiles) {
+            // the file can be gone already, the log has its destroy record then
+            int fd = ::open(fileName.c_str(), O_RDONLY);
+            if (fd < 0) {
+                continue;
+            }
+            if (0 != fdatasync(fd)) {
+                ERROR("WriteAheadLog::checkpoint - error while syncing file '%s'. err - %s\n", fileName.c_str(), std::strerror(errno));
+                rc = -1;
+            }
+            ::close(fd);
+        }
+
+        if (0 != rc || 0 != flush()) {
+            return -1;
+        }
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_durableLsn != m_lastLsn || !m_dirtyPages.empty()) {
+            // pages were written meanwhile, their records have to stay
+            return 0;
+        }
+        if (0 != ftruncate(m_fd, 0)) {
+            ERROR("WriteAheadLog::checkpoint - error while truncating log '%s'. err - %s\n", m_logFileName.c_str(), std::strerror(errno));
+            return -1;
+        }
+        m_logBytes = 0;
+        return 0;
+    }
+
+    bool WriteAheadLog::needsCheckpoint() {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_logBytes >= WAL_CHECKPOINT_BYTES;
+    }
+
+    RC WriteAheadLog::replay() {
+        std::ifstream in(m_logFileName.c_str(), std::ifstream::in | std::ifstream::binary);
+        std::string log((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+        in.close();
+
+        // files are kept open while their records are applied
+        std::map<std::string, FILE *> files;
+        auto closeFile = [&files](const std::string &fileName) {
+            auto file = files.find(fileName);
+            if (files.end() != file) {
+                fclose(file->second);
+                files.erase(file);
+            }
+        };
+
+        // the records that made it to disk before the crash, and the last commit record among them
+        std::vector<size_t> offsets;
+        LSN commitLsn = 0;
+        size_t offset = 0;
+        while (offset + sizeof(RecordHeader) <= log.size()) {
+            RecordHeader header;
+            memcpy(&header, log.data() + offset, sizeof(header));
+            if (header.length < sizeof(header) + header.fileNameLength || header.length > log.size() - offset ||
+                header.checksum != checksumOf(log.data() + offset + offsetof(RecordHeader, lsn),
+                                              header.length - offsetof(RecordHeader, lsn))) {
+                break;
+            }
+            if (CommitRecord == header.type) {
+                commitLsn = header.lsn;
+            }
+            offsets.push_back(offset);
+            offset += header.length;
+        }
+
+        RC rc = 0;
+        unsigned replayed = 0;
+        for (size_t recordOffset : offsets) {
+            RecordHeader header;
+            memcpy(&header, log.data() + recordOffset, sizeof(header));
+            m_lastLsn = std::max(m_lastLsn, (LSN) header.lsn);
+
+            // files were created and destroyed as their records were logged, pages of operations still
+            // in progress at the crash are left out
+            size_t bodyLength = sizeof(header) + header.fileNameLength;
+            if (PageRecord == header.type && header.lsn > commitLsn) {
+                continue;
+            }
+
+            std::string fileName = log.substr(recordOffset + sizeof(header), header.fileNameLength);
+            const char *page = log.data() + recordOffset + bodyLength;
+            switch (header.type) {
+                case CreateFileRecord:
+                    if (!file_exists(fileName)) {
+                        FILE *file = fopen(fileName.c_str(), "wb+");
+                        if (nullptr != file) {
+                            fclose(file);
+                        }
+                    }
+                    break;
+                case DestroyFileRecord:
+                    closeFile(fileName);
+                    file_delete(fileName);
+                    break;
+                case PageRecord: {
+                    if (header.length != bodyLength + PAGE_SIZE) {
+                        break;
+                    }
+                    if (files.end() == files.find(fileName)) {
+                        // pages of a file destroyed later on have nowhere to go
+                        FILE *file = fopen(fileName.c_str(), "rb+");
+                        if (nullptr == file) {
+                            break;
+                        }
+                        files[fileName] = file;
+                    }
+                    FILE *file = files[fileName];
+                    if (0 != fseek(file, (long) PAGE_SIZE * header.physicalPage, SEEK_SET) ||
+                        1 != fwrite(page, PAGE_SIZE, 1, file)) {
+                        ERROR("WriteAheadLog::replay - error while writing page %u of file '%s'\n", header.physicalPage, fileName.c_str());
+                        rc = -1;
+                    }
+                    break;
+                }
+                default:
+                    break;
+            }
+
+            replayed++;
+        }
+
+        for (auto &file : files) {
+            if (0 != fflush(file.second) || 0 != fdatasync(fileno(file.second))) {
+                ERROR("WriteAheadLog::replay - error while syncing file '%s'\n", file.first.c_str());
+                rc = -1;
+            }
+            fclose(file.second);
+        }
+
+        if (0 != replayed) {
+            INFO("WriteAheadLog - replayed %u records of log '%s'", replayed, m_logFileName.c_str());
+        }
+        return rc;
+    }
+
+} // namespace PeterDB
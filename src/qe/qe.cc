@@ -118,6 +118,14 @@ namespace PeterDB {
         return m_input_iter->getAttributes(attrs);
     }
 
+    RC Filter::getTupleCount(unsigned &count) {
+        TableScan *tableScan = dynamic_cast<TableScan *>(m_input_iter);
+        if (nullptr == tableScan) {
+            return -1;
+        }
+        return tableScan->getMatchingTupleCount(m_condition, count);
+    }
+
     Project::Project(Iterator *input, const std::vector<std::string> &attrNames) {
         m_iterator = input;
         m_projectedAttrNames = attrNames;
@@ -196,6 +204,10 @@ namespace PeterDB {
         return 0;
     }
 
+    RC Project::getTupleCount(unsigned &count) {
+        return m_iterator->getTupleCount(count);
+    }
+
     BNLJoin::BNLJoin(Iterator *leftIn, TableScan *rightIn, const Condition &condition, const unsigned int numPages) {
         m_leftIn = leftIn;
         m_rightIn = rightIn;
@@ -453,6 +465,11 @@ namespace PeterDB {
         assert(nullptr != m_tupleData);
         memset(m_tupleData, 0, PAGE_SIZE);
 
+        unsigned count = 0;
+        if (COUNT == m_op && 0 == m_iterator->getTupleCount(count)) {
+            m_aggOpVarchar[m_groupAttr.name].cnt = count;
+            return;
+        }
         fetchAndStoreData();
     }
 
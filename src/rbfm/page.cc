@@ -23,21 +23,19 @@ namespace PeterDB {
             return 0;
         }
 
-        // if we have the same file, but different page, then we need
-        // to write the current page to disk before reading the new page
-        if (fileHandle.getFileName() == m_fileName &&
-                -1 != m_pageNum) {
-            auto wp = writePage(fileHandle, m_pageNum);
-            if (0 != wp) {
-                ERROR("Error while writing the page %d into file %s", m_pageNum, fileHandle.getFileName().c_str());
-                return -1;
-            }
+        // if the current page was modified but not written yet, then we need
+        // to write it to disk before reading the new page
+        auto fp = flush();
+        if (0 != fp) {
+            return fp;
         }
 
         eraseAndReset();
 
         auto rp = fileHandle.readPage(pageNum, m_data);
         if (0 != rp) {
+            m_fileName = "";
+            m_pageNum = -1;
             return rp;
         }
 
@@ -58,9 +56,55 @@ namespace PeterDB {
             return wp;
         }
 
+        m_dirty = false;
+        m_dirtyFileHandle = nullptr;
+        return 0;
+    }
+
+    void Page::markDirty(FileHandle &fileHandle) {
+        assert(m_fileName == fileHandle.getFileName());
+
+        m_dirty = true;
+        m_dirtyFileHandle = &fileHandle;
+    }
+
+    RC Page::flush() {
+        if (!m_dirty) {
+            return 0;
+        }
+
+        assert(nullptr != m_dirtyFileHandle && m_dirtyFileHandle->isActive());
+        auto wp = writePage(*m_dirtyFileHandle, m_pageNum);
+        if (0 != wp) {
+            ERROR("Error while writing the page %d into file %s", m_pageNum, m_fileName.c_str());
+            return wp;
+        }
         return 0;
     }
 
+    void Page::release(const std::string &fileName) {
+        if (fileName != m_fileName) {
+            return;
+        }
+
+        m_dirty = false;
+        m_dirtyFileHandle = nullptr;
+        m_fileName = "";
+        m_pageNum = -1;
+    }
+
+    bool Page::holds(const std::string &fileName, PageNum pageNum) {
+        return fileName == m_fileName && (int) pageNum == m_pageNum;
+    }
+
+    void Page::copyFrom(Page &other) {
+        assert(!m_dirty);
+
+        memcpy(m_data, other.m_data, PAGE_SIZE);
+        m_fileName = other.m_fileName;
+        m_pageNum = other.m_pageNum;
+    }
+
     bool Page::canInsertRecord(unsigned short recordDataLengthBytes) {
         unsigned short availableBytes = getFreeByteCount();
         // account for the new slot metadata that we need to write after inserting a new record
@@ -80,13 +124,14 @@ namespace PeterDB {
         byte *recordStart = m_data + recordOffset;
         recordAndMetadata->write(recordStart);
 
-        // set the newly inserted record's slot metadata
-        Slot slot = getSlot(recordAndMetadata->getSlotNumber());
+        // set the newly inserted record's slot metadata. the record keeps its own RID, which is another
+        // one for the copy of a record moved here by an update
+        Slot slot = getSlot(slotNum);
         slot.setRecordOffsetBytes(recordOffset);
         slot.setRecordLengthBytes(recordAndMetadata->getRecordAndMetadataLength());
 
         // update the page's metadata
-        if (recordAndMetadata->getSlotNumber() == getSlotCount()) {
+        if (slotNum == getSlotCount()) {
             // this was a newly created slot.
             setSlotCount(getSlotCount() + 1);
         }
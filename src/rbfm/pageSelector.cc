@@ -12,6 +12,8 @@ PageSelector::PageSelector(const std::string& fileName, FileHandle *fileHandle)
     m_pageOccupancyMetadata = (uint32_t*)malloc(PAGE_SIZE);
     assert(nullptr != m_pageOccupancyMetadata);
     memset(m_pageOccupancyMetadata, 0, PAGE_SIZE);
+
+    m_trailer = (PageSelectorTrailer*) ((char*)m_pageOccupancyMetadata + PAGE_SIZE - sizeof(PageSelectorTrailer));
 }
 
 PageSelector::~PageSelector() {
@@ -20,212 +22,440 @@ PageSelector::~PageSelector() {
     free(m_pageOccupancyMetadata);
 }
 
+void PageSelector::setFileHandle(FileHandle *fileHandle) {
+    assert(m_fileName == fileHandle->getFileName());
+    m_fileHandle = fileHandle;
+}
+
 void heapify(std::vector<PageOccupancy> &pageOccupancyArr) {
     std::make_heap(pageOccupancyArr.begin(), pageOccupancyArr.end(), [](const PageOccupancy& a, const PageOccupancy& b) {
         return a.availableSpace < b.availableSpace;
     });
 }
 
-std::vector<PageOccupancy> PageSelector::deserializePageOccupancyInfo(const void *data) {
-    uint32_t numEntries = *( (uint32_t*) data);
+unsigned maxEntriesInOccupancyPage() {
+    return (PAGE_SIZE - sizeof(uint32_t)) / sizeof(PageOccupancy);
+}
+
+unsigned maxZonesInPage() {
+    return (PAGE_SIZE - sizeof(uint32_t)) / sizeof(PageZone);
+}
+
+unsigned PageSelector::directoryCapacity(const unsigned &directoryIndex) {
+    // the metadata page shares its space with the trailer
+    unsigned szHeader = 2 * sizeof(uint32_t);
+    if (0 == directoryIndex) {
+        return (PAGE_SIZE - szHeader - sizeof(PageSelectorTrailer)) / sizeof(OccupancyPageSummary);
+    }
+    return (PAGE_SIZE - szHeader) / sizeof(OccupancyPageSummary);
+}
 
-    uint16_t szNumEntries = sizeof(numEntries);
-    uint16_t szPageOccupancy = sizeof(PageOccupancy);
+RC PageSelector::readDirectory() {
+    m_summaries.clear();
+    m_directoryPages.clear();
+    m_summariesBySpace.clear();
+    m_occupancyPages.clear();
+
+    void *data = malloc(PAGE_SIZE);
+    assert(nullptr != data);
 
-    assert(numEntries <= ((PAGE_SIZE - szNumEntries) / szPageOccupancy));
+    // the metadata page is already read, further directory pages are chained from it
+    uint32_t *directoryPage = m_pageOccupancyMetadata;
+    unsigned directoryPageNum = PAGE_OCCUPANCY_METADATA_PAGE;
+    RC rc = 0;
 
-    std::vector<PageOccupancy> pageOccupancyArr;
+    while (true) {
+        m_directoryPages.push_back(directoryPageNum);
 
-    for (uint32_t i = 0; i < numEntries; i++) {
-        PageOccupancy pageOcc;
+        uint32_t numSummaries = directoryPage[0];
+        if (numSummaries > directoryCapacity(m_directoryPages.size() - 1)) {
+            ERROR("PageOccupancy directory page with pageNum %d of file %s is corrupt", directoryPageNum, m_fileName.c_str());
+            rc = -1;
+            break;
+        }
 
-        memmove((void*)&pageOcc,
-                (void*) ( (char*)data + szNumEntries + i*szPageOccupancy ),
-                szPageOccupancy);
-        pageOccupancyArr.push_back(pageOcc);
-    }
+        for (uint32_t i = 0; i < numSummaries; i++) {
+            OccupancyPageSummary summary;
+            memcpy(&summary, (char*) directoryPage + 2 * sizeof(uint32_t) + i * sizeof(OccupancyPageSummary),
+                   sizeof(OccupancyPageSummary));
+            m_summaries.push_back(summary);
 
+            if (0 != summary.maxAvailableSpace) {
+                m_summariesBySpace.insert(std::make_pair(summary.maxAvailableSpace, m_summaries.size() - 1));
+            }
+        }
+
+        directoryPageNum = directoryPage[1];
+        if (0 == directoryPageNum) {
+            break;
+        }
+
+        auto rp = m_fileHandle->readPage(directoryPageNum, data);
+        if (0 != rp) {
+            ERROR("Error while reading the PageOccupancy directory page with pageNum %d", directoryPageNum);
+            rc = -1;
+            break;
+        }
+        directoryPage = (uint32_t*) data;
+    }
 
-    return pageOccupancyArr;
+    free(data);
+    m_directoryDirty = false;
+    return rc;
 }
 
-void PageSelector::readPageOccupancyInfo() {
-    assert(nullptr != m_pageOccupancyMetadata);
-    assert(true == m_fileHandle->isActive());
+RC PageSelector::convertOlderDirectory() {
+    // older files list their hidden pages in the metadata page, [count][pageNum...]. a hidden page was
+    // only added once the ones before it were full, so each of them already covers a contiguous run of
+    // data pages, and their entries have the same layout. only the directory has to be built from them
+    uint32_t count = m_pageOccupancyMetadata[0];
+    unsigned maxCount = (PAGE_SIZE - sizeof(PageSelectorTrailer)) / sizeof(uint32_t) - 1;
+    if (0 == count || count > maxCount) {
+        ERROR("PageOccupancy metadata page of file %s is in no known layout", m_fileName.c_str());
+        return -1;
+    }
+    std::vector<uint32_t> hiddenPageNums(m_pageOccupancyMetadata + 1, m_pageOccupancyMetadata + 1 + count);
+
+    m_summaries.clear();
+    m_directoryPages.clear();
+    m_summariesBySpace.clear();
+    m_occupancyPages.clear();
+
+    uint32_t *data = (uint32_t*) malloc(PAGE_SIZE);
+    assert(nullptr != data);
+    RC rc = 0;
+
+    for (uint32_t i = 0; i < count; i++) {
+        uint32_t pageNum = hiddenPageNums[i];
+        if (PAGE_OCCUPANCY_METADATA_PAGE == pageNum || pageNum >= m_fileHandle->getNextPageNum() ||
+            (0 != i && pageNum <= hiddenPageNums[i - 1])) {
+            ERROR("PageOccupancy metadata page of file %s is in no known layout", m_fileName.c_str());
+            rc = -1;
+            break;
+        }
 
-    // go through all the page numbers present in metadata
-    // and read those as array of PageOccupancy and store it
-    // in the vector m_pageOccupancyInfo
-    // the first integer in each page represents the number of
-    // PageOccupancy data present in that page
+        if (0 != m_fileHandle->readPage(pageNum, data)) {
+            ERROR("Error while reading the PageOccupancy info page with pageNum %d", pageNum);
+            rc = -1;
+            break;
+        }
 
-    for (int i=1; i < m_pageOccupancyMetadata[0]+1; i++) {
-        auto pageNum = m_pageOccupancyMetadata[i];
+        OccupancyPageSummary summary;
+        memset(&summary, 0, sizeof(summary));
+        summary.pageNum = pageNum;
+        summary.numEntries = data[0];
+        if (summary.numEntries > maxEntriesInOccupancyPage() || (0 == summary.numEntries && i + 1 != count)) {
+            ERROR("PageOccupancy info page with pageNum %d of file %s is corrupt", pageNum, m_fileName.c_str());
+            rc = -1;
+            break;
+        }
 
-        // read page with pageNum=pageNum
-        // convert the data into PageOccupancy metainfo
-        void *data = malloc(PAGE_SIZE);
-        assert(nullptr != data);
-        memset(data, 0, PAGE_SIZE);
+        PageOccupancy *entries = (PageOccupancy*) (data + 1);
+        for (uint32_t j = 0; j < summary.numEntries; j++) {
+            if (0 == j || entries[j].pageNum < summary.firstDataPageNum) {
+                summary.firstDataPageNum = entries[j].pageNum;
+            }
+            summary.maxAvailableSpace = std::max<uint32_t>(summary.maxAvailableSpace, entries[j].availableSpace);
+        }
+        if (!m_summaries.empty() && 0 != summary.numEntries && summary.firstDataPageNum <= m_summaries.back().firstDataPageNum) {
+            ERROR("PageOccupancy info page with pageNum %d of file %s is corrupt", pageNum, m_fileName.c_str());
+            rc = -1;
+            break;
+        }
 
-        auto rp = m_fileHandle->readPage(pageNum, data);
-        if (0 != rp) {
-            ERROR("Error while reading the PageOccupancy info page with pageNum %d", i);
-            free(data);
-            return;
+        m_summaries.push_back(summary);
+        if (0 != summary.maxAvailableSpace) {
+            m_summariesBySpace.insert(std::make_pair(summary.maxAvailableSpace, m_summaries.size() - 1));
         }
+    }
+    free(data);
+
+    if (0 != rc) {
+        m_summaries.clear();
+        m_summariesBySpace.clear();
+        return rc;
+    }
 
-       m_pageOccupancyInfo.insert(std::make_pair(pageNum, deserializePageOccupancyInfo(data)));
-       free(data);
+    // the list took less room than the summaries do, so the directory may need pages of its own
+    m_directoryPages.push_back(PAGE_OCCUPANCY_METADATA_PAGE);
+    unsigned capacity = directoryCapacity(0);
+    while (capacity < m_summaries.size()) {
+        void *emptyPage = calloc(1, PAGE_SIZE);
+        assert(nullptr != emptyPage);
+
+        unsigned directoryPageNum = m_fileHandle->getNextPageNum();
+        auto ap = m_fileHandle->appendPage(emptyPage);
+        free(emptyPage);
+        if (0 != ap) {
+            ERROR("Error while appending new PageOccupancy directory page\n");
+            return -1;
+        }
+        m_directoryPages.push_back(directoryPageNum);
+        capacity += directoryCapacity(m_directoryPages.size() - 1);
     }
+
+    // written back right away, the older list is gone from the metadata page after this
+    m_trailer->directoryFormat = PAGE_OCCUPANCY_DIRECTORY_FORMAT;
+    writeDirectory();
+    return 0;
 }
 
-void PageSelector::readMetadataFromDisk() {
-    assert(true == m_fileHandle->isActive());
+void PageSelector::writeDirectory() {
+    void *data = malloc(PAGE_SIZE);
+    assert(nullptr != data);
 
-    if (0 != m_fileHandle->getNextPageNum()) {
-        auto rp = m_fileHandle->readPage(PAGE_OCCUPANCY_METADATA_PAGE, m_pageOccupancyMetadata);
-        if (0 != rp) {
-            ERROR("Error while reading PageOccupancy metadata page");
-            return;
+    unsigned first = 0;
+    for (unsigned i = 0; i < m_directoryPages.size(); i++) {
+        // the metadata page is written from m_pageOccupancyMetadata, so that the trailer goes along
+        uint32_t *directoryPage = (0 == i) ? m_pageOccupancyMetadata : (uint32_t*) data;
+        unsigned szEntries = PAGE_SIZE - ((0 == i) ? sizeof(PageSelectorTrailer) : 0);
+        memset(directoryPage, 0, szEntries);
+
+        unsigned numSummaries = std::min<unsigned>(directoryCapacity(i), m_summaries.size() - first);
+        directoryPage[0] = numSummaries;
+        directoryPage[1] = (i + 1 < m_directoryPages.size()) ? m_directoryPages[i + 1] : 0;
+        if (0 != numSummaries) {
+            memcpy((char*) directoryPage + 2 * sizeof(uint32_t), &m_summaries[first],
+                   numSummaries * sizeof(OccupancyPageSummary));
         }
+        first += numSummaries;
 
-        readPageOccupancyInfo();
+        auto wp = m_fileHandle->writePage(m_directoryPages[i], directoryPage);
+        if (0 != wp) {
+            ERROR("Error while writing the PageOccupancy directory to page with pageNum %d", m_directoryPages[i]);
+            break;
+        }
+    }
+    assert(first == m_summaries.size());
 
-        // after reading the page occupancy info, set the number of hidden pages
-        // used by rbfm
-        m_fileHandle->setHiddenPagesUsed(1 + m_pageOccupancyMetadata[0]);
+    free(data);
+    m_directoryDirty = false;
+}
 
-        return;
+OccupancyPage* PageSelector::loadOccupancyPage(const unsigned &index) {
+    assert(index < m_summaries.size());
+
+    auto it = m_occupancyPages.find(index);
+    if (it != m_occupancyPages.end()) {
+        return &it->second;
     }
-    
-    memset(m_pageOccupancyMetadata, 0, PAGE_SIZE);
 
-    auto ap = m_fileHandle->appendPage(m_pageOccupancyMetadata);
-    if (0 != ap) {
-        ERROR("Failure while creating PageOccupancy metadata page");
-        return;
+    uint32_t *data = (uint32_t*) malloc(PAGE_SIZE);
+    assert(nullptr != data);
+
+    auto rp = m_fileHandle->readPage(m_summaries[index].pageNum, data);
+    if (0 != rp) {
+        ERROR("Error while reading the PageOccupancy info page with pageNum %d", m_summaries[index].pageNum);
+        free(data);
+        return nullptr;
     }
 
-    // if we inserted the metadata page, then insert one more
-    // page which actually contains the pageNum-availSpace data
-    ap = m_fileHandle->appendPage(m_pageOccupancyMetadata);
-    if (0 != ap) {
-        ERROR("Failure while creating PageOccupancy first page");
-        return;
+    OccupancyPage &page = m_occupancyPages[index];
+    uint32_t numEntries = data[0];
+    char *entries = (char*) data + sizeof(uint32_t);
+
+    if (isAppendOnly()) {
+        assert(numEntries <= maxZonesInPage());
+        page.pageZones.resize(numEntries);
+        if (0 != numEntries) {
+            memcpy(&page.pageZones[0], entries, numEntries * sizeof(PageZone));
+        }
+    } else {
+        assert(numEntries <= maxEntriesInOccupancyPage());
+        page.pageOccupancyArr.resize(numEntries);
+        if (0 != numEntries) {
+            memcpy(&page.pageOccupancyArr[0], entries, numEntries * sizeof(PageOccupancy));
+        }
     }
 
-    // set the number of PageOccupancy pages, and their page num
-    // in PageOccupancy metadata page
-    m_pageOccupancyMetadata[0] = 1; // we have one page dedicated for page occupancy info
-    m_pageOccupancyMetadata[1] = 1; // the page with pageNum = 1 has PageOccupancy info
+    free(data);
+    return &page;
+}
+
+void PageSelector::writeOccupancyPage(const unsigned &index) {
+    OccupancyPage &page = m_occupancyPages[index];
+
+    uint32_t *data = (uint32_t*) malloc(PAGE_SIZE);
+    assert(nullptr != data);
+    memset(data, 0, PAGE_SIZE);
+
+    char *entries = (char*) data + sizeof(uint32_t);
+    if (isAppendOnly()) {
+        data[0] = page.pageZones.size();
+        if (0 != data[0]) {
+            memcpy(entries, &page.pageZones[0], data[0] * sizeof(PageZone));
+        }
+    } else {
+        data[0] = page.pageOccupancyArr.size();
+        if (0 != data[0]) {
+            memcpy(entries, &page.pageOccupancyArr[0], data[0] * sizeof(PageOccupancy));
+        }
+    }
 
-    // set the number of hidden pages used
-    // 1 for metadata page, and number of page occupancy info pages
-    m_fileHandle->setHiddenPagesUsed(1 + m_pageOccupancyMetadata[0]);
+    auto wp = m_fileHandle->writePage(m_summaries[index].pageNum, data);
+    if (0 != wp) {
+        ERROR("Error while writing the PageOccupancy info to page with pageNum %d", m_summaries[index].pageNum);
+    } else {
+        page.dirty = false;
+    }
 
-    std::vector<PageOccupancy> pageOccupancyArr;
-    m_pageOccupancyInfo[1] = pageOccupancyArr; // PageOccupancy info stored in pageNum=1
-    return;
+    free(data);
 }
 
-void PageSelector::serializePageOccupancyInfo(const std::vector<PageOccupancy>& pageOccupancyArr, void* serializedData) {
-    void *dataPtr = serializedData;
+void PageSelector::updateSummary(const unsigned &index) {
+    OccupancyPageSummary &summary = m_summaries[index];
+    OccupancyPage &page = m_occupancyPages[index];
 
-    uint16_t szNumEntries = sizeof(uint32_t);
-    uint16_t szPageOccupancy = sizeof(PageOccupancy);
+    m_summariesBySpace.erase(std::make_pair(summary.maxAvailableSpace, index));
 
-    // Write the number of entries to the data block (first 4 bytes)
-    uint32_t numEntries = static_cast<uint32_t>(pageOccupancyArr.size());
+    if (isAppendOnly()) {
+        summary.numEntries = page.pageZones.size();
+        summary.maxAvailableSpace = 0;
+        if (!page.pageZones.empty()) {
+            summary.firstDataPageNum = page.pageZones.front().pageNum;
+        }
+    } else {
+        summary.numEntries = page.pageOccupancyArr.size();
+        summary.maxAvailableSpace = page.pageOccupancyArr.empty() ? 0 : page.pageOccupancyArr.front().availableSpace;
+        if (0 != summary.maxAvailableSpace) {
+            m_summariesBySpace.insert(std::make_pair(summary.maxAvailableSpace, index));
+        }
+    }
 
-    memmove(dataPtr, (void*)(&numEntries), szNumEntries);
-    dataPtr = (void*)( (char*)dataPtr + szNumEntries);
+    page.dirty = true;
+    m_directoryDirty = true;
+}
 
-    // Write each PageOccupancy entry to the data block
-    for (uint32_t i = 0; i < numEntries; i++) {
-        const PageOccupancy& pageOcc = pageOccupancyArr[i];
+int PageSelector::findSummaryOfDataPage(const unsigned &pageNum) {
+    // hidden pages cover increasing runs of data pages. only the last one can still be empty
+    auto end = m_summaries.end();
+    if (!m_summaries.empty() && 0 == m_summaries.back().numEntries) {
+        --end;
+    }
 
-        memmove(dataPtr, (void*)(&pageOcc), szPageOccupancy);
-        dataPtr = (void*)( (char*)dataPtr + szPageOccupancy);
+    auto it = std::upper_bound(m_summaries.begin(), end, pageNum,
+                               [](const unsigned &num, const OccupancyPageSummary &summary) {
+                                   return num < summary.firstDataPageNum;
+                               });
+    if (it == m_summaries.begin()) {
+        return -1;
     }
+    return (int) (it - m_summaries.begin()) - 1;
 }
 
-void PageSelector::writePageOccupancyInfo() {
-    assert(nullptr != m_pageOccupancyMetadata);
+RC PageSelector::readMetadataFromDisk() {
     assert(true == m_fileHandle->isActive());
 
-    void *serializedData = malloc(PAGE_SIZE);
-    assert(nullptr != serializedData);
-    memset(serializedData, 0, PAGE_SIZE);
-
-    // Iterate through all the page numbers present in metadata
-    // and write the serialized PageOccupancy data to those pages
-    for (int i = 1; i < m_pageOccupancyMetadata[0] + 1; i++) {
-        uint32_t pageNum = m_pageOccupancyMetadata[i];
+    if (0 != m_fileHandle->getNextPageNum()) {
+        auto rp = m_fileHandle->readPage(PAGE_OCCUPANCY_METADATA_PAGE, m_pageOccupancyMetadata);
+        if (0 != rp) {
+            ERROR("Error while reading PageOccupancy metadata page");
+            return -1;
+        }
 
-        // Get the serialized data block for the corresponding page
-        assert(m_pageOccupancyInfo.find(pageNum) != m_pageOccupancyInfo.end());
-        serializePageOccupancyInfo(m_pageOccupancyInfo[pageNum], serializedData);
+        // only the directory is read here, hidden pages are read when first needed.
+        // files without the format in their trailer still have the older list of hidden pages
+        RC rc = (PAGE_OCCUPANCY_DIRECTORY_FORMAT == m_trailer->directoryFormat) ? readDirectory() : convertOlderDirectory();
+        if (0 != rc) {
+            return rc;
+        }
 
-        // Write the serialized data block to the specified page
-        auto wp = m_fileHandle->writePage(pageNum, serializedData);
-        if (0 != wp) {
-            ERROR("Error while writing the PageOccupancy info to page with pageNum %d", pageNum);
-            free(serializedData);
-            return;
+        // after reading the directory, set the number of hidden pages used by rbfm
+        unsigned hiddenPages = m_directoryPages.size() + m_summaries.size();
+        if (hiddenPages > m_fileHandle->getNextPageNum()) {
+            ERROR("PageOccupancy directory of file %s lists more pages than the file has", m_fileName.c_str());
+            return -1;
         }
+        m_fileHandle->setHiddenPagesUsed(hiddenPages);
 
-        memset(serializedData, 0, PAGE_SIZE);
+        return 0;
     }
+    
+    memset(m_pageOccupancyMetadata, 0, PAGE_SIZE);
+    m_trailer->recordCountKnown = 1;
+    m_trailer->directoryFormat = PAGE_OCCUPANCY_DIRECTORY_FORMAT;
 
-    free(serializedData);
+    auto ap = m_fileHandle->appendPage(m_pageOccupancyMetadata);
+    if (0 != ap) {
+        ERROR("Failure while creating PageOccupancy metadata page");
+        return -1;
+    }
+    m_directoryPages.push_back(PAGE_OCCUPANCY_METADATA_PAGE);
+
+    // if we inserted the metadata page, then insert one more
+    // page which actually contains the pageNum-availSpace data
+    createPageForPageOccupancyInfo();
+    return 0;
 }
 
 void PageSelector::writeMetadataToDisk() {
     assert(true == m_fileHandle->isActive());
     assert(nullptr != m_pageOccupancyMetadata);
 
-    // first go through all the pageNums present in the metadata
-    // and write each of that info as it's own page
-    writePageOccupancyInfo();
+    // first write the hidden pages that changed since they were read,
+    // then the directory (and trailer) if any of it changed
+    for (auto &page : m_occupancyPages) {
+        if (page.second.dirty) {
+            writeOccupancyPage(page.first);
+        }
+    }
 
-    // then write the metadata page into the disk
-    auto wp = m_fileHandle->writePage(PAGE_OCCUPANCY_METADATA_PAGE, (void*)m_pageOccupancyMetadata);
-    if (0 != wp) {
-        ERROR("Error while writing PageOccupancy metadata into the file");
-        return;
+    if (m_directoryDirty) {
+        writeDirectory();
     }
 }
 
 unsigned PageSelector::selectPage(const uint32_t& requiredBytes) {
-    // go through all of the hidden pages
-    // check if top page-info in that hidden page has data
-    // if it's enough, then decrement the required amount
-    // heapify the vector of page-occupancy-info
-    unsigned pageNum = 0;
-    bool pageFound = false;
-
-    for (auto &pageInfo : m_pageOccupancyInfo) {
-        if (!pageInfo.second.empty() &&
-            pageInfo.second.front().availableSpace >= requiredBytes) {
-            
-            pageFound = true;
-            pageNum = pageInfo.second.front().pageNum;
-
-            pageInfo.second.front().availableSpace -= requiredBytes;
-            heapify(pageInfo.second);
-            break;
+    if (isAppendOnly()) {
+        return selectTailPage(requiredBytes);
+    }
+
+    // the hidden page whose top page-info has the most available space
+    // is known from the directory. if it's enough, then decrement the
+    // required amount and heapify the vector of page-occupancy-info
+    if (!m_summariesBySpace.empty() && m_summariesBySpace.rbegin()->first >= requiredBytes) {
+        unsigned index = m_summariesBySpace.rbegin()->second;
+
+        OccupancyPage *page = loadOccupancyPage(index);
+        if (nullptr == page) {
+            assert(false);
+            return 0;
         }
+        assert(!page->pageOccupancyArr.empty() && page->pageOccupancyArr.front().availableSpace >= requiredBytes);
+
+        unsigned pageNum = page->pageOccupancyArr.front().pageNum;
+        page->pageOccupancyArr.front().availableSpace -= requiredBytes;
+        heapify(page->pageOccupancyArr);
+        updateSummary(index);
+
+        return pageNum;
+    }
+
+    // if there are no pages with enough available space, then append a new page
+    return appendDataPage(requiredBytes);
+}
+
+unsigned PageSelector::selectPageAfter(const int &pageNum, const uint32_t& requiredBytes) {
+    if (isAppendOnly()) {
+        return selectTailPage(requiredBytes);
     }
-    if (pageFound) {
+
+    // records go into the page the last one went to as long as they fit, pages with
+    // more space earlier in the file are left alone, so the records stay in order
+    OccupancyPage *page = nullptr;
+    PageOccupancy *pageOcc = pageNum < 0 ? nullptr : findPageOccupancy(pageNum, page);
+    if (nullptr != pageOcc && pageOcc->availableSpace >= requiredBytes) {
+        decrementAvailableSpace(pageNum, requiredBytes);
         return pageNum;
     }
+    return appendDataPage(requiredBytes);
+}
 
-    // if there are no pages with enough available space, then append
-    // a new page. add new pages data into one of the hidden pages
+unsigned PageSelector::appendDataPage(const uint32_t& requiredBytes) {
+    // add new pages data into one of the hidden pages
     // return the page number
-    pageNum = m_fileHandle->getNextPageNum();
-    
+    unsigned pageNum = m_fileHandle->getNextPageNum();
+
     void *data = malloc(PAGE_SIZE);
     assert(nullptr != data);
     memset(data, 0, PAGE_SIZE);
@@ -248,26 +478,27 @@ void PageSelector::insertNewPageOccupancyInfo(const unsigned &pageNum, const uns
     PageOccupancy pageOcc;
     pageOcc.pageNum = pageNum;
     pageOcc.availableSpace = availableSpace;
+    pageOcc.recordCount = 0;
 
-    auto szNumEntries = sizeof(uint32_t);
-    auto szPageOccupancy = sizeof(PageOccupancy);
-    auto maxEntriesInVector = ( (PAGE_SIZE - szNumEntries) / szPageOccupancy );
-
-    // find vector to which we can add this info and re-heapify
-    // i.e, find a page which has pageNum-availaSpace info, and has space to
-    // store another item of pageNum-availSpace info
-    for (auto &pageInfo : m_pageOccupancyInfo) {
-        if (pageInfo.second.size() < maxEntriesInVector) {
-            pageInfo.second.push_back(pageOcc);
-            heapify(pageInfo.second);
-            return;
-        }
+    // new pages always go to the last hidden page, so that every hidden page
+    // covers a contiguous run of data pages. once it's full, add one more
+    if (m_summaries.back().numEntries >= maxEntriesInOccupancyPage()) {
+        createPageForPageOccupancyInfo();
+    }
+
+    unsigned index = m_summaries.size() - 1;
+    OccupancyPage *page = loadOccupancyPage(index);
+    if (nullptr == page) {
+        assert(false);
+        return;
     }
 
-    unsigned createdPageNum = createPageForPageOccupancyInfo();
-    std::vector<PageOccupancy> newVectorForNewPage;
-    newVectorForNewPage.push_back(pageOcc);
-    m_pageOccupancyInfo.insert(std::make_pair(createdPageNum, newVectorForNewPage));
+    page->pageOccupancyArr.push_back(pageOcc);
+    heapify(page->pageOccupancyArr);
+    if (1 == page->pageOccupancyArr.size()) {
+        m_summaries[index].firstDataPageNum = pageNum;
+    }
+    updateSummary(index);
 }
 
 unsigned PageSelector::createPageForPageOccupancyInfo() {
@@ -275,6 +506,23 @@ unsigned PageSelector::createPageForPageOccupancyInfo() {
     assert(nullptr != data);
     memset(data, 0, PAGE_SIZE);
 
+    // the directory itself needs one more page, once the pages it has are full
+    unsigned capacity = 0;
+    for (unsigned i = 0; i < m_directoryPages.size(); i++) {
+        capacity += directoryCapacity(i);
+    }
+    if (m_summaries.size() == capacity) {
+        unsigned directoryPageNum = m_fileHandle->getNextPageNum();
+        auto ap = m_fileHandle->appendPage(data);
+        if (0 != ap) {
+            assert(false);
+            ERROR("Error while appending new PageOccupancy directory page\n");
+            free(data);
+            return 0;
+        }
+        m_directoryPages.push_back(directoryPageNum);
+    }
+
     unsigned newPageNum = m_fileHandle->getNextPageNum();
     auto ap = m_fileHandle->appendPage(data);
     if (0 != ap) {
@@ -284,44 +532,289 @@ unsigned PageSelector::createPageForPageOccupancyInfo() {
         return 0;
     }
 
-    // store the pageNum in PageOccupancy metadata
-    m_pageOccupancyMetadata[0] += 1;
-    m_pageOccupancyMetadata[m_pageOccupancyMetadata[0]] = newPageNum;
+    // store the pageNum in the directory, the page starts out empty
+    OccupancyPageSummary summary;
+    memset(&summary, 0, sizeof(summary));
+    summary.pageNum = newPageNum;
+    m_summaries.push_back(summary);
+
+    m_occupancyPages[m_summaries.size() - 1].dirty = true;
+    m_directoryDirty = true;
 
     // reset the hidden pages used by this layer
-    m_fileHandle->setHiddenPagesUsed(1 + m_pageOccupancyMetadata[0]);
+    m_fileHandle->setHiddenPagesUsed(m_directoryPages.size() + m_summaries.size());
 
     free(data);
     return newPageNum;
 }
 
 void PageSelector::decrementAvailableSpace(const unsigned pageNum, int diff) {
-    
-    bool pageFound = false;
-
-    for (auto &pageInfo : m_pageOccupancyInfo) {
-        for (auto &pageOcc : pageInfo.second) {
-            if (pageNum == pageOcc.pageNum) {
-                pageOcc.availableSpace -= diff;
-                pageFound = true;
-                break;
-            }
-        }
-        if (pageFound) {
-            heapify(pageInfo.second);
-            break;
+    // append-only files keep no free space entries, space freed in a page is never reused
+    if (isAppendOnly()) {
+        return;
+    }
+
+    int index = findSummaryOfDataPage(pageNum);
+    assert(index >= 0);
+
+    OccupancyPage *page = nullptr;
+    PageOccupancy *pageOcc = findPageOccupancy(pageNum, page);
+    if (nullptr == pageOcc) {
+        assert(false);
+        return;
+    }
+    pageOcc->availableSpace -= diff;
+
+    heapify(page->pageOccupancyArr);
+    updateSummary(index);
+}
+
+PageOccupancy* PageSelector::findPageOccupancy(const unsigned &pageNum, OccupancyPage *&page) {
+    int index = findSummaryOfDataPage(pageNum);
+    if (index < 0) {
+        return nullptr;
+    }
+
+    page = loadOccupancyPage(index);
+    if (nullptr == page) {
+        return nullptr;
+    }
+
+    // the entries of a hidden page are kept as a heap, not in page order
+    for (auto &pageOcc : page->pageOccupancyArr) {
+        if (pageNum == pageOcc.pageNum) {
+            return &pageOcc;
         }
     }
-    assert(true == pageFound);
+    return nullptr;
+}
+
+bool PageSelector::isRecordCountKnown() {
+    return 1 == m_trailer->recordCountKnown;
+}
+
+unsigned PageSelector::getRecordCount() {
+    return m_trailer->recordCount;
+}
+
+void PageSelector::adjustRecordCount(const unsigned &pageNum, int diff) {
+    // counts of older files are wrong until they are set, there's nothing to adjust yet
+    if (!isRecordCountKnown()) {
+        return;
+    }
+
+    m_trailer->recordCount += diff;
+    m_directoryDirty = true;
+
+    if (isAppendOnly()) {
+        return;
+    }
+
+    OccupancyPage *page = nullptr;
+    PageOccupancy *pageOcc = findPageOccupancy(pageNum, page);
+    if (nullptr == pageOcc) {
+        assert(false);
+        return;
+    }
+    pageOcc->recordCount += diff;
+    page->dirty = true;
+}
+
+void PageSelector::setRecordCount(const unsigned &recordCount) {
+    m_trailer->recordCountKnown = 1;
+    m_trailer->recordCount = recordCount;
+    m_directoryDirty = true;
+}
+
+void PageSelector::setPageRecordCount(const unsigned &pageNum, const unsigned &recordCount) {
+    if (isAppendOnly()) {
+        return;
+    }
+
+    OccupancyPage *page = nullptr;
+    PageOccupancy *pageOcc = findPageOccupancy(pageNum, page);
+    if (nullptr == pageOcc) {
+        return;
+    }
+    pageOcc->recordCount = recordCount;
+    page->dirty = true;
+}
+
+bool PageSelector::getPageRecordCount(const unsigned &pageNum, unsigned &recordCount) {
+    if (!isRecordCountKnown() || isAppendOnly()) {
+        return false;
+    }
+
+    OccupancyPage *page = nullptr;
+    PageOccupancy *pageOcc = findPageOccupancy(pageNum, page);
+    if (nullptr == pageOcc) {
+        return false;
+    }
+    recordCount = pageOcc->recordCount;
+    return true;
 }
 
 bool PageSelector::isThisPageAMetadataPage(const PageNum &pageNum) {
-    for (int i=1; i < m_pageOccupancyMetadata[0]+1; i++) {
-        if(pageNum == m_pageOccupancyMetadata[i]) {
-            return true;
+    if (PAGE_OCCUPANCY_METADATA_PAGE == pageNum) {
+        return true;
+    }
+
+    // both the directory pages and the hidden pages are in increasing page order
+    if (std::binary_search(m_directoryPages.begin(), m_directoryPages.end(), (unsigned) pageNum)) {
+        return true;
+    }
+
+    auto it = std::lower_bound(m_summaries.begin(), m_summaries.end(), pageNum,
+                               [](const OccupancyPageSummary &summary, const PageNum &num) {
+                                   return summary.pageNum < num;
+                               });
+    return it != m_summaries.end() && it->pageNum == pageNum;
+}
+
+bool PageSelector::isAppendOnly() {
+    return 1 == m_trailer->appendOnly;
+}
+
+void PageSelector::enableAppendOnly(const std::string &zoneAttrName, bool zoneAttrIsReal) {
+    assert(zoneAttrName.length() < sizeof(m_trailer->zoneAttrName));
+
+    m_trailer->appendOnly = 1;
+    m_trailer->tailPageNum = 0;
+    m_trailer->tailAvailableSpace = 0;
+    m_trailer->zoneCount = 0;
+    m_trailer->zoneAttrIsReal = zoneAttrIsReal ? 1 : 0;
+    memset(m_trailer->zoneAttrName, 0, sizeof(m_trailer->zoneAttrName));
+    memcpy(m_trailer->zoneAttrName, zoneAttrName.c_str(), zoneAttrName.length());
+
+    // the hidden pages now hold the zone map instead of the page occupancy info
+    m_summariesBySpace.clear();
+    for (unsigned i = 0; i < m_summaries.size(); i++) {
+        m_occupancyPages[i] = OccupancyPage();
+        m_occupancyPages[i].dirty = true;
+        m_summaries[i].numEntries = 0;
+        m_summaries[i].maxAvailableSpace = 0;
+    }
+    m_directoryDirty = true;
+
+    writeMetadataToDisk();
+}
+
+std::string PageSelector::getZoneAttrName() {
+    return std::string(m_trailer->zoneAttrName);
+}
+
+unsigned PageSelector::selectTailPage(const uint32_t& requiredBytes) {
+    // keep filling the tail page until the record does not fit
+    m_directoryDirty = true;
+    if (0 != m_trailer->tailPageNum && m_trailer->tailAvailableSpace >= requiredBytes) {
+        m_trailer->tailAvailableSpace -= requiredBytes;
+        return m_trailer->tailPageNum;
+    }
+
+    unsigned pageNum = m_fileHandle->getNextPageNum();
+
+    void *data = malloc(PAGE_SIZE);
+    assert(nullptr != data);
+    memset(data, 0, PAGE_SIZE);
+
+    auto ap = m_fileHandle->appendPage(data);
+    free(data);
+    if (0 != ap) {
+        assert(false);
+        ERROR("Error while appending new tail page\n");
+        return 0;
+    }
+
+    m_trailer->tailPageNum = pageNum;
+    m_trailer->tailAvailableSpace = PAGE_SIZE - requiredBytes - (2*sizeof(unsigned short));
+
+    if (0 != m_trailer->zoneAttrName[0]) {
+        // zones are appended in page order. once the hidden pages are full, add one more
+        if (m_summaries.back().numEntries >= maxZonesInPage()) {
+            createPageForPageOccupancyInfo();
         }
+
+        unsigned index = m_summaries.size() - 1;
+        OccupancyPage *page = loadOccupancyPage(index);
+        if (nullptr == page) {
+            assert(false);
+            return 0;
+        }
+
+        PageZone pageZone;
+        memset(&pageZone, 0, sizeof(pageZone));
+        pageZone.pageNum = pageNum;
+        page->pageZones.push_back(pageZone);
+        updateSummary(index);
+        m_trailer->zoneCount += 1;
+    }
+
+    return pageNum;
+}
+
+int compareZoneValues(const uint32_t &a, const uint32_t &b, bool isReal) {
+    if (isReal) {
+        float fa, fb;
+        memcpy(&fa, &a, sizeof(float));
+        memcpy(&fb, &b, sizeof(float));
+        return (fa < fb) ? -1 : (fa > fb ? 1 : 0);
     }
-    return false;
+
+    int ia, ib;
+    memcpy(&ia, &a, sizeof(int));
+    memcpy(&ib, &b, sizeof(int));
+    return (ia < ib) ? -1 : (ia > ib ? 1 : 0);
+}
+
+void PageSelector::extendZone(const unsigned &pageNum, const void *value) {
+    // records only go to the tail page, which has the last zone
+    OccupancyPage *page = loadOccupancyPage(m_summaries.size() - 1);
+    assert(nullptr != page && !page->pageZones.empty() && page->pageZones.back().pageNum == pageNum);
+
+    PageZone &pageZone = page->pageZones.back();
+    page->dirty = true;
+    bool isReal = (1 == m_trailer->zoneAttrIsReal);
+
+    uint32_t rawValue;
+    memcpy(&rawValue, value, sizeof(uint32_t));
+
+    if (0 == pageZone.hasValues) {
+        pageZone.hasValues = 1;
+        pageZone.minValue = rawValue;
+        pageZone.maxValue = rawValue;
+        return;
+    }
+
+    if (compareZoneValues(rawValue, pageZone.minValue, isReal) < 0) {
+        pageZone.minValue = rawValue;
+    }
+    if (compareZoneValues(rawValue, pageZone.maxValue, isReal) > 0) {
+        pageZone.maxValue = rawValue;
+    }
+}
+
+bool PageSelector::getZone(const unsigned &pageNum, PageZone &zone) {
+    // zones are in increasing page order, across the hidden pages and within each of them
+    int index = findSummaryOfDataPage(pageNum);
+    if (index < 0) {
+        return false;
+    }
+
+    OccupancyPage *page = loadOccupancyPage(index);
+    if (nullptr == page) {
+        return false;
+    }
+
+    auto it = std::lower_bound(page->pageZones.begin(), page->pageZones.end(), pageNum,
+                               [](const PageZone &pageZone, const unsigned &num) {
+                                   return pageZone.pageNum < num;
+                               });
+    if (it == page->pageZones.end() || it->pageNum != pageNum) {
+        return false;
+    }
+
+    zone = *it;
+    return true;
 }
 
 }
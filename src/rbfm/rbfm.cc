@@ -3,13 +3,49 @@
 #include "src/include/slot.h"
 #include "src/include/recordTransformer.h"
 
+#include <algorithm>
 #include <assert.h>
+#include <cmath>
 #include <iostream>
+#include <random>
+#include <set>
 
 namespace PeterDB {
 
+    bool getComparisonResult(const AttrType &attrType, const CompOp &compOp,
+                             const void *data, const void *expected);
+
+    // copies the value of an int/real attribute out of a record in the api format,
+    // returns false if the value is NULL
+    bool getFixedAttrValue(const std::vector<Attribute> &recordDescriptor, const void *data,
+                           const std::string &attributeName, void *value) {
+        unsigned nullFlagSize = (recordDescriptor.size() + 7) / 8;
+        const char *dataPtr = (const char *) data + nullFlagSize;
+
+        for (unsigned i = 0; i < recordDescriptor.size(); i++) {
+            bool isNull = 0 != (((const char *) data)[i / 8] & (1 << (7 - i % 8)));
+            if (recordDescriptor[i].name == attributeName) {
+                if (isNull) {
+                    return false;
+                }
+                memcpy(value, dataPtr, INT_SZ);
+                return true;
+            }
+
+            if (isNull) {
+                continue;
+            }
+            if (TypeVarChar == recordDescriptor[i].type) {
+                dataPtr += VARCHAR_ATTR_LEN_SZ + *((const uint32_t *) dataPtr);
+            } else {
+                dataPtr += INT_SZ;
+            }
+        }
+        return false;
+    }
+
     RecordBasedFileManager &RecordBasedFileManager::instance() {
-        static RecordBasedFileManager _rbf_manager = RecordBasedFileManager();
+        static RecordBasedFileManager _rbf_manager;
         _rbf_manager.m_pagedFileManager = &PagedFileManager::instance();
         return _rbf_manager;
     }
@@ -18,22 +54,19 @@ namespace PeterDB {
 
     RecordBasedFileManager::~RecordBasedFileManager() = default;
 
-    RecordBasedFileManager::RecordBasedFileManager(const RecordBasedFileManager &) = default;
-
-    RecordBasedFileManager &RecordBasedFileManager::operator=(const RecordBasedFileManager &) = default;
-
     RC RecordBasedFileManager::createFile(const std::string &fileName) {
         return m_pagedFileManager->createFile(fileName);
     }
 
     RC RecordBasedFileManager::destroyFile(const std::string &fileName) {
-        m_fileOpenRefCount.erase(fileName);
- 
-        // Check if PageSelector for this filename exists
-        auto it = m_pageSelectors.find(fileName);
-        if (it != m_pageSelectors.end()) {
-            delete it->second;
-            m_pageSelectors.erase(it);
+        {
+            std::lock_guard<std::mutex> openFilesLock(m_openFilesLatch);
+            auto it = m_openFiles.find(fileName);
+            if (it != m_openFiles.end()) {
+                delete it->second->pageSelector;
+                delete it->second;
+                m_openFiles.erase(it);
+            }
         }
 
         return m_pagedFileManager->destroyFile(fileName);
@@ -45,39 +78,54 @@ namespace PeterDB {
             return retCode;
         }
 
-        if (m_fileOpenRefCount.end() == m_fileOpenRefCount.find(fileName)) {
-            m_fileOpenRefCount[fileName] = 0;
-        }
-        m_fileOpenRefCount[fileName]++;
-
-        // Check if PageSelector for this filename already exists
-        auto it = m_pageSelectors.find(fileName);
-        if (it == m_pageSelectors.end()) {
-            // If not, create a new PageSelector and add it to the map
-            PageSelector* pageSelector = new PageSelector(fileName, &fileHandle);
-            m_pageSelectors[fileName] = pageSelector;
-            pageSelector->readMetadataFromDisk();
+        std::lock_guard<std::mutex> openFilesLock(m_openFilesLatch);
+        OpenFile *&file = m_openFiles[fileName];
+        if (nullptr == file) {
+            // the first handle of the file reads the PageSelector in
+            file = new OpenFile();
+            file->pageSelector = new PageSelector(fileName, &fileHandle);
+            if (0 != file->pageSelector->readMetadataFromDisk()) {
+                ERROR("Error while reading the metadata of file %s\n", fileName.c_str());
+                delete file->pageSelector;
+                delete file;
+                m_openFiles.erase(fileName);
+                m_pagedFileManager->closeFile(fileHandle);
+                return -1;
+            }
         }
+        file->refCount++;
 
         return 0;
     }
 
     RC RecordBasedFileManager::closeFile(FileHandle &fileHandle) {
-        if (m_fileOpenRefCount.end() == m_fileOpenRefCount.find(fileHandle.getFileName())) {
+        std::lock_guard<std::mutex> openFilesLock(m_openFilesLatch);
+        auto it = m_openFiles.find(fileHandle.getFileName());
+        if (m_openFiles.end() == it) {
             // return failure ??, fow now returning 0
             return 0;
         }
 
-        m_fileOpenRefCount[fileHandle.getFileName()]--;
-        int curRefCount = m_fileOpenRefCount[fileHandle.getFileName()];
+        OpenFile *file = it->second;
+        {
+            std::lock_guard<SharedLatch> fileLock(file->latch);
 
-        // Check if PageSelector for this filename exists
-        auto it = m_pageSelectors.find(fileHandle.getFileName());
-        if (it != m_pageSelectors.end() && curRefCount==0) {
-            // Write metadata to disk and delete the PageSelector
-            it->second->writeMetadataToDisk();
-            delete it->second;
-            m_pageSelectors.erase(it);
+            // the tail page of an append-only file may not be written yet
+            if (0 != file->page.flush()) {
+                ERROR("Error while writing back the page of file %s\n", fileHandle.getFileName().c_str());
+            }
+
+            file->refCount--;
+            if (0 == file->refCount) {
+                // Write metadata to disk and delete the PageSelector
+                file->pageSelector->setFileHandle(&fileHandle);
+                file->pageSelector->writeMetadataToDisk();
+            }
+        }
+        if (0 == file->refCount) {
+            delete file->pageSelector;
+            delete file;
+            m_openFiles.erase(it);
         }
 
         auto retCode = m_pagedFileManager->closeFile(fileHandle);
@@ -87,36 +135,128 @@ namespace PeterDB {
         return 0;
     }
 
+    RC RecordBasedFileManager::flushFile(FileHandle &fileHandle) {
+        OpenFile *file = getOpenFile(fileHandle);
+        if (nullptr == file) {
+            return -1;
+        }
+        std::lock_guard<SharedLatch> fileLock(file->latch);
+
+        if (0 != file->page.flush()) {
+            ERROR("Error while writing back the page of file %s\n", fileHandle.getFileName().c_str());
+            return -1;
+        }
+
+        getPageSelector(*file, fileHandle)->writeMetadataToDisk();
+        return fileHandle.flush();
+    }
+
+    RecordBasedFileManager::OpenFile *RecordBasedFileManager::getOpenFile(FileHandle &fileHandle) {
+        std::lock_guard<std::mutex> openFilesLock(m_openFilesLatch);
+        auto it = m_openFiles.find(fileHandle.getFileName());
+        return m_openFiles.end() == it ? nullptr : it->second;
+    }
+
+    PageSelector* RecordBasedFileManager::getPageSelector(OpenFile &file, FileHandle &fileHandle) {
+        // the file may be open through several handles, and the one the PageSelector
+        // was created with can be closed already
+        file.pageSelector->setFileHandle(&fileHandle);
+        return file.pageSelector;
+    }
+
     RC RecordBasedFileManager::insertRecord(FileHandle &fileHandle, const std::vector<Attribute> &recordDescriptor,
                                             const void *data, RID &rid) {
+        OpenFile *file = getOpenFile(fileHandle);
+        assert(nullptr != file);
+        std::lock_guard<SharedLatch> fileLock(file->latch);
+
+        insertRecordIntoPage(*file, fileHandle, recordDescriptor, data, rid);
+
+        if (file->pageSelector->isAppendOnly()) {
+            // the tail page stays in memory, it gets written once the next page is started
+            return 0;
+        }
+
+        if (0 != file->page.writePage(fileHandle, rid.pageNum)) {
+            ERROR("Error while writing the page %d\n", rid.pageNum);
+            return -1;
+        }
+        return 0;
+    }
+
+    RC RecordBasedFileManager::insertRecords(FileHandle &fileHandle, const std::vector<Attribute> &recordDescriptor,
+                                             const std::vector<const void *> &data, std::vector<RID> &rids,
+                                             bool inOrder) {
+        OpenFile *file = getOpenFile(fileHandle);
+        assert(nullptr != file);
+        std::lock_guard<SharedLatch> fileLock(file->latch);
+
+        rids.clear();
+        rids.reserve(data.size());
+
+        // each page stays in memory while it is being filled, and is written once
+        // the next page is picked (or at the end)
+        for (auto record : data) {
+            RID rid;
+            insertRecordIntoPage(*file, fileHandle, recordDescriptor, record, rid,
+                                 inOrder ? file->inOrderPageNum : -1);
+            rids.push_back(rid);
+            if (inOrder) {
+                file->inOrderPageNum = (int) rid.pageNum;
+            }
+        }
+
+        if (file->pageSelector->isAppendOnly()) {
+            return 0;
+        }
+
+        if (0 != file->page.flush()) {
+            ERROR("Error while writing the last page of file %s\n", fileHandle.getFileName().c_str());
+            return -1;
+        }
+        return 0;
+    }
+
+    void RecordBasedFileManager::insertRecordIntoPage(OpenFile &file, FileHandle &fileHandle,
+                                                      const std::vector<Attribute> &recordDescriptor,
+                                                      const void *data, RID &rid, int previousPageNum) {
 
         // get the length of the serialised data
         // then allocate that much memory and then
         // serialize the data into that memory
-        unsigned short serializedRecordLength = RecordTransformer::serialize(recordDescriptor, data, nullptr);
+        uint16_t schemaVersion = getSchemaVersion(file);
+        unsigned short serializedRecordLength = RecordTransformer::serialize(recordDescriptor, data, nullptr,
+                                                                             schemaVersion);
         void *serializedRecord = malloc(serializedRecordLength);
         assert(nullptr != serializedRecord);
-        RecordTransformer::serialize(recordDescriptor, data, serializedRecord);
+        RecordTransformer::serialize(recordDescriptor, data, serializedRecord, schemaVersion);
 
-        unsigned pageNumber = computePageNumForInsertion(serializedRecordLength, fileHandle);
-        
-        m_page.readPage(fileHandle, pageNumber);
+        unsigned pageNumber = computePageNumForInsertion(file, serializedRecordLength, fileHandle, previousPageNum);
 
-        unsigned short slotNum = m_page.generateSlotForInsertion(serializedRecordLength);
+        file.page.readPage(fileHandle, pageNumber);
+
+        unsigned short slotNum = file.page.generateSlotForInsertion(serializedRecordLength);
         RecordAndMetadata recordAndMetadata;
         recordAndMetadata.init(pageNumber, slotNum, false, serializedRecordLength, serializedRecord);
-        m_page.insertRecord(&recordAndMetadata, slotNum);
+        file.page.insertRecord(&recordAndMetadata, slotNum);
+        file.page.markDirty(fileHandle);
+        file.changeCount++;
 
         rid.pageNum = pageNumber;
         rid.slotNum = slotNum;
         INFO("Inserted record into page=%hu, slot=%hu\n", rid.pageNum, rid.slotNum);
-        if (0 != m_page.writePage(fileHandle, pageNumber)) {
-            ERROR("Error while writing the page %d\n", pageNumber);
-            return -1;
-        }
-
         free(serializedRecord);
-        return 0;
+        keepVersion(file, fileHandle, rid, false);
+
+        PageSelector *pageSelector = getPageSelector(file, fileHandle);
+        pageSelector->adjustRecordCount(pageNumber, 1);
+        if (pageSelector->isAppendOnly()) {
+            std::string zoneAttrName = pageSelector->getZoneAttrName();
+            byte zoneValue[INT_SZ];
+            if (!zoneAttrName.empty() && getFixedAttrValue(recordDescriptor, data, zoneAttrName, zoneValue)) {
+                pageSelector->extendZone(pageNumber, zoneValue);
+            }
+        }
     }
 
     RC RecordBasedFileManager::readRecord(FileHandle &fileHandle, const std::vector<Attribute> &recordDescriptor,
@@ -129,20 +269,90 @@ namespace PeterDB {
         return readRecordWithAttrFilter(fileHandle, recordDescriptor, attrNames, rid, data);
     }
 
+    RC RecordBasedFileManager::readRecords(FileHandle &fileHandle, const std::vector<Attribute> &recordDescriptor,
+                                           const std::vector<RID> &rids, const std::vector<void *> &data) {
+        assert(rids.size() == data.size());
+        std::vector<std::string> attrNames;
+        for (auto &attrInfo : recordDescriptor) {
+            attrNames.push_back(attrInfo.name);
+        }
+
+        std::vector<size_t> order(rids.size());
+        for (size_t i = 0; i < order.size(); i++) {
+            order[i] = i;
+        }
+        std::sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+            return rids[a].pageNum < rids[b].pageNum ||
+                   (rids[a].pageNum == rids[b].pageNum && rids[a].slotNum < rids[b].slotNum);
+        });
+
+        OpenFile *file = getOpenFile(fileHandle);
+        assert(nullptr != file);
+        SharedLatchGuard fileLock(file->latch);
+
+        // the frame keeps the page of the previous record, the next records of that page are read from it
+        PageFrame frame;
+        RC rc = 0;
+        for (size_t i : order) {
+            if (0 != readRecordInFrame(*file, fileHandle, recordDescriptor, attrNames, rids[i], data[i], frame)) {
+                rc = -1;
+            }
+        }
+        return rc;
+    }
+
     RC RecordBasedFileManager::readRecordWithAttrFilter(FileHandle &fileHandle, const std::vector<Attribute> &recordDescriptor,
                                                         const std::vector<std::string> &attributeNames, const RID &rid, void *data) {
+        OpenFile *file = getOpenFile(fileHandle);
+        assert(nullptr != file);
+        SharedLatchGuard fileLock(file->latch);
+
+        PageFrame frame;
+        return readRecordInFrame(*file, fileHandle, recordDescriptor, attributeNames, rid, data, frame);
+    }
+
+    RC RecordBasedFileManager::loadPage(OpenFile &file, FileHandle &fileHandle, PageNum pageNum, PageFrame &frame) {
+        if (frame.changeCount != file.changeCount) {
+            frame.page.release(fileHandle.getFileName());
+            frame.changeCount = file.changeCount;
+        }
+        if (frame.page.holds(fileHandle.getFileName(), pageNum)) {
+            return 0;
+        }
+
+        // the page records are written in may not be written back yet
+        if (file.page.holds(fileHandle.getFileName(), pageNum)) {
+            frame.page.copyFrom(file.page);
+            return 0;
+        }
+        return frame.page.readPage(fileHandle, pageNum);
+    }
+
+    RC RecordBasedFileManager::readRecordInFrame(OpenFile &file, FileHandle &fileHandle,
+                                                 const std::vector<Attribute> &recordDescriptor,
+                                                 const std::vector<std::string> &attributeNames, const RID &rid,
+                                                 void *data, PageFrame &frame) {
+        if (0 != readSerializedRecord(file, fileHandle, rid, frame)) {
+            return -1;
+        }
+        deserializeRecord(file, recordDescriptor, attributeNames, frame.record.data(), data);
+        return 0;
+    }
+
+    RC RecordBasedFileManager::readSerializedRecord(OpenFile &file, FileHandle &fileHandle, const RID &rid,
+                                                    PageFrame &frame) {
         // 1. pageNo = RID.pageNo
         PageNum pageNum = rid.pageNum;
 
         // 2. Load the page
-        if (0 != m_page.readPage(fileHandle, pageNum)) {
+        if (0 != loadPage(file, fileHandle, pageNum, frame)) {
             ERROR("Error while reading page %d\n", pageNum);
             return -1;
         }
 
         // 3. serializedRecord = page.readRecord(slotNum)
         unsigned short slotNum = rid.slotNum;
-        unsigned short serializedRecordLengthBytes = m_page.getRecordLengthBytes(slotNum);
+        unsigned short serializedRecordLengthBytes = frame.page.getRecordLengthBytes(slotNum);
         if (serializedRecordLengthBytes == 0) {
             WARNING("Cannot read record on page=%hu, slot=%hu as it was previously deleted", rid.pageNum, rid.slotNum);
             return -1;
@@ -151,27 +361,45 @@ namespace PeterDB {
         INFO("Reading record of size=%hu from page=%hu, slot=%hu\n", serializedRecordLengthBytes, rid.pageNum,
                rid.slotNum);
         RecordAndMetadata recordAndMetadata;
-        m_page.readRecord(&recordAndMetadata, slotNum);
+        frame.page.readRecord(&recordAndMetadata, slotNum);
 
-        while (recordAndMetadata.isTombstone()) {
+        if (recordAndMetadata.isTombstone()) {
+            // updates move a record at most once, its tombstone always forwards to the record itself
             RID updatedRid;
             memcpy(&updatedRid, recordAndMetadata.getRecordDataPtr(), sizeof(RID));
 
             // load the page of the updated record into memory
-            if (0 != m_page.readPage(fileHandle, updatedRid.pageNum)) {
-                ERROR("Error while reading page %d\n", pageNum);
+            if (0 != loadPage(file, fileHandle, updatedRid.pageNum, frame)) {
+                ERROR("Error while reading page %d\n", updatedRid.pageNum);
                 return -1;
             }
 
-            m_page.readRecord(&recordAndMetadata, slotNum);
+            RecordAndMetadata forwardedRecordAndMetadata;
+            frame.page.readRecord(&forwardedRecordAndMetadata, updatedRid.slotNum);
+            frame.record.assign((const char *) forwardedRecordAndMetadata.getRecordDataPtr(),
+                                forwardedRecordAndMetadata.getRecordDataLength());
+            return 0;
         }
 
-        // 4. *data <- transform to unserializedFormat(serializedRecord)
-        RecordTransformer::deserialize(recordDescriptor, attributeNames, recordAndMetadata.getRecordDataPtr(), data);
-
+        frame.record.assign((const char *) recordAndMetadata.getRecordDataPtr(),
+                            recordAndMetadata.getRecordDataLength());
         return 0;
     }
 
+    void RecordBasedFileManager::deserializeRecord(OpenFile &file, const std::vector<Attribute> &recordDescriptor,
+                                                   const std::vector<std::string> &attributeNames,
+                                                   const void *serializedRecord, void *data) {
+        // 4. *data <- transform to unserializedFormat(serializedRecord), with the attributes of the
+        //    schema version the record was written with
+        const std::vector<Attribute> *writtenWith = &recordDescriptor;
+        if (!file.schemaVersions.empty()) {
+            uint16_t schemaVersion = RecordTransformer::getSchemaVersion(serializedRecord);
+            assert(schemaVersion < file.schemaVersions.size());
+            writtenWith = &file.schemaVersions[schemaVersion];
+        }
+        RecordTransformer::deserialize(*writtenWith, attributeNames, serializedRecord, data);
+    }
+
     RC RecordBasedFileManager::printRecord(const std::vector<Attribute> &recordDescriptor, const void *data,
                                            std::ostream &out) {
         RecordTransformer::print(recordDescriptor, data, out);
@@ -181,68 +409,157 @@ namespace PeterDB {
 
     RC RecordBasedFileManager::deleteRecord(FileHandle &fileHandle, const std::vector<Attribute> &recordDescriptor,
                                             const RID &rid) {
-//        1. read the page indicated by rid.pageNum into memory (m_page)
-        assert(rid.pageNum >= 0 && rid.pageNum < fileHandle.getNextPageNum());
-        m_page.readPage(fileHandle, rid.pageNum);
+        return deleteRecords(fileHandle, recordDescriptor, {rid});
+    }
 
-        m_pageSelectors[fileHandle.getFileName()]->decrementAvailableSpace(rid.pageNum, -1 * m_page.getSlot(rid.slotNum).getRecordLengthBytes());
+    RC RecordBasedFileManager::deleteRecords(FileHandle &fileHandle, const std::vector<Attribute> &recordDescriptor,
+                                             const std::vector<RID> &rids) {
+        OpenFile *file = getOpenFile(fileHandle);
+        assert(nullptr != file);
+        std::lock_guard<SharedLatch> fileLock(file->latch);
 
-//        2. page.deleteRecord(rid.slotNum)
-        m_page.deleteRecord(rid.slotNum);
+        if (file->pageSelector->isAppendOnly()) {
+            ERROR("Cannot delete records from file %s, it is append-only\n", fileHandle.getFileName().c_str());
+            return -1;
+        }
 
-//      3. write through - current page from memory to file
-        if (0 != m_page.writePage(fileHandle, rid.pageNum)) {
-            ERROR("Error while writing the page %d\n", rid.pageNum);
+        // the page stays in memory while its records are deleted, it's written once the next page is read
+        RC rc = 0;
+        for (auto &rid : rids) {
+            if (0 != deleteRecordInPage(*file, fileHandle, rid)) {
+                rc = -1;
+                break;
+            }
+        }
+
+        if (0 != file->page.flush()) {
+            ERROR("Error while writing the last page deleted from in file %s\n", fileHandle.getFileName().c_str());
+            return -1;
+        }
+        return rc;
+    }
+
+    RC RecordBasedFileManager::deleteRecordInPage(OpenFile &file, FileHandle &fileHandle, const RID &rid) {
+        assert(rid.pageNum >= 0 && rid.pageNum < fileHandle.getNextPageNum());
+        keepVersion(file, fileHandle, rid, true);
+        file.changeCount++;
+        if (0 != dropForwardedCopy(file, fileHandle, rid)) {
+            ERROR("Error while deleting the record page=%hu, slot=%hu forwards to\n", rid.pageNum, rid.slotNum);
             return -1;
         }
 
+//        1. read the page indicated by rid.pageNum into memory
+        if (0 != file.page.readPage(fileHandle, rid.pageNum)) {
+            ERROR("Error while reading the page %d\n", rid.pageNum);
+            return -1;
+        }
+
+        PageSelector *pageSelector = getPageSelector(file, fileHandle);
+        pageSelector->decrementAvailableSpace(rid.pageNum, -1 * file.page.getSlot(rid.slotNum).getRecordLengthBytes());
+        pageSelector->adjustRecordCount(rid.pageNum, -1);
+
+//        2. page.deleteRecord(rid.slotNum)
+        file.page.deleteRecord(rid.slotNum);
+
+//        3. the page is written back once the caller is done with it
+        file.page.markDirty(fileHandle);
+
         INFO("Deleted record from page=%hu, slot=%hu", rid.pageNum, rid.slotNum);
         return 0;
     }
 
     RC RecordBasedFileManager::updateRecord(FileHandle &fileHandle, const std::vector<Attribute> &recordDescriptor,
                                             const void *data, const RID &existingRid) {
+        return updateRecords(fileHandle, recordDescriptor, {data}, {existingRid});
+    }
+
+    RC RecordBasedFileManager::updateRecords(FileHandle &fileHandle, const std::vector<Attribute> &recordDescriptor,
+                                             const std::vector<const void *> &data, const std::vector<RID> &rids) {
+        OpenFile *file = getOpenFile(fileHandle);
+        assert(nullptr != file);
+        std::lock_guard<SharedLatch> fileLock(file->latch);
+
+        if (file->pageSelector->isAppendOnly()) {
+            ERROR("Cannot update records in file %s, it is append-only\n", fileHandle.getFileName().c_str());
+            return -1;
+        }
+        if (data.size() != rids.size()) {
+            ERROR("Got %zu records but %zu rids to update in file %s\n", data.size(), rids.size(),
+                  fileHandle.getFileName().c_str());
+            return -1;
+        }
+
+        RC rc = 0;
+        for (size_t i = 0; i < rids.size(); i++) {
+            if (0 != updateRecordInPage(*file, fileHandle, recordDescriptor, data[i], rids[i])) {
+                rc = -1;
+                break;
+            }
+        }
+
+        if (0 != file->page.flush()) {
+            ERROR("Error while writing the last page updated in file %s\n", fileHandle.getFileName().c_str());
+            return -1;
+        }
+        return rc;
+    }
+
+    RC RecordBasedFileManager::updateRecordInPage(OpenFile &file, FileHandle &fileHandle,
+                                                  const std::vector<Attribute> &recordDescriptor,
+                                                  const void *data, const RID &existingRid) {
+        Page &page = file.page;
+        keepVersion(file, fileHandle, existingRid, true);
+        file.changeCount++;
+
+        // a record moved by an earlier update is moved again, or back in place, its copy goes
+        if (0 != dropForwardedCopy(file, fileHandle, existingRid)) {
+            ERROR("Error while deleting the record page=%hu, slot=%hu forwards to\n", existingRid.pageNum,
+                  existingRid.slotNum);
+            return -1;
+        }
+
         // 1. serialize the record data
-        unsigned short serializedRecordLength = RecordTransformer::serialize(recordDescriptor, data, nullptr);
+        uint16_t schemaVersion = getSchemaVersion(file);
+        unsigned short serializedRecordLength = RecordTransformer::serialize(recordDescriptor, data, nullptr,
+                                                                             schemaVersion);
         void *serializedRecord = malloc(serializedRecordLength);
         assert(nullptr != serializedRecord);
-        RecordTransformer::serialize(recordDescriptor, data, serializedRecord);
+        RecordTransformer::serialize(recordDescriptor, data, serializedRecord, schemaVersion);
 
         // 2. Load the record's page into memory
-        m_page.readPage(fileHandle, existingRid.pageNum);
+        page.readPage(fileHandle, existingRid.pageNum);
 
         // 3. If the new record still fits into the original page, just update the record in-place.
-        unsigned short oldLengthOfRecord = m_page.getRecordLengthBytes(existingRid.slotNum);
+        unsigned short oldLengthOfRecord = page.getRecordLengthBytes(existingRid.slotNum);
         unsigned short newLengthOfRecord = serializedRecordLength + RecordAndMetadata::RECORD_METADATA_LENGTH_BYTES;
         INFO("Updating record in page=%hu, slot=%hu. Old size=%hu, new size=%hu\n",
              existingRid.pageNum, existingRid.slotNum, oldLengthOfRecord,
              newLengthOfRecord);
 
         int growthInRecordLength = newLengthOfRecord - oldLengthOfRecord;
-        if (growthInRecordLength <= 0 || m_page.canInsertRecord(growthInRecordLength)) {
+        if (growthInRecordLength <= 0 || page.canInsertRecord(growthInRecordLength)) {
             // the updated record fits into the original page
             RecordAndMetadata recordAndMetadata;
             recordAndMetadata.init(existingRid.pageNum, existingRid.slotNum, false, serializedRecordLength, serializedRecord);
-            m_page.updateRecord(&recordAndMetadata, existingRid.slotNum);
-            m_page.writePage(fileHandle, existingRid.pageNum);
-            m_pageSelectors[fileHandle.getFileName()]->decrementAvailableSpace(existingRid.pageNum, growthInRecordLength);
+            page.updateRecord(&recordAndMetadata, existingRid.slotNum);
+            page.markDirty(fileHandle);
+            getPageSelector(file, fileHandle)->decrementAvailableSpace(existingRid.pageNum, growthInRecordLength);
 
         } else {
 //          the updated record does not fit into the original page.
-            //todo:
 //1.        'clean-insert' the new record into any oher page.
-            int updatedPageNum = computePageNumForInsertion(serializedRecordLength, fileHandle);
+            int updatedPageNum = computePageNumForInsertion(file, serializedRecordLength, fileHandle);
             assert(updatedPageNum != -1);
 
-            m_page.readPage(fileHandle, updatedPageNum);
+            page.readPage(fileHandle, updatedPageNum);
             INFO("Inserting updated record into pageNum=%hu, which currently has %hu bytes free",
-                 updatedPageNum, m_page.getFreeByteCount());
+                 updatedPageNum, page.getFreeByteCount());
 
-            unsigned short updatedSlotNum = m_page.generateSlotForInsertion(serializedRecordLength);
+            unsigned short updatedSlotNum = page.generateSlotForInsertion(serializedRecordLength);
             RecordAndMetadata freshRecordAndMetadata;
             freshRecordAndMetadata.init(existingRid.pageNum, existingRid.slotNum, false, serializedRecordLength, serializedRecord);
-            m_page.insertRecord(&freshRecordAndMetadata, updatedSlotNum);
-            m_page.writePage(fileHandle, updatedPageNum);
+            page.insertRecord(&freshRecordAndMetadata, updatedSlotNum);
+            page.markDirty(fileHandle);
 
             RID updatedRid;
             updatedRid.pageNum = updatedPageNum;
@@ -252,16 +569,147 @@ namespace PeterDB {
             RecordAndMetadata tombstoneRecordAndMetadata;
             tombstoneRecordAndMetadata.init(existingRid.pageNum, existingRid.slotNum, true, sizeof(RID), &updatedRid);
 
-            m_page.readPage(fileHandle, existingRid.pageNum);
-            m_page.updateRecord(&tombstoneRecordAndMetadata, existingRid.slotNum);
-            m_page.writePage(fileHandle, existingRid.pageNum);
-            m_pageSelectors[fileHandle.getFileName()]->decrementAvailableSpace(existingRid.pageNum, tombstoneRecordAndMetadata.getRecordAndMetadataLength() - oldLengthOfRecord);
+            page.readPage(fileHandle, existingRid.pageNum);
+            page.updateRecord(&tombstoneRecordAndMetadata, existingRid.slotNum);
+            page.markDirty(fileHandle);
+            getPageSelector(file, fileHandle)->decrementAvailableSpace(existingRid.pageNum, tombstoneRecordAndMetadata.getRecordAndMetadataLength() - oldLengthOfRecord);
         }
 
         free(serializedRecord);
         return 0;
     }
 
+    void RecordBasedFileManager::setSchemaVersions(FileHandle &fileHandle,
+                                                   const std::vector<std::vector<Attribute>> &schemaVersions) {
+        OpenFile *file = getOpenFile(fileHandle);
+        assert(nullptr != file);
+        std::lock_guard<SharedLatch> fileLock(file->latch);
+
+        file->schemaVersions = schemaVersions;
+        file->changeCount++;
+    }
+
+    uint16_t RecordBasedFileManager::getSchemaVersion(OpenFile &file) {
+        return file.schemaVersions.empty() ? 0 : file.schemaVersions.size() - 1;
+    }
+
+    RC RecordBasedFileManager::dropForwardedCopy(OpenFile &file, FileHandle &fileHandle, const RID &rid) {
+        if (0 != file.page.readPage(fileHandle, rid.pageNum)) {
+            return -1;
+        }
+        if (0 == file.page.getRecordLengthBytes(rid.slotNum)) {
+            return 0;
+        }
+
+        RecordAndMetadata recordAndMetadata;
+        file.page.readRecord(&recordAndMetadata, rid.slotNum);
+        if (!recordAndMetadata.isTombstone()) {
+            return 0;
+        }
+
+        RID forwardedRid;
+        memcpy(&forwardedRid, recordAndMetadata.getRecordDataPtr(), sizeof(RID));
+        if (0 != file.page.readPage(fileHandle, forwardedRid.pageNum)) {
+            return -1;
+        }
+        getPageSelector(file, fileHandle)->decrementAvailableSpace(forwardedRid.pageNum, -1 * file.page.getSlot(forwardedRid.slotNum).getRecordLengthBytes());
+        file.page.deleteRecord(forwardedRid.slotNum);
+        return file.page.writePage(fileHandle, forwardedRid.pageNum);
+    }
+
+    Timestamp RecordBasedFileManager::getTimestamp() {
+        return m_clock.load();
+    }
+
+    Timestamp RecordBasedFileManager::beginSnapshot(Timestamp asOf) {
+        std::lock_guard<std::mutex> snapshotsLock(m_snapshotsLatch);
+        Timestamp snapshot = 0 == asOf ? m_clock.load() : asOf;
+        assert(m_snapshots.empty() ? snapshot == m_clock.load() : snapshot >= *m_snapshots.begin());
+        m_snapshots.insert(snapshot);
+        return snapshot;
+    }
+
+    void RecordBasedFileManager::endSnapshot(Timestamp snapshot) {
+        // the versions of changes made up to the oldest snapshot left are seen by none
+        Timestamp oldest;
+        {
+            std::lock_guard<std::mutex> snapshotsLock(m_snapshotsLatch);
+            auto it = m_snapshots.find(snapshot);
+            if (m_snapshots.end() == it) {
+                return;
+            }
+            m_snapshots.erase(it);
+            if (!m_snapshots.empty() && *m_snapshots.begin() <= snapshot) {
+                return;
+            }
+            oldest = m_snapshots.empty() ? m_clock.load() : *m_snapshots.begin();
+        }
+
+        std::lock_guard<std::mutex> openFilesLock(m_openFilesLatch);
+        for (auto &openFile : m_openFiles) {
+            OpenFile *file = openFile.second;
+            std::lock_guard<std::mutex> versionsLock(file->versionLatch);
+            for (auto it = file->versions.begin(); it != file->versions.end();) {
+                std::vector<RecordVersion> &chain = it->second;
+                size_t seen = 0;
+                while (seen < chain.size() && chain[seen].changedAt <= oldest) {
+                    seen++;
+                }
+                chain.erase(chain.begin(), chain.begin() + seen);
+                it = chain.empty() ? file->versions.erase(it) : std::next(it);
+            }
+        }
+    }
+
+    uint64_t RecordBasedFileManager::versionKey(const RID &rid) {
+        return ((uint64_t) rid.pageNum << 16) | rid.slotNum;
+    }
+
+    void RecordBasedFileManager::keepVersion(OpenFile &file, FileHandle &fileHandle, const RID &rid, bool existed) {
+        // a snapshot beginning once the clock ticked sees this change, the latch of the file keeps it
+        // from reading before the change is made
+        Timestamp changedAt = ++m_clock;
+        {
+            std::lock_guard<std::mutex> snapshotsLock(m_snapshotsLatch);
+            if (m_snapshots.empty()) {
+                return;
+            }
+        }
+
+        RecordVersion version;
+        version.changedAt = changedAt;
+        version.existed = false;
+        if (existed) {
+            PageFrame frame;
+            if (0 == readSerializedRecord(file, fileHandle, rid, frame)) {
+                version.existed = true;
+                version.image.swap(frame.record);
+            }
+        }
+
+        std::lock_guard<std::mutex> versionsLock(file.versionLatch);
+        file.versions[versionKey(rid)].push_back(std::move(version));
+    }
+
+    bool RecordBasedFileManager::versionAsOf(OpenFile &file, const RID &rid, Timestamp snapshot, bool &existed,
+                                             std::string &image) {
+        std::lock_guard<std::mutex> versionsLock(file.versionLatch);
+        auto chain = file.versions.find(versionKey(rid));
+        if (file.versions.end() == chain) {
+            return false;
+        }
+
+        // the first change made after the snapshot has what the record was at the snapshot
+        for (auto &version : chain->second) {
+            if (version.changedAt > snapshot) {
+                existed = version.existed;
+                image = version.image;
+                return true;
+            }
+        }
+        return false;
+    }
+
     // returns nullFlag + data
     RC RecordBasedFileManager::readAttribute(FileHandle &fileHandle, const std::vector<Attribute> &recordDescriptor,
                                              const RID &rid, const std::string &attributeName, void *data) {
@@ -285,32 +733,286 @@ namespace PeterDB {
         return 0;
     }
 
-    unsigned RecordBasedFileManager::computePageNumForInsertion(unsigned recordLength, FileHandle &fileHandle) {
+    RC RecordBasedFileManager::sampleScan(FileHandle &fileHandle, const std::vector<Attribute> &recordDescriptor,
+                                          double fraction, unsigned seed,
+                                          const std::string &conditionAttribute, const CompOp compOp,
+                                          const void *value, const std::vector<std::string> &attributeNames,
+                                          RBFM_ScanIterator &rbfm_ScanIterator) {
+        if (fraction <= 0 || fraction > 1) {
+            ERROR("RecordBasedFileManager::sampleScan - sample fraction %f should be in (0, 1]\n", fraction);
+            return -1;
+        }
+
+        auto numPages = (unsigned) std::ceil(fraction * fileHandle.getNumberOfPages());
+        return sampleScanPages(fileHandle, recordDescriptor, numPages, seed, conditionAttribute, compOp, value,
+                               attributeNames, rbfm_ScanIterator);
+    }
+
+    RC RecordBasedFileManager::sampleScanPages(FileHandle &fileHandle, const std::vector<Attribute> &recordDescriptor,
+                                               unsigned numPages, unsigned seed,
+                                               const std::string &conditionAttribute, const CompOp compOp,
+                                               const void *value, const std::vector<std::string> &attributeNames,
+                                               RBFM_ScanIterator &rbfm_ScanIterator) {
+        OpenFile *file = getOpenFile(fileHandle);
+        assert(nullptr != file);
+
+        std::vector<PageNum> samplePages;
+        {
+            SharedLatchGuard fileLock(file->latch);
+            pickSamplePages(*file, fileHandle, numPages, seed, samplePages);
+        }
+
+        rbfm_ScanIterator.init(this, &fileHandle, recordDescriptor, conditionAttribute, compOp, value, attributeNames);
+        rbfm_ScanIterator.setSamplePages(samplePages, fileHandle.getNumberOfPages());
+        return 0;
+    }
+
+    void RecordBasedFileManager::pickSamplePages(OpenFile &file, FileHandle &fileHandle, unsigned numPages,
+                                                 unsigned seed, std::vector<PageNum> &samplePages) {
+        samplePages.clear();
+
+        unsigned totalPages = fileHandle.getNextPageNum();
+        unsigned dataPages = fileHandle.getNumberOfPages();
+        if (numPages > dataPages) {
+            numPages = dataPages;
+        }
+        if (0 == numPages) {
+            return;
+        }
+
+        std::mt19937 generator(seed);
+
+        if (2 * numPages <= dataPages) {
+            // sparse sample - draw random page numbers, and reject the metadata pages
+            // and the pages which are already picked. since at least half of the data
+            // pages are still available, this needs only a few draws per page
+            std::set<PageNum> pickedPages;
+            std::uniform_int_distribution<PageNum> pageDistribution(0, totalPages - 1);
+            while (pickedPages.size() < numPages) {
+                PageNum pageNum = pageDistribution(generator);
+                if (dataPageExists(file, fileHandle, pageNum)) {
+                    pickedPages.insert(pageNum);
+                }
+            }
+            samplePages.assign(pickedPages.begin(), pickedPages.end());
+            return;
+        }
+
+        // dense sample - selection sampling (knuth's algorithm S), one pass over all the pages.
+        // each data page is picked with probability (pages still needed / data pages left)
+        unsigned pagesNeeded = numPages;
+        unsigned pagesLeft = dataPages;
+        std::uniform_real_distribution<double> distribution(0.0, 1.0);
+        for (PageNum pageNum = 0; pageNum < totalPages && pagesNeeded > 0; pageNum++) {
+            if (!dataPageExists(file, fileHandle, pageNum)) {
+                continue;
+            }
+
+            if (distribution(generator) * pagesLeft < pagesNeeded) {
+                samplePages.push_back(pageNum);
+                pagesNeeded--;
+            }
+            pagesLeft--;
+        }
+    }
+
+    unsigned RecordBasedFileManager::computePageNumForInsertion(OpenFile &file, unsigned recordLength,
+                                                                FileHandle &fileHandle, int previousPageNum) {
         unsigned prevPages = fileHandle.getNextPageNum();
 
-        assert(m_pageSelectors.end() != m_pageSelectors.find(fileHandle.getFileName()));
-        int pageNumber = m_pageSelectors[fileHandle.getFileName()]->selectPage(recordLength +
-                                                                               RecordAndMetadata::RECORD_METADATA_LENGTH_BYTES +
-                                                                               Slot::SLOT_METADATA_LENGTH_BYTES);
+        PageSelector *pageSelector = getPageSelector(file, fileHandle);
+        uint32_t requiredBytes = recordLength + RecordAndMetadata::RECORD_METADATA_LENGTH_BYTES +
+                                 Slot::SLOT_METADATA_LENGTH_BYTES;
+        int pageNumber = -1 == previousPageNum ? pageSelector->selectPage(requiredBytes)
+                                               : pageSelector->selectPageAfter(previousPageNum, requiredBytes);
         assert(pageNumber != -1);
 
         if (prevPages < fileHandle.getNextPageNum()) {
             // meaning there was new page added
             // so initialise the available space metadata for that page
-            appendFreshPage(pageNumber, fileHandle);
+            appendFreshPage(file, pageNumber, fileHandle);
         }
         return pageNumber;
     }
 
-    void RecordBasedFileManager::appendFreshPage(int pageNumber, FileHandle &fileHandle) {
-        auto rp = m_page.readPage(fileHandle, pageNumber);
+    void RecordBasedFileManager::appendFreshPage(OpenFile &file, int pageNumber, FileHandle &fileHandle) {
+        auto rp = file.page.readPage(fileHandle, pageNumber);
         assert(0 == rp);
-        m_page.eraseAndReset();
-        // auto rc = m_page.writePage(fileHandle, pageNumber);
+        file.page.eraseAndReset();
+        file.page.markDirty(fileHandle);
+        // auto rc = file.page.writePage(fileHandle, pageNumber);
         // assert(rc == 0);
     }
 
+    RC RecordBasedFileManager::enableAppendOnly(FileHandle &fileHandle, const std::vector<Attribute> &recordDescriptor,
+                                                const std::string &zoneMapAttribute) {
+        OpenFile *file = getOpenFile(fileHandle);
+        assert(nullptr != file);
+        std::lock_guard<SharedLatch> fileLock(file->latch);
+
+        if (0 != fileHandle.getNumberOfPages()) {
+            ERROR("File %s already has records, it cannot be made append-only\n", fileHandle.getFileName().c_str());
+            return -1;
+        }
+
+        bool zoneAttrIsReal = false;
+        if (!zoneMapAttribute.empty()) {
+            bool attrFound = false;
+            for (auto &attr : recordDescriptor) {
+                if (attr.name == zoneMapAttribute && TypeVarChar != attr.type) {
+                    attrFound = true;
+                    zoneAttrIsReal = (TypeReal == attr.type);
+                    break;
+                }
+            }
+
+            if (!attrFound || zoneMapAttribute.length() >= sizeof(PageSelectorTrailer::zoneAttrName)) {
+                ERROR("Zone map attribute %s should be an int or real attribute of the record\n", zoneMapAttribute.c_str());
+                return -1;
+            }
+        }
+
+        getPageSelector(*file, fileHandle)->enableAppendOnly(zoneMapAttribute, zoneAttrIsReal);
+        file->changeCount++;
+        return 0;
+    }
+
+    bool RecordBasedFileManager::isAppendOnly(FileHandle &fileHandle) {
+        OpenFile *file = getOpenFile(fileHandle);
+        assert(nullptr != file);
+        SharedLatchGuard fileLock(file->latch);
+        return file->pageSelector->isAppendOnly();
+    }
+
+    std::string RecordBasedFileManager::getZoneMapAttribute(FileHandle &fileHandle) {
+        OpenFile *file = getOpenFile(fileHandle);
+        assert(nullptr != file);
+        SharedLatchGuard fileLock(file->latch);
+        return file->pageSelector->isAppendOnly() ? file->pageSelector->getZoneAttrName() : std::string();
+    }
+
+    bool RecordBasedFileManager::pageMayMatch(FileHandle &fileHandle, PageNum pageNum,
+                                              const std::vector<Attribute> &recordDescriptor,
+                                              const std::string &conditionAttribute, const CompOp compOp,
+                                              const void *value) {
+        OpenFile *file = getOpenFile(fileHandle);
+        assert(nullptr != file);
+        SharedLatchGuard fileLock(file->latch);
+        return zoneMayMatch(*file, fileHandle, pageNum, recordDescriptor, conditionAttribute, compOp, value);
+    }
+
+    bool RecordBasedFileManager::zoneMayMatch(OpenFile &file, FileHandle &fileHandle, PageNum pageNum,
+                                              const std::vector<Attribute> &recordDescriptor,
+                                              const std::string &conditionAttribute, const CompOp compOp,
+                                              const void *value) {
+        if (NO_OP == compOp || nullptr == value) {
+            return true;
+        }
+
+        if (!file.pageSelector->isAppendOnly() || conditionAttribute != file.pageSelector->getZoneAttrName()) {
+            return true;
+        }
+
+        // the hidden page of the zone may have to be read in, readers take turns for it
+        PageZone zone;
+        {
+            std::lock_guard<std::mutex> zoneLock(file.zoneLatch);
+            if (!getPageSelector(file, fileHandle)->getZone(pageNum, zone)) {
+                return true;
+            }
+        }
+
+        // no comparison holds against NULL, so a page with only NULLs never matches
+        if (0 == zone.hasValues) {
+            return false;
+        }
+
+        AttrType attrType = TypeInt;
+        for (auto &attr : recordDescriptor) {
+            if (attr.name == conditionAttribute) {
+                attrType = attr.type;
+                break;
+            }
+        }
+
+        switch (compOp) {
+            case EQ_OP:
+                return getComparisonResult(attrType, LE_OP, &zone.minValue, value) &&
+                       getComparisonResult(attrType, GE_OP, &zone.maxValue, value);
+            case LT_OP:
+                return getComparisonResult(attrType, LT_OP, &zone.minValue, value);
+            case LE_OP:
+                return getComparisonResult(attrType, LE_OP, &zone.minValue, value);
+            case GT_OP:
+                return getComparisonResult(attrType, GT_OP, &zone.maxValue, value);
+            case GE_OP:
+                return getComparisonResult(attrType, GE_OP, &zone.maxValue, value);
+            case NE_OP:
+                return !(getComparisonResult(attrType, EQ_OP, &zone.minValue, value) &&
+                         getComparisonResult(attrType, EQ_OP, &zone.maxValue, value));
+            default:
+                return true;
+        }
+    }
+
+    RC RecordBasedFileManager::getRecordCount(FileHandle &fileHandle, unsigned &count) {
+        OpenFile *file = getOpenFile(fileHandle);
+        assert(nullptr != file);
+        {
+            SharedLatchGuard fileLock(file->latch);
+            if (file->pageSelector->isRecordCountKnown()) {
+                count = file->pageSelector->getRecordCount();
+                return 0;
+            }
+        }
+
+        std::lock_guard<SharedLatch> fileLock(file->latch);
+        if (!file->pageSelector->isRecordCountKnown()) {
+            countRecords(*file, fileHandle);
+        }
+        count = file->pageSelector->getRecordCount();
+        return 0;
+    }
+
+    void RecordBasedFileManager::countRecords(OpenFile &file, FileHandle &fileHandle) {
+        PageSelector *pageSelector = getPageSelector(file, fileHandle);
+        PageFrame frame;
+        unsigned recordCount = 0;
+        for (PageNum pageNum = 0; pageNum < fileHandle.getNextPageNum(); pageNum++) {
+            if (!dataPageExists(file, fileHandle, pageNum) || 0 != loadPage(file, fileHandle, pageNum, frame)) {
+                continue;
+            }
+
+            unsigned pageRecordCount = 0;
+            RID rid;
+            rid.pageNum = pageNum;
+            for (rid.slotNum = 0; rid.slotNum < frame.page.getSlotCount(); rid.slotNum++) {
+                if (slotHoldsRecord(file, fileHandle, rid, frame)) {
+                    pageRecordCount++;
+                }
+            }
+            pageSelector->setPageRecordCount(pageNum, pageRecordCount);
+            recordCount += pageRecordCount;
+        }
+        pageSelector->setRecordCount(recordCount);
+        INFO("Counted %u records in file %s\n", recordCount, fileHandle.getFileName().c_str());
+    }
+
+    bool RecordBasedFileManager::pageHoldsRecords(OpenFile &file, FileHandle &fileHandle, PageNum pageNum) {
+        // the hidden page of the count may have to be read in, readers take turns for it
+        std::lock_guard<std::mutex> zoneLock(file.zoneLatch);
+        unsigned recordCount = 0;
+        return !getPageSelector(file, fileHandle)->getPageRecordCount(pageNum, recordCount) || 0 != recordCount;
+    }
+
     bool RecordBasedFileManager::isValidDataPage(FileHandle &fileHandle, PageNum pageNum) {
+        OpenFile *file = getOpenFile(fileHandle);
+        assert(nullptr != file);
+        SharedLatchGuard fileLock(file->latch);
+        return dataPageExists(*file, fileHandle, pageNum);
+    }
+
+    bool RecordBasedFileManager::dataPageExists(OpenFile &file, FileHandle &fileHandle, PageNum pageNum) {
         assert(true == fileHandle.isActive());
 
         // check if the page number is under the max page
@@ -319,8 +1021,7 @@ namespace PeterDB {
         }
 
         // check if the page is one of the metadata pages
-        assert(m_pageSelectors.end() != m_pageSelectors.find(fileHandle.getFileName()));
-        if (m_pageSelectors[fileHandle.getFileName()]->isThisPageAMetadataPage(pageNum)) {
+        if (file.pageSelector->isThisPageAMetadataPage(pageNum)) {
             return false;
         }
 
@@ -328,43 +1029,58 @@ namespace PeterDB {
     }
 
     bool RecordBasedFileManager::isValidRid(FileHandle &fileHandle, const RID &rid) {
-        if (!isValidDataPage(fileHandle, rid.pageNum)) {
-            return false;
-        }
+        OpenFile *file = getOpenFile(fileHandle);
+        assert(nullptr != file);
+        SharedLatchGuard fileLock(file->latch);
 
-        // check if given slot is present in this page
-        auto rp = m_page.readPage(fileHandle, rid.pageNum);
-        assert(0 == rp);
+        PageFrame frame;
+        return slotHoldsRecord(*file, fileHandle, rid, frame);
+    }
 
-        if (0 != rp) {
-            ERROR("Error while reading the page %d from file %s \n", rid.pageNum, fileHandle.getFileName());
+    bool RecordBasedFileManager::slotHoldsRecord(OpenFile &file, FileHandle &fileHandle, const RID &rid,
+                                                 PageFrame &frame) {
+        if (slotBeyondPage(file, fileHandle, rid, frame)) {
             return false;
         }
 
-        if (rid.slotNum >= m_page.getSlotCount()) {
+        // deleted records leave an empty slot behind
+        if (0 == frame.page.getRecordLengthBytes(rid.slotNum)) {
             return false;
         }
 
+        // the copy a tombstone forwards to keeps the RID of the tombstone
         RecordAndMetadata recordAndMetadata;
-        m_page.readRecord(&recordAndMetadata, rid.slotNum);
-        return !recordAndMetadata.isTombstone();
+        frame.page.readRecord(&recordAndMetadata, rid.slotNum);
+        return recordAndMetadata.isTombstone() ||
+               (recordAndMetadata.getMPageNum() == (unsigned short) rid.pageNum &&
+                recordAndMetadata.getSlotNumber() == rid.slotNum);
     }
 
     bool RecordBasedFileManager::maxSlotBreached(FileHandle &fileHandle, const RID &rid) {
-        if (!isValidDataPage(fileHandle, rid.pageNum)) {
+        OpenFile *file = getOpenFile(fileHandle);
+        assert(nullptr != file);
+        SharedLatchGuard fileLock(file->latch);
+
+        PageFrame frame;
+        return slotBeyondPage(*file, fileHandle, rid, frame);
+    }
+
+    bool RecordBasedFileManager::slotBeyondPage(OpenFile &file, FileHandle &fileHandle, const RID &rid,
+                                                PageFrame &frame) {
+        if (!dataPageExists(file, fileHandle, rid.pageNum)) {
             return true;
         }
 
         // check if given slot is present in this page
-        auto rp = m_page.readPage(fileHandle, rid.pageNum);
+        auto rp = loadPage(file, fileHandle, rid.pageNum, frame);
         assert(0 == rp);
 
         if (0 != rp) {
-            ERROR("Error while reading the page %d from file %s \n", rid.pageNum, fileHandle.getFileName());
+            ERROR("Error while reading the page %d from file %s \n", rid.pageNum, fileHandle.getFileName().c_str());
             return true;
         }
 
-        if (rid.slotNum >= m_page.getSlotCount()) {
+        if (rid.slotNum >= frame.page.getSlotCount()) {
             return true;
         }
 
@@ -375,12 +1091,21 @@ namespace PeterDB {
                                  const std::vector<Attribute> &recordDescriptor, const std::string &conditionAttribute,
                                  const CompOp compOp, const void *value, const std::vector<std::string> &attributeNames) {
         m_initDone = true;
+        m_scanStarted = false;
+        m_pagesExhausted = false;
+        m_sampling = false;
+        m_samplePages.clear();
+        m_samplePos = 0;
+        m_dataPageCount = fileHandle->getNumberOfPages();
         m_rbfm = rbfm;
         m_fileHandle = fileHandle;
         m_recodrdDescriptor = recordDescriptor;
         m_conditionAttribute = conditionAttribute;
         m_compOp = compOp;
         m_attributeNames = attributeNames;
+        m_frame.reset(new PageFrame());
+        m_snapshot = 0;
+        m_readsVersion = false;
 
         auto attrType = TypeInt;
         for (auto &attr : recordDescriptor) {
@@ -410,64 +1135,111 @@ namespace PeterDB {
         }
     }
 
+    void RBFM_ScanIterator::setSamplePages(const std::vector<PageNum> &samplePages, unsigned dataPageCount) {
+        m_sampling = true;
+        m_samplePages = samplePages;
+        m_samplePos = 0;
+        m_dataPageCount = dataPageCount;
+    }
+
+    void RBFM_ScanIterator::setSnapshot(Timestamp snapshot) {
+        m_snapshot = snapshot;
+    }
+
+    unsigned RBFM_ScanIterator::getScannedPageCount() const {
+        return m_sampling ? (unsigned) m_samplePages.size() : m_dataPageCount;
+    }
+
+    unsigned RBFM_ScanIterator::getDataPageCount() const {
+        return m_dataPageCount;
+    }
+
     RC RBFM_ScanIterator::close() {
         m_initDone = false;
         m_scanStarted = false;
         m_rbfm = nullptr;
         m_fileHandle = nullptr;
+        m_frame.reset();
         free(m_value);
         m_value = nullptr;
         return 0;
     }
 
-    bool RBFM_ScanIterator::pickNextValidRID() {
-        bool samePage = true;
-        // check if the scan has started, else start from the first page in the file
-        if (!m_scanStarted) {
-            samePage = false;
-            m_scanStarted = true;
+    bool RBFM_ScanIterator::moveToNextPage() {
+        RecordBasedFileManager::OpenFile *file = m_rbfm->getOpenFile(*m_fileHandle);
+        assert(nullptr != file);
+        PageNum pageNum = m_scanStarted ? m_currentRid.pageNum + 1 : 0;
 
-            m_currentRid.pageNum = 0;
+        while (true) {
+            if (m_sampling) {
+                if (m_samplePos >= m_samplePages.size()) {
+                    return false;
+                }
+                pageNum = m_samplePages[m_samplePos++];
+            } else {
+                // full scan - next page which is not one of the metadata pages
+                while (pageNum < m_fileHandle->getNextPageNum() && !m_rbfm->dataPageExists(*file, *m_fileHandle, pageNum)) {
+                    pageNum += 1;
+                }
+
+                if (pageNum >= m_fileHandle->getNextPageNum()) {
+                    return false;
+                }
+            }
+
+            m_currentRid.pageNum = pageNum;
             m_currentRid.slotNum = 0;
 
-            while (!m_rbfm->isValidDataPage(*m_fileHandle, m_currentRid.pageNum)) {
-                m_currentRid.pageNum += 1;
+            // skip the pages left without records, unless the scan reads a snapshot they may still be in,
+            // and the pages whose zone map rules out the condition
+            bool mayHoldRecords = 0 != m_snapshot || m_rbfm->pageHoldsRecords(*file, *m_fileHandle, pageNum);
+            if (mayHoldRecords && m_rbfm->zoneMayMatch(*file, *m_fileHandle, pageNum, m_recodrdDescriptor,
+                                                       m_conditionAttribute, m_compOp, m_value)) {
+                return true;
             }
+            pageNum += 1;
+        }
+    }
+
+    bool RBFM_ScanIterator::pickNextValidRID() {
+        if (m_pagesExhausted) {
+            return false;
         }
 
-        if (samePage) {
+        // check if the scan has started, else start from the first page to be scanned
+        if (!m_scanStarted) {
+            if (!moveToNextPage()) {
+                m_pagesExhausted = true;
+                return false;
+            }
+            m_scanStarted = true;
+        } else {
             m_currentRid.slotNum += 1;
         }
 
         // at this point we have potential RID, we just have to validate we have
-        // valid slotNum and valid pageNum ans read the record
-        bool slotsExhausted = false;
-        bool pagesExhausted = false;
-
-        while (!pagesExhausted && !m_rbfm->isValidRid(*m_fileHandle, m_currentRid)) {
-            slotsExhausted = false;
-            while (!slotsExhausted) {
-                m_currentRid.slotNum += 1;
-
-                if (m_rbfm->maxSlotBreached(*m_fileHandle, m_currentRid)) {
-                    slotsExhausted = true;
+        // valid slotNum and valid pageNum, once the slots of a page are exhausted
+        // move on to the next page
+        RecordBasedFileManager::OpenFile *file = m_rbfm->getOpenFile(*m_fileHandle);
+        assert(nullptr != file);
+        while (true) {
+            if (m_rbfm->slotBeyondPage(*file, *m_fileHandle, m_currentRid, *m_frame)) {
+                if (!moveToNextPage()) {
+                    m_pagesExhausted = true;
+                    return false;
                 }
+                continue;
             }
 
-            if (slotsExhausted) {
-                // slots are exhausted, go to next page
-                unsigned lastPage = m_fileHandle->getNextPageNum()-1;
-                if (m_currentRid.pageNum == lastPage) {
-                    pagesExhausted = true;
-                }
-                else {
-                    m_currentRid.pageNum += 1;
-                    m_currentRid.slotNum = 0;
-                }
+            // a record changed since the snapshot is returned as it was then, if it was there
+            bool existed = false;
+            m_readsVersion = 0 != m_snapshot &&
+                             m_rbfm->versionAsOf(*file, m_currentRid, m_snapshot, existed, m_version);
+            if (m_readsVersion ? existed : m_rbfm->slotHoldsRecord(*file, *m_fileHandle, m_currentRid, *m_frame)) {
+                return true;
             }
+            m_currentRid.slotNum += 1;
         }
-
-        return !pagesExhausted;
     }
 
     template <typename T>
@@ -576,7 +1348,7 @@ namespace PeterDB {
 
         assert(data != nullptr);
 
-        auto ra = m_rbfm->readAttribute(*m_fileHandle, m_recodrdDescriptor, m_currentRid, m_conditionAttribute, data);
+        auto ra = readCurrentRecord(std::vector<std::string>(1, m_conditionAttribute), data);
         if (0 != ra) {
             ERROR("Error while reading attribute %s from record with pageNum %u and slotNum %u\n", m_conditionAttribute, m_currentRid.pageNum, m_currentRid.slotNum);
             free(data);
@@ -594,27 +1366,43 @@ namespace PeterDB {
         return comparisonResult;
     }
 
+    RC RBFM_ScanIterator::readCurrentRecord(const std::vector<std::string> &attributeNames, void *data) {
+        RecordBasedFileManager::OpenFile *file = m_rbfm->getOpenFile(*m_fileHandle);
+        assert(nullptr != file);
+        if (m_readsVersion) {
+            m_rbfm->deserializeRecord(*file, m_recodrdDescriptor, attributeNames, m_version.data(), data);
+            return 0;
+        }
+        return m_rbfm->readRecordInFrame(*file, *m_fileHandle, m_recodrdDescriptor, attributeNames, m_currentRid,
+                                         data, *m_frame);
+    }
+
     RC RBFM_ScanIterator::getNextRecord(RID &rid, void *data) {
         assert(true == m_initDone);
 
-        if (!pickNextValidRID())
-            return RBFM_EOF;
-
-        // we have valid next RID to read, read that data
-        auto rr = m_rbfm->readRecordWithAttrFilter(*m_fileHandle, m_recodrdDescriptor, m_attributeNames, m_currentRid, data);
-        if (0 != rr) {
-            ERROR("Error while reading record with pageNum - %u and slotNum - %u", m_currentRid.pageNum, m_currentRid.slotNum);
-            return rr;
-        }
+        // the records stay put while the file is held shared. the frame holding the page of the scan
+        // is read again if the file changed since the last call
+        RecordBasedFileManager::OpenFile *file = m_rbfm->getOpenFile(*m_fileHandle);
+        assert(nullptr != file);
+        SharedLatchGuard fileLock(file->latch);
+
+        // keep picking records until one satisfies the condition
+        while (pickNextValidRID()) {
+            // we have valid next RID to read, read that data
+            auto rr = readCurrentRecord(m_attributeNames, data);
+            if (0 != rr) {
+                ERROR("Error while reading record with pageNum - %u and slotNum - %u", m_currentRid.pageNum, m_currentRid.slotNum);
+                return rr;
+            }
 
-        // check for condition attr if it satisfies then return the data
-        // else call this function recursively
-        if (recordSatisfiesCondition()) {
-            rid = m_currentRid;
-            return 0;
+            // check for condition attr if it satisfies then return the data
+            if (recordSatisfiesCondition()) {
+                rid = m_currentRid;
+                return 0;
+            }
         }
 
-        return getNextRecord(rid, data);
+        return RBFM_EOF;
     }
 
 } // namespace PeterDB
@@ -7,6 +7,8 @@
 
 #define ATTR_COUNT_FIELD_SZ sizeof(uint16_t)
 #define ATTR_OFFSET_SZ sizeof(uint16_t)
+#define SCHEMA_VERSION_FIELD_SZ sizeof(uint16_t)
+#define SCHEMA_VERSION_FLAG 0x8000  // set in the attribute count of records followed by their schema version
 
 // given the null flags and the attribute number, returns True if the
 // attribute is defined as null in the flag
@@ -23,18 +25,28 @@ uint32_t getVarcharAttrSize(const void *data) {
     return *((const uint32_t*)data);
 }
 
-void writeRecordMetadata(void *serializedRecord, uint16_t &attrCount,
+// size of the attribute count, and of the schema version when there is one
+uint16_t getRecordHeaderSize(uint16_t attrCountField) {
+    return ATTR_COUNT_FIELD_SZ + ((attrCountField & SCHEMA_VERSION_FLAG) ? SCHEMA_VERSION_FIELD_SZ : 0);
+}
+
+void writeRecordMetadata(void *serializedRecord, uint16_t &attrCount, uint16_t schemaVersion,
                          const void *unserializedRecordData, uint16_t &nullFlagSize,
                          uint16_t *attrOffsetsInRecord, uint16_t offsetSzInRecord) {
-    // write total number of attributes in the record
-    memmove(serializedRecord, &attrCount, ATTR_COUNT_FIELD_SZ);
+    // write total number of attributes in the record, flagged when the schema version follows
+    uint16_t attrCountField = attrCount | (0 == schemaVersion ? 0 : SCHEMA_VERSION_FLAG);
+    memmove(serializedRecord, &attrCountField, ATTR_COUNT_FIELD_SZ);
+    if (0 != schemaVersion)
+        memmove((void*)((char*)serializedRecord + ATTR_COUNT_FIELD_SZ), &schemaVersion, SCHEMA_VERSION_FIELD_SZ);
+
+    uint16_t headerSize = getRecordHeaderSize(attrCountField);
 
     // write the nullflags of all the attributes
-    memmove((void*)((char*)serializedRecord + ATTR_COUNT_FIELD_SZ),
+    memmove((void*)((char*)serializedRecord + headerSize),
             unserializedRecordData, nullFlagSize);
 
     // write the offset details of all the attributes
-    memmove((void*)((char*)serializedRecord + ATTR_COUNT_FIELD_SZ + nullFlagSize),
+    memmove((void*)((char*)serializedRecord + headerSize + nullFlagSize),
             (void*)attrOffsetsInRecord, offsetSzInRecord);
 
     return;
@@ -61,13 +73,16 @@ void getNullFlagsFromBoolean(const std::vector<bool>& booleanVector, char *nullF
 
 uint32_t PeterDB::RecordTransformer::serialize(const std::vector<Attribute> &recordDescriptor,
                                                const void *recordData,
-                                               void *serializedRecord) {
+                                               void *serializedRecord,
+                                               uint16_t schemaVersion) {
     uint16_t attrCount = recordDescriptor.size();
     uint32_t serializedDataSz = 0;
+    assert(0 == (attrCount & SCHEMA_VERSION_FLAG));
 
     uint16_t nullFlagSize = (attrCount + 7) / 8;
     uint16_t offsetSzInRecord = attrCount * ATTR_OFFSET_SZ;
-    serializedDataSz += (ATTR_OFFSET_SZ + nullFlagSize + offsetSzInRecord);
+    uint16_t headerSize = ATTR_COUNT_FIELD_SZ + (0 == schemaVersion ? 0 : SCHEMA_VERSION_FIELD_SZ);
+    serializedDataSz += (headerSize + nullFlagSize + offsetSzInRecord);
 
     uint16_t *attrOffsetsInRecord = (uint16_t*)malloc(offsetSzInRecord);
     assert(nullptr != attrOffsetsInRecord);
@@ -152,7 +167,7 @@ uint32_t PeterDB::RecordTransformer::serialize(const std::vector<Attribute> &rec
          * the record. i,e number of attr, their null flags,
          * and their offsets
          */
-        writeRecordMetadata(serializedRecord, attrCount,
+        writeRecordMetadata(serializedRecord, attrCount, schemaVersion,
                             recordData, nullFlagSize,
                             attrOffsetsInRecord, offsetSzInRecord);
     }
@@ -165,32 +180,41 @@ void PeterDB::RecordTransformer::deserialize(const std::vector<Attribute> &recor
                                              const std::vector<std::string> &attributeNames,
                                              const void *serializedRecord,
                                              void *recordData) {
-    uint16_t attrCount = recordDescriptor.size();
-    uint16_t attrCountInSerializedData = *((const uint16_t*)serializedRecord);
+    uint16_t attrCountField = *((const uint16_t*)serializedRecord);
+    uint16_t attrCount = attrCountField & ~SCHEMA_VERSION_FLAG;
 
-    assert(attrCountInSerializedData == attrCount);
+    // records written before attributes were appended to a descriptor, e.g. rows of older catalogs,
+    // have only the first attributes of it. the ones after are NULL
+    assert(attrCount <= recordDescriptor.size());
 
+    uint16_t headerSize = getRecordHeaderSize(attrCountField);
     uint16_t nullFlagSize = (attrCount + 7) / 8;
     uint16_t offsetSzInRecord = attrCount * ATTR_OFFSET_SZ;
 
     const uint16_t *attrOffsetData = nullptr;
-    attrOffsetData = (const uint16_t*)((const char*)serializedRecord + (ATTR_COUNT_FIELD_SZ + nullFlagSize));
+    attrOffsetData = (const uint16_t*)((const char*)serializedRecord + (headerSize + nullFlagSize));
 
     const void *nullFlagsPtr = nullptr;
-    nullFlagsPtr = (const void*) ((const char*)serializedRecord + ATTR_COUNT_FIELD_SZ);
+    nullFlagsPtr = (const void*) ((const char*)serializedRecord + headerSize);
 
+    // attributes the record doesn't have, like the ones added after it was written, are NULL
     std::unordered_map<std::string, ProjectedAttrInfo> projectedAttrInfo;
     for (auto &attrName : attributeNames) {
         ProjectedAttrInfo newInfo;
+        newInfo.attrStart = newInfo.attrEnd = 0;
+        newInfo.isNull = true;
         projectedAttrInfo[attrName] = newInfo;
     }
 
     auto currAttr = 0;
-    uint32_t attrStart = ATTR_COUNT_FIELD_SZ + nullFlagSize + offsetSzInRecord;
+    uint32_t attrStart = headerSize + nullFlagSize + offsetSzInRecord;
     uint32_t attrEnd = attrStart;
     uint32_t attrSize = 0;
 
     for (auto attr : recordDescriptor) {
+        if (currAttr == attrCount) {
+            break;
+        }
         currAttr++;
 
         // Read null flag and offset
@@ -271,6 +295,16 @@ void PeterDB::RecordTransformer::deserialize(const std::vector<Attribute> &recor
     memcpy(recordData, (void*) projectedAttrsNullFlags, projectedAttrsNullFlagSize);
 }
 
+uint16_t PeterDB::RecordTransformer::getSchemaVersion(const void *serializedRecord) {
+    uint16_t attrCountField = *((const uint16_t*)serializedRecord);
+    if (0 == (attrCountField & SCHEMA_VERSION_FLAG))
+        return 0;
+
+    uint16_t schemaVersion;
+    memcpy(&schemaVersion, (const char*)serializedRecord + ATTR_COUNT_FIELD_SZ, SCHEMA_VERSION_FIELD_SZ);
+    return schemaVersion;
+}
+
 void PeterDB::RecordTransformer::print(const std::vector<Attribute> &recordDescriptor,
                                        const void *recordData,
                                        std::ostream &out) {
@@ -0,0 +1,237 @@
+#include "src/include/asyncRelationManager.h"
+
+#include <algorithm>
+#include <map>
+
+namespace PeterDB {
+
+    AsyncRelationManager::AsyncRelationManager(unsigned workers, RelationManager &rm) : m_rm(rm) {
+        if (0 == workers) {
+            workers = std::min(std::max(std::thread::hardware_concurrency(), 1u), (unsigned) ASYNC_RM_WORKERS);
+        }
+        for (unsigned i = 0; i < workers; i++) {
+            m_workers.emplace_back(&AsyncRelationManager::workerLoop, this);
+        }
+    }
+
+    AsyncRelationManager::~AsyncRelationManager() {
+        {
+            std::lock_guard<std::mutex> guard(m_mutex);
+            m_stop = true;
+        }
+        m_queued.notify_all();
+        for (auto &worker : m_workers) {
+            worker.join();
+        }
+    }
+
+    std::future<RC> AsyncRelationManager::readTupleAsync(const std::string &tableName, const RID &rid, void *data) {
+        Request request;
+        request.tableName = tableName;
+        request.rid = rid;
+        request.data = data;
+        return enqueue(request);
+    }
+
+    std::future<RC> AsyncRelationManager::readAttributeAsync(const std::string &tableName, const RID &rid,
+                                                             const std::string &attributeName, void *data) {
+        Request request;
+        request.call = [=](RelationManager &rm) {
+            return rm.readAttribute(tableName, rid, attributeName, data);
+        };
+        return enqueue(request);
+    }
+
+    std::future<RC> AsyncRelationManager::insertTupleAsync(const std::string &tableName, const void *data,
+                                                           RID &rid) {
+        Request request;
+        RID *insertedRid = &rid;
+        request.call = [=](RelationManager &rm) {
+            return rm.insertTuple(tableName, data, *insertedRid);
+        };
+        return enqueue(request);
+    }
+
+    std::future<RC> AsyncRelationManager::updateTupleAsync(const std::string &tableName, const void *data,
+                                                           const RID &rid) {
+        Request request;
+        request.call = [=](RelationManager &rm) {
+            return rm.updateTuple(tableName, data, rid);
+        };
+        return enqueue(request);
+    }
+
+    std::future<RC> AsyncRelationManager::deleteTupleAsync(const std::string &tableName, const RID &rid) {
+        Request request;
+        request.call = [=](RelationManager &rm) {
+            return rm.deleteTuple(tableName, rid);
+        };
+        return enqueue(request);
+    }
+
+    void AsyncRelationManager::submit(const std::function<RC(RelationManager &)> &call,
+                                      const std::function<void(RC)> &done) {
+        Request request;
+        request.call = call;
+        request.done = done;
+        push(request);
+    }
+
+    std::future<RC> AsyncRelationManager::enqueue(Request &request) {
+        request.promise = std::make_shared<std::promise<RC> >();
+        std::future<RC> result = request.promise->get_future();
+        push(request);
+        return result;
+    }
+
+    void AsyncRelationManager::push(Request &request) {
+        bool wakeUp = false;
+        {
+            std::lock_guard<std::mutex> guard(m_mutex);
+            m_queue.push_back(std::move(request));
+
+            // a worker woken up already takes this request along with the ones queued before it
+            wakeUp = !m_wakeUpPending;
+            m_wakeUpPending = true;
+        }
+        if (wakeUp) {
+            m_queued.notify_one();
+        }
+    }
+
+    void AsyncRelationManager::drain() {
+        std::unique_lock<std::mutex> guard(m_mutex);
+        m_idle.wait(guard, [this]() { return m_queue.empty() && 0 == m_running; });
+    }
+
+    void AsyncRelationManager::setMaxBatch(unsigned maxBatch) {
+        std::lock_guard<std::mutex> guard(m_mutex);
+        m_maxBatch = 0 == maxBatch ? 1 : maxBatch;
+    }
+
+    unsigned long AsyncRelationManager::getBatchCount() {
+        std::lock_guard<std::mutex> guard(m_mutex);
+        return m_batches;
+    }
+
+    unsigned long AsyncRelationManager::getBatchedReadCount() {
+        std::lock_guard<std::mutex> guard(m_mutex);
+        return m_batchedReads;
+    }
+
+    void AsyncRelationManager::workerLoop() {
+        std::vector<Request> batch;
+        while (true) {
+            bool wakeUpOther;
+            {
+                std::unique_lock<std::mutex> guard(m_mutex);
+                m_queued.wait(guard, [this]() { return m_stop || !m_queue.empty(); });
+                if (m_queue.empty()) {
+                    return;
+                }
+                takeBatch(batch);
+                m_running += batch.size();
+
+                // what is left is for another worker
+                m_wakeUpPending = !m_queue.empty();
+                wakeUpOther = m_wakeUpPending;
+            }
+            if (wakeUpOther) {
+                m_queued.notify_one();
+            }
+
+            runBatch(batch);
+
+            {
+                std::lock_guard<std::mutex> guard(m_mutex);
+                m_running -= batch.size();
+                if (m_queue.empty() && 0 == m_running) {
+                    m_idle.notify_all();
+                }
+            }
+            batch.clear();
+        }
+    }
+
+    void AsyncRelationManager::takeBatch(std::vector<Request> &batch) {
+        batch.push_back(std::move(m_queue.front()));
+        m_queue.pop_front();
+        if (batch.front().call) {
+            return;
+        }
+
+        // the queued reads of the table, by page. the reads of a page all go to the same batch, so that the
+        // page is read once for all of them: the page of the first read, then the pages after it, in order
+        std::map<PageNum, std::vector<unsigned> > pages;
+        for (unsigned i = 0; i < m_queue.size(); i++) {
+            if (!m_queue[i].call && m_queue[i].tableName == batch.front().tableName) {
+                pages[m_queue[i].rid.pageNum].push_back(i);
+            }
+        }
+        std::vector<bool> taken(m_queue.size(), false);
+        unsigned takenCount = 0;
+        auto first = pages.lower_bound(batch.front().rid.pageNum);
+        for (unsigned i = 0; i < pages.size(); i++) {
+            if (pages.end() == first) {
+                first = pages.begin();
+            }
+            auto &reads = first->second;
+            ++first;
+
+            // a page which doesn't fit waits for the next batch, unless it is the page of the first read
+            if (0 != i && batch.size() + takenCount + reads.size() > m_maxBatch) {
+                break;
+            }
+            for (unsigned j = 0; j < reads.size() && batch.size() + takenCount < m_maxBatch; j++) {
+                taken[reads[j]] = true;
+                takenCount++;
+            }
+        }
+
+        std::deque<Request> left;
+        for (unsigned i = 0; i < m_queue.size(); i++) {
+            if (taken[i]) {
+                batch.push_back(std::move(m_queue[i]));
+            } else {
+                left.push_back(std::move(m_queue[i]));
+            }
+        }
+        m_queue.swap(left);
+        m_batches++;
+        m_batchedReads += batch.size();
+    }
+
+    void AsyncRelationManager::runBatch(std::vector<Request> &batch) {
+        if (batch.front().call) {
+            finish(batch.front(), batch.front().call(m_rm));
+            return;
+        }
+
+        std::vector<RID> rids;
+        std::vector<void *> data;
+        for (auto &request : batch) {
+            rids.push_back(request.rid);
+            data.push_back(request.data);
+        }
+        if (0 == m_rm.readTuples(batch.front().tableName, rids, data)) {
+            for (auto &request : batch) {
+                finish(request, 0);
+            }
+            return;
+        }
+
+        // some read failed, each one gets its own rc
+        for (auto &request : batch) {
+            finish(request, batch.size() > 1 ? m_rm.readTuple(request.tableName, request.rid, request.data) : -1);
+        }
+    }
+
+    void AsyncRelationManager::finish(Request &request, RC rc) {
+        if (request.done) {
+            request.done(rc);
+        } else {
+            request.promise->set_value(rc);
+        }
+    }
+
+} // namespace PeterDB
@@ -7,9 +7,24 @@ namespace PeterDB {
     const std::string CatalogueConstants::ATTRIBUTES_TABLE_NAME = "Columns";
     const std::string CatalogueConstants::TABLES_FILE_NAME = "Tables";
     const std::string CatalogueConstants::ATTRIBUTES_FILE_NAME = "Columns";
+    const std::string CatalogueConstants::INDEXES_TABLE_NAME = "Indexes";
+    const std::string CatalogueConstants::INDEXES_FILE_NAME = "Indexes";
+    const std::string CatalogueConstants::STATISTICS_TABLE_NAME = "Statistics";
+    const std::string CatalogueConstants::STATISTICS_FILE_NAME = "Statistics";
+    const std::string CatalogueConstants::PARTITIONS_TABLE_NAME = "Partitions";
+    const std::string CatalogueConstants::PARTITIONS_FILE_NAME = "Partitions";
+    const std::string CatalogueConstants::TABLESPACES_TABLE_NAME = "Tablespaces";
+    const std::string CatalogueConstants::TABLESPACES_FILE_NAME = "Tablespaces";
+    const std::string CatalogueConstants::AGGREGATES_TABLE_NAME = "Aggregates";
+    const std::string CatalogueConstants::AGGREGATES_FILE_NAME = "Aggregates";
 
     const unsigned int CatalogueConstants::TABLES_TABLE_ID = 0;
     const unsigned int CatalogueConstants::ATTRIBUTES_TABLE_ID = 1;
+    const unsigned int CatalogueConstants::INDEXES_TABLE_ID = 2;
+    const unsigned int CatalogueConstants::STATISTICS_TABLE_ID = 3;
+    const unsigned int CatalogueConstants::PARTITIONS_TABLE_ID = 4;
+    const unsigned int CatalogueConstants::TABLESPACES_TABLE_ID = 5;
+    const unsigned int CatalogueConstants::AGGREGATES_TABLE_ID = 6;
 
         const std::vector<Attribute> CatalogueConstants::tablesTableAttributes ({
             Attribute {TABLE_ATTR_NAME_ID, AttrType::TypeInt, INTEGER_ATTRIBUTE_LENGTH},
@@ -22,5 +37,46 @@ namespace PeterDB {
             {ATTRIBUTES_ATTR_NAME_ATTR_TYPE, AttrType::TypeInt, INTEGER_ATTRIBUTE_LENGTH},
             {ATTRIBUTES_ATTR_NAME_ATTR_LENGTH, AttrType::TypeInt, INTEGER_ATTRIBUTE_LENGTH},
             {ATTRIBUTES_ATTR_NAME_POSITION, AttrType::TypeInt, INTEGER_ATTRIBUTE_LENGTH},
+            {ATTRIBUTES_ATTR_NAME_ADDED, AttrType::TypeInt, INTEGER_ATTRIBUTE_LENGTH},
+            {ATTRIBUTES_ATTR_NAME_DROPPED, AttrType::TypeInt, INTEGER_ATTRIBUTE_LENGTH},
+        });
+        const std::vector<Attribute> CatalogueConstants::indexesTableAttributes ({
+            {INDEXES_ATTR_NAME_TABLE_ID, AttrType::TypeInt, INTEGER_ATTRIBUTE_LENGTH},
+            {INDEXES_ATTR_NAME_ATTR_NAME, AttrType::TypeVarChar, ATTRIBUTE_NAME_MAX_LENGTH},
+            {INDEXES_ATTR_NAME_FNAME, AttrType::TypeVarChar, INDEX_FILE_NAME_MAX_LENGTH},
+            {INDEXES_ATTR_NAME_INCLUDED, AttrType::TypeVarChar, INDEX_INCLUDED_COLUMNS_MAX_LENGTH},
+        });
+        const std::vector<Attribute> CatalogueConstants::statisticsTableAttributes ({
+            {STATISTICS_ATTR_NAME_TABLE_ID, AttrType::TypeInt, INTEGER_ATTRIBUTE_LENGTH},
+            {STATISTICS_ATTR_NAME_ATTR_NAME, AttrType::TypeVarChar, ATTRIBUTE_NAME_MAX_LENGTH},
+            {STATISTICS_ATTR_NAME_ROW_COUNT, AttrType::TypeInt, INTEGER_ATTRIBUTE_LENGTH},
+            {STATISTICS_ATTR_NAME_PAGE_COUNT, AttrType::TypeInt, INTEGER_ATTRIBUTE_LENGTH},
+            {STATISTICS_ATTR_NAME_AVG_RECORD_SIZE, AttrType::TypeReal, INTEGER_ATTRIBUTE_LENGTH},
+            {STATISTICS_ATTR_NAME_SAMPLED, AttrType::TypeInt, INTEGER_ATTRIBUTE_LENGTH},
+            {STATISTICS_ATTR_NAME_NULL_FRACTION, AttrType::TypeReal, INTEGER_ATTRIBUTE_LENGTH},
+            {STATISTICS_ATTR_NAME_DISTINCT_COUNT, AttrType::TypeInt, INTEGER_ATTRIBUTE_LENGTH},
+            {STATISTICS_ATTR_NAME_MIN_VALUE, AttrType::TypeVarChar, STATISTICS_VALUE_MAX_LENGTH},
+            {STATISTICS_ATTR_NAME_MAX_VALUE, AttrType::TypeVarChar, STATISTICS_VALUE_MAX_LENGTH},
+            {STATISTICS_ATTR_NAME_HISTOGRAM, AttrType::TypeVarChar, STATISTICS_HISTOGRAM_MAX_LENGTH},
+        });
+        const std::vector<Attribute> CatalogueConstants::partitionsTableAttributes ({
+            {PARTITIONS_ATTR_NAME_TABLE_ID, AttrType::TypeInt, INTEGER_ATTRIBUTE_LENGTH},
+            {PARTITIONS_ATTR_NAME_ATTR_NAME, AttrType::TypeVarChar, ATTRIBUTE_NAME_MAX_LENGTH},
+            {PARTITIONS_ATTR_NAME_METHOD, AttrType::TypeInt, INTEGER_ATTRIBUTE_LENGTH},
+            {PARTITIONS_ATTR_NAME_COUNT, AttrType::TypeInt, INTEGER_ATTRIBUTE_LENGTH},
+            {PARTITIONS_ATTR_NAME_BOUNDS, AttrType::TypeVarChar, PARTITION_BOUNDS_MAX_LENGTH},
+        });
+        const std::vector<Attribute> CatalogueConstants::tablespacesTableAttributes ({
+            {TABLESPACES_ATTR_NAME_NAME, AttrType::TypeVarChar, TABLESPACE_NAME_MAX_LENGTH},
+            {TABLESPACES_ATTR_NAME_DIRECTORY, AttrType::TypeVarChar, TABLESPACE_DIRECTORY_MAX_LENGTH},
+            {TABLESPACES_ATTR_NAME_POSITION, AttrType::TypeInt, INTEGER_ATTRIBUTE_LENGTH},
+        });
+        const std::vector<Attribute> CatalogueConstants::aggregatesTableAttributes ({
+            {AGGREGATES_ATTR_NAME_TABLE_ID, AttrType::TypeInt, INTEGER_ATTRIBUTE_LENGTH},
+            {AGGREGATES_ATTR_NAME_VIEW_NAME, AttrType::TypeVarChar, ATTRIBUTE_NAME_MAX_LENGTH},
+            {AGGREGATES_ATTR_NAME_BASE_TABLE, AttrType::TypeVarChar, ATTRIBUTE_NAME_MAX_LENGTH},
+            {AGGREGATES_ATTR_NAME_ATTR_NAME, AttrType::TypeVarChar, ATTRIBUTE_NAME_MAX_LENGTH},
+            {AGGREGATES_ATTR_NAME_GROUP_ATTR_NAME, AttrType::TypeVarChar, ATTRIBUTE_NAME_MAX_LENGTH},
+            {AGGREGATES_ATTR_NAME_OPS, AttrType::TypeInt, INTEGER_ATTRIBUTE_LENGTH},
         });
 }
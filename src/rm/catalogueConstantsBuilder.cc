@@ -20,6 +20,93 @@ namespace PeterDB {
     const Attribute AttributesAttributeConstants::ATTRIBUTE_POSITION = Attribute{ATTRIBUTES_ATTR_NAME_POSITION,
                                                                                  AttrType::TypeInt,
                                                                                  INTEGER_ATTRIBUTE_LENGTH};
+    const Attribute AttributesAttributeConstants::SCHEMA_VERSION_ADDED = Attribute{ATTRIBUTES_ATTR_NAME_ADDED,
+                                                                                   AttrType::TypeInt,
+                                                                                   INTEGER_ATTRIBUTE_LENGTH};
+    const Attribute AttributesAttributeConstants::SCHEMA_VERSION_DROPPED = Attribute{ATTRIBUTES_ATTR_NAME_DROPPED,
+                                                                                     AttrType::TypeInt,
+                                                                                     INTEGER_ATTRIBUTE_LENGTH};
+
+    const Attribute IndexesAttributeConstants::TABLE_ID = Attribute{INDEXES_ATTR_NAME_TABLE_ID,
+                                                                    AttrType::TypeInt, INTEGER_ATTRIBUTE_LENGTH};
+    const Attribute IndexesAttributeConstants::ATTRIBUTE_NAME = Attribute{INDEXES_ATTR_NAME_ATTR_NAME,
+                                                                          AttrType::TypeVarChar,
+                                                                          ATTRIBUTE_NAME_MAX_LENGTH};
+    const Attribute IndexesAttributeConstants::FILE_NAME = Attribute{INDEXES_ATTR_NAME_FNAME,
+                                                                     AttrType::TypeVarChar,
+                                                                     INDEX_FILE_NAME_MAX_LENGTH};
+    const Attribute IndexesAttributeConstants::INCLUDED_COLUMNS = Attribute{INDEXES_ATTR_NAME_INCLUDED,
+                                                                            AttrType::TypeVarChar,
+                                                                            INDEX_INCLUDED_COLUMNS_MAX_LENGTH};
+
+    const Attribute StatisticsAttributeConstants::TABLE_ID = Attribute{STATISTICS_ATTR_NAME_TABLE_ID,
+                                                                       AttrType::TypeInt, INTEGER_ATTRIBUTE_LENGTH};
+    const Attribute StatisticsAttributeConstants::ATTRIBUTE_NAME = Attribute{STATISTICS_ATTR_NAME_ATTR_NAME,
+                                                                             AttrType::TypeVarChar,
+                                                                             ATTRIBUTE_NAME_MAX_LENGTH};
+    const Attribute StatisticsAttributeConstants::ROW_COUNT = Attribute{STATISTICS_ATTR_NAME_ROW_COUNT,
+                                                                        AttrType::TypeInt, INTEGER_ATTRIBUTE_LENGTH};
+    const Attribute StatisticsAttributeConstants::PAGE_COUNT = Attribute{STATISTICS_ATTR_NAME_PAGE_COUNT,
+                                                                         AttrType::TypeInt, INTEGER_ATTRIBUTE_LENGTH};
+    const Attribute StatisticsAttributeConstants::AVG_RECORD_SIZE = Attribute{STATISTICS_ATTR_NAME_AVG_RECORD_SIZE,
+                                                                              AttrType::TypeReal,
+                                                                              INTEGER_ATTRIBUTE_LENGTH};
+    const Attribute StatisticsAttributeConstants::SAMPLED = Attribute{STATISTICS_ATTR_NAME_SAMPLED,
+                                                                      AttrType::TypeInt, INTEGER_ATTRIBUTE_LENGTH};
+    const Attribute StatisticsAttributeConstants::NULL_FRACTION = Attribute{STATISTICS_ATTR_NAME_NULL_FRACTION,
+                                                                            AttrType::TypeReal,
+                                                                            INTEGER_ATTRIBUTE_LENGTH};
+    const Attribute StatisticsAttributeConstants::DISTINCT_COUNT = Attribute{STATISTICS_ATTR_NAME_DISTINCT_COUNT,
+                                                                             AttrType::TypeInt,
+                                                                             INTEGER_ATTRIBUTE_LENGTH};
+    const Attribute StatisticsAttributeConstants::MIN_VALUE = Attribute{STATISTICS_ATTR_NAME_MIN_VALUE,
+                                                                        AttrType::TypeVarChar,
+                                                                        STATISTICS_VALUE_MAX_LENGTH};
+    const Attribute StatisticsAttributeConstants::MAX_VALUE = Attribute{STATISTICS_ATTR_NAME_MAX_VALUE,
+                                                                        AttrType::TypeVarChar,
+                                                                        STATISTICS_VALUE_MAX_LENGTH};
+    const Attribute StatisticsAttributeConstants::HISTOGRAM = Attribute{STATISTICS_ATTR_NAME_HISTOGRAM,
+                                                                        AttrType::TypeVarChar,
+                                                                        STATISTICS_HISTOGRAM_MAX_LENGTH};
+
+    const Attribute PartitionsAttributeConstants::TABLE_ID = Attribute{PARTITIONS_ATTR_NAME_TABLE_ID,
+                                                                       AttrType::TypeInt, INTEGER_ATTRIBUTE_LENGTH};
+    const Attribute PartitionsAttributeConstants::ATTRIBUTE_NAME = Attribute{PARTITIONS_ATTR_NAME_ATTR_NAME,
+                                                                             AttrType::TypeVarChar,
+                                                                             ATTRIBUTE_NAME_MAX_LENGTH};
+    const Attribute PartitionsAttributeConstants::METHOD = Attribute{PARTITIONS_ATTR_NAME_METHOD,
+                                                                     AttrType::TypeInt, INTEGER_ATTRIBUTE_LENGTH};
+    const Attribute PartitionsAttributeConstants::COUNT = Attribute{PARTITIONS_ATTR_NAME_COUNT,
+                                                                    AttrType::TypeInt, INTEGER_ATTRIBUTE_LENGTH};
+    const Attribute PartitionsAttributeConstants::BOUNDS = Attribute{PARTITIONS_ATTR_NAME_BOUNDS,
+                                                                     AttrType::TypeVarChar,
+                                                                     PARTITION_BOUNDS_MAX_LENGTH};
+
+    const Attribute TablespacesAttributeConstants::NAME = Attribute{TABLESPACES_ATTR_NAME_NAME,
+                                                                    AttrType::TypeVarChar,
+                                                                    TABLESPACE_NAME_MAX_LENGTH};
+    const Attribute TablespacesAttributeConstants::DIRECTORY = Attribute{TABLESPACES_ATTR_NAME_DIRECTORY,
+                                                                         AttrType::TypeVarChar,
+                                                                         TABLESPACE_DIRECTORY_MAX_LENGTH};
+    const Attribute TablespacesAttributeConstants::POSITION = Attribute{TABLESPACES_ATTR_NAME_POSITION,
+                                                                        AttrType::TypeInt, INTEGER_ATTRIBUTE_LENGTH};
+
+    const Attribute AggregatesAttributeConstants::TABLE_ID = Attribute{AGGREGATES_ATTR_NAME_TABLE_ID,
+                                                                       AttrType::TypeInt, INTEGER_ATTRIBUTE_LENGTH};
+    const Attribute AggregatesAttributeConstants::VIEW_NAME = Attribute{AGGREGATES_ATTR_NAME_VIEW_NAME,
+                                                                        AttrType::TypeVarChar,
+                                                                        ATTRIBUTE_NAME_MAX_LENGTH};
+    const Attribute AggregatesAttributeConstants::BASE_TABLE = Attribute{AGGREGATES_ATTR_NAME_BASE_TABLE,
+                                                                         AttrType::TypeVarChar,
+                                                                         ATTRIBUTE_NAME_MAX_LENGTH};
+    const Attribute AggregatesAttributeConstants::ATTRIBUTE_NAME = Attribute{AGGREGATES_ATTR_NAME_ATTR_NAME,
+                                                                             AttrType::TypeVarChar,
+                                                                             ATTRIBUTE_NAME_MAX_LENGTH};
+    const Attribute AggregatesAttributeConstants::GROUP_ATTRIBUTE_NAME = Attribute{AGGREGATES_ATTR_NAME_GROUP_ATTR_NAME,
+                                                                                   AttrType::TypeVarChar,
+                                                                                   ATTRIBUTE_NAME_MAX_LENGTH};
+    const Attribute AggregatesAttributeConstants::OPS = Attribute{AGGREGATES_ATTR_NAME_OPS,
+                                                                  AttrType::TypeInt, INTEGER_ATTRIBUTE_LENGTH};
 
     // Attributes and values to insert into "Tables" table
     void CatalogueConstantsBuilder::buildTablesTableAttributeAndValues(std::vector<AttributeAndValue> &attributesAndValues) {
@@ -40,4 +127,54 @@ namespace PeterDB {
         attributesAndValues.push_back(AttributeAndValue(TablesAttributeConstants::TABLE_NAME, &tableName));
         attributesAndValues.push_back(AttributeAndValue(TablesAttributeConstants::TABLE_FILENAME, &tableFileName));
     }
+
+// Attributes and values to insert into "Tables" table
+    void CatalogueConstantsBuilder::buildIndexesTableAttributeAndValues(std::vector<AttributeAndValue> &attributesAndValues) {
+        int tableId = 2;
+        std::string tableName = "Indexes";
+        std::string tableFileName = "Indexes";
+        attributesAndValues.push_back(AttributeAndValue(TablesAttributeConstants::TABLE_ID, &tableId));
+        attributesAndValues.push_back(AttributeAndValue(TablesAttributeConstants::TABLE_NAME, &tableName));
+        attributesAndValues.push_back(AttributeAndValue(TablesAttributeConstants::TABLE_FILENAME, &tableFileName));
+    }
+
+// Attributes and values to insert into "Tables" table
+    void CatalogueConstantsBuilder::buildStatisticsTableAttributeAndValues(std::vector<AttributeAndValue> &attributesAndValues) {
+        int tableId = 3;
+        std::string tableName = "Statistics";
+        std::string tableFileName = "Statistics";
+        attributesAndValues.push_back(AttributeAndValue(TablesAttributeConstants::TABLE_ID, &tableId));
+        attributesAndValues.push_back(AttributeAndValue(TablesAttributeConstants::TABLE_NAME, &tableName));
+        attributesAndValues.push_back(AttributeAndValue(TablesAttributeConstants::TABLE_FILENAME, &tableFileName));
+    }
+
+// Attributes and values to insert into "Tables" table
+    void CatalogueConstantsBuilder::buildPartitionsTableAttributeAndValues(std::vector<AttributeAndValue> &attributesAndValues) {
+        int tableId = 4;
+        std::string tableName = "Partitions";
+        std::string tableFileName = "Partitions";
+        attributesAndValues.push_back(AttributeAndValue(TablesAttributeConstants::TABLE_ID, &tableId));
+        attributesAndValues.push_back(AttributeAndValue(TablesAttributeConstants::TABLE_NAME, &tableName));
+        attributesAndValues.push_back(AttributeAndValue(TablesAttributeConstants::TABLE_FILENAME, &tableFileName));
+    }
+
+// Attributes and values to insert into "Tables" table
+    void CatalogueConstantsBuilder::buildTablespacesTableAttributeAndValues(std::vector<AttributeAndValue> &attributesAndValues) {
+        int tableId = 5;
+        std::string tableName = "Tablespaces";
+        std::string tableFileName = "Tablespaces";
+        attributesAndValues.push_back(AttributeAndValue(TablesAttributeConstants::TABLE_ID, &tableId));
+        attributesAndValues.push_back(AttributeAndValue(TablesAttributeConstants::TABLE_NAME, &tableName));
+        attributesAndValues.push_back(AttributeAndValue(TablesAttributeConstants::TABLE_FILENAME, &tableFileName));
+    }
+
+// Attributes and values to insert into "Tables" table
+    void CatalogueConstantsBuilder::buildAggregatesTableAttributeAndValues(std::vector<AttributeAndValue> &attributesAndValues) {
+        int tableId = 6;
+        std::string tableName = "Aggregates";
+        std::string tableFileName = "Aggregates";
+        attributesAndValues.push_back(AttributeAndValue(TablesAttributeConstants::TABLE_ID, &tableId));
+        attributesAndValues.push_back(AttributeAndValue(TablesAttributeConstants::TABLE_NAME, &tableName));
+        attributesAndValues.push_back(AttributeAndValue(TablesAttributeConstants::TABLE_FILENAME, &tableFileName));
+    }
 }
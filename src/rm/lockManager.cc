@@ -0,0 +1,241 @@
+#include "src/include/lockManager.h"
+#include "src/include/util.h"
+
+#include <chrono>
+#include <tuple>
+#include <vector>
+
+namespace PeterDB {
+
+    LockId LockId::table(const std::string &tableName) {
+        LockId lockId;
+        lockId.tableName = tableName;
+        return lockId;
+    }
+
+    LockId LockId::page(const std::string &tableName, PageNum pageNum) {
+        LockId lockId;
+        lockId.tableName = tableName;
+        lockId.pageNum = (int) pageNum;
+        return lockId;
+    }
+
+    LockId LockId::row(const std::string &tableName, const RID &rid) {
+        LockId lockId;
+        lockId.tableName = tableName;
+        lockId.pageNum = (int) rid.pageNum;
+        lockId.slotNum = rid.slotNum;
+        return lockId;
+    }
+
+    bool LockId::operator<(const LockId &other) const {
+        return std::tie(tableName, pageNum, slotNum) < std::tie(other.tableName, other.pageNum, other.slotNum);
+    }
+
+    LockManager &LockManager::instance() {
+        static LockManager _lock_manager;
+        return _lock_manager;
+    }
+
+    LockManager::LockManager() : m_nextTxn(1), m_nextSession(1) {
+    }
+
+    LockManager::~LockManager() = default;
+
+    SessionId LockManager::beginSession() {
+        return m_nextSession++;
+    }
+
+    TxnId LockManager::beginTransaction(SessionId session) {
+        TxnId txn = m_nextTxn++;
+        if (0 != session) {
+            std::lock_guard<std::mutex> guard(m_mutex);
+            m_sessions[txn] = session;
+        }
+        return txn;
+    }
+
+    bool LockManager::compatible(LockMode held, LockMode requested) {
+        //                       IS     IX     S      SIX    X
+        static const bool matrix[5][5] = {
+                /* IS  */       {true,  true,  true,  true,  false},
+                /* IX  */       {true,  true,  false, false, false},
+                /* S   */       {true,  false, true,  false, false},
+                /* SIX */       {true,  false, false, false, false},
+                /* X   */       {false, false, false, false, false}
+        };
+        return matrix[held][requested];
+    }
+
+    LockMode LockManager::combine(LockMode a, LockMode b) {
+        if (a == b || IntentionShared == b) {
+            return a;
+        }
+        if (IntentionShared == a) {
+            return b;
+        }
+        if (Exclusive == a || Exclusive == b) {
+            return Exclusive;
+        }
+        // what is left are two different modes out of IX, S and SIX
+        return SharedIntentionExclusive;
+    }
+
+    bool LockManager::conflicts(TxnId txn, TxnId holder, LockMode held, LockMode requested) {
+        if (txn == holder || compatible(held, requested)) {
+            return false;
+        }
+
+        auto session = m_sessions.find(txn);
+        if (m_sessions.end() == session) {
+            return true;
+        }
+        auto holderSession = m_sessions.find(holder);
+        return m_sessions.end() == holderSession || session->second != holderSession->second;
+    }
+
+    bool LockManager::grantable(TxnId txn, const LockId &lockId, LockMode mode) {
+        auto holders = m_locks.find(lockId);
+        if (m_locks.end() == holders) {
+            return true;
+        }
+        for (auto &holder : holders->second) {
+            if (conflicts(txn, holder.first, holder.second, mode)) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    bool LockManager::waitWouldDeadlock(TxnId txn, const LockId &lockId, LockMode mode) {
+        // depth-first through the transactions txn would wait for, and the ones those wait for
+        std::vector<WaitingRequest> toVisit(1, WaitingRequest{lockId, mode});
+        std::vector<TxnId> waiters(1, txn);
+        std::set<TxnId> visited;
+        while (!toVisit.empty()) {
+            WaitingRequest request = toVisit.back();
+            TxnId waiter = waiters.back();
+            toVisit.pop_back();
+            waiters.pop_back();
+
+            auto holders = m_locks.find(request.lockId);
+            if (m_locks.end() == holders) {
+                continue;
+            }
+            for (auto &holder : holders->second) {
+                if (!conflicts(waiter, holder.first, holder.second, request.mode)) {
+                    continue;
+                }
+                if (holder.first == txn) {
+                    return true;
+                }
+                if (!visited.insert(holder.first).second) {
+                    continue;
+                }
+                auto waiting = m_waiting.find(holder.first);
+                if (m_waiting.end() != waiting) {
+                    toVisit.push_back(waiting->second);
+                    waiters.push_back(holder.first);
+                }
+            }
+        }
+        return false;
+    }
+
+    RC LockManager::lock(TxnId txn, const LockId &lockId, LockMode mode) {
+        std::unique_lock<std::mutex> guard(m_mutex);
+
+        auto holders = m_locks.find(lockId);
+        if (m_locks.end() != holders) {
+            auto held = holders->second.find(txn);
+            if (holders->second.end() != held) {
+                mode = combine(held->second, mode);
+                if (mode == held->second) {
+                    return 0;
+                }
+            }
+        }
+
+        if (!grantable(txn, lockId, mode)) {
+            m_waits++;
+            auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(m_waitTimeoutMs);
+            m_waiting[txn] = WaitingRequest{lockId, mode};
+            while (!grantable(txn, lockId, mode)) {
+                // the graph changes while waiting, a cycle can only be closed by this wait though
+                if (waitWouldDeadlock(txn, lockId, mode)) {
+                    m_deadlocks++;
+                    m_waiting.erase(txn);
+                    WARNING("Transaction %llu would deadlock waiting for a lock on table %s, page %d, slot %d\n",
+                            (unsigned long long) txn, lockId.tableName.c_str(), lockId.pageNum, lockId.slotNum);
+                    return -1;
+                }
+                if (std::cv_status::timeout == m_released.wait_until(guard, deadline) &&
+                    !grantable(txn, lockId, mode)) {
+                    m_waiting.erase(txn);
+                    WARNING("Transaction %llu timed out waiting for a lock on table %s, page %d, slot %d\n",
+                            (unsigned long long) txn, lockId.tableName.c_str(), lockId.pageNum, lockId.slotNum);
+                    return -1;
+                }
+            }
+            m_waiting.erase(txn);
+        }
+
+        m_locks[lockId][txn] = mode;
+        m_held[txn].insert(lockId);
+        return 0;
+    }
+
+    RC LockManager::lockRow(TxnId txn, const std::string &tableName, const RID &rid, LockMode mode) {
+        LockMode intention = (Shared == mode || IntentionShared == mode) ? IntentionShared : IntentionExclusive;
+        if (0 != lock(txn, LockId::table(tableName), intention) ||
+            0 != lock(txn, LockId::page(tableName, rid.pageNum), intention)) {
+            return -1;
+        }
+        return lock(txn, LockId::row(tableName, rid), mode);
+    }
+
+    void LockManager::releaseAll(TxnId txn) {
+        std::lock_guard<std::mutex> guard(m_mutex);
+        m_sessions.erase(txn);
+        auto held = m_held.find(txn);
+        if (m_held.end() == held) {
+            return;
+        }
+
+        for (auto &lockId : held->second) {
+            auto holders = m_locks.find(lockId);
+            holders->second.erase(txn);
+            if (holders->second.empty()) {
+                m_locks.erase(holders);
+            }
+        }
+        m_held.erase(held);
+        m_released.notify_all();
+    }
+
+    bool LockManager::holds(TxnId txn, const LockId &lockId, LockMode mode) {
+        std::lock_guard<std::mutex> guard(m_mutex);
+        auto holders = m_locks.find(lockId);
+        if (m_locks.end() == holders) {
+            return false;
+        }
+        auto held = holders->second.find(txn);
+        return holders->second.end() != held && combine(held->second, mode) == held->second;
+    }
+
+    void LockManager::setWaitTimeout(unsigned milliseconds) {
+        std::lock_guard<std::mutex> guard(m_mutex);
+        m_waitTimeoutMs = milliseconds;
+    }
+
+    unsigned long LockManager::getDeadlockCount() {
+        std::lock_guard<std::mutex> guard(m_mutex);
+        return m_deadlocks;
+    }
+
+    unsigned long LockManager::getWaitCount() {
+        std::lock_guard<std::mutex> guard(m_mutex);
+        return m_waits;
+    }
+
+} // namespace PeterDB
@@ -1,12 +1,21 @@
 #include "src/include/rm.h"
 #include "src/include/ix.h"
 #include "src/include/attributeAndValueSerializer.h"
+#include "src/include/externalSorter.h"
+#include "src/include/compositeKey.h"
+#include "src/include/lockManager.h"
 
-#include <dirent.h>
+#include <algorithm>
+#include <memory>
 
 namespace PeterDB {
     RelationManager &RelationManager::instance() {
-        static RelationManager _relation_manager = RelationManager();
+        // construct the lower layers first, so that they are destroyed after this one,
+        // which still closes its open table files on destruction
+        RecordBasedFileManager::instance();
+        IndexManager::instance();
+
+        static RelationManager _relation_manager;
         if (nullptr == _relation_manager.m_rbfm) {
             _relation_manager.m_rbfm = &RecordBasedFileManager::instance();
         }
@@ -18,60 +27,452 @@ namespace PeterDB {
 
     RelationManager::RelationManager() = default;
 
-    RelationManager::~RelationManager() = default;
-
-    RelationManager::RelationManager(const RelationManager &) = default;
-
-    RelationManager &RelationManager::operator=(const RelationManager &) = default;
+    RelationManager::~RelationManager() {
+        closeAllTableHandles();
+    }
 
     std::string getFileName(const std::string& tableName) {
         return tableName; // + ".bin"; we don't have a choice.. test cases expects this way
     }
 
+    bool isAttrNull(const void *recordData, const uint16_t &attrNum);
+
+    unsigned tupleSize(const void *data, const std::vector<Attribute> &attrs);
+
+    // the name of a memory file on disk, e.g. for the temporary files used along with it
+    static std::string withoutMemoryPrefix(const std::string &fileName) {
+        return PagedFileManager::isMemoryFile(fileName) ? fileName.substr(strlen(MEMORY_FILE_PREFIX)) : fileName;
+    }
+
+    // sort runs for a file go next to it on disk, in the working directory for memory files
+    static std::string runFilePrefix(const std::string &fileName) {
+        return PagedFileManager::instance().getPath(withoutMemoryPrefix(fileName));
+    }
+
+    // the transaction the calling thread began, 0 outside of one
+    static thread_local TxnId t_transaction = 0;
+
+    // set once a lock request of the thread's transaction failed, on a deadlock or a timeout. the calls it
+    // makes fail from then on, and so does its commit
+    static thread_local bool t_transactionFailed = false;
+
+    // each thread is a session of its own
+    static thread_local SessionId t_session = 0;
+
+    static TxnId beginThreadTransaction() {
+        if (0 == t_session) {
+            t_session = LockManager::instance().beginSession();
+        }
+        return LockManager::instance().beginTransaction(t_session);
+    }
+
+    // calls of RelationManager the calling thread is in the middle of
+    static thread_local unsigned t_callDepth = 0;
+
+    // the outermost of them holds RelationManager::m_latch shared
+    static thread_local bool t_sharedCall = false;
+
+    enum LatchMode {
+        ExclusiveCall,
+        SharedCall
+    };
+
+    // Holds RelationManager::m_latch for its scope. The calls made meanwhile, e.g. to the partitions
+    // of a table, or by a scan reading the tuples of the entries of an index, are part of this call: only
+    // the outermost call takes the latch, and one holding it shared makes no call needing it exclusively.
+    // The call is an operation of the write-ahead log as well, a crash in the middle of it drops its pages
+    class LatchedCall {
+    public:
+        explicit LatchedCall(SharedLatch &latch, LatchMode mode = ExclusiveCall)
+                : m_latch(latch), m_outermost(0 == t_callDepth) {
+            if (m_outermost) {
+                SharedCall == mode ? m_latch.lock_shared() : m_latch.lock();
+                t_sharedCall = SharedCall == mode;
+            }
+            assert(SharedCall == mode || !t_sharedCall);
+            t_callDepth++;
+            WriteAheadLog::instance().beginOperation();
+        }
+
+        ~LatchedCall() {
+            WriteAheadLog::instance().endOperation();
+            t_callDepth--;
+            if (m_outermost) {
+                t_sharedCall ? m_latch.unlock_shared() : m_latch.unlock();
+                t_sharedCall = false;
+            }
+        }
+
+        // the latch is held shared by this call, not by an outer one
+        bool holdsShared() const {
+            return m_outermost && t_sharedCall;
+        }
+
+    private:
+        SharedLatch &m_latch;
+        bool m_outermost;
+
+        LatchedCall(const LatchedCall &);
+        LatchedCall &operator=(const LatchedCall &);
+    };
+
+    // Holds a latch of RelationManager guarding state shared by the calls holding m_latch shared, when the
+    // calling thread holds it shared. With m_latch held exclusively, there is no other call to keep out
+    class SharedCallGuard {
+    public:
+        explicit SharedCallGuard(std::mutex &latch) : m_guard(latch, std::defer_lock) {
+            if (t_sharedCall) {
+                m_guard.lock();
+            }
+        }
+
+    private:
+        std::unique_lock<std::mutex> m_guard;
+    };
+
+    // a change of the thread's transaction to a tuple, and what undoes it
+    struct UndoRecord {
+        TupleChange change;
+        std::string tableName;
+        RID rid;
+        std::string tuple;      // before the change
+    };
+
+    // the changes of the thread's transaction, oldest first
+    static thread_local std::vector<UndoRecord> t_undo;
+
+    // The locks of a call of RelationManager, taken for the transaction of the thread, or for a transaction
+    // of the call's own, ending with it. Calls made by another call take none, the outer call has them
+    class TransactionScope {
+    public:
+        TransactionScope() : m_nested(t_callDepth > 0), m_ownTransaction(!m_nested && 0 == t_transaction) {
+            m_txn = m_ownTransaction ? beginThreadTransaction() : t_transaction;
+        }
+
+        ~TransactionScope() {
+            if (m_ownTransaction) {
+                LockManager::instance().releaseAll(m_txn);
+            }
+        }
+
+        RC lockTable(const std::string &tableName, LockMode mode) {
+            if (m_nested) {
+                return 0;
+            }
+            return checkLock(LockManager::instance().lock(m_txn, LockId::table(tableName), mode));
+        }
+
+        RC lockRows(const std::string &tableName, const std::vector<RID> &rids, LockMode mode) {
+            for (auto &rid : rids) {
+                if (!m_nested && 0 != checkLock(LockManager::instance().lockRow(m_txn, tableName, rid, mode))) {
+                    return -1;
+                }
+            }
+            return 0;
+        }
+
+        // rc of a call changing tuples, once its changes are in the log for a transaction of its own
+        RC commit(RC rc) {
+            WriteAheadLog &wal = WriteAheadLog::instance();
+            if (!m_ownTransaction || !wal.isOpen()) {
+                return rc;
+            }
+            RC committed = wal.commit();
+            return 0 != rc ? rc : committed;
+        }
+
+        // the call is a transaction of its own, it isn't part of the thread's transaction nor of another call
+        bool ownsTransaction() const {
+            return m_ownTransaction;
+        }
+
+        // a scan outside of a transaction keeps its locks until it is closed, it gets the transaction
+        // of the call along with them. 0 when there is nothing to hand over
+        TxnId handOver() {
+            if (!m_ownTransaction) {
+                return 0;
+            }
+            m_ownTransaction = false;
+            return m_txn;
+        }
+
+    private:
+        bool m_nested;
+        bool m_ownTransaction;
+        TxnId m_txn = 0;
+
+        // rc of a lock request. in the thread's transaction, a failed one fails the transaction, which
+        // takes no lock anymore
+        RC checkLock(RC rc) {
+            if (m_ownTransaction) {
+                return rc;
+            }
+            if (t_transactionFailed) {
+                ERROR("Transaction %llu failed, it can only be committed\n", (unsigned long long) m_txn);
+                return -1;
+            }
+            t_transactionFailed = 0 != rc;
+            return rc;
+        }
+
+        TransactionScope(const TransactionScope &);
+        TransactionScope &operator=(const TransactionScope &);
+    };
+
+    RC RelationManager::beginTransaction() {
+        if (0 != t_transaction) {
+            ERROR("The thread is in transaction %llu already\n", (unsigned long long) t_transaction);
+            return -1;
+        }
+        t_transaction = beginThreadTransaction();
+        return 0;
+    }
+
+    RC RelationManager::commitTransaction() {
+        if (0 == t_transaction) {
+            ERROR("The thread is not in a transaction\n");
+            return -1;
+        }
+
+        // a failed transaction is undone before its locks go, nobody saw its changes but snapshots taken
+        // before it, which its write span keeps them from
+        RC rc = 0;
+        if (t_transactionFailed) {
+            ERROR("Transaction %llu failed, the changes it made are undone\n", (unsigned long long) t_transaction);
+            rollBack();
+            rc = -1;
+        }
+        t_undo.clear();
+
+        {
+            LatchedCall latched(m_latch, SharedCall);
+            endWriteSpan();
+        }
+
+        // the changes of the transaction are logged, but other commits may not have written the log out yet
+        if (0 != WriteAheadLog::instance().commit()) {
+            rc = -1;
+        }
+        LockManager::instance().releaseAll(t_transaction);
+        t_transaction = 0;
+        t_transactionFailed = false;
+        return rc;
+    }
+
+    void RelationManager::keepUndo(TupleChange change, const std::string &tableName,
+                                   const std::vector<Attribute> &attrs, const std::vector<RID> &rids,
+                                   const std::vector<const void *> &tuples) {
+        if (0 == t_transaction || isMaterializedAggregate(tableName)) {
+            return;
+        }
+        for (size_t i = 0; i < rids.size(); i++) {
+            UndoRecord record = {change, tableName, rids[i], ""};
+            if (TuplesInserted != change) {
+                record.tuple.assign((const char *) tuples[i], tupleSize(tuples[i], attrs));
+            }
+            t_undo.push_back(record);
+        }
+    }
+
+    RC RelationManager::rollBack() {
+        // the undo is one call, and one operation of the log: a crash leaves the transaction's changes
+        // either all there or all undone. the calls it makes take no locks, the transaction has them
+        std::vector<UndoRecord> undo;
+        undo.swap(t_undo);
+        LatchedCall latched(m_latch);
+        RC rc = 0;
+        for (auto it = undo.rbegin(); it != undo.rend(); it++) {
+            std::vector<RID> rids;
+            RC undone;
+            switch (it->change) {
+                case TuplesInserted:
+                    undone = deleteTuples(it->tableName, {it->rid});
+                    break;
+                case TuplesDeleted:
+                    undone = insertTuples(it->tableName, {it->tuple.data()}, rids);
+                    break;
+                default:
+                    undone = updateTuples(it->tableName, {it->tuple.data()}, {it->rid});
+                    break;
+            }
+            if (0 != undone) {
+                ERROR("Error while undoing a change to table %s\n", it->tableName.c_str());
+                rc = -1;
+            }
+        }
+        // what undoing changed is no change of the transaction
+        t_undo.clear();
+        return rc;
+    }
+
+    void RelationManager::beginWriteSpan() {
+        if (0 == t_transaction) {
+            return;
+        }
+        SharedCallGuard guard(m_writeSpansLatch);
+        if (m_writeSpans.end() != m_writeSpans.find(t_transaction)) {
+            return;
+        }
+        WriteSpan span = {m_rbfm->beginSnapshot(), 0, false};
+        m_writeSpans[t_transaction] = span;
+    }
+
+    void RelationManager::endWriteSpan() {
+        SharedCallGuard guard(m_writeSpansLatch);
+        auto span = m_writeSpans.find(t_transaction);
+        if (m_writeSpans.end() == span) {
+            return;
+        }
+        span->second.end = m_rbfm->getTimestamp();
+        span->second.committed = true;
+
+        // snapshots taken from now on are no older than the one taken now, the spans ending before it
+        // can't be split by any
+        Timestamp oldestSnapshot = snapshotTimestamp();
+        for (auto it = m_writeSpans.begin(); it != m_writeSpans.end();) {
+            if (it->second.committed && it->second.end <= oldestSnapshot) {
+                m_rbfm->endSnapshot(it->second.start);
+                it = m_writeSpans.erase(it);
+            } else {
+                ++it;
+            }
+        }
+    }
+
+    Timestamp RelationManager::snapshotTimestamp() {
+        // stepping back before a span can make the snapshot fall into another one, begun earlier
+        Timestamp snapshot = m_rbfm->getTimestamp();
+        bool steppedBack = true;
+        while (steppedBack) {
+            steppedBack = false;
+            for (auto &span : m_writeSpans) {
+                if (span.second.start < snapshot && (!span.second.committed || snapshot < span.second.end)) {
+                    snapshot = span.second.start;
+                    steppedBack = true;
+                }
+            }
+        }
+        return snapshot;
+    }
+
     RC RelationManager::createCatalog() {
+        LatchedCall latched(m_latch);
         if (m_catalogCreated) return 0;
 
         m_catalogCreated = true;
+        m_catalogCache.clear();
         INFO("Creating Catalogue\n");
 
         initTablesTable();
         initAttributesTable();
-
-        m_tablesCreated[CatalogueConstants::TABLES_FILE_NAME] = true;
-        m_tablesCreated[CatalogueConstants::ATTRIBUTES_FILE_NAME] = true;
+        initIndexesTable();
+        initStatisticsTable();
+        initPartitionsTable();
+        initTablespacesTable();
+        initAggregatesTable();
+
+        m_tablesCreated[CatalogueConstants::TABLES_FILE_NAME] = CatalogueConstants::TABLES_FILE_NAME;
+        m_tablesCreated[CatalogueConstants::ATTRIBUTES_FILE_NAME] = CatalogueConstants::ATTRIBUTES_FILE_NAME;
+        m_tablesCreated[CatalogueConstants::INDEXES_FILE_NAME] = CatalogueConstants::INDEXES_FILE_NAME;
+        m_tablesCreated[CatalogueConstants::STATISTICS_FILE_NAME] = CatalogueConstants::STATISTICS_FILE_NAME;
+        m_tablesCreated[CatalogueConstants::PARTITIONS_FILE_NAME] = CatalogueConstants::PARTITIONS_FILE_NAME;
+        m_tablesCreated[CatalogueConstants::TABLESPACES_FILE_NAME] = CatalogueConstants::TABLESPACES_FILE_NAME;
+        m_tablesCreated[CatalogueConstants::AGGREGATES_FILE_NAME] = CatalogueConstants::AGGREGATES_FILE_NAME;
 
         INFO("Created Catalogue\n");
         return 0;
     }
 
     RC RelationManager::deleteCatalog() {
+        LatchedCall latched(m_latch);
         if (!m_catalogCreated) return -1;
 
+        closeAllTableHandles();
         for (auto &table : m_tablesCreated) {
-            m_rbfm->destroyFile(getFileName(table.first));
+            m_rbfm->destroyFile(table.second);
         }
 
         m_tablesCreated.clear();
+        m_catalogCache.clear();
 
         m_catalogCreated = false;
 
         return 0;
     }
 
+    // the attribute the zone map of an append-only table is kept on, none if the table has no int/real one
+    static std::string zoneMapAttribute(const std::vector<Attribute> &attrs, const TableOptions &options) {
+        if (!options.timeAttribute.empty()) {
+            return options.timeAttribute;
+        }
+        for (auto &attr : attrs) {
+            if (TypeVarChar != attr.type && attr.name.length() < sizeof(PageSelectorTrailer::zoneAttrName)) {
+                return attr.name;
+            }
+        }
+        return "";
+    }
+
     RC RelationManager::createTable(const std::string &tablezName, const std::vector<Attribute> &attrs) {
+        return createTable(tablezName, attrs, TableOptions());
+    }
+
+    RC RelationManager::createTable(const std::string &tablezName, const std::vector<Attribute> &attrs,
+                                    const TableOptions &options) {
+        TransactionScope transaction;
+        if (0 != transaction.lockTable(tablezName, Exclusive)) {
+            return -1;
+        }
+        LatchedCall latched(m_latch);
         if (!m_catalogCreated) return -1;
 
-        if (tablezName == CatalogueConstants::TABLES_FILE_NAME ||
-            tablezName == CatalogueConstants::ATTRIBUTES_FILE_NAME) {
+        if (isCatalogTable(tablezName)) {
+            return -1;
+        }
+
+        // the tuples of a partitioned table are in its partitions, it has no file of its own
+        bool partitioned = NoPartitioning != options.partitioning.method;
+        if (partitioned && 0 != checkPartitioning(attrs, options.partitioning)) {
+            ERROR("Invalid partitioning of table %s\n", tablezName.c_str());
             return -1;
         }
 
         std::string tableFileName = getFileName(tablezName);
-        if (0 != m_rbfm->createFile(tableFileName)) {
+        if (MemoryStorage == options.storage) {
+            tableFileName = PagedFileManager::memoryFileName(tableFileName);
+        }
+        if (!options.tablespace.empty()) {
+            tableFileName = PagedFileManager::tablespaceFileName(options.tablespace, tableFileName);
+            if (MemoryStorage == options.storage || tableFileName.size() > ATTRIBUTE_NAME_MAX_LENGTH ||
+                0 != loadTablespace(options.tablespace)) {
+                ERROR("Table %s can't go to tablespace %s\n", tablezName.c_str(), options.tablespace.c_str());
+                return -1;
+            }
+        }
+        if (options.striped && options.tablespace.empty()) {
+            ERROR("Table %s can only be striped over the directories of a tablespace\n", tablezName.c_str());
+            return -1;
+        }
+        PagedFileManager &pfm = PagedFileManager::instance();
+        if (!partitioned &&
+            0 != (options.striped ? pfm.createStripedFile(tableFileName) : m_rbfm->createFile(tableFileName))) {
             ERROR("Error while creating the file for table %s\n", tableFileName);
             return -1;
         }
 
+        if (!partitioned && options.appendOnly) {
+            FileHandle tableFileHandle;
+            m_rbfm->openFile(tableFileName, tableFileHandle);
+            auto ea = m_rbfm->enableAppendOnly(tableFileHandle, attrs, zoneMapAttribute(attrs, options));
+            m_rbfm->closeFile(tableFileHandle);
+
+            if (0 != ea) {
+                ERROR("Error while making table %s append-only\n", tablezName.c_str());
+                m_rbfm->destroyFile(tableFileName);
+                return -1;
+            }
+        }
+
         // find next TID
         int tid = computeNextTableId();
         INFO("Creating table for tableName=%s; allottedTID=%d\n", tablezName.data(), tid);
@@ -106,28 +507,92 @@ namespace PeterDB {
         // prepare and insert table attribute details into "Attributes" table
         buildAndInsertAttributesIntoAttributesTable(attrs, tid);
 
-        m_tablesCreated[tablezName] = true;
+        m_tablesCreated[tablezName] = tableFileName;
+        invalidateCatalogEntry(tablezName);
+
+        // ======= STEP 3
+        // record how the table is partitioned, and create the table of each partition
+        if (partitioned) {
+            if (0 != insertPartitioningIntoCatalog(tid, options.partitioning)) {
+                ERROR("Error while inserting the partitioning of table %s into the catalog\n", tablezName.c_str());
+                return -1;
+            }
+            TableOptions partitionOptions = options;
+            partitionOptions.partitioning = PartitionSpec();
+            for (unsigned p = 0; p < options.partitioning.partitionCount(); p++) {
+                if (0 != createTable(partitionTableName(tablezName, p), attrs, partitionOptions)) {
+                    ERROR("Error while creating partition %u of table %s\n", p, tablezName.c_str());
+                    return -1;
+                }
+            }
+        }
         return 0;
     }
 
     RC RelationManager::deleteTable(const std::string &tableName) {
+        TransactionScope transaction;
+        if (0 != transaction.lockTable(tableName, Exclusive)) {
+            return -1;
+        }
+        for (auto &viewName : getAggregateViewNames(tableName)) {
+            if (0 != transaction.lockTable(viewName, Exclusive)) {
+                return -1;
+            }
+        }
+        LatchedCall latched(m_latch);
         if (!m_catalogCreated) return -1;
 
-        if (tableName == CatalogueConstants::TABLES_FILE_NAME ||
-            tableName == CatalogueConstants::ATTRIBUTES_FILE_NAME) {
+        if (isCatalogTable(tableName)) {
             return -1;
         }
 
+        // tables created by an earlier process are only in the catalog
+        CatalogEntry *entry = nullptr;
+        int tableId = 0 == getCatalogEntry(tableName, entry) ? entry->tableId : -1;
         auto it = m_tablesCreated.find(tableName);
         if (m_tablesCreated.end() == it) {
             ERROR("Delete table '%s' not possible, it was not created\n", tableName);
             return -1;
         }
 
+        std::string tableFileName = it->second;
         m_tablesCreated.erase(it);
 
-        m_rbfm->destroyFile(getFileName(tableName));
-        destroyIndex(tableName);
+        unsigned partitionCount = -1 != tableId ? entry->partitioning.partitionCount() : 0;
+        std::vector<AggregateView> views;
+        bool isView = false;
+        if (-1 != tableId) {
+            views = entry->aggregateViews;
+            isView = !entry->aggregateOf.empty();
+        }
+
+        closeTableHandle(tableName);
+        if (0 == partitionCount) {
+            m_rbfm->destroyFile(tableFileName);
+            destroyIndex(tableName);
+        } else {
+            // the partitions take their indexes along
+            for (unsigned p = 0; p < partitionCount; p++) {
+                deleteTable(partitionTableName(tableName, p));
+            }
+            deletePartitioningFromCatalog(tableId);
+        }
+        if (-1 != tableId) {
+            deleteStatisticsFromCatalog(tableId);
+            deleteTableFromCatalog(tableId);
+        }
+
+        // the materialized aggregates of a table go along with it, while one deleted on its own is no
+        // longer updated by its base table
+        if (isView) {
+            deleteAggregateFromCatalog(tableName);
+        }
+        for (auto &view : views) {
+            if (view.baseTable == tableName) {
+                deleteTable(view.name);
+            }
+        }
+        invalidateCatalogEntry(tableName);
         return 0;
     }
 
@@ -167,14 +632,57 @@ namespace PeterDB {
         assert(nullptr != tableIdData);
         RID tableIdRid;
 
-        int numTables = 0;
+        // ids of deleted tables are gone from Tables, so the next one comes after the highest id
+        int nextTableId = 0;
         while(RBFM_EOF != rbfmsi.getNextRecord(tableIdRid, tableIdData)) {
-            numTables++;
+            nextTableId = std::max(nextTableId, *((int*) ((char*) tableIdData + 1)) + 1);
         }
         rbfmsi.close();
+        m_rbfm->closeFile(tableFileHandle);
 
         free(tableIdData);
-        return numTables;
+        return nextTableId;
+    }
+
+    RC RelationManager::deleteTableFromCatalog(int tableId) {
+        // both tables have the table id as their first attribute
+        const std::vector<std::pair<std::string, const std::vector<Attribute> *> > catalogTables = {
+            {CatalogueConstants::TABLES_FILE_NAME, &CatalogueConstants::tablesTableAttributes},
+            {CatalogueConstants::ATTRIBUTES_FILE_NAME, &CatalogueConstants::attributesTableAttributes}};
+
+        RC rc = 0;
+        for (auto &catalogTable : catalogTables) {
+            FileHandle fileHandle;
+            if (0 != m_rbfm->openFile(catalogTable.first, fileHandle)) {
+                ERROR("Error while opening %s file", catalogTable.first.c_str());
+                return -1;
+            }
+
+            std::vector<std::string> attrsToRead = {TABLE_ATTR_NAME_ID};
+            RBFM_ScanIterator rbfmsi;
+            if (0 != m_rbfm->scan(fileHandle, *catalogTable.second, TABLE_ATTR_NAME_ID, EQ_OP, &tableId, attrsToRead,
+                                  rbfmsi)) {
+                m_rbfm->closeFile(fileHandle);
+                return -1;
+            }
+
+            // nullflags + table-id
+            char data[1 + 4];
+            RID rid;
+            std::vector<RID> ridsToDelete;
+            while (RBFM_EOF != rbfmsi.getNextRecord(rid, data)) {
+                ridsToDelete.push_back(rid);
+            }
+            rbfmsi.close();
+
+            for (auto &ridToDelete : ridsToDelete) {
+                if (0 != m_rbfm->deleteRecord(fileHandle, *catalogTable.second, ridToDelete)) {
+                    rc = -1;
+                }
+            }
+            m_rbfm->closeFile(fileHandle);
+        }
+        return rc;
     }
 
     AttrType getAttrType(uint32_t attrType) {
@@ -229,6 +737,96 @@ namespace PeterDB {
     }
 
     RC RelationManager::getAttributes(const std::string &tableName, std::vector<Attribute> &attrs) {
+        LatchedCall latched(m_latch);
+        CatalogEntry *entry = nullptr;
+        if (0 != getCatalogEntry(tableName, entry)) {
+            return -1;
+        }
+
+        attrs.insert(attrs.end(), entry->attrs.begin(), entry->attrs.end());
+        return 0;
+    }
+
+    RC RelationManager::getCatalogEntry(const std::string &tableName, CatalogEntry *&entry) {
+        auto it = m_catalogCache.find(tableName);
+        if (m_catalogCache.end() == it) {
+            // other calls may be using the cache
+            if (t_sharedCall) {
+                ERROR("The catalog entry of table %s is read with the latch held shared\n", tableName.c_str());
+                return -1;
+            }
+            CatalogEntry loadedEntry;
+            if (0 != loadCatalogEntry(tableName, loadedEntry)) {
+                return -1;
+            }
+            it = m_catalogCache.insert(std::make_pair(tableName, loadedEntry)).first;
+
+            // tables created by an earlier process are known from their first use on
+            m_tablesCreated[tableName] = it->second.fileName;
+            if (0 != restoreMemoryTable(tableName, it->second)) {
+                ERROR("Error while restoring the memory table %s\n", tableName.c_str());
+                return -1;
+            }
+        }
+
+        entry = &(it->second);
+        return 0;
+    }
+
+    CatalogEntry *RelationManager::getCachedEntry(const std::string &tableName) {
+        auto it = m_catalogCache.find(tableName);
+        return m_catalogCache.end() == it ? nullptr : &(it->second);
+    }
+
+    bool RelationManager::isPlainTable(const std::string &tableName) {
+        CatalogEntry *entry = getCachedEntry(tableName);
+        return nullptr != entry && !isCatalogTable(tableName) && NoPartitioning == entry->partitioning.method &&
+               entry->aggregateViews.empty() && entry->aggregateOf.empty();
+    }
+
+    RC RelationManager::restoreMemoryTable(const std::string &tableName, const CatalogEntry &entry) {
+        // a materialized aggregate holds what its base table does, which is restored first
+        CatalogEntry *baseEntry = nullptr;
+        if (!entry.aggregateOf.empty() && 0 != getCatalogEntry(entry.aggregateOf, baseEntry)) {
+            return -1;
+        }
+
+        // partitioned tables have no file of their own, their partitions are restored one by one
+        PagedFileManager &pfm = PagedFileManager::instance();
+        if (!PagedFileManager::isMemoryFile(entry.fileName) || NoPartitioning != entry.partitioning.method ||
+            pfm.fileExists(entry.fileName)) {
+            return 0;
+        }
+
+        // the tuples of a memory table are gone with the process which inserted them, the table itself is
+        // still in the catalog: it comes back empty, along with its indexes. being append-only isn't kept
+        // in the catalog, such tables come back as heap tables
+        INFO("Memory table %s is restored empty\n", tableName.c_str());
+        if (0 != m_rbfm->createFile(entry.fileName)) {
+            return -1;
+        }
+        for (auto &indexFileName : entry.indexFileNames) {
+            if (!pfm.fileExists(indexFileName.second) && 0 != m_ix->createFile(indexFileName.second)) {
+                return -1;
+            }
+        }
+        deleteStatisticsFromCatalog(entry.tableId);
+
+        // the views of the table no longer hold what it does. the entry may be read again meanwhile
+        std::vector<AggregateView> views = entry.aggregateViews;
+        for (auto &view : views) {
+            if (0 != refreshMaterializedAggregate(view)) {
+                return -1;
+            }
+        }
+        return 0;
+    }
+
+    void RelationManager::invalidateCatalogEntry(const std::string &tableName) {
+        m_catalogCache.erase(tableName);
+    }
+
+    RC RelationManager::loadCatalogEntry(const std::string &tableName, CatalogEntry &entry) {
         FileHandle tableFileHandle;
         FileHandle attributesFileHandle;
 
@@ -236,10 +834,10 @@ namespace PeterDB {
             return -1;
         }
 
-        // read table Tables and read id for which name = tableName
+        // read table Tables and read id and file name for which name = tableName
 
         // vector of attibutes to project from scan result
-        auto attrToReadFromTablesTable = std::vector<std::string>(1, TABLE_ATTR_NAME_ID);
+        std::vector<std::string> attrToReadFromTablesTable = {TABLE_ATTR_NAME_ID, TABLE_ATTR_NAME_FNAME};
 
         // prepare condition value and attribute
         std::string conditionAttr = TABLE_ATTR_NAME_NAME;
@@ -270,7 +868,8 @@ namespace PeterDB {
 
         // using scan iterator for the table, read the entry for tabeName and read only the id
         // construct the data into which the id is written
-        void* tableIdData = malloc(1 + 4); // nullflag byte, bytes to store table-id data
+        // nullflag byte, bytes to store table-id data, file name length and file name
+        void* tableIdData = malloc(1 + 4 + 4 + ATTRIBUTE_NAME_MAX_LENGTH);
         assert(nullptr != tableIdData);
         RID tableIdRid;
 
@@ -288,16 +887,23 @@ namespace PeterDB {
         // now tableIdData is as follows
         // first 1 byte = <nullflags>, representing theres only one byte used for nullflags
         // next 4 bytes = <table-id> representing the table id value for table with name=tableName
+        // next 4 bytes = length of the file name, followed by the file name
+        entry.tableId = *((int*) ((char*) tableIdData + 1));
+        uint32_t fileNameLength = *((uint32_t*) ((char*) tableIdData + 1 + 4));
+        entry.fileName.assign((char*) tableIdData + 1 + 4 + 4, fileNameLength);
 
         // read the table Attributes and read for all the entries with table_id = id
         
         // attributes to project from attributes table
         std::vector<std::string> attrsToReadFromAttributesTable = {ATTRIBUTES_ATTR_NAME_ATTR_NAME,
                                                                    ATTRIBUTES_ATTR_NAME_ATTR_TYPE,
-                                                                   ATTRIBUTES_ATTR_NAME_ATTR_LENGTH};
+                                                                   ATTRIBUTES_ATTR_NAME_ATTR_LENGTH,
+                                                                   ATTRIBUTES_ATTR_NAME_POSITION,
+                                                                   ATTRIBUTES_ATTR_NAME_ADDED,
+                                                                   ATTRIBUTES_ATTR_NAME_DROPPED};
 
-        // nullflags + length of varchar attr + varchar attr + int attr + int attr
-        unsigned maxSpaceReq = 1 + 4 + ATTRIBUTE_NAME_MAX_LENGTH + 4 + 4;
+        // nullflags + length of varchar attr + varchar attr + 5 int attrs
+        unsigned maxSpaceReq = 1 + 4 + ATTRIBUTE_NAME_MAX_LENGTH + 5 * 4;
 
         // prepare the arguments for scan function
         conditionValue = (void*)( (char*) tableIdData + 1);
@@ -324,9 +930,35 @@ namespace PeterDB {
         assert(nullptr != data);
         memset(data, 0, maxSpaceReq);
 
+        // the position, and the schema versions it was added and dropped in, follow the attribute
+        struct VersionedAttribute {
+            Attribute attr;
+            int position;
+            int added;
+            int dropped;
+        };
+        std::vector<VersionedAttribute> versionedAttrs;
+        int schemaVersion = 0;
         while ( RBFM_EOF != rbfmsi.getNextRecord(ridOfRecordInAttrsTable, data)) {
-            Attribute attr = getAttributeFromData(data);
-            attrs.push_back(attr);
+            VersionedAttribute versionedAttr;
+            versionedAttr.attr = getAttributeFromData(data);
+            const char *versionsData = (char*) data + 1 + 4 + versionedAttr.attr.name.size() + 4 + 4;
+            memcpy(&versionedAttr.position, versionsData, 4);
+            versionsData += 4;
+
+            // rows of catalogs written before schema versions were kept have no versions, and those are NULL
+            versionedAttr.added = versionedAttr.dropped = 0;
+            if (!isAttrNull(data, 4)) {
+                memcpy(&versionedAttr.added, versionsData, 4);
+                versionsData += 4;
+            }
+            if (!isAttrNull(data, 5)) {
+                memcpy(&versionedAttr.dropped, versionsData, 4);
+            }
+            versionedAttrs.push_back(versionedAttr);
+
+            schemaVersion = std::max(schemaVersion, std::max(versionedAttr.added, versionedAttr.dropped));
+            entry.lastPosition = std::max(entry.lastPosition, versionedAttr.position);
             memset(data, 0, maxSpaceReq);
         }
         rbfmsi.close();
@@ -334,488 +966,4064 @@ namespace PeterDB {
         m_rbfm->closeFile(attributesFileHandle);
         free(data);
 
-        return 0;
-    }
+        // rows added to Columns later can be anywhere in its file
+        std::sort(versionedAttrs.begin(), versionedAttrs.end(),
+                  [](const VersionedAttribute &a, const VersionedAttribute &b) { return a.position < b.position; });
+        for (auto &versionedAttr : versionedAttrs) {
+            if (0 == versionedAttr.dropped) {
+                entry.attrs.push_back(versionedAttr.attr);
+            }
+        }
+        for (int version = 0; 0 != schemaVersion && version <= schemaVersion; version++) {
+            std::vector<Attribute> versionAttrs;
+            for (auto &versionedAttr : versionedAttrs) {
+                if (versionedAttr.added <= version && (0 == versionedAttr.dropped || version < versionedAttr.dropped)) {
+                    versionAttrs.push_back(versionedAttr.attr);
+                    if (0 != versionedAttr.dropped) {
+                        versionAttrs.back().name.clear();
+                    }
+                }
+            }
+            entry.schemaVersions.push_back(versionAttrs);
+        }
 
-    RC RelationManager::getFileHandleAndAttributes(const std::string& tableName,
-                                                          FileHandle& fh,
-                                                          std::vector<Attribute>& attrs) {
-        if (0 != getAttributes(tableName, attrs)) {
-            ERROR("Error while getting attributes for table %s", tableName);
+        if (0 != readIndexesFromCatalog(entry.tableId, entry.indexedAttrs, entry.includedAttrs, entry.indexFileNames) ||
+            0 != readPartitioningFromCatalog(entry.tableId, entry.partitioning) ||
+            0 != readAggregatesFromCatalog(entry.tableId, tableName, entry.aggregateViews, entry.aggregateOf)) {
             return -1;
         }
 
-        std::string filename = getFileName(tableName);
-        if (0 != m_rbfm->openFile(filename, fh)) {
-            ERROR("Error while opening the file %s", filename);
+        // the files of the table may be in tablespaces not used yet by this process
+        if (0 != useTablespace(entry.fileName)) {
             return -1;
         }
+        for (auto &indexFileName : entry.indexFileNames) {
+            if (0 != useTablespace(indexFileName.second)) {
+                return -1;
+            }
+        }
 
+        // the indexes of a partitioned table are those every partition has
+        CatalogEntry *firstPartition = nullptr;
+        if (NoPartitioning != entry.partitioning.method &&
+            0 == getCatalogEntry(partitionTableName(tableName, 0), firstPartition)) {
+            entry.indexedAttrs = firstPartition->indexedAttrs;
+            entry.includedAttrs = firstPartition->includedAttrs;
+        }
         return 0;
     }
 
-    // 0 indexed..
-    // in recordData, most significant bit represents the null flag bit
-    // of the attr with attrNum=0
-    bool isAttrNull(const void *recordData, const uint16_t &attrNum) {
-        uint16_t q = (attrNum) / 8;
-        uint16_t r = (attrNum) % 8;
-
-        return (0 != (((char*)recordData)[q] & (1 << (7-r))));
+    RC RelationManager::getFileHandleAndAttributes(const std::string& tableName,
+                                                          FileHandle*& fh,
+                                                          std::vector<Attribute>& attrs) {
+        // a table whose entry isn't cached yet is pinned with the latch held exclusively, for the catalog
+        {
+            LatchedCall latched(m_latch, SharedCall);
+            if (!latched.holdsShared() || nullptr != getCachedEntry(tableName)) {
+                return pinTable(tableName, fh, attrs);
+            }
+        }
+        LatchedCall latched(m_latch);
+        return pinTable(tableName, fh, attrs);
     }
 
-    void* getKeyFromRecord(const void* data, const std::vector<Attribute> attrs, const Attribute& attrToFetch) {
+    RC RelationManager::pinTable(const std::string &tableName, FileHandle *&fh, std::vector<Attribute> &attrs) {
+        CatalogEntry *entry = nullptr;
+        if (0 != getCatalogEntry(tableName, entry)) {
+            ERROR("Error while getting attributes for table %s", tableName);
+            return -1;
+        }
+        if (NoPartitioning != entry->partitioning.method) {
+            ERROR("Table %s is partitioned, its tuples are in the files of its partitions\n", tableName.c_str());
+            return -1;
+        }
+        attrs.insert(attrs.end(), entry->attrs.begin(), entry->attrs.end());
 
-        int nullFlagSize = ((attrs.size() + 7) / 8);
-        void* dataPtr = ((char*)data + nullFlagSize);
+        SharedCallGuard guard(m_tableHandlesLatch);
+        TableHandle *tableHandle = nullptr;
+        auto it = m_tableHandles.find(tableName);
+        if (m_tableHandles.end() != it) {
+            tableHandle = it->second;
+        } else {
+            std::string filename = entry->fileName;
+            tableHandle = new TableHandle();
+            if (0 != m_rbfm->openFile(filename, tableHandle->fileHandle)) {
+                ERROR("Error while opening the file %s", filename.c_str());
+                delete tableHandle;
+                return -1;
+            }
+            m_rbfm->setSchemaVersions(tableHandle->fileHandle, entry->schemaVersions);
+            m_tableHandles[tableName] = tableHandle;
+        }
 
-        int attrIdx = 0, attrSize = 0;
-        for (auto &attr: attrs) {
-            bool isNull = isAttrNull(data, attrIdx);
+        tableHandle->refCount++;
+        tableHandle->lastUsed = ++m_tableHandleClock;
+        fh = &(tableHandle->fileHandle);
 
-            if (!isNull) {
-                attrSize = 4;
-                if (TypeVarChar == attr.type) {
-                    attrSize += *((uint32_t*)dataPtr);
-                }
+        evictIdleTableHandles();
+        return 0;
+    }
 
-                if (attrToFetch.name == attr.name) {
-                    void* key = malloc(attrSize);
-                    assert(nullptr != key);
+    void RelationManager::releaseFileHandle(const std::string &tableName) {
+        LatchedCall latched(m_latch, SharedCall);
+        SharedCallGuard guard(m_tableHandlesLatch);
+        auto it = m_tableHandles.find(tableName);
+        if (m_tableHandles.end() == it) {
+            // closed already, e.g. the table was deleted while it was in use
+            return;
+        }
 
-                    memmove(key, dataPtr, attrSize);
-                    return key;
+        assert(it->second->refCount > 0);
+        it->second->refCount--;
+        evictIdleTableHandles();
+    }
+
+    void RelationManager::evictIdleTableHandles() {
+        while (m_tableHandles.size() > MAX_OPEN_TABLE_HANDLES) {
+            // close the least recently used handle nobody is using
+            auto lru = m_tableHandles.end();
+            for (auto it = m_tableHandles.begin(); it != m_tableHandles.end(); it++) {
+                if (0 == it->second->refCount &&
+                    (m_tableHandles.end() == lru || it->second->lastUsed < lru->second->lastUsed)) {
+                    lru = it;
                 }
+            }
 
-                dataPtr = (void*) ((char*)dataPtr + attrSize);
+            if (m_tableHandles.end() == lru) {
+                return;
             }
-            attrIdx++;
+            closeTableHandle(lru->first);
         }
-        return nullptr;
     }
 
-    RC RelationManager::insertTuple(const std::string &tableName, const void *data, RID &rid) {
-        if (tableName == CatalogueConstants::TABLES_FILE_NAME ||
-            tableName == CatalogueConstants::ATTRIBUTES_FILE_NAME) {
-            return -1;
+    void RelationManager::closeTableHandle(const std::string &tableName) {
+        auto it = m_tableHandles.find(tableName);
+        if (m_tableHandles.end() == it) {
+            return;
         }
 
-        std::vector<Attribute> attrs;
-        FileHandle fh;
-
-        if (0 != getFileHandleAndAttributes(tableName, fh, attrs)) {
-            ERROR("Error while getting filehandle and attributes for table %s", tableName);
-            return -1;
+        if (0 != it->second->refCount) {
+            WARNING("Closing table %s while it is still in use\n", tableName.c_str());
         }
 
-        if ( 0 != m_rbfm->insertRecord(fh, attrs, data, rid)) {
-            ERROR("Error while inserting the record into table %s", tableName);
-            m_rbfm->closeFile(fh);
-            return -1;
+        while (!it->second->indexHandles.empty()) {
+            closeIndexHandle(it->second, it->second->indexHandles.begin()->first);
         }
-        m_rbfm->closeFile(fh);
 
-        insertIntoIndex(tableName, attrs, data, rid);
+        m_rbfm->closeFile(it->second->fileHandle);
+        delete it->second;
+        m_tableHandles.erase(it);
+    }
+
+    void RelationManager::closeIndexHandle(TableHandle *tableHandle, const std::string &attributeName) {
+        auto it = tableHandle->indexHandles.find(attributeName);
+        if (tableHandle->indexHandles.end() == it) {
+            return;
+        }
+
+        m_ix->closeFile(*(it->second));
+        delete it->second;
+        tableHandle->indexHandles.erase(it);
+    }
+
+    RC RelationManager::getIndexFileHandle(const std::string &tableName, const std::string &attributeName,
+                                           IXFileHandle *&ixFileHandle) {
+        LatchedCall latched(m_latch, SharedCall);
+        TableHandle *tableHandle = nullptr;
+        {
+            SharedCallGuard guard(m_tableHandlesLatch);
+            auto it = m_tableHandles.find(tableName);
+            if (m_tableHandles.end() == it) {
+                ERROR("Table %s should be pinned before using its indexes\n", tableName.c_str());
+                return -1;
+            }
+            assert(it->second->refCount > 0);
+            tableHandle = it->second;
+        }
+
+        // a pinned handle isn't evicted
+        SharedCallGuard guard(tableHandle->indexLatch);
+        auto &indexHandles = tableHandle->indexHandles;
+        auto indexIt = indexHandles.find(attributeName);
+        if (indexHandles.end() != indexIt) {
+            ixFileHandle = indexIt->second;
+            return 0;
+        }
+
+        const std::string indexFileName = getIndexFileName(tableName, attributeName);
+        auto *newHandle = new IXFileHandle();
+        if (0 != m_ix->openFile(indexFileName, *newHandle)) {
+            ERROR("Error while opening the index file %s\n", indexFileName.c_str());
+            delete newHandle;
+            return -1;
+        }
+        // the handle stays open, so the root pointer only needs to be read once
+        newHandle->cacheRootPageNum();
+
+        indexHandles[attributeName] = newHandle;
+        ixFileHandle = newHandle;
+        return 0;
+    }
+
+    std::mutex &RelationManager::getIndexLatch(const std::string &tableName) {
+        SharedCallGuard guard(m_tableHandlesLatch);
+        auto it = m_tableHandles.find(tableName);
+        assert(m_tableHandles.end() != it && it->second->refCount > 0);
+        return it->second->indexLatch;
+    }
+
+    void RelationManager::closeAllTableHandles() {
+        while (!m_tableHandles.empty()) {
+            closeTableHandle(m_tableHandles.begin()->first);
+        }
+    }
+
+    RC RelationManager::checkpoint() {
+        LatchedCall latched(m_latch);
+        RC rc = 0;
+        for (auto &tableHandle : m_tableHandles) {
+            if (0 != m_rbfm->flushFile(tableHandle.second->fileHandle)) {
+                ERROR("Error while flushing table %s\n", tableHandle.first.c_str());
+                rc = -1;
+            }
+            for (auto &indexHandle : tableHandle.second->indexHandles) {
+                if (0 != m_ix->flushFile(*(indexHandle.second))) {
+                    ERROR("Error while flushing index on %s of table %s\n",
+                          indexHandle.first.c_str(), tableHandle.first.c_str());
+                    rc = -1;
+                }
+            }
+        }
+
+        WriteAheadLog &wal = WriteAheadLog::instance();
+        if (wal.isOpen() && 0 != wal.checkpoint()) {
+            ERROR("Error while checkpointing the write-ahead log\n");
+            rc = -1;
+        }
+        return rc;
+    }
+
+    RC RelationManager::openLog(const std::string &logFileName) {
+        LatchedCall latched(m_latch);
+        // files are read again after redo
+        closeAllTableHandles();
+        m_catalogCache.clear();
+        return WriteAheadLog::instance().open(logFileName);
+    }
+
+    RC RelationManager::closeLog() {
+        LatchedCall latched(m_latch);
+        WriteAheadLog &wal = WriteAheadLog::instance();
+        if (!wal.isOpen()) {
+            return 0;
+        }
+        RC rc = checkpoint();
+        if (0 != wal.close()) {
+            rc = -1;
+        }
+        return rc;
+    }
+
+    RC RelationManager::commitChanges(const std::string &tableName) {
+        WriteAheadLog &wal = WriteAheadLog::instance();
+        if (!wal.isOpen()) {
+            return 0;
+        }
+
+        // page occupancy, root pointers and counters go to the log along with the pages
+        TableHandle *tableHandle = nullptr;
+        {
+            SharedCallGuard guard(m_tableHandlesLatch);
+            auto it = m_tableHandles.find(tableName);
+            tableHandle = m_tableHandles.end() == it ? nullptr : it->second;
+        }
+        if (nullptr != tableHandle) {
+            if (0 != m_rbfm->flushFile(tableHandle->fileHandle)) {
+                return -1;
+            }
+            SharedCallGuard guard(tableHandle->indexLatch);
+            for (auto &indexHandle : tableHandle->indexHandles) {
+                if (0 != m_ix->flushFile(*(indexHandle.second))) {
+                    return -1;
+                }
+            }
+        }
+
+        // a checkpoint needs the latch exclusively
+        return wal.needsCheckpoint() && !t_sharedCall ? checkpoint() : 0;
+    }
+
+    // 0 indexed..
+    // in recordData, most significant bit represents the null flag bit
+    // of the attr with attrNum=0
+    bool isAttrNull(const void *recordData, const uint16_t &attrNum) {
+        uint16_t q = (attrNum) / 8;
+        uint16_t r = (attrNum) % 8;
+
+        return (0 != (((char*)recordData)[q] & (1 << (7-r))));
+    }
+
+    void* getKeyFromRecord(const void* data, const std::vector<Attribute> &attrs, const Attribute& attrToFetch) {
+
+        int nullFlagSize = ((attrs.size() + 7) / 8);
+        void* dataPtr = ((char*)data + nullFlagSize);
+
+        int attrIdx = 0, attrSize = 0;
+        for (auto &attr: attrs) {
+            bool isNull = isAttrNull(data, attrIdx);
+
+            if (!isNull) {
+                attrSize = 4;
+                if (TypeVarChar == attr.type) {
+                    attrSize += *((uint32_t*)dataPtr);
+                }
+
+                if (attrToFetch.name == attr.name) {
+                    void* key = malloc(attrSize);
+                    assert(nullptr != key);
+
+                    memmove(key, dataPtr, attrSize);
+                    return key;
+                }
+
+                dataPtr = (void*) ((char*)dataPtr + attrSize);
+            }
+            attrIdx++;
+        }
+        return nullptr;
+    }
+
+    // key of a record in an index on keyAttrs, the values of keyAttrs encoded by CompositeKey if there are
+    // several of them. nullptr if any of them is NULL, as those are not indexed
+    void* getIndexKeyFromRecord(const void *data, const std::vector<Attribute> &attrs,
+                                const std::vector<Attribute> &keyAttrs) {
+        if (1 == keyAttrs.size()) {
+            return getKeyFromRecord(data, attrs, keyAttrs[0]);
+        }
+
+        std::vector<const void *> values;
+        for (auto &keyAttr : keyAttrs) {
+            void *value = getKeyFromRecord(data, attrs, keyAttr);
+            if (nullptr == value) {
+                break;
+            }
+            values.push_back(value);
+        }
+
+        void *key = nullptr;
+        if (values.size() == keyAttrs.size()) {
+            key = malloc(sizeof(uint32_t) + CompositeKey::maxEncodedSize(keyAttrs));
+            assert(nullptr != key);
+            CompositeKey::encode(keyAttrs, values, key);
+        }
+        for (auto value : values) {
+            free((void *) value);
+        }
+        return key;
+    }
+
+    // enough room for any tuple of the table, in the insertTuple() format
+    unsigned maxTupleSize(const std::vector<Attribute> &attrs) {
+        unsigned size = (attrs.size() + 7) / 8;
+        for (auto &attr: attrs) {
+            size += 4;
+            if (TypeVarChar == attr.type) size += attr.length;
+        }
+        return size;
+    }
+
+    // copies the values of attributeNames out of a tuple of attrs into projected, which gets them in
+    // the insertTuple() format (over attributeNames), and returns the size of the projected tuple
+    unsigned projectTuple(const void *data, const std::vector<Attribute> &attrs,
+                          const std::vector<std::string> &attributeNames, void *projected) {
+        // where the value of each attribute starts in data, -1 if it is NULL
+        std::vector<int> offsets(attrs.size(), -1);
+        std::vector<unsigned> sizes(attrs.size(), 0);
+        unsigned offset = (attrs.size() + 7) / 8;
+        for (unsigned i = 0; i < attrs.size(); i++) {
+            if (isAttrNull(data, i)) {
+                continue;
+            }
+            sizes[i] = 4;
+            if (TypeVarChar == attrs[i].type) {
+                sizes[i] += *((uint32_t *) ((char *) data + offset));
+            }
+            offsets[i] = offset;
+            offset += sizes[i];
+        }
+
+        auto *out = (char *) projected;
+        unsigned nullBytes = (attributeNames.size() + 7) / 8;
+        memset(out, 0, nullBytes);
+        unsigned outOffset = nullBytes;
+        for (unsigned j = 0; j < attributeNames.size(); j++) {
+            unsigned i = 0;
+            while (i < attrs.size() && attrs[i].name != attributeNames[j]) {
+                i++;
+            }
+            if (i == attrs.size() || -1 == offsets[i]) {
+                out[j / 8] |= (char) (0x80 >> (j % 8));
+                continue;
+            }
+            memcpy(out + outOffset, (char *) data + offsets[i], sizes[i]);
+            outOffset += sizes[i];
+        }
+        return outOffset;
+    }
+
+    // size of a tuple of attrs, in the insertTuple() format
+    unsigned tupleSize(const void *data, const std::vector<Attribute> &attrs) {
+        unsigned size = (attrs.size() + 7) / 8;
+        for (unsigned i = 0; i < attrs.size(); i++) {
+            if (isAttrNull(data, i)) {
+                continue;
+            }
+            size += 4;
+            if (TypeVarChar == attrs[i].type) {
+                size += *((uint32_t *) ((char *) data + size - 4));
+            }
+        }
+        return size;
+    }
+
+    // a tuple of attrs with the values of the assigned attributes replaced, in the insertTuple() format
+    std::string assignTuple(const void *data, const std::vector<Attribute> &attrs,
+                            const std::vector<AttributeAssignment> &assignments) {
+        unsigned nullBytes = (attrs.size() + 7) / 8;
+        std::string tuple(nullBytes, '\0');
+        unsigned offset = nullBytes;
+        for (unsigned i = 0; i < attrs.size(); i++) {
+            // the value of the tuple, then the one assigned last, if any
+            const char *value = nullptr;
+            if (!isAttrNull(data, i)) {
+                value = (const char *) data + offset;
+                offset += 4 + (TypeVarChar == attrs[i].type ? *((uint32_t *) value) : 0);
+            }
+            for (auto &assignment : assignments) {
+                if (assignment.attributeName == attrs[i].name) {
+                    value = (const char *) assignment.value;
+                }
+            }
+
+            if (nullptr == value) {
+                tuple[i / 8] |= (char) (0x80 >> (i % 8));
+                continue;
+            }
+            tuple.append(value, 4 + (TypeVarChar == attrs[i].type ? *((uint32_t *) value) : 0));
+        }
+        return tuple;
+    }
+
+    // lists of values (histogram and partition bounds) are stored one after the other, each as [length][value]
+    static std::string serializeValues(const std::vector<std::string> &values) {
+        std::string serialized;
+        for (auto &value : values) {
+            uint32_t length = value.size();
+            serialized.append((const char *) &length, sizeof(uint32_t));
+            serialized.append(value);
+        }
+        return serialized;
+    }
+
+    static void deserializeValues(const std::string &serialized, std::vector<std::string> &values) {
+        size_t offset = 0;
+        while (offset + sizeof(uint32_t) <= serialized.size()) {
+            uint32_t length;
+            memcpy(&length, serialized.data() + offset, sizeof(uint32_t));
+            offset += sizeof(uint32_t);
+            values.push_back(serialized.substr(offset, length));
+            offset += length;
+        }
+    }
+
+    // a key (or condition value) given in the key format of an attribute of the given type, as bytes
+    static std::string keyToString(AttrType type, const void *key) {
+        if (nullptr == key) {
+            return "";
+        }
+        uint32_t size = sizeof(uint32_t);
+        if (TypeVarChar == type) {
+            size += *((uint32_t *) key);
+        }
+        return std::string((const char *) key, size);
+    }
+
+    // tuples of partitioned tables carry their partition in the top bits of the page number of their RID
+    static RID toPartitionRid(const RID &rid, unsigned partition) {
+        RID partitionRid;
+        partitionRid.pageNum = rid.pageNum | (partition << PARTITION_RID_SHIFT);
+        partitionRid.slotNum = rid.slotNum;
+        return partitionRid;
+    }
+
+    static RID fromPartitionRid(const RID &rid) {
+        RID partitionRid;
+        partitionRid.pageNum = rid.pageNum & ((1u << PARTITION_RID_SHIFT) - 1);
+        partitionRid.slotNum = rid.slotNum;
+        return partitionRid;
+    }
+
+    static unsigned partitionOfKey(const PartitionSpec &spec, AttrType type, const std::string &key) {
+        if (HashPartitioning == spec.method) {
+            std::string value = key;
+            if (TypeReal == type) {
+                // -0 and 0 are the same value
+                float real;
+                memcpy(&real, value.data(), sizeof(float));
+                real = 0 == real ? 0 : real;
+                memcpy(&value[0], &real, sizeof(float));
+            }
+
+            // FNV-1a, which unlike std::hash is the same everywhere, as the partition of a tuple is on disk
+            uint32_t hash = 2166136261u;
+            for (char c : value) {
+                hash = (hash ^ (unsigned char) c) * 16777619u;
+            }
+            return hash % spec.count;
+        }
+
+        // the number of bounds up to the key
+        unsigned partition = 0;
+        while (partition < spec.bounds.size() &&
+               ColumnStatistics::compareValues(type, spec.bounds[partition], key) <= 0) {
+            partition++;
+        }
+        return partition;
+    }
+
+    unsigned PartitionSpec::partitionCount() const {
+        switch (method) {
+            case HashPartitioning:
+                return count;
+            case RangePartitioning:
+                return bounds.size() + 1;
+            case NoPartitioning:
+                break;
+        }
+        return 0;
+    }
+
+    std::string RelationManager::partitionTableName(const std::string &tableName, unsigned partition) {
+        return tableName + "#" + std::to_string(partition);
+    }
+
+    RC RelationManager::checkPartitioning(const std::vector<Attribute> &attrs, const PartitionSpec &spec) {
+        auto attr = std::find_if(attrs.begin(), attrs.end(), [&](const Attribute &a) {
+            return a.name == spec.attribute;
+        });
+        if (attrs.end() == attr) {
+            ERROR("Partition key %s is not an attribute of the table\n", spec.attribute.c_str());
+            return -1;
+        }
+
+        unsigned partitionCount = spec.partitionCount();
+        if (0 == partitionCount || partitionCount > PARTITION_MAX_COUNT ||
+            (RangePartitioning == spec.method && spec.bounds.empty())) {
+            ERROR("Tables have 1 to %u partitions, not %u\n", PARTITION_MAX_COUNT, partitionCount);
+            return -1;
+        }
+        if (RangePartitioning != spec.method) {
+            return 0;
+        }
+
+        // range bounds are values of the partition key, in ascending order
+        for (unsigned i = 0; i < spec.bounds.size(); i++) {
+            const std::string &bound = spec.bounds[i];
+            if (bound.size() < sizeof(uint32_t) || bound.size() != keyToString(attr->type, bound.data()).size()) {
+                ERROR("Partition bound %u is not a value of %s\n", i, spec.attribute.c_str());
+                return -1;
+            }
+            if (0 != i && ColumnStatistics::compareValues(attr->type, spec.bounds[i - 1], bound) >= 0) {
+                ERROR("Partition bounds should be in ascending order\n");
+                return -1;
+            }
+        }
+        if (serializeValues(spec.bounds).size() > PARTITION_BOUNDS_MAX_LENGTH) {
+            ERROR("Partition bounds take more than %d bytes\n", PARTITION_BOUNDS_MAX_LENGTH);
+            return -1;
+        }
+        return 0;
+    }
+
+    CatalogEntry *RelationManager::getPartitionedEntry(const std::string &tableName) {
+        CatalogEntry *entry = nullptr;
+        if (0 != getCatalogEntry(tableName, entry) || NoPartitioning == entry->partitioning.method) {
+            return nullptr;
+        }
+        return entry;
+    }
+
+    unsigned RelationManager::partitionOf(const CatalogEntry &entry, const void *data) {
+        auto attr = std::find_if(entry.attrs.begin(), entry.attrs.end(), [&](const Attribute &a) {
+            return a.name == entry.partitioning.attribute;
+        });
+        assert(entry.attrs.end() != attr);
+
+        void *key = getKeyFromRecord(data, entry.attrs, *attr);
+        if (nullptr == key) {
+            return 0;
+        }
+        unsigned partition = partitionOfKey(entry.partitioning, attr->type, keyToString(attr->type, key));
+        free(key);
+        return partition;
+    }
+
+    std::vector<unsigned> RelationManager::prunePartitions(const CatalogEntry &entry,
+                                                           const std::string &conditionAttribute,
+                                                           CompOp compOp, const void *value) {
+        const PartitionSpec &spec = entry.partitioning;
+        auto attr = std::find_if(entry.attrs.begin(), entry.attrs.end(), [&](const Attribute &a) {
+            return a.name == spec.attribute;
+        });
+        bool prunable = conditionAttribute == spec.attribute && nullptr != value &&
+                        NO_OP != compOp && NE_OP != compOp;
+        std::string key = prunable ? keyToString(attr->type, value) : "";
+
+        std::vector<unsigned> partitions;
+        for (unsigned p = 0; p < spec.partitionCount(); p++) {
+            bool matches = true;
+            if (prunable && HashPartitioning == spec.method) {
+                matches = EQ_OP != compOp || partitionOfKey(spec, attr->type, key) == p;
+            } else if (prunable) {
+                // partition p has the values from its lower bound up to (but not including) its upper bound,
+                // a missing bound is lower (higher) than any value. NULLs never match a condition
+                int lowerToKey = 0 == p ? -1 : ColumnStatistics::compareValues(attr->type, spec.bounds[p - 1], key);
+                int upperToKey = spec.bounds.size() == p ? 1 :
+                                 ColumnStatistics::compareValues(attr->type, spec.bounds[p], key);
+                switch (compOp) {
+                    case EQ_OP:
+                        matches = lowerToKey <= 0 && upperToKey > 0;
+                        break;
+                    case LT_OP:
+                        matches = lowerToKey < 0;
+                        break;
+                    case LE_OP:
+                        matches = lowerToKey <= 0;
+                        break;
+                    case GT_OP:
+                    case GE_OP:
+                        matches = upperToKey > 0;
+                        break;
+                    default:
+                        break;
+                }
+            }
+            if (matches) {
+                partitions.push_back(p);
+            }
+        }
+        return partitions;
+    }
+
+    RC RelationManager::locatePartitionTuple(const std::string &tableName, const CatalogEntry &entry, const RID &rid,
+                                             std::string &partitionName, RID &partitionRid) {
+        unsigned partition = rid.pageNum >> PARTITION_RID_SHIFT;
+        if (partition >= entry.partitioning.partitionCount()) {
+            ERROR("Table %s has no partition %u\n", tableName.c_str(), partition);
+            return -1;
+        }
+        partitionName = partitionTableName(tableName, partition);
+        partitionRid = fromPartitionRid(rid);
+        return 0;
+    }
+
+    RC RelationManager::insertPartitionedTuples(const std::string &tableName, const CatalogEntry &entry,
+                                                const std::vector<const void *> &data, std::vector<RID> &rids) {
+        // each partition gets its tuples as a single batch
+        unsigned partitionCount = entry.partitioning.partitionCount();
+        std::vector<std::vector<const void *> > partitionData(partitionCount);
+        std::vector<std::vector<unsigned> > positions(partitionCount);
+        for (unsigned i = 0; i < data.size(); i++) {
+            unsigned partition = partitionOf(entry, data[i]);
+            partitionData[partition].push_back(data[i]);
+            positions[partition].push_back(i);
+        }
+
+        rids.resize(data.size());
+        for (unsigned p = 0; p < partitionCount; p++) {
+            if (partitionData[p].empty()) {
+                continue;
+            }
+            std::vector<RID> partitionRids;
+            if (0 != insertTuples(partitionTableName(tableName, p), partitionData[p], partitionRids)) {
+                return -1;
+            }
+            for (unsigned i = 0; i < partitionRids.size(); i++) {
+                if (0 != (partitionRids[i].pageNum >> PARTITION_RID_SHIFT)) {
+                    ERROR("Partition %u of table %s is full\n", p, tableName.c_str());
+                    return -1;
+                }
+                rids[positions[p][i]] = toPartitionRid(partitionRids[i], p);
+            }
+        }
+        return 0;
+    }
+
+    RC RelationManager::deletePartitionedTuples(const std::string &tableName, const CatalogEntry &entry,
+                                                const std::vector<RID> &rids) {
+        std::vector<std::vector<RID> > partitionRids(entry.partitioning.partitionCount());
+        for (auto &rid : rids) {
+            std::string partitionName;
+            RID partitionRid;
+            if (0 != locatePartitionTuple(tableName, entry, rid, partitionName, partitionRid)) {
+                return -1;
+            }
+            partitionRids[rid.pageNum >> PARTITION_RID_SHIFT].push_back(partitionRid);
+        }
+
+        for (unsigned p = 0; p < partitionRids.size(); p++) {
+            if (!partitionRids[p].empty() && 0 != deleteTuples(partitionTableName(tableName, p), partitionRids[p])) {
+                return -1;
+            }
+        }
+        return 0;
+    }
+
+    RC RelationManager::updatePartitionedTuples(const std::string &tableName, const CatalogEntry &entry,
+                                                const std::vector<const void *> &data, const std::vector<RID> &rids) {
+        unsigned partitionCount = entry.partitioning.partitionCount();
+        std::vector<std::vector<const void *> > partitionData(partitionCount);
+        std::vector<std::vector<RID> > partitionRids(partitionCount);
+        for (unsigned i = 0; i < rids.size(); i++) {
+            std::string partitionName;
+            RID partitionRid;
+            if (0 != locatePartitionTuple(tableName, entry, rids[i], partitionName, partitionRid)) {
+                return -1;
+            }
+
+            // the RID of a tuple says which partition it is in, so it can't move to another one
+            unsigned partition = rids[i].pageNum >> PARTITION_RID_SHIFT;
+            if (partitionOf(entry, data[i]) != partition) {
+                ERROR("Updating the partition key of a tuple of %s would move it to another partition\n",
+                      tableName.c_str());
+                return -1;
+            }
+            partitionData[partition].push_back(data[i]);
+            partitionRids[partition].push_back(partitionRid);
+        }
+
+        for (unsigned p = 0; p < partitionCount; p++) {
+            if (!partitionRids[p].empty() &&
+                0 != updateTuples(partitionTableName(tableName, p), partitionData[p], partitionRids[p])) {
+                return -1;
+            }
+        }
+        return 0;
+    }
+
+    RC RelationManager::insertTuple(const std::string &tableName, const void *data, RID &rid) {
+        std::vector<RID> rids;
+        if (0 != insertTuples(tableName, {data}, rids)) {
+            return -1;
+        }
+
+        rid = rids[0];
+        return 0;
+    }
+
+    RC RelationManager::insertTuples(const std::string &tableName, const std::vector<const void *> &data,
+                                     std::vector<RID> &rids) {
+        // the intention lock on the table is enough: the new tuples can't be scanned before the
+        // transaction commits, scans lock the table shared or read a snapshot taken before it
+        TransactionScope transaction;
+        if (0 != transaction.lockTable(tableName, IntentionExclusive)) {
+            return -1;
+        }
+        for (auto &viewName : getAggregateViewNames(tableName)) {
+            if (0 != transaction.lockTable(viewName, IntentionExclusive)) {
+                return -1;
+            }
+        }
+
+        RC rc = changeTuples(tableName, [&]() {
+            return insertTuplesLatched(tableName, data, rids);
+        });
+        return transaction.commit(rc);
+    }
+
+    RC RelationManager::changeTuples(const std::string &tableName, const std::function<RC()> &change) {
+        // writers of plain tables go on side by side, the locks keep them off each other's tuples
+        bool checkpointDue = false;
+        {
+            LatchedCall latched(m_latch, SharedCall);
+            if (!latched.holdsShared() || isPlainTable(tableName)) {
+                beginWriteSpan();
+                RC rc = isMaterializedAggregate(tableName) ? -1 : change();
+                if (0 != rc || !latched.holdsShared() || !WriteAheadLog::instance().needsCheckpoint()) {
+                    return rc;
+                }
+                checkpointDue = true;
+            }
+        }
+        // left by commitChanges(), it needs the latch exclusively
+        if (checkpointDue) {
+            return checkpoint();
+        }
+
+        // the catalog is read, or partitions and materialized aggregates change along with the table
+        LatchedCall latched(m_latch);
+        beginWriteSpan();
+        return isMaterializedAggregate(tableName) ? -1 : change();
+    }
+
+    RC RelationManager::insertTuplesLatched(const std::string &tableName, const std::vector<const void *> &data,
+                                            std::vector<RID> &rids) {
+        if (isCatalogTable(tableName)) {
+            return -1;
+        }
+
+        CatalogEntry *partitionedEntry = getPartitionedEntry(tableName);
+        if (nullptr != partitionedEntry) {
+            return insertPartitionedTuples(tableName, *partitionedEntry, data, rids);
+        }
+
+        std::vector<Attribute> attrs;
+        FileHandle *fh = nullptr;
+
+        if (0 != getFileHandleAndAttributes(tableName, fh, attrs)) {
+            ERROR("Error while getting filehandle and attributes for table %s", tableName);
+            return -1;
+        }
+
+        if ( 0 != m_rbfm->insertRecords(*fh, attrs, data, rids)) {
+            ERROR("Error while inserting the records into table %s", tableName);
+            releaseFileHandle(tableName);
+            return -1;
+        }
+
+        insertIntoIndex(tableName, attrs, data, rids);
+        keepUndo(TuplesInserted, tableName, attrs, rids, {});
+        RC rc = commitChanges(tableName);
+        releaseFileHandle(tableName);
+
+        if (0 == rc) {
+            rc = maintainAggregates(tableName, attrs, {}, data);
+        }
+        return rc;
+    }
+
+    void RelationManager::insertIntoIndex(const std::string& tableName,
+                                          const std::vector<Attribute>& attrs,
+                                          const std::vector<const void *> &records, const std::vector<RID> &rids,
+                                          const std::vector<std::string> *indexNames) {
+        // insert the entries into indexes created on this table
+        CatalogEntry *entry = nullptr;
+        if (0 != getCatalogEntry(tableName, entry)) {
+            return;
+        }
+
+        for (auto& attrName: entry->indexedAttrs) {
+            if (nullptr != indexNames && indexNames->end() == std::find(indexNames->begin(), indexNames->end(), attrName)) {
+                continue;
+            }
+            // create the index keys that need to be inserted into the index file
+            std::vector<Attribute> keyAttrs = getIndexKeyAttributes(tableName, attrName);
+            Attribute attrDef = getIndexKeyAttribute(tableName, attrName);
+
+            // covering indexes also get the values of their included attributes
+            auto included = entry->includedAttrs.find(attrName);
+            std::vector<char> payload;
+            if (entry->includedAttrs.end() != included) {
+                payload.resize(maxTupleSize(attrs));
+            }
+
+            std::vector<const void *> keys;
+            std::vector<RID> keyRids;
+            std::vector<std::string> payloads;
+            for (unsigned i = 0; i < records.size(); i++) {
+                void* key = getIndexKeyFromRecord(records[i], attrs, keyAttrs);
+                if (nullptr == key) {
+                    // null values are not indexed
+                    continue;
+                }
+                keys.push_back(key);
+                keyRids.push_back(rids[i]);
+                if (entry->includedAttrs.end() != included) {
+                    unsigned payloadSize = projectTuple(records[i], attrs, included->second, payload.data());
+                    payloads.push_back(std::string(payload.data(), payloadSize));
+                }
+            }
+
+            IXFileHandle *ixFileHandle = nullptr;
+            if (!keys.empty() && 0 == getIndexFileHandle(tableName, attrName, ixFileHandle)) {
+                SharedCallGuard guard(getIndexLatch(tableName));
+                m_ix->insertEntries(*ixFileHandle, attrDef, keys, keyRids, payloads);
+            }
+
+            for (auto key: keys) {
+                free((void *) key);
+            }
+        }
+    }
+
+    RC RelationManager::deleteTuple(const std::string &tableName, const RID &rid) {
+        return deleteTuples(tableName, {rid});
+    }
+
+    RC RelationManager::deleteTuples(const std::string &tableName, const std::vector<RID> &rids) {
+        TransactionScope transaction;
+        if (0 != transaction.lockRows(tableName, rids, Exclusive)) {
+            return -1;
+        }
+        for (auto &viewName : getAggregateViewNames(tableName)) {
+            if (0 != transaction.lockTable(viewName, IntentionExclusive)) {
+                return -1;
+            }
+        }
+
+        RC rc = changeTuples(tableName, [&]() {
+            return deleteTuplesLatched(tableName, rids);
+        });
+        return transaction.commit(rc);
+    }
+
+    RC RelationManager::deleteTuplesLatched(const std::string &tableName, const std::vector<RID> &rids) {
+        if (isCatalogTable(tableName)) {
+            return -1;
+        }
+
+        CatalogEntry *partitionedEntry = getPartitionedEntry(tableName);
+        if (nullptr != partitionedEntry) {
+            return deletePartitionedTuples(tableName, *partitionedEntry, rids);
+        }
+
+        std::vector<Attribute> attrs;
+        FileHandle *fh = nullptr;
+
+        if (0 != getFileHandleAndAttributes(tableName, fh, attrs)) {
+            ERROR("Error while getting filehandle and attributes for table %s", tableName);
+            return -1;
+        }
+
+        // before deleting the records, read them to get the record data
+        // this is used to delete the entries in the index files
+        unsigned maxSpaceRequired = maxTupleSize(attrs);
+        std::vector<const void *> deletedRecords;
+        std::vector<RID> deletedRids;
+        RC rc = 0;
+        for (auto &rid: rids) {
+            void* data = malloc(maxSpaceRequired);
+            assert(nullptr != data);
+            memset(data, 0, maxSpaceRequired);
+
+            if (0 != m_rbfm->readRecord(*fh, attrs, rid, data) ||
+                0 != m_rbfm->deleteRecord(*fh, attrs, rid)) {
+                ERROR("Error while deleting the record from table %s", tableName);
+                free(data);
+                rc = -1;
+                break;
+            }
+            deletedRecords.push_back(data);
+            deletedRids.push_back(rid);
+        }
+
+        // the records deleted before any failure are removed from the indexes too
+        deleteFromIndex(tableName, attrs, deletedRecords, deletedRids);
+        keepUndo(TuplesDeleted, tableName, attrs, deletedRids, deletedRecords);
+        if (0 != commitChanges(tableName)) {
+            rc = -1;
+        }
+        releaseFileHandle(tableName);
+        if (0 != maintainAggregates(tableName, attrs, deletedRecords, {})) {
+            rc = -1;
+        }
+
+        for (auto data: deletedRecords) {
+            free((void *) data);
+        }
+        return rc;
+    }
+
+    void RelationManager::deleteFromIndex(const std::string& tableName,
+                                          const std::vector<Attribute>& attrs,
+                                          const std::vector<const void *> &records, const std::vector<RID> &rids,
+                                          const std::vector<std::string> *indexNames) {
+        // delete the entries from indexes created on this table
+        CatalogEntry *entry = nullptr;
+        if (0 != getCatalogEntry(tableName, entry)) {
+            return;
+        }
+
+        for (auto& attrName: entry->indexedAttrs) {
+            if (nullptr != indexNames && indexNames->end() == std::find(indexNames->begin(), indexNames->end(), attrName)) {
+                continue;
+            }
+            // create the index keys that need to be deleted from the index file
+            std::vector<Attribute> keyAttrs = getIndexKeyAttributes(tableName, attrName);
+            Attribute attrDef = getIndexKeyAttribute(tableName, attrName);
+
+            std::vector<const void *> keys;
+            std::vector<RID> keyRids;
+            for (unsigned i = 0; i < records.size(); i++) {
+                void* key = getIndexKeyFromRecord(records[i], attrs, keyAttrs);
+                if (nullptr == key) {
+                    continue;
+                }
+                keys.push_back(key);
+                keyRids.push_back(rids[i]);
+            }
+
+            IXFileHandle *ixFileHandle = nullptr;
+            if (!keys.empty() && 0 == getIndexFileHandle(tableName, attrName, ixFileHandle)) {
+                SharedCallGuard guard(getIndexLatch(tableName));
+                m_ix->deleteEntries(*ixFileHandle, attrDef, keys, keyRids);
+            }
+
+            for (auto key: keys) {
+                free((void *) key);
+            }
+        }
+    }
+
+    RC RelationManager::updateTuple(const std::string &tableName, const void *data, const RID &rid) {
+        return updateTuples(tableName, {data}, {rid});
+    }
+
+    RC RelationManager::updateTuples(const std::string &tableName, const std::vector<const void *> &data,
+                                     const std::vector<RID> &rids) {
+        TransactionScope transaction;
+        if (0 != transaction.lockRows(tableName, rids, Exclusive)) {
+            return -1;
+        }
+        for (auto &viewName : getAggregateViewNames(tableName)) {
+            if (0 != transaction.lockTable(viewName, IntentionExclusive)) {
+                return -1;
+            }
+        }
+
+        RC rc = changeTuples(tableName, [&]() {
+            return updateTuplesLatched(tableName, data, rids);
+        });
+        return transaction.commit(rc);
+    }
+
+    RC RelationManager::updateTuplesLatched(const std::string &tableName, const std::vector<const void *> &data,
+                                            const std::vector<RID> &rids) {
+        if (isCatalogTable(tableName)) {
+            return -1;
+        }
+        if (data.size() != rids.size()) {
+            ERROR("Got %zu tuples but %zu rids to update in table %s\n", data.size(), rids.size(), tableName.c_str());
+            return -1;
+        }
+
+        CatalogEntry *partitionedEntry = getPartitionedEntry(tableName);
+        if (nullptr != partitionedEntry) {
+            return updatePartitionedTuples(tableName, *partitionedEntry, data, rids);
+        }
+
+        std::vector<Attribute> attrs;
+        FileHandle *fh = nullptr;
+
+        if (0 != getFileHandleAndAttributes(tableName, fh, attrs)) {
+            ERROR("Error while getting filehandle and attributes for table %s", tableName);
+            return -1;
+        }
+
+        // before updating the records, read them to get the record data
+        // this is used to delete the entries in the index files
+        unsigned maxSpaceRequired = maxTupleSize(attrs);
+        std::vector<const void *> oldRecords;
+        std::vector<const void *> newRecords;
+        std::vector<RID> updatedRids;
+        RC rc = 0;
+        for (unsigned i = 0; i < rids.size(); i++) {
+            void* oldRecordData = malloc(maxSpaceRequired);
+            assert(nullptr != oldRecordData);
+            memset(oldRecordData, 0, maxSpaceRequired);
+
+            if (0 != m_rbfm->readRecord(*fh, attrs, rids[i], oldRecordData) ||
+                0 != m_rbfm->updateRecord(*fh, attrs, data[i], rids[i])) {
+                ERROR("Error while updating the record in table %s", tableName);
+                free(oldRecordData);
+                rc = -1;
+                break;
+            }
+            oldRecords.push_back(oldRecordData);
+            newRecords.push_back(data[i]);
+            updatedRids.push_back(rids[i]);
+        }
+
+        deleteFromIndex(tableName, attrs, oldRecords, updatedRids);
+        insertIntoIndex(tableName, attrs, newRecords, updatedRids);
+        keepUndo(TuplesUpdated, tableName, attrs, updatedRids, oldRecords);
+        if (0 != commitChanges(tableName)) {
+            rc = -1;
+        }
+        releaseFileHandle(tableName);
+        if (0 != maintainAggregates(tableName, attrs, oldRecords, newRecords)) {
+            rc = -1;
+        }
+
+        for (auto oldRecordData: oldRecords) {
+            free((void *) oldRecordData);
+        }
+        return rc;
+    }
+
+    RC RelationManager::deleteWhere(const std::string &tableName, const std::string &conditionAttribute,
+                                    const CompOp compOp, const void *value) {
+        unsigned count = 0;
+        return deleteWhere(tableName, conditionAttribute, compOp, value, count);
+    }
+
+    RC RelationManager::deleteWhere(const std::string &tableName, const std::string &conditionAttribute,
+                                    const CompOp compOp, const void *value, unsigned &count) {
+        // the tuples to delete aren't known before the table is read, nor may tuples start matching meanwhile
+        TransactionScope transaction;
+        if (0 != transaction.lockTable(tableName, Exclusive)) {
+            return -1;
+        }
+        for (auto &viewName : getAggregateViewNames(tableName)) {
+            if (0 != transaction.lockTable(viewName, IntentionExclusive)) {
+                return -1;
+            }
+        }
+
+        RC rc;
+        count = 0;
+        {
+            LatchedCall latched(m_latch);
+            beginWriteSpan();
+            rc = isMaterializedAggregate(tableName) ? -1 : deleteWhereLatched(tableName, conditionAttribute, compOp, value, count);
+        }
+        return transaction.commit(rc);
+    }
+
+    RC RelationManager::deleteWhereLatched(const std::string &tableName, const std::string &conditionAttribute,
+                                           const CompOp compOp, const void *value, unsigned &count) {
+        if (isCatalogTable(tableName)) {
+            return -1;
+        }
+
+        CatalogEntry *partitionedEntry = getPartitionedEntry(tableName);
+        if (nullptr != partitionedEntry) {
+            for (unsigned p : prunePartitions(*partitionedEntry, conditionAttribute, compOp, value)) {
+                if (0 != deleteWhereLatched(partitionTableName(tableName, p), conditionAttribute, compOp, value,
+                                            count)) {
+                    return -1;
+                }
+            }
+            return 0;
+        }
+
+        std::vector<Attribute> attrs;
+        FileHandle *fh = nullptr;
+        if (0 != getFileHandleAndAttributes(tableName, fh, attrs)) {
+            ERROR("Error while getting filehandle and attributes for table %s", tableName.c_str());
+            return -1;
+        }
+
+        std::vector<RID> rids;
+        std::vector<std::string> tuples;
+        if (0 != scanMatchingTuples(*fh, attrs, conditionAttribute, compOp, value, rids, tuples) ||
+            0 != m_rbfm->deleteRecords(*fh, attrs, rids)) {
+            ERROR("Error while deleting the matching tuples of table %s\n", tableName.c_str());
+            releaseFileHandle(tableName);
+            return -1;
+        }
+
+        std::vector<const void *> records;
+        for (auto &tuple : tuples) {
+            records.push_back(tuple.data());
+        }
+        deleteFromIndex(tableName, attrs, records, rids);
+        keepUndo(TuplesDeleted, tableName, attrs, rids, records);
+        count += rids.size();
+
+        RC rc = commitChanges(tableName);
+        releaseFileHandle(tableName);
+        if (0 == rc) {
+            rc = maintainAggregates(tableName, attrs, records, {});
+        }
+        return rc;
+    }
+
+    RC RelationManager::updateWhere(const std::string &tableName, const std::string &conditionAttribute,
+                                    const CompOp compOp, const void *value,
+                                    const std::vector<AttributeAssignment> &assignments) {
+        unsigned count = 0;
+        return updateWhere(tableName, conditionAttribute, compOp, value, assignments, count);
+    }
+
+    RC RelationManager::updateWhere(const std::string &tableName, const std::string &conditionAttribute,
+                                    const CompOp compOp, const void *value,
+                                    const std::vector<AttributeAssignment> &assignments, unsigned &count) {
+        TransactionScope transaction;
+        if (0 != transaction.lockTable(tableName, Exclusive)) {
+            return -1;
+        }
+        for (auto &viewName : getAggregateViewNames(tableName)) {
+            if (0 != transaction.lockTable(viewName, IntentionExclusive)) {
+                return -1;
+            }
+        }
+
+        RC rc;
+        count = 0;
+        {
+            LatchedCall latched(m_latch);
+            beginWriteSpan();
+            rc = isMaterializedAggregate(tableName) ? -1 :
+                 updateWhereLatched(tableName, conditionAttribute, compOp, value, assignments, count);
+        }
+        return transaction.commit(rc);
+    }
+
+    RC RelationManager::updateWhereLatched(const std::string &tableName, const std::string &conditionAttribute,
+                                           const CompOp compOp, const void *value,
+                                           const std::vector<AttributeAssignment> &assignments, unsigned &count) {
+        if (isCatalogTable(tableName)) {
+            return -1;
+        }
+
+        CatalogEntry *entry = nullptr;
+        if (0 != getCatalogEntry(tableName, entry)) {
+            return -1;
+        }
+        for (auto &assignment : assignments) {
+            if (entry->attrs.end() == std::find_if(entry->attrs.begin(), entry->attrs.end(), [&](const Attribute &a) {
+                return a.name == assignment.attributeName;
+            })) {
+                ERROR("Table %s has no attribute %s to update\n", tableName.c_str(), assignment.attributeName.c_str());
+                return -1;
+            }
+            // tuples can't move to another partition
+            if (NoPartitioning != entry->partitioning.method &&
+                assignment.attributeName == entry->partitioning.attribute) {
+                ERROR("Partition key %s of table %s can't be updated\n", assignment.attributeName.c_str(),
+                      tableName.c_str());
+                return -1;
+            }
+        }
+
+        if (NoPartitioning != entry->partitioning.method) {
+            for (unsigned p : prunePartitions(*entry, conditionAttribute, compOp, value)) {
+                if (0 != updateWhereLatched(partitionTableName(tableName, p), conditionAttribute, compOp, value,
+                                            assignments, count)) {
+                    return -1;
+                }
+            }
+            return 0;
+        }
+
+        // only the indexes on an assigned attribute, or carrying one, have entries to change
+        std::vector<std::string> changedIndexes;
+        for (auto &indexName : entry->indexedAttrs) {
+            std::vector<std::string> indexAttrNames;
+            for (auto &keyAttr : getIndexKeyAttributes(tableName, indexName)) {
+                indexAttrNames.push_back(keyAttr.name);
+            }
+            auto included = entry->includedAttrs.find(indexName);
+            if (entry->includedAttrs.end() != included) {
+                indexAttrNames.insert(indexAttrNames.end(), included->second.begin(), included->second.end());
+            }
+            for (auto &assignment : assignments) {
+                if (indexAttrNames.end() != std::find(indexAttrNames.begin(), indexAttrNames.end(),
+                                                      assignment.attributeName)) {
+                    changedIndexes.push_back(indexName);
+                    break;
+                }
+            }
+        }
+
+        std::vector<Attribute> attrs;
+        FileHandle *fh = nullptr;
+        if (0 != getFileHandleAndAttributes(tableName, fh, attrs)) {
+            ERROR("Error while getting filehandle and attributes for table %s", tableName.c_str());
+            return -1;
+        }
+
+        std::vector<RID> rids;
+        std::vector<std::string> oldTuples;
+        if (0 != scanMatchingTuples(*fh, attrs, conditionAttribute, compOp, value, rids, oldTuples)) {
+            ERROR("Error while reading the matching tuples of table %s\n", tableName.c_str());
+            releaseFileHandle(tableName);
+            return -1;
+        }
+
+        std::vector<std::string> newTuples;
+        std::vector<const void *> oldRecords, newRecords;
+        for (auto &oldTuple : oldTuples) {
+            newTuples.push_back(assignTuple(oldTuple.data(), attrs, assignments));
+        }
+        for (size_t i = 0; i < rids.size(); i++) {
+            oldRecords.push_back(oldTuples[i].data());
+            newRecords.push_back(newTuples[i].data());
+        }
+
+        if (0 != m_rbfm->updateRecords(*fh, attrs, newRecords, rids)) {
+            ERROR("Error while updating the matching tuples of table %s\n", tableName.c_str());
+            releaseFileHandle(tableName);
+            return -1;
+        }
+        if (!changedIndexes.empty()) {
+            deleteFromIndex(tableName, attrs, oldRecords, rids, &changedIndexes);
+            insertIntoIndex(tableName, attrs, newRecords, rids, &changedIndexes);
+        }
+        keepUndo(TuplesUpdated, tableName, attrs, rids, oldRecords);
+        count += rids.size();
+
+        RC rc = commitChanges(tableName);
+        releaseFileHandle(tableName);
+        if (0 == rc) {
+            rc = maintainAggregates(tableName, attrs, oldRecords, newRecords);
+        }
+        return rc;
+    }
+
+    RC RelationManager::scanMatchingTuples(FileHandle &fileHandle, const std::vector<Attribute> &attrs,
+                                           const std::string &conditionAttribute, const CompOp compOp,
+                                           const void *value, std::vector<RID> &rids,
+                                           std::vector<std::string> &tuples) {
+        std::vector<std::string> attributeNames;
+        for (auto &attr : attrs) {
+            attributeNames.push_back(attr.name);
+        }
+
+        RBFM_ScanIterator rbfmsi;
+        if (0 != m_rbfm->scan(fileHandle, attrs, conditionAttribute, compOp, value, attributeNames, rbfmsi)) {
+            return -1;
+        }
+        std::vector<char> buffer(maxTupleSize(attrs));
+        RID rid;
+        while (RBFM_EOF != rbfmsi.getNextRecord(rid, buffer.data())) {
+            rids.push_back(rid);
+            tuples.push_back(std::string(buffer.data(), tupleSize(buffer.data(), attrs)));
+        }
+        rbfmsi.close();
+        return 0;
+    }
+
+    RC RelationManager::readTuple(const std::string &tableName, const RID &rid, void *data) {
+        return readTuples(tableName, {rid}, {data});
+    }
+
+    RC RelationManager::readTuples(const std::string &tableName, const std::vector<RID> &rids,
+                                   const std::vector<void *> &data) {
+        TransactionScope transaction;
+        if (0 != transaction.lockRows(tableName, rids, Shared)) {
+            return -1;
+        }
+
+        return readLatched(tableName, [&]() {
+            CatalogEntry *partitionedEntry = getPartitionedEntry(tableName);
+            if (nullptr != partitionedEntry) {
+                RC rc = 0;
+                for (size_t i = 0; i < rids.size(); i++) {
+                    std::string partitionName;
+                    RID partitionRid;
+                    if (0 != locatePartitionTuple(tableName, *partitionedEntry, rids[i], partitionName,
+                                                  partitionRid) ||
+                        0 != readTuples(partitionName, {partitionRid}, {data[i]})) {
+                        rc = -1;
+                    }
+                }
+                return rc;
+            }
+
+            std::vector<Attribute> attrs;
+            FileHandle *fh = nullptr;
+            if (0 != getFileHandleAndAttributes(tableName, fh, attrs)) {
+                ERROR("Error while getting filehandle and attributes for table %s", tableName);
+                return -1;
+            }
+
+            // the locks keep the tuples from changing, the latch of the file their pages
+            RC rc = m_rbfm->readRecords(*fh, attrs, rids, data);
+            if (0 != rc) {
+                ERROR("Error while reading the records from table %s", tableName);
+            }
+            releaseFileHandle(tableName);
+            return rc;
+        });
+    }
+
+    RC RelationManager::readLatched(const std::string &tableName, const std::function<RC()> &read) {
+        // readers of a table with no partitions, known already, go on side by side, and along with writers
+        {
+            LatchedCall latched(m_latch, SharedCall);
+            if (!latched.holdsShared() ||
+                (nullptr != getCachedEntry(tableName) && nullptr == getPartitionedEntry(tableName))) {
+                return read();
+            }
+        }
+
+        // the catalog is read, or the partitions of the table are looked up
+        LatchedCall latched(m_latch);
+        return read();
+    }
+
+    RC RelationManager::printTuple(const std::vector<Attribute> &attrs, const void *data, std::ostream &out) {
+        return m_rbfm->printRecord(attrs, data, out);
+    }
+
+    RC RelationManager::readAttribute(const std::string &tableName, const RID &rid,
+                                      const std::string &attributeName, void *data) {
+        TransactionScope transaction;
+        if (0 != transaction.lockRows(tableName, {rid}, Shared)) {
+            return -1;
+        }
+        return readLatched(tableName, [&]() {
+            CatalogEntry *partitionedEntry = getPartitionedEntry(tableName);
+            if (nullptr != partitionedEntry) {
+                std::string partitionName;
+                RID partitionRid;
+                if (0 != locatePartitionTuple(tableName, *partitionedEntry, rid, partitionName, partitionRid)) {
+                    return -1;
+                }
+                return readAttribute(partitionName, partitionRid, attributeName, data);
+            }
+
+            std::vector<Attribute> attrs;
+            FileHandle *fh = nullptr;
+
+            if (0 != getFileHandleAndAttributes(tableName, fh, attrs)) {
+                ERROR("Error while getting filehandle and attributes for table %s", tableName);
+                return -1;
+            }
+
+            if (0 != m_rbfm->readAttribute(*fh, attrs, rid, attributeName, data)) {
+                ERROR("Error while reading an attribute from table %s", tableName);
+                releaseFileHandle(tableName);
+                return -1;
+            }
+            releaseFileHandle(tableName);
+            return 0;
+        });
+    }
+
+    RC RelationManager::scan(const std::string &tableName,
+                             const std::string &conditionAttribute,
+                             const CompOp compOp,
+                             const void *value,
+                             const std::vector<std::string> &attributeNames,
+                             RM_ScanIterator &rm_ScanIterator) {
+        // no row locks, nor tuples inserted meanwhile: in a transaction, the table stays locked shared until
+        // the scan is closed. outside of one, the scan reads a snapshot, only keeping out schema changes
+        TransactionScope transaction;
+        bool readsSnapshot = transaction.ownsTransaction();
+        if (0 != transaction.lockTable(tableName, readsSnapshot ? IntentionShared : Shared)) {
+            return -1;
+        }
+        LatchedCall latched(m_latch);
+
+        CatalogEntry *entry = nullptr;
+        if (m_tablesCreated.end() == m_tablesCreated.find(tableName) && 0 != getCatalogEntry(tableName, entry)) {
+            ERROR("Scan: Table %s not found\n", tableName);
+            return -1;
+        }
+
+        // partitioned tables are scanned partition by partition, skipping the ones which can't match
+        CatalogEntry *partitionedEntry = getPartitionedEntry(tableName);
+        if (nullptr != partitionedEntry) {
+            std::string conditionValue;
+            auto conditionAttr = std::find_if(partitionedEntry->attrs.begin(), partitionedEntry->attrs.end(),
+                                              [&](const Attribute &a) { return a.name == conditionAttribute; });
+            if (partitionedEntry->attrs.end() != conditionAttr && NO_OP != compOp) {
+                conditionValue = keyToString(conditionAttr->type, value);
+            }
+            if (0 != rm_ScanIterator.initPartitions(this, m_rbfm, tableName,
+                                                    prunePartitions(*partitionedEntry, conditionAttribute, compOp,
+                                                                    value),
+                                                    conditionAttribute, compOp, conditionValue, attributeNames)) {
+                return -1;
+            }
+        } else if (0 != rm_ScanIterator.init(this, m_rbfm, tableName) ||
+                   0 != rm_ScanIterator.initRbfmsi(conditionAttribute, compOp, value, attributeNames)) {
+            return -1;
+        }
+
+        rm_ScanIterator.holdLocks(transaction.handOver());
+        if (readsSnapshot) {
+            SharedCallGuard guard(m_writeSpansLatch);
+            rm_ScanIterator.holdSnapshot(m_rbfm->beginSnapshot(snapshotTimestamp()));
+        }
+        return 0;
+    }
+
+    RM_ScanIterator::RM_ScanIterator() = default;
+
+    RM_ScanIterator::~RM_ScanIterator() {
+        // a scan which wasn't closed doesn't keep its table locked, nor the versions of its snapshot
+        if (0 != m_lockOwner) {
+            LockManager::instance().releaseAll(m_lockOwner);
+        }
+        if (0 != m_snapshot) {
+            RecordBasedFileManager::instance().endSnapshot(m_snapshot);
+        }
+        delete m_partitionScan;
+    }
+
+    void RM_ScanIterator::reset() {
+        m_initDone = false;
+        m_rm = nullptr;
+        m_rbfm = nullptr;
+        m_tableName = "";
+        m_fh = nullptr;
+        m_attrs.clear();
+        m_partitioned = false;
+        m_partitions.clear();
+        m_nextPartition = 0;
+    }
+
+    RC RM_ScanIterator::init(RelationManager *rm, RecordBasedFileManager *rbfm, const std::string &tableName) {
+        close(); // unpin the table of a previous scan, if it wasn't closed
+        reset(); // in case of reusing the same iterator object
+                 // we need to reset the info inside the object, so that
+                 // it wont be corrupt
+        m_initDone = true;
+        m_rm = rm;
+        m_rbfm = rbfm;
+
+        if (0 != m_rm->getFileHandleAndAttributes(tableName, m_fh, m_attrs)) {
+            ERROR("Error while initialising a scan iterator. Failed while creating file handle");
+            m_initDone = false;
+            return -1;
+        }
+        m_tableName = tableName;
+        return 0;
+    }
+
+    RC RM_ScanIterator::initRbfmsi(const std::string &conditionAttribute,
+                                   const CompOp compOp,
+                                   const void *value,
+                                   const std::vector<std::string> &attributeNames) {
+        assert(m_initDone == true);
+
+        if (0 != m_rbfm->scan(*m_fh, m_attrs, conditionAttribute, compOp, value, attributeNames, m_rbfmsi)) {
+            ERROR("Error while init'ing RBFM scan iterator");
+            return -1;
+        }
+        return 0;
+   }
+
+    RC RM_ScanIterator::initPartitions(RelationManager *rm, RecordBasedFileManager *rbfm, const std::string &tableName,
+                                       const std::vector<unsigned> &partitions,
+                                       const std::string &conditionAttribute,
+                                       const CompOp compOp,
+                                       const std::string &value,
+                                       const std::vector<std::string> &attributeNames) {
+        close();
+        reset();
+        m_initDone = true;
+        m_partitioned = true;
+        m_rm = rm;
+        m_rbfm = rbfm;
+        m_tableName = tableName;
+        m_partitions = partitions;
+        m_conditionAttribute = conditionAttribute;
+        m_compOp = compOp;
+        m_value = value;
+        m_attributeNames = attributeNames;
+        if (nullptr == m_partitionScan) {
+            m_partitionScan = new RM_ScanIterator();
+        }
+
+        // the first partition right away, for the scan to fail early on e.g. an unknown condition attribute
+        if (!m_partitions.empty() && 0 != openNextPartition()) {
+            close();
+            return -1;
+        }
+        return 0;
+    }
+
+    RC RM_ScanIterator::openNextPartition() {
+        m_partitionScan->close();
+        if (m_nextPartition == m_partitions.size()) {
+            return RM_EOF;
+        }
+
+        unsigned partition = m_partitions[m_nextPartition++];
+        RC rc = m_rm->scan(RelationManager::partitionTableName(m_tableName, partition), m_conditionAttribute,
+                           m_compOp, m_value.empty() ? nullptr : m_value.data(), m_attributeNames, *m_partitionScan);
+
+        // the partitions are read as of the snapshot of the whole scan
+        if (0 == rc && 0 != m_snapshot) {
+            m_partitionScan->m_rbfmsi.setSnapshot(m_snapshot);
+        }
+        return rc;
+    }
+
+    void RM_ScanIterator::holdLocks(TxnId txn) {
+        if (0 != txn) {
+            m_lockOwner = txn;
+        }
+    }
+
+    void RM_ScanIterator::holdSnapshot(Timestamp snapshot) {
+        m_snapshot = snapshot;
+        if (!m_partitioned) {
+            m_rbfmsi.setSnapshot(snapshot);
+        } else if (m_partitionScan->m_initDone) {
+            m_partitionScan->m_rbfmsi.setSnapshot(snapshot);
+        }
+    }
+
+    RC RM_ScanIterator::getNextTuple(RID &rid, void *data) {
+        assert(true == m_initDone);
+        // moving on to the next partition opens a scan of it
+        LatchedCall latched(m_rm->m_latch, m_partitioned ? ExclusiveCall : SharedCall);
+
+        if (m_partitioned) {
+            while (0 != m_nextPartition) {
+                if (m_partitionScan->m_initDone && RM_EOF != m_partitionScan->getNextTuple(rid, data)) {
+                    rid = toPartitionRid(rid, m_partitions[m_nextPartition - 1]);
+                    return 0;
+                }
+                if (0 != openNextPartition()) {
+                    return RM_EOF;
+                }
+            }
+            return RM_EOF;
+        }
+
+        if (RBFM_EOF != m_rbfmsi.getNextRecord(rid, data)) {
+            return 0;
+        }
+        return RM_EOF;
+    }
+
+    RC RM_ScanIterator::close() {
+        if (m_initDone && m_partitioned) {
+            LatchedCall latched(m_rm->m_latch);
+            m_initDone = false;
+            m_partitionScan->close();
+        } else if (m_initDone) {
+            LatchedCall latched(m_rm->m_latch, SharedCall);
+            m_initDone = false;
+            m_rbfmsi.close();
+            m_rm->releaseFileHandle(m_tableName);
+            m_fh = nullptr;
+        }
+
+        if (0 != m_lockOwner) {
+            LockManager::instance().releaseAll(m_lockOwner);
+            m_lockOwner = 0;
+        }
+        if (0 != m_snapshot) {
+            RecordBasedFileManager::instance().endSnapshot(m_snapshot);
+            m_snapshot = 0;
+        }
+        return 0;
+    }
+
+    RC RelationManager::dropAttribute(const std::string &tableName, const std::string &attributeName) {
+        TransactionScope transaction;
+        if (0 != transaction.lockTable(tableName, Exclusive)) {
+            return -1;
+        }
+        LatchedCall latched(m_latch);
+        CatalogEntry *entry = nullptr;
+        if (isCatalogTable(tableName) || 0 != getCatalogEntry(tableName, entry) || !entry->aggregateOf.empty()) {
+            ERROR("Cannot drop attributes of table %s\n", tableName.c_str());
+            return -1;
+        }
+
+        // the attribute must not be the last one, nor be needed by an index, the partitioning or a
+        // materialized aggregate
+        auto attr = std::find_if(entry->attrs.begin(), entry->attrs.end(), [&](const Attribute &a) {
+            return a.name == attributeName;
+        });
+        bool inUse = attributeName == entry->partitioning.attribute;
+        for (auto &indexName : entry->indexedAttrs) {
+            std::vector<std::string> keyNames = splitAttributeNames(indexName);
+            inUse = inUse || keyNames.end() != std::find(keyNames.begin(), keyNames.end(), attributeName);
+        }
+        for (auto &included : entry->includedAttrs) {
+            inUse = inUse || included.second.end() != std::find(included.second.begin(), included.second.end(),
+                                                                attributeName);
+        }
+        for (auto &view : entry->aggregateViews) {
+            inUse = inUse || attributeName == view.attribute || attributeName == view.groupAttribute;
+        }
+        if (entry->attrs.end() == attr || 1 == entry->attrs.size() || inUse) {
+            ERROR("Cannot drop attribute %s of table %s\n", attributeName.c_str(), tableName.c_str());
+            return -1;
+        }
+
+        // partitions have the attributes of their table. they all have the same options, so the
+        // first one fails before any is changed if the attribute can't be dropped
+        unsigned partitionCount = entry->partitioning.partitionCount();
+        for (unsigned p = 0; p < partitionCount; p++) {
+            if (0 != dropAttribute(partitionTableName(tableName, p), attributeName)) {
+                return -1;
+            }
+        }
+
+        if (0 == partitionCount) {
+            // the zone map of an append-only table is kept on one of its attributes
+            FileHandle *fh = nullptr;
+            std::vector<Attribute> attrs;
+            if (0 != getFileHandleAndAttributes(tableName, fh, attrs)) {
+                return -1;
+            }
+            std::string zoneMapAttribute = m_rbfm->getZoneMapAttribute(*fh);
+            releaseFileHandle(tableName);
+            if (attributeName == zoneMapAttribute) {
+                ERROR("Cannot drop attribute %s of table %s, it has a zone map\n", attributeName.c_str(),
+                      tableName.c_str());
+                return -1;
+            }
+        }
+
+        if (0 != markAttributeDropped(entry->tableId, attributeName, nextSchemaVersion(*entry))) {
+            return -1;
+        }
+        schemaChanged(tableName);
+        return 0;
+    }
+
+    RC RelationManager::retrospectivelyInsertExistingKeysIntoIndex(const std::string &table_name,
+        const std::string &attribute_name) {
+        LatchedCall latched(m_latch);
+        Attribute indexAttribute = getIndexKeyAttribute(table_name, attribute_name);
+        std::vector<Attribute> keyAttributes = getIndexKeyAttributes(table_name, attribute_name);
+        std::vector<Attribute> attributes;
+        FileHandle *fh = nullptr;
+        IXFileHandle *ixFileHandle = nullptr;
+        if (0 != getFileHandleAndAttributes(table_name, fh, attributes)) {
+            return -1;
+        }
+        if (0 != getIndexFileHandle(table_name, attribute_name, ixFileHandle)) {
+            releaseFileHandle(table_name);
+            return -1;
+        }
+
+        // sort the (key, RID) pairs of the existing records, then build the tree bottom-up from them,
+        // instead of inserting the keys one by one
+        const std::string indexFileName = buildIndexFilename(table_name, attribute_name);
+        ExternalSorter sorter(indexAttribute, indexFileName);
+
+        // covering indexes also carry the included attributes, which are scanned right after the key ones
+        std::vector<Attribute> includedAttributes = getIncludedAttributes(table_name, attribute_name);
+        std::vector<Attribute> scannedAttributes;
+        std::vector<std::string> attributeNames;
+        std::vector<std::string> includedNames;
+        for (auto &keyAttribute : keyAttributes) {
+            scannedAttributes.push_back(keyAttribute);
+            attributeNames.push_back(keyAttribute.name);
+        }
+        for (auto &includedAttribute : includedAttributes) {
+            scannedAttributes.push_back(includedAttribute);
+            attributeNames.push_back(includedAttribute.name);
+            includedNames.push_back(includedAttribute.name);
+        }
+
+        // scan for existing records, each one comes back as the null indicator followed by the key
+        // attributes (and the included attributes)
+        RM_ScanIterator scan_iter;
+        unsigned recordSize = maxTupleSize(scannedAttributes);
+        void *recordData = malloc(recordSize);
+        assert(nullptr != recordData);
+        std::vector<char> payload(recordSize);
+        scan(table_name, "", NO_OP, nullptr, attributeNames, scan_iter);
+
+        RC rc = 0;
+        RID recordRid;
+        while (0 == rc && RM_EOF != scan_iter.getNextTuple(recordRid, recordData)) {
+            void *key = getIndexKeyFromRecord(recordData, scannedAttributes, keyAttributes);
+            if (nullptr == key) {
+                // null values are not indexed
+                continue;
+            }
+            unsigned payloadSize = 0;
+            if (!includedNames.empty()) {
+                payloadSize = projectTuple(recordData, scannedAttributes, includedNames, payload.data());
+            }
+            rc = sorter.addEntry(key, recordRid, std::string(payload.data(), payloadSize));
+            free(key);
+        }
+        scan_iter.close();
+        free(recordData);
+
+        if (0 == rc) {
+            rc = sorter.finish();
+        }
+        if (0 == rc) {
+            INFO("Bulk loading index %s, sorted in %u runs\n", indexFileName.c_str(), sorter.getNumRuns());
+            rc = m_ix->bulkLoad(*ixFileHandle, indexAttribute, sorter);
+        }
+
+        releaseFileHandle(table_name);
+        return rc;
+    }
+
+
+    RC RelationManager::addAttribute(const std::string &tableName, const Attribute &attr) {
+        TransactionScope transaction;
+        if (0 != transaction.lockTable(tableName, Exclusive)) {
+            return -1;
+        }
+        LatchedCall latched(m_latch);
+        CatalogEntry *entry = nullptr;
+        if (isCatalogTable(tableName) || 0 != getCatalogEntry(tableName, entry) || !entry->aggregateOf.empty()) {
+            ERROR("Cannot add attributes to table %s\n", tableName.c_str());
+            return -1;
+        }
+
+        auto existing = std::find_if(entry->attrs.begin(), entry->attrs.end(), [&](const Attribute &a) {
+            return a.name == attr.name;
+        });
+        if (attr.name.empty() || attr.name.size() > ATTRIBUTE_NAME_MAX_LENGTH || entry->attrs.end() != existing) {
+            ERROR("Cannot add attribute %s to table %s\n", attr.name.c_str(), tableName.c_str());
+            return -1;
+        }
+
+        // partitions have the attributes of their table
+        unsigned partitionCount = entry->partitioning.partitionCount();
+        for (unsigned p = 0; p < partitionCount; p++) {
+            if (0 != addAttribute(partitionTableName(tableName, p), attr)) {
+                while (p-- > 0) {
+                    dropAttribute(partitionTableName(tableName, p), attr.name);
+                }
+                return -1;
+            }
+        }
+
+        buildAndInsertAttributesIntoAttributesTable(std::vector<Attribute>(1, attr), entry->tableId,
+                                                    entry->lastPosition + 1, nextSchemaVersion(*entry));
+        schemaChanged(tableName);
+        return 0;
+    }
+
+    int RelationManager::nextSchemaVersion(const CatalogEntry &entry) {
+        // tables that never changed have no versions, and are in version 0
+        return entry.schemaVersions.empty() ? 1 : (int) entry.schemaVersions.size();
+    }
+
+    void RelationManager::schemaChanged(const std::string &tableName) {
+        invalidateCatalogEntry(tableName);
+
+        // the open file of the table reads and writes records with the new versions from now on
+        CatalogEntry *entry = nullptr;
+        auto it = m_tableHandles.find(tableName);
+        if (m_tableHandles.end() != it && 0 == getCatalogEntry(tableName, entry)) {
+            m_rbfm->setSchemaVersions(it->second->fileHandle, entry->schemaVersions);
+        }
+    }
+
+    RC RelationManager::markAttributeDropped(int tableId, const std::string &attributeName, int schemaVersion) {
+        FileHandle attributesFileHandle;
+        if (0 != m_rbfm->openFile(CatalogueConstants::ATTRIBUTES_FILE_NAME, attributesFileHandle)) {
+            return -1;
+        }
+
+        // find the row of the attribute among the ones of the table not dropped yet
+        RBFM_ScanIterator rbfmsi;
+        std::vector<std::string> attributeNames = {ATTRIBUTES_ATTR_NAME_ATTR_NAME, ATTRIBUTES_ATTR_NAME_DROPPED};
+        m_rbfm->scan(attributesFileHandle, CatalogueConstants::attributesTableAttributes,
+                     ATTRIBUTES_ATTR_NAME_TABLE_ID, EQ_OP, &tableId, attributeNames, rbfmsi);
+
+        // nullflags + table id + length of varchar attr + varchar attr + 5 int attrs
+        std::vector<char> data(1 + 4 + 4 + ATTRIBUTE_NAME_MAX_LENGTH + 5 * 4);
+        RID rid;
+        bool found = false;
+        while (!found && RBFM_EOF != rbfmsi.getNextRecord(rid, data.data())) {
+            uint32_t nameLength;
+            int dropped = 0;
+            memcpy(&nameLength, data.data() + 1, 4);
+            if (!isAttrNull(data.data(), 1)) {
+                memcpy(&dropped, data.data() + 1 + 4 + nameLength, 4);
+            }
+            found = 0 == dropped && attributeName == std::string(data.data() + 1 + 4, nameLength);
+        }
+        rbfmsi.close();
+
+        // column-added and column-dropped are the last attributes of the row. rows of older
+        // catalogs have them NULL, the one for column-added is then 0
+        RC rc = found ? 0 : -1;
+        if (found && 0 == (rc = m_rbfm->readRecord(attributesFileHandle, CatalogueConstants::attributesTableAttributes,
+                                                   rid, data.data()))) {
+            char *versionsData = data.data() + 1 + 4 + 4 + attributeName.size() + 3 * 4;
+            if (isAttrNull(data.data(), 5)) {
+                memset(versionsData, 0, 4);
+            }
+            data[0] &= ~((1 << (7 - 5)) | (1 << (7 - 6)));
+            memcpy(versionsData + 4, &schemaVersion, 4);
+            rc = m_rbfm->updateRecord(attributesFileHandle, CatalogueConstants::attributesTableAttributes,
+                                      data.data(), rid);
+        }
+        m_rbfm->closeFile(attributesFileHandle);
+        return rc;
+    }
+
+    // QE IX related
+    RC RelationManager::createIndex(const std::string &tableName, const std::string &attributeName) {
+        return createIndex(tableName, attributeName, std::vector<std::string>());
+    }
+
+    RC RelationManager::createIndex(const std::string &tableName, const std::string &attributeName,
+                                    const std::vector<std::string> &includedAttributeNames) {
+        return createIndex(tableName, std::vector<std::string>(1, attributeName), includedAttributeNames);
+    }
+
+    RC RelationManager::createIndex(const std::string &tableName, const std::vector<std::string> &attributeNames,
+                                    const std::vector<std::string> &includedAttributeNames) {
+        return createIndex(tableName, attributeNames, includedAttributeNames, "");
+    }
+
+    RC RelationManager::createIndex(const std::string &tableName, const std::vector<std::string> &attributeNames,
+                                    const std::vector<std::string> &includedAttributeNames,
+                                    const std::string &tablespace) {
+        TransactionScope transaction;
+        if (0 != transaction.lockTable(tableName, Shared)) {
+            return -1;
+        }
+        LatchedCall latched(m_latch);
+        const std::string attributeName = joinAttributeNames(attributeNames);
+        INFO("Creaitng index for tableName=%s on attribute=%s\n",
+             tableName, attributeName);
+        CatalogEntry *entry = nullptr;
+        if (0 != getCatalogEntry(tableName, entry)) {
+            ERROR("Table %s not found\n", tableName.c_str());
+            return -1;
+        }
+
+        // key attributes must be distinct attributes of the table, and fit into a key together
+        std::vector<Attribute> keyAttributes;
+        for (auto &keyAttributeName : attributeNames) {
+            auto attr = std::find_if(entry->attrs.begin(), entry->attrs.end(), [&](const Attribute &a) {
+                return a.name == keyAttributeName;
+            });
+            if (entry->attrs.end() == attr ||
+                1 != std::count(attributeNames.begin(), attributeNames.end(), keyAttributeName)) {
+                ERROR("Cannot index attribute %s of table %s\n", keyAttributeName.c_str(), tableName.c_str());
+                return -1;
+            }
+            keyAttributes.push_back(*attr);
+        }
+        if (keyAttributes.empty() || attributeName.size() > ATTRIBUTE_NAME_MAX_LENGTH ||
+            (keyAttributes.size() > 1 && CompositeKey::maxEncodedSize(keyAttributes) > COMPOSITE_KEY_MAX_SIZE)) {
+            ERROR("Cannot create an index on %s.%s\n", tableName.c_str(), attributeName.c_str());
+            return -1;
+        }
+
+        // partitioned tables have a local index in each partition
+        unsigned partitionCount = entry->partitioning.partitionCount();
+        for (unsigned p = 0; p < partitionCount; p++) {
+            if (0 != createIndex(partitionTableName(tableName, p), attributeNames, includedAttributeNames, tablespace)) {
+                while (p-- > 0) {
+                    destroyIndex(partitionTableName(tableName, p), attributeName);
+                }
+                invalidateCatalogEntry(tableName);
+                return -1;
+            }
+        }
+        if (0 != partitionCount) {
+            invalidateCatalogEntry(tableName);
+            return 0;
+        }
+
+        // included attributes must be other attributes of the table, and fit into an index entry
+        std::vector<Attribute> includedAttributes;
+        unsigned includedNamesLength = 0;
+        for (auto &includedAttributeName : includedAttributeNames) {
+            auto attr = std::find_if(entry->attrs.begin(), entry->attrs.end(), [&](const Attribute &a) {
+                return a.name == includedAttributeName;
+            });
+            auto included = std::find_if(includedAttributes.begin(), includedAttributes.end(),
+                                         [&](const Attribute &a) { return a.name == includedAttributeName; });
+            if (entry->attrs.end() == attr || includedAttributes.end() != included ||
+                attributeNames.end() != std::find(attributeNames.begin(), attributeNames.end(), includedAttributeName)) {
+                ERROR("Cannot include attribute %s in the index on %s.%s\n", includedAttributeName.c_str(),
+                      tableName.c_str(), attributeName.c_str());
+                return -1;
+            }
+            includedAttributes.push_back(*attr);
+            includedNamesLength += includedAttributeName.size() + 1;
+        }
+        if (includedNamesLength > INDEX_INCLUDED_COLUMNS_MAX_LENGTH + 1 ||
+            (!includedAttributes.empty() && maxTupleSize(includedAttributes) > IX_MAX_PAYLOAD_SIZE)) {
+            ERROR("Included attributes of the index on %s.%s take too much room\n",
+                  tableName.c_str(), attributeName.c_str());
+            return -1;
+        }
+
+        // check if index already exists
+        if (doesIndexExist(tableName, attributeName)) {
+            ERROR("Index for table=%s, attribute=%s already exists",
+                  tableName.data(), attributeName.data());
+            return -1;
+        }
+
+        // IndexFilename format: <tableName>_<attrName>_index, next to the table file unless in a tablespace given
+        std::string indexFileName = getIndexFileName(tableName, attributeName);
+        if (!tablespace.empty()) {
+            indexFileName = PagedFileManager::tablespaceFileName(tablespace, indexFileName);
+            if (PagedFileManager::isMemoryFile(indexFileName) || 0 != loadTablespace(tablespace)) {
+                ERROR("Index on %s.%s can't go to tablespace %s\n", tableName.c_str(), attributeName.c_str(),
+                      tablespace.c_str());
+                return -1;
+            }
+        }
+        if (PagedFileManager::instance().fileExists(indexFileName)) {
+            // left behind by an index the catalog no longer knows of
+            WARNING("Removing stale index file %s\n", indexFileName.c_str());
+            m_ix->destroyFile(indexFileName);
+        }
+        if (0 != m_ix->createFile(indexFileName)) {
+            ERROR("Error while creating index file for table=%s, attribute=%s \n", tableName.c_str(), attributeName.c_str());
+            return -1;
+        }
+
+        if (0 != insertIndexIntoCatalog(entry->tableId, attributeName, indexFileName, includedAttributeNames)) {
+            m_ix->destroyFile(indexFileName);
+            return -1;
+        }
+        entry->indexedAttrs.push_back(attributeName);
+        entry->indexFileNames[attributeName] = indexFileName;
+        if (!includedAttributeNames.empty()) {
+            entry->includedAttrs[attributeName] = includedAttributeNames;
+        }
+
+        // bulk load previously inserted tuples
+        if (0 != retrospectivelyInsertExistingKeysIntoIndex(tableName, attributeName)) {
+            ERROR("Error while loading the existing keys into index for table=%s, attribute=%s\n",
+                  tableName.c_str(), attributeName.c_str());
+            destroyIndex(tableName, attributeName);
+            return -1;
+        }
+
+        return 0;
+    }
+
+    RC RelationManager::destroyIndex(const std::string &tableName, const std::string &attributeName) {
+        TransactionScope transaction;
+        if (0 != transaction.lockTable(tableName, Exclusive)) {
+            return -1;
+        }
+        LatchedCall latched(m_latch);
+        // check if index even exists
+        if (!doesIndexExist(tableName, attributeName)) {
+            ERROR("Index for table=%s, attribute=%s does not even exist",
+                  tableName.data(), attributeName.data());
+            return -1;
+        }
+
+        CatalogEntry *entry = nullptr;
+        getCatalogEntry(tableName, entry);
+
+        unsigned partitionCount = entry->partitioning.partitionCount();
+        if (0 != partitionCount) {
+            RC rc = 0;
+            for (unsigned p = 0; p < partitionCount; p++) {
+                if (0 != destroyIndex(partitionTableName(tableName, p), attributeName)) {
+                    rc = -1;
+                }
+            }
+            invalidateCatalogEntry(tableName);
+            return rc;
+        }
+
+        const std::string indexFileName = getIndexFileName(tableName, attributeName);
+        if (0 != deleteIndexFromCatalog(entry->tableId, attributeName)) {
+            return -1;
+        }
+        entry->indexedAttrs.erase(std::find(entry->indexedAttrs.begin(), entry->indexedAttrs.end(), attributeName));
+        entry->includedAttrs.erase(attributeName);
+        entry->indexFileNames.erase(attributeName);
+
+        auto it = m_tableHandles.find(tableName);
+        if (m_tableHandles.end() != it) {
+            closeIndexHandle(it->second, attributeName);
+        }
+
+        return m_ix->destroyFile(indexFileName);
+    }
+
+    void RelationManager::destroyIndex(const std::string &tableName) {
+        LatchedCall latched(m_latch);
+        CatalogEntry *entry = nullptr;
+        if (0 != getCatalogEntry(tableName, entry)) {
+            return;
+        }
+        // composite indexes too, which are not named after a single attribute
+        std::vector<std::string> indexNames = entry->indexedAttrs;
+        for (const auto &indexName: indexNames) {
+            destroyIndex(tableName, indexName);
+        }
+    }
+
+    // indexScan returns an iterator to allow the caller to go through qualified entries in index
+    RC RelationManager::indexScan(const std::string &tableName,
+                                  const std::string &attributeName,
+                                  const void *lowKey,
+                                  const void *highKey,
+                                  bool lowKeyInclusive,
+                                  bool highKeyInclusive,
+                                  RM_IndexScanIterator &rm_IndexScanIterator) {
+        return indexScan(tableName, attributeName, lowKey, highKey, lowKeyInclusive, highKeyInclusive,
+                         std::vector<std::string>(), rm_IndexScanIterator);
+    }
+
+    RC RelationManager::indexScan(const std::string &tableName,
+                                  const std::string &attributeName,
+                                  const void *lowKey,
+                                  const void *highKey,
+                                  bool lowKeyInclusive,
+                                  bool highKeyInclusive,
+                                  const std::vector<std::string> &attributeNames,
+                                  RM_IndexScanIterator &rm_IndexScanIterator) {
+        /*
+         * wrapper around ix.scan()
+         */
+        TransactionScope transaction;
+        if (0 != transaction.lockTable(tableName, Shared)) {
+            return -1;
+        }
+        LatchedCall latched(m_latch);
+
+        // check if index even exists
+        if (!doesIndexExist(tableName, attributeName)) {
+            ERROR("Index for table=%s, attribute=%s does not even exist",
+                  tableName.data(), attributeName.data());
+            return -1;
+        }
+
+        // partitioned tables are scanned through the index of each partition which can have matching keys
+        CatalogEntry *partitionedEntry = getPartitionedEntry(tableName);
+        if (nullptr != partitionedEntry) {
+            AttrType keyType = getIndexKeyAttribute(tableName, attributeName).type;
+            std::string low = keyToString(keyType, lowKey);
+            std::string high = keyToString(keyType, highKey);
+
+            std::vector<unsigned> partitions;
+            if (nullptr != lowKey && lowKeyInclusive && highKeyInclusive && low == high) {
+                partitions = prunePartitions(*partitionedEntry, attributeName, EQ_OP, lowKey);
+            } else {
+                std::vector<unsigned> aboveLow = prunePartitions(*partitionedEntry, attributeName,
+                                                                 lowKeyInclusive ? GE_OP : GT_OP, lowKey);
+                std::vector<unsigned> belowHigh = prunePartitions(*partitionedEntry, attributeName,
+                                                                  highKeyInclusive ? LE_OP : LT_OP, highKey);
+                std::set_intersection(aboveLow.begin(), aboveLow.end(), belowHigh.begin(), belowHigh.end(),
+                                      std::back_inserter(partitions));
+            }
+            if (0 != rm_IndexScanIterator.initPartitions(this, tableName, partitions, attributeName, low, high,
+                                                         lowKeyInclusive, highKeyInclusive, attributeNames)) {
+                return -1;
+            }
+            rm_IndexScanIterator.holdLocks(transaction.handOver());
+            return 0;
+        }
+
+        // pin the table, so that its open index file stays around until the scan is closed
+        std::vector<Attribute> attrs;
+        FileHandle *fh = nullptr;
+        IXFileHandle *ixFileHandle = nullptr;
+        if (0 != getFileHandleAndAttributes(tableName, fh, attrs)) {
+            return -1;
+        }
+        if (0 != getIndexFileHandle(tableName, attributeName, ixFileHandle)) {
+            releaseFileHandle(tableName);
+            return -1;
+        }
+        rm_IndexScanIterator.init(this, tableName, ixFileHandle);
+        rm_IndexScanIterator.initProjection(attrs, getIndexKeyAttributes(tableName, attributeName),
+                                            getIncludedAttributes(tableName, attributeName), attributeNames);
+
+        m_ix->scan(*ixFileHandle,
+                   getIndexKeyAttribute(tableName, attributeName),
+                   lowKey,
+                   highKey,
+                   lowKeyInclusive,
+                   highKeyInclusive,
+                   rm_IndexScanIterator.getIxScanIterator());
+
+        rm_IndexScanIterator.holdLocks(transaction.handOver());
+        return 0;
+    }
+
+    RC RelationManager::indexScan(const std::string &tableName,
+                                  const std::vector<std::string> &attributeNames,
+                                  const std::vector<const void *> &lowValues,
+                                  const std::vector<const void *> &highValues,
+                                  bool lowInclusive,
+                                  bool highInclusive,
+                                  const std::vector<std::string> &projectedAttributeNames,
+                                  RM_IndexScanIterator &rm_IndexScanIterator) {
+        TransactionScope transaction;
+        if (0 != transaction.lockTable(tableName, Shared)) {
+            return -1;
+        }
+        LatchedCall latched(m_latch);
+
+        const std::string indexName = joinAttributeNames(attributeNames);
+        if (!doesIndexExist(tableName, indexName)) {
+            ERROR("Index for table=%s, attribute=%s does not even exist",
+                  tableName.data(), indexName.data());
+            return -1;
+        }
+        std::vector<Attribute> keyAttrs = getIndexKeyAttributes(tableName, indexName);
+        if (lowValues.size() > keyAttrs.size() || highValues.size() > keyAttrs.size()) {
+            ERROR("Index %s of table %s has only %zu attributes\n", indexName.c_str(), tableName.c_str(),
+                  keyAttrs.size());
+            return -1;
+        }
+        if (1 == keyAttrs.size()) {
+            if (0 != indexScan(tableName, indexName, lowValues.empty() ? nullptr : lowValues[0],
+                               highValues.empty() ? nullptr : highValues[0], lowInclusive, highInclusive,
+                               projectedAttributeNames, rm_IndexScanIterator)) {
+                return -1;
+            }
+            rm_IndexScanIterator.holdLocks(transaction.handOver());
+            return 0;
+        }
+
+        // the keys of the entries matching a prefix all start with the key of the prefix. so, an inclusive
+        // low bound starts at the prefix, an exclusive one right after all the keys starting with it, and
+        // the other way round for the high bound
+        unsigned keySize = sizeof(uint32_t) + CompositeKey::maxEncodedSize(keyAttrs);
+        std::vector<char> lowKey(keySize), highKey(keySize);
+        const void *low = nullptr;
+        const void *high = nullptr;
+        bool emptyScan = false;
+        if (!lowValues.empty()) {
+            CompositeKey::encode(keyAttrs, lowValues, lowKey.data());
+            low = lowKey.data();
+            // nothing comes after the prefix, the scan is empty
+            emptyScan = !lowInclusive && !CompositeKey::prefixEnd(lowKey.data(), lowKey.data());
+        }
+        bool highKeyInclusive = false;
+        if (!highValues.empty()) {
+            CompositeKey::encode(keyAttrs, highValues, highKey.data());
+            high = highKey.data();
+            if (highInclusive && !CompositeKey::prefixEnd(highKey.data(), highKey.data())) {
+                // nothing comes after the prefix, the scan is open ended
+                high = nullptr;
+            }
+        }
+        RC rc = emptyScan ? indexScan(tableName, indexName, low, low, false, false, projectedAttributeNames,
+                                      rm_IndexScanIterator)
+                          : indexScan(tableName, indexName, low, high, true, highKeyInclusive, projectedAttributeNames,
+                                      rm_IndexScanIterator);
+        if (0 != rc) {
+            return -1;
+        }
+        rm_IndexScanIterator.holdLocks(transaction.handOver());
+        return 0;
+    }
+
+    RC RelationManager::analyze(const std::string &tableName, unsigned samplePages) {
+        TransactionScope transaction;
+        if (0 != transaction.lockTable(tableName, Shared)) {
+            return -1;
+        }
+        LatchedCall latched(m_latch);
+        CatalogEntry *entry = nullptr;
+        if (0 != getCatalogEntry(tableName, entry)) {
+            return -1;
+        }
+        int tableId = entry->tableId;
+
+        unsigned partitionCount = entry->partitioning.partitionCount();
+        for (unsigned p = 0; p < partitionCount; p++) {
+            if (0 != analyze(partitionTableName(tableName, p), samplePages)) {
+                return -1;
+            }
+        }
+        if (0 != partitionCount) {
+            return 0;
+        }
+
+        FileHandle *fh = nullptr;
+        std::vector<Attribute> attrs;
+        if (0 != getFileHandleAndAttributes(tableName, fh, attrs)) {
+            return -1;
+        }
+
+        std::vector<std::string> attributeNames;
+        for (auto &attr : attrs) {
+            attributeNames.push_back(attr.name);
+        }
+
+        // small tables are read in full, larger ones only from a sample of their pages
+        unsigned dataPages = fh->getNumberOfPages();
+        bool sampled = dataPages > samplePages;
+        RBFM_ScanIterator rbfmsi;
+        RC rc = sampled ? m_rbfm->sampleScanPages(*fh, attrs, samplePages, STATS_SAMPLE_SEED, "", NO_OP, nullptr,
+                                                  attributeNames, rbfmsi)
+                        : m_rbfm->scan(*fh, attrs, "", NO_OP, nullptr, attributeNames, rbfmsi);
+        if (0 != rc) {
+            ERROR("Error while scanning table %s for its statistics\n", tableName.c_str());
+            releaseFileHandle(tableName);
+            return -1;
+        }
+
+        StatisticsCollector collector(attrs);
+        std::vector<char> data(maxTupleSize(attrs));
+        RID rid;
+        while (RBFM_EOF != rbfmsi.getNextRecord(rid, data.data())) {
+            collector.addTuple(data.data());
+        }
+
+        double rowScale = 1;
+        if (sampled && 0 != rbfmsi.getScannedPageCount()) {
+            rowScale = (double) rbfmsi.getDataPageCount() / rbfmsi.getScannedPageCount();
+        }
+        rbfmsi.close();
+        releaseFileHandle(tableName);
+
+        TableStatistics stats;
+        collector.finish(dataPages, rowScale, stats);
+        stats.sampled = sampled;
+
+        if (0 != deleteStatisticsFromCatalog(tableId) || 0 != insertStatisticsIntoCatalog(tableId, stats)) {
+            ERROR("Error while writing the statistics of table %s\n", tableName.c_str());
+            invalidateCatalogEntry(tableName);
+            return -1;
+        }
+
+        if (0 == getCatalogEntry(tableName, entry)) {
+            entry->statistics = stats;
+            entry->statisticsLoaded = true;
+            entry->hasStatistics = true;
+        }
+        return 0;
+    }
+
+    RC RelationManager::getStatistics(const std::string &tableName, TableStatistics &stats) {
+        LatchedCall latched(m_latch);
+        CatalogEntry *entry = nullptr;
+        if (0 != getCatalogEntry(tableName, entry)) {
+            return -1;
+        }
+
+        if (!entry->statisticsLoaded) {
+            entry->hasStatistics = 0 == readStatisticsFromCatalog(entry->tableId, entry->attrs, entry->statistics);
+            entry->statisticsLoaded = true;
+        }
+        if (!entry->hasStatistics) {
+            return -1;
+        }
+
+        stats = entry->statistics;
+        return 0;
+    }
+
+    RC RelationManager::getRowCount(const std::string &tableName, unsigned &count) {
+        TransactionScope transaction;
+        if (0 != transaction.lockTable(tableName, Shared)) {
+            return -1;
+        }
+        LatchedCall latched(m_latch);
+        CatalogEntry *entry = nullptr;
+        if (0 != getCatalogEntry(tableName, entry)) {
+            return -1;
+        }
+
+        count = 0;
+        unsigned partitionCount = entry->partitioning.partitionCount();
+        if (0 != partitionCount) {
+            for (unsigned p = 0; p < partitionCount; p++) {
+                unsigned partitionRows = 0;
+                if (0 != getRowCount(partitionTableName(tableName, p), partitionRows)) {
+                    return -1;
+                }
+                count += partitionRows;
+            }
+            return 0;
+        }
+
+        FileHandle *fh = nullptr;
+        std::vector<Attribute> attrs;
+        if (0 != getFileHandleAndAttributes(tableName, fh, attrs)) {
+            return -1;
+        }
+        RC rc = m_rbfm->getRecordCount(*fh, count);
+        releaseFileHandle(tableName);
+        return rc;
+    }
+
+    RC RelationManager::getRowCount(const std::string &tableName, const std::string &attributeName,
+                                    const CompOp compOp, const void *value, unsigned &count) {
+        if (NO_OP == compOp) {
+            return getRowCount(tableName, count);
+        }
+        {
+            LatchedCall latched(m_latch);
+            if (!doesIndexExist(tableName, attributeName)) {
+                return -1;
+            }
+        }
+
+        // the entries in the key range of the condition. NULLs aren't indexed, which is what the
+        // condition wants: all the entries less the equal ones are the tuples not equal to the value
+        const void *lowKey = nullptr;
+        const void *highKey = nullptr;
+        bool lowKeyInclusive = true;
+        bool highKeyInclusive = true;
+        switch (compOp) {
+            case EQ_OP:
+            case NE_OP:
+                lowKey = value;
+                highKey = value;
+                break;
+            case LT_OP:
+            case LE_OP:
+                highKey = value;
+                highKeyInclusive = LE_OP == compOp;
+                break;
+            case GT_OP:
+            case GE_OP:
+                lowKey = value;
+                lowKeyInclusive = GE_OP == compOp;
+                break;
+            default:
+                return -1;
+        }
+
+        unsigned rangeCount = 0;
+        unsigned allCount = 0;
+        if (0 != countIndexEntries(tableName, attributeName, lowKey, highKey, lowKeyInclusive, highKeyInclusive,
+                                   rangeCount) ||
+            (NE_OP == compOp &&
+             0 != countIndexEntries(tableName, attributeName, nullptr, nullptr, true, true, allCount))) {
+            return -1;
+        }
+        count = NE_OP == compOp ? allCount - rangeCount : rangeCount;
+        return 0;
+    }
+
+    RC RelationManager::countIndexEntries(const std::string &tableName, const std::string &attributeName,
+                                          const void *lowKey, const void *highKey, bool lowKeyInclusive,
+                                          bool highKeyInclusive, unsigned &count) {
+        RM_IndexScanIterator iter;
+        if (0 != indexScan(tableName, attributeName, lowKey, highKey, lowKeyInclusive, highKeyInclusive, iter)) {
+            return -1;
+        }
+
+        count = 0;
+        RID rid;
+        std::vector<char> key(PAGE_SIZE);
+        while (RM_EOF != iter.getNextEntry(rid, key.data())) {
+            count++;
+        }
+        iter.close();
+        return 0;
+    }
+
+    RC RelationManager::cluster(const std::string &tableName, const std::string &attributeName) {
+        // writers wait until the table is switched over, readers go on with the old files meanwhile
+        TransactionScope transaction;
+        if (0 != transaction.lockTable(tableName, Shared)) {
+            return -1;
+        }
+
+        // the tables with a file of their own: the table, or its partitions
+        std::vector<std::string> tableNames;
+        {
+            LatchedCall latched(m_latch);
+            CatalogEntry *entry = nullptr;
+            if (isCatalogTable(tableName) || 0 != getCatalogEntry(tableName, entry)) {
+                ERROR("Cannot cluster table %s\n", tableName.c_str());
+                return -1;
+            }
+            auto attr = std::find_if(entry->attrs.begin(), entry->attrs.end(), [&](const Attribute &a) {
+                return a.name == attributeName;
+            });
+            if (entry->attrs.end() == attr) {
+                ERROR("Table %s has no attribute %s to cluster on\n", tableName.c_str(), attributeName.c_str());
+                return -1;
+            }
+
+            unsigned partitionCount = entry->partitioning.partitionCount();
+            for (unsigned p = 0; p < partitionCount; p++) {
+                tableNames.push_back(partitionTableName(tableName, p));
+            }
+            if (0 == partitionCount) {
+                tableNames.push_back(tableName);
+            }
+        }
+
+        RC rc = 0;
+        std::vector<std::string> fileNames;
+        for (unsigned i = 0; 0 == rc && i < tableNames.size(); i++) {
+            std::string fileName;
+            rc = writeClustered(tableNames[i], attributeName, fileName);
+            if (0 == rc) {
+                fileNames.push_back(fileName);
+            }
+        }
+
+        // the switch waits for the scans of the old files to be closed
+        if (0 == rc) {
+            rc = transaction.lockTable(tableName, Exclusive);
+        }
+
+        {
+            LatchedCall latched(m_latch);
+            for (unsigned i = 0; 0 == rc && i < fileNames.size(); i++) {
+                // only scans of the thread's own transactions can still be open
+                auto it = m_tableHandles.find(tableNames[i]);
+                if (m_tableHandles.end() != it && 0 != it->second->refCount) {
+                    ERROR("Table %s is in use, it can't switch over to its clustered file\n", tableNames[i].c_str());
+                    rc = -1;
+                }
+            }
+            for (unsigned i = 0; i < fileNames.size(); i++) {
+                if (0 == rc) {
+                    rc = switchTableFile(tableNames[i], fileNames[i]);
+                }
+                if (0 != rc) {
+                    destroyClusteredFiles(tableNames[i], fileNames[i]);
+                }
+            }
+        }
+        return transaction.commit(rc);
+    }
+
+    RC RelationManager::writeClustered(const std::string &tableName, const std::string &attributeName,
+                                       std::string &fileName) {
+        std::vector<Attribute> attrs;
+        std::vector<std::vector<Attribute> > schemaVersions;
+        std::vector<std::string> indexedAttrs;
+        std::vector<std::vector<Attribute> > indexKeyAttrs;
+        std::vector<Attribute> indexAttrs;
+        std::vector<std::vector<std::string> > includedNames;
+        std::vector<std::string> indexFileNames;
+        FileHandle *fh = nullptr;
+        {
+            LatchedCall latched(m_latch);
+            CatalogEntry *entry = nullptr;
+            if (0 != getCatalogEntry(tableName, entry)) {
+                return -1;
+            }
+            fileName = nextTableFileName(entry->fileName);
+            if (fileName.size() > ATTRIBUTE_NAME_MAX_LENGTH) {
+                ERROR("File name %s of table %s is too long\n", fileName.c_str(), tableName.c_str());
+                return -1;
+            }
+            schemaVersions = entry->schemaVersions;
+            indexedAttrs = entry->indexedAttrs;
+            for (auto &indexName : indexedAttrs) {
+                auto included = entry->includedAttrs.find(indexName);
+                includedNames.push_back(entry->includedAttrs.end() != included ? included->second
+                                                                                : std::vector<std::string>());
+                indexKeyAttrs.push_back(getIndexKeyAttributes(tableName, indexName));
+                indexAttrs.push_back(getIndexKeyAttribute(tableName, indexName));
+                indexFileNames.push_back(movedIndexFileName(tableName, indexName, fileName));
+            }
+            if (0 != getFileHandleAndAttributes(tableName, fh, attrs)) {
+                return -1;
+            }
+        }
+
+        auto keyAttr = std::find_if(attrs.begin(), attrs.end(), [&](const Attribute &a) {
+            return a.name == attributeName;
+        });
+        if (attrs.end() == keyAttr || m_rbfm->isAppendOnly(*fh)) {
+            ERROR("Table %s can't be clustered on %s, append-only tables keep the order their tuples came in\n",
+                  tableName.c_str(), attributeName.c_str());
+            releaseFileHandle(tableName);
+            return -1;
+        }
+
+        // sort the tuples on the attribute, each one carried along as the payload of its entry. the ones
+        // where it is NULL have no key, they are read again at the end
+        ExternalSorter sorter(*keyAttr, runFilePrefix(fileName));
+        std::vector<RID> nullKeyRids;
+        std::vector<std::string> attributeNames;
+        for (auto &attr : attrs) {
+            attributeNames.push_back(attr.name);
+        }
+        std::vector<char> tuple(maxTupleSize(attrs));
+        RBFM_ScanIterator rbfmsi;
+        RC rc = m_rbfm->scan(*fh, attrs, "", NO_OP, nullptr, attributeNames, rbfmsi);
+        RID rid;
+        while (0 == rc && RBFM_EOF != rbfmsi.getNextRecord(rid, tuple.data())) {
+            void *key = getKeyFromRecord(tuple.data(), attrs, *keyAttr);
+            if (nullptr == key) {
+                nullKeyRids.push_back(rid);
+                continue;
+            }
+            rc = sorter.addEntry(key, rid, std::string(tuple.data(), tupleSize(tuple.data(), attrs)));
+            free(key);
+        }
+        rbfmsi.close();
+        if (0 == rc) {
+            rc = sorter.finish();
+        }
+
+        // striped tables stay striped
+        FileHandle clusteredFh;
+        bool striped = 0 != fh->getStripeCount();
+        bool opened = 0 == rc &&
+                      0 == (striped ? PagedFileManager::instance().createStripedFile(fileName)
+                                    : m_rbfm->createFile(fileName)) &&
+                      0 == m_rbfm->openFile(fileName, clusteredFh);
+        if (0 == rc && !opened) {
+            ERROR("Error while creating the file %s\n", fileName.c_str());
+            rc = -1;
+        }
+        if (opened) {
+            m_rbfm->setSchemaVersions(clusteredFh, schemaVersions);
+        }
+
+        // the tuples fill the pages of the new file one after another, in batches. the entries of every
+        // index are sorted along the way, with the RIDs the tuples get
+        std::vector<std::unique_ptr<ExternalSorter> > indexSorters;
+        for (unsigned i = 0; i < indexedAttrs.size(); i++) {
+            indexSorters.push_back(std::unique_ptr<ExternalSorter>(
+                    new ExternalSorter(indexAttrs[i], runFilePrefix(indexFileNames[i]))));
+        }
+        std::vector<std::string> batch;
+        std::vector<char> payload(tuple.size());
+        auto writeBatch = [&]() -> RC {
+            std::vector<const void *> data;
+            for (auto &batchTuple : batch) {
+                data.push_back(batchTuple.data());
+            }
+            std::vector<RID> rids;
+            if (0 != m_rbfm->insertRecords(clusteredFh, attrs, data, rids, true)) {
+                return -1;
+            }
+            for (unsigned i = 0; i < indexSorters.size(); i++) {
+                for (unsigned j = 0; j < data.size(); j++) {
+                    void *key = getIndexKeyFromRecord(data[j], attrs, indexKeyAttrs[i]);
+                    if (nullptr == key) {
+                        // null values are not indexed
+                        continue;
+                    }
+                    unsigned payloadSize = 0;
+                    if (!includedNames[i].empty()) {
+                        payloadSize = projectTuple(data[j], attrs, includedNames[i], payload.data());
+                    }
+                    RC ae = indexSorters[i]->addEntry(key, rids[j], std::string(payload.data(), payloadSize));
+                    free(key);
+                    if (0 != ae) {
+                        return -1;
+                    }
+                }
+            }
+            batch.clear();
+            return 0;
+        };
+
+        std::vector<char> key(PAGE_SIZE);
+        std::string sortedTuple;
+        while (0 == rc && IX_EOF != sorter.getNextEntry(rid, key.data(), sortedTuple)) {
+            batch.push_back(sortedTuple);
+            if (batch.size() >= CLUSTER_BATCH_TUPLES) {
+                rc = writeBatch();
+            }
+        }
+        for (unsigned i = 0; 0 == rc && i < nullKeyRids.size(); i++) {
+            rc = m_rbfm->readRecord(*fh, attrs, nullKeyRids[i], tuple.data());
+            if (0 == rc) {
+                batch.push_back(std::string(tuple.data(), tupleSize(tuple.data(), attrs)));
+            }
+            if (0 == rc && batch.size() >= CLUSTER_BATCH_TUPLES) {
+                rc = writeBatch();
+            }
+        }
+        if (0 == rc && !batch.empty()) {
+            rc = writeBatch();
+        }
+        releaseFileHandle(tableName);
+        if (opened) {
+            m_rbfm->closeFile(clusteredFh);
+        }
+
+        // the indexes are built bottom-up from their sorted entries, into the files next to the new one
+        for (unsigned i = 0; 0 == rc && i < indexSorters.size(); i++) {
+            const std::string &indexFileName = indexFileNames[i];
+            IXFileHandle ixFileHandle;
+            rc = indexSorters[i]->finish();
+            if (0 == rc && (0 != m_ix->createFile(indexFileName) ||
+                            0 != m_ix->openFile(indexFileName, ixFileHandle))) {
+                ERROR("Error while creating the index file %s\n", indexFileName.c_str());
+                rc = -1;
+            }
+            if (0 == rc) {
+                INFO("Bulk loading index %s, sorted in %u runs\n", indexFileName.c_str(),
+                     indexSorters[i]->getNumRuns());
+                rc = m_ix->bulkLoad(ixFileHandle, indexAttrs[i], *indexSorters[i]);
+                m_ix->closeFile(ixFileHandle);
+            }
+        }
+
+        if (0 != rc) {
+            LatchedCall latched(m_latch);
+            destroyClusteredFiles(tableName, fileName);
+        }
+        return rc;
+    }
+
+    RC RelationManager::switchTableFile(const std::string &tableName, const std::string &fileName) {
+        CatalogEntry *entry = nullptr;
+        if (0 != getCatalogEntry(tableName, entry)) {
+            return -1;
+        }
+        int tableId = entry->tableId;
+        std::string oldFileName = entry->fileName;
+        std::vector<std::string> indexedAttrs = entry->indexedAttrs;
+        std::unordered_map<std::string, std::vector<std::string> > includedAttrs = entry->includedAttrs;
+        std::vector<std::string> oldIndexFileNames;
+        std::vector<std::string> indexFileNames;
+        for (auto &indexName : indexedAttrs) {
+            oldIndexFileNames.push_back(getIndexFileName(tableName, indexName));
+            indexFileNames.push_back(movedIndexFileName(tableName, indexName, fileName));
+        }
+
+        if (0 != updateTableFileInCatalog(tableId, tableName, fileName)) {
+            ERROR("Error while updating the file of table %s in the catalog\n", tableName.c_str());
+            return -1;
+        }
+        for (unsigned i = 0; i < indexedAttrs.size(); i++) {
+            const std::string &indexName = indexedAttrs[i];
+            if (0 != deleteIndexFromCatalog(tableId, indexName) ||
+                0 != insertIndexIntoCatalog(tableId, indexName, indexFileNames[i], includedAttrs[indexName])) {
+                ERROR("Error while updating the file of index %s of table %s in the catalog\n", indexName.c_str(),
+                      tableName.c_str());
+                return -1;
+            }
+        }
+
+        closeTableHandle(tableName);
+        m_tablesCreated[tableName] = fileName;
+        invalidateCatalogEntry(tableName);
+
+        m_rbfm->destroyFile(oldFileName);
+        for (auto &oldIndexFileName : oldIndexFileNames) {
+            m_ix->destroyFile(oldIndexFileName);
+        }
+        return 0;
+    }
+
+    void RelationManager::destroyClusteredFiles(const std::string &tableName, const std::string &fileName) {
+        PagedFileManager &pfm = PagedFileManager::instance();
+        if (pfm.fileExists(fileName)) {
+            m_rbfm->destroyFile(fileName);
+        }
+
+        CatalogEntry *entry = nullptr;
+        if (0 != getCatalogEntry(tableName, entry)) {
+            return;
+        }
+        for (auto &indexName : entry->indexedAttrs) {
+            const std::string indexFileName = movedIndexFileName(tableName, indexName, fileName);
+            if (pfm.fileExists(indexFileName)) {
+                m_ix->destroyFile(indexFileName);
+            }
+        }
+    }
+
+    std::string RelationManager::nextTableFileName(const std::string &fileName) {
+        // the files of a table rewritten before end in #<n>
+        std::string baseName = fileName;
+        unsigned generation = 0;
+        size_t mark = fileName.rfind('#');
+        if (std::string::npos != mark && mark + 1 < fileName.size() &&
+            std::all_of(fileName.begin() + mark + 1, fileName.end(), ::isdigit)) {
+            baseName = fileName.substr(0, mark);
+            generation = std::stoul(fileName.substr(mark + 1));
+        }
+
+        std::string nextName;
+        do {
+            nextName = baseName + "#" + std::to_string(++generation);
+        } while (PagedFileManager::instance().fileExists(nextName));
+        return nextName;
+    }
+
+    RC RelationManager::updateTableFileInCatalog(int tableId, const std::string &tableName,
+                                                 const std::string &fileName) {
+        FileHandle tablesFileHandle;
+        if (0 != m_rbfm->openFile(CatalogueConstants::TABLES_FILE_NAME, tablesFileHandle)) {
+            ERROR("Error while opening %s file", CatalogueConstants::TABLES_FILE_NAME.c_str());
+            return -1;
+        }
+
+        // find the row of the table, then write it again with the new file name
+        std::vector<std::string> attrsToRead = {TABLE_ATTR_NAME_ID};
+        RBFM_ScanIterator rbfmsi;
+        RID rid;
+        std::vector<char> tableIdData(1 + 4);
+        RC rc = m_rbfm->scan(tablesFileHandle, CatalogueConstants::tablesTableAttributes, TABLE_ATTR_NAME_ID, EQ_OP,
+                             &tableId, attrsToRead, rbfmsi);
+        if (0 == rc && RBFM_EOF == rbfmsi.getNextRecord(rid, tableIdData.data())) {
+            rc = -1;
+        }
+        rbfmsi.close();
+
+        if (0 == rc) {
+            std::vector<AttributeAndValue> tablesTableAttributeAndValues;
+            tablesTableAttributeAndValues.push_back(AttributeAndValue{TablesAttributeConstants::TABLE_ID, &tableId});
+            tablesTableAttributeAndValues.push_back(AttributeAndValue{TablesAttributeConstants::TABLE_NAME, (void*) &tableName});
+            tablesTableAttributeAndValues.push_back(AttributeAndValue{TablesAttributeConstants::TABLE_FILENAME, (void*) &fileName});
+
+            size_t dataSize = AttributeAndValueSerializer::computeSerializedDataLenBytes(&tablesTableAttributeAndValues);
+            void *data = malloc(dataSize);
+            assert(nullptr != data);
+            AttributeAndValueSerializer::serialize(tablesTableAttributeAndValues, data);
+            rc = m_rbfm->updateRecord(tablesFileHandle, CatalogueConstants::tablesTableAttributes, data, rid);
+            free(data);
+        }
+        m_rbfm->closeFile(tablesFileHandle);
+        return rc;
+    }
+
+    Attribute RelationManager::getAttributeDefn(const std::string &tableName, const std::string &attributeName) {
+        CatalogEntry *entry = nullptr;
+        if (0 != getCatalogEntry(tableName, entry)) {
+            return {};
+        }
+        for (const Attribute &attribute: entry->attrs) {
+            if (strcmp(attribute.name.data(), attributeName.data()) == 0) {
+                return attribute;
+            }
+        }
+        ERROR("Table=%s contains no attribute named %s\n",
+              tableName, attributeName);
+        return {};
+    }
+
+    void RelationManager::initStatisticsTable() {
+        INFO("Initializing \"Statistics\"\n");
+        // Create a file for table "Statistics", it has no rows until a table is analyzed
+        m_rbfm->createFile(CatalogueConstants::STATISTICS_FILE_NAME);
+
+        // insert its row into "Tables"
+        std::vector<AttributeAndValue> tablesTableAttributeAndValues;
+        CatalogueConstantsBuilder::buildStatisticsTableAttributeAndValues(tablesTableAttributeAndValues);
+        size_t tablesTableAttributeAndValuesDataSize = AttributeAndValueSerializer::computeSerializedDataLenBytes(
+                &tablesTableAttributeAndValues);
+        void *tablesTableAttributeAndValuesData = malloc(tablesTableAttributeAndValuesDataSize);
+        AttributeAndValueSerializer::serialize(tablesTableAttributeAndValues, tablesTableAttributeAndValuesData);
+
+        RID rid;
+        FileHandle tablesFileHandle;
+        m_rbfm->openFile(CatalogueConstants::TABLES_FILE_NAME, tablesFileHandle);
+        m_rbfm->insertRecord(tablesFileHandle, CatalogueConstants::tablesTableAttributes,
+                             tablesTableAttributeAndValuesData, rid);
+        m_rbfm->closeFile(tablesFileHandle);
+        free(tablesTableAttributeAndValuesData);
+
+        // and its attributes into "Attributes"
+        buildAndInsertAttributesIntoAttributesTable(CatalogueConstants::statisticsTableAttributes,
+                                                    CatalogueConstants::STATISTICS_TABLE_ID);
+    }
+
+    RC RelationManager::insertStatisticsIntoCatalog(int tableId, const TableStatistics &stats) {
+        FileHandle statisticsFileHandle;
+        if (0 != m_rbfm->openFile(CatalogueConstants::STATISTICS_FILE_NAME, statisticsFileHandle)) {
+            ERROR("Error while opening %s file", CatalogueConstants::STATISTICS_FILE_NAME.c_str());
+            return -1;
+        }
+
+        // the table's row first, then one row per column
+        RC rc = 0;
+        for (int row = -1; 0 == rc && row < (int) stats.columns.size(); row++) {
+            int rowCount = 0, pageCount = 0, sampled = 0, distinctCount = 0;
+            float avgRecordSize = 0, nullFraction = 0;
+            std::string columnName, minValue, maxValue, histogram;
+            if (-1 == row) {
+                rowCount = stats.rowCount;
+                pageCount = stats.pageCount;
+                avgRecordSize = stats.avgRecordSize;
+                sampled = stats.sampled ? 1 : 0;
+            } else {
+                const ColumnStatistics &column = stats.columns[row];
+                columnName = column.name;
+                nullFraction = column.nullFraction;
+                distinctCount = column.distinctCount;
+                minValue = column.minValue;
+                maxValue = column.maxValue;
+                histogram = serializeValues(column.histogramBounds);
+            }
+
+            std::vector<AttributeAndValue> statisticsTableAttributeAndValues;
+            statisticsTableAttributeAndValues.push_back(AttributeAndValue{StatisticsAttributeConstants::TABLE_ID, &tableId});
+            statisticsTableAttributeAndValues.push_back(AttributeAndValue{StatisticsAttributeConstants::ATTRIBUTE_NAME, &columnName});
+            statisticsTableAttributeAndValues.push_back(AttributeAndValue{StatisticsAttributeConstants::ROW_COUNT, &rowCount});
+            statisticsTableAttributeAndValues.push_back(AttributeAndValue{StatisticsAttributeConstants::PAGE_COUNT, &pageCount});
+            statisticsTableAttributeAndValues.push_back(AttributeAndValue{StatisticsAttributeConstants::AVG_RECORD_SIZE, &avgRecordSize});
+            statisticsTableAttributeAndValues.push_back(AttributeAndValue{StatisticsAttributeConstants::SAMPLED, &sampled});
+            statisticsTableAttributeAndValues.push_back(AttributeAndValue{StatisticsAttributeConstants::NULL_FRACTION, &nullFraction});
+            statisticsTableAttributeAndValues.push_back(AttributeAndValue{StatisticsAttributeConstants::DISTINCT_COUNT, &distinctCount});
+            statisticsTableAttributeAndValues.push_back(AttributeAndValue{StatisticsAttributeConstants::MIN_VALUE, &minValue});
+            statisticsTableAttributeAndValues.push_back(AttributeAndValue{StatisticsAttributeConstants::MAX_VALUE, &maxValue});
+            statisticsTableAttributeAndValues.push_back(AttributeAndValue{StatisticsAttributeConstants::HISTOGRAM, &histogram});
+
+            size_t dataSize = AttributeAndValueSerializer::computeSerializedDataLenBytes(&statisticsTableAttributeAndValues);
+            void *data = malloc(dataSize);
+            assert(nullptr != data);
+            AttributeAndValueSerializer::serialize(statisticsTableAttributeAndValues, data);
+
+            RID rid;
+            rc = m_rbfm->insertRecord(statisticsFileHandle, CatalogueConstants::statisticsTableAttributes, data, rid);
+            free(data);
+        }
+        m_rbfm->closeFile(statisticsFileHandle);
+
+        return rc;
+    }
+
+    RC RelationManager::deleteStatisticsFromCatalog(int tableId) {
+        FileHandle statisticsFileHandle;
+        if (0 != m_rbfm->openFile(CatalogueConstants::STATISTICS_FILE_NAME, statisticsFileHandle)) {
+            ERROR("Error while opening %s file", CatalogueConstants::STATISTICS_FILE_NAME.c_str());
+            return -1;
+        }
+
+        std::vector<std::string> attrsToRead = {STATISTICS_ATTR_NAME_TABLE_ID};
+        RBFM_ScanIterator rbfmsi;
+        if (0 != m_rbfm->scan(statisticsFileHandle, CatalogueConstants::statisticsTableAttributes,
+                              STATISTICS_ATTR_NAME_TABLE_ID, EQ_OP, &tableId, attrsToRead, rbfmsi)) {
+            m_rbfm->closeFile(statisticsFileHandle);
+            return -1;
+        }
+
+        // nullflags + table-id
+        char data[1 + 4];
+        RID rid;
+        std::vector<RID> ridsToDelete;
+        while (RBFM_EOF != rbfmsi.getNextRecord(rid, data)) {
+            ridsToDelete.push_back(rid);
+        }
+        rbfmsi.close();
+
+        // a table which was never analyzed has no rows to delete
+        RC rc = 0;
+        for (auto &ridToDelete : ridsToDelete) {
+            if (0 != m_rbfm->deleteRecord(statisticsFileHandle, CatalogueConstants::statisticsTableAttributes,
+                                          ridToDelete)) {
+                rc = -1;
+            }
+        }
+        m_rbfm->closeFile(statisticsFileHandle);
+
+        return rc;
+    }
+
+    RC RelationManager::readStatisticsFromCatalog(int tableId, const std::vector<Attribute> &attrs,
+                                                  TableStatistics &stats) {
+        if (!file_exists(CatalogueConstants::STATISTICS_FILE_NAME)) {
+            // catalog created before there was a Statistics table
+            return -1;
+        }
+
+        FileHandle statisticsFileHandle;
+        if (0 != m_rbfm->openFile(CatalogueConstants::STATISTICS_FILE_NAME, statisticsFileHandle)) {
+            ERROR("Error while opening %s file", CatalogueConstants::STATISTICS_FILE_NAME.c_str());
+            return -1;
+        }
+
+        std::vector<std::string> attrsToRead;
+        for (auto &attr : CatalogueConstants::statisticsTableAttributes) {
+            attrsToRead.push_back(attr.name);
+        }
+        RBFM_ScanIterator rbfmsi;
+        if (0 != m_rbfm->scan(statisticsFileHandle, CatalogueConstants::statisticsTableAttributes,
+                              STATISTICS_ATTR_NAME_TABLE_ID, EQ_OP, &tableId, attrsToRead, rbfmsi)) {
+            m_rbfm->closeFile(statisticsFileHandle);
+            return -1;
+        }
+
+        // rows are never NULL, read the fields one after the other past the null flags
+        std::vector<char> data(maxTupleSize(CatalogueConstants::statisticsTableAttributes));
+        RID rid;
+        bool tableRowFound = false;
+        stats = TableStatistics();
+        while (RBFM_EOF != rbfmsi.getNextRecord(rid, data.data())) {
+            const char *field = data.data() + (CatalogueConstants::statisticsTableAttributes.size() + 7) / 8;
+            auto readInt = [&field]() {
+                int value;
+                memcpy(&value, field, sizeof(int));
+                field += sizeof(int);
+                return value;
+            };
+            auto readFloat = [&field]() {
+                float value;
+                memcpy(&value, field, sizeof(float));
+                field += sizeof(float);
+                return value;
+            };
+            auto readString = [&field, &readInt]() {
+                int length = readInt();
+                std::string value(field, length);
+                field += length;
+                return value;
+            };
+
+            readInt();
+            std::string columnName = readString();
+            int rowCount = readInt();
+            int pageCount = readInt();
+            float avgRecordSize = readFloat();
+            int sampled = readInt();
+
+            if (columnName.empty()) {
+                stats.rowCount = rowCount;
+                stats.pageCount = pageCount;
+                stats.avgRecordSize = avgRecordSize;
+                stats.sampled = 0 != sampled;
+                tableRowFound = true;
+                continue;
+            }
+
+            // columns dropped since the table was analyzed are left out
+            auto attr = std::find_if(attrs.begin(), attrs.end(), [&columnName](const Attribute &a) {
+                return a.name == columnName;
+            });
+            if (attrs.end() == attr) {
+                continue;
+            }
+
+            ColumnStatistics column;
+            column.name = columnName;
+            column.type = attr->type;
+            column.nullFraction = readFloat();
+            column.distinctCount = readInt();
+            column.minValue = readString();
+            column.maxValue = readString();
+            deserializeValues(readString(), column.histogramBounds);
+            stats.columns.push_back(column);
+        }
+        rbfmsi.close();
+        m_rbfm->closeFile(statisticsFileHandle);
+
+        return tableRowFound ? 0 : -1;
+    }
+
+    void RelationManager::initPartitionsTable() {
+        INFO("Initializing \"Partitions\"\n");
+        // Create a file for table "Partitions", it has no rows until a partitioned table is created
+        m_rbfm->createFile(CatalogueConstants::PARTITIONS_FILE_NAME);
+
+        // insert its row into "Tables"
+        std::vector<AttributeAndValue> tablesTableAttributeAndValues;
+        CatalogueConstantsBuilder::buildPartitionsTableAttributeAndValues(tablesTableAttributeAndValues);
+        size_t tablesTableAttributeAndValuesDataSize = AttributeAndValueSerializer::computeSerializedDataLenBytes(
+                &tablesTableAttributeAndValues);
+        void *tablesTableAttributeAndValuesData = malloc(tablesTableAttributeAndValuesDataSize);
+        AttributeAndValueSerializer::serialize(tablesTableAttributeAndValues, tablesTableAttributeAndValuesData);
+
+        RID rid;
+        FileHandle tablesFileHandle;
+        m_rbfm->openFile(CatalogueConstants::TABLES_FILE_NAME, tablesFileHandle);
+        m_rbfm->insertRecord(tablesFileHandle, CatalogueConstants::tablesTableAttributes,
+                             tablesTableAttributeAndValuesData, rid);
+        m_rbfm->closeFile(tablesFileHandle);
+        free(tablesTableAttributeAndValuesData);
+
+        // and its attributes into "Attributes"
+        buildAndInsertAttributesIntoAttributesTable(CatalogueConstants::partitionsTableAttributes,
+                                                    CatalogueConstants::PARTITIONS_TABLE_ID);
+    }
+
+    RC RelationManager::insertPartitioningIntoCatalog(int tableId, const PartitionSpec &spec) {
+        FileHandle partitionsFileHandle;
+        if (0 != m_rbfm->openFile(CatalogueConstants::PARTITIONS_FILE_NAME, partitionsFileHandle)) {
+            ERROR("Error while opening %s file", CatalogueConstants::PARTITIONS_FILE_NAME.c_str());
+            return -1;
+        }
+
+        int method = spec.method;
+        int count = spec.partitionCount();
+        std::string bounds = serializeValues(spec.bounds);
+
+        std::vector<AttributeAndValue> partitionsTableAttributeAndValues;
+        partitionsTableAttributeAndValues.push_back(AttributeAndValue{PartitionsAttributeConstants::TABLE_ID, &tableId});
+        partitionsTableAttributeAndValues.push_back(AttributeAndValue{PartitionsAttributeConstants::ATTRIBUTE_NAME, (void *) &spec.attribute});
+        partitionsTableAttributeAndValues.push_back(AttributeAndValue{PartitionsAttributeConstants::METHOD, &method});
+        partitionsTableAttributeAndValues.push_back(AttributeAndValue{PartitionsAttributeConstants::COUNT, &count});
+        partitionsTableAttributeAndValues.push_back(AttributeAndValue{PartitionsAttributeConstants::BOUNDS, &bounds});
+
+        size_t dataSize = AttributeAndValueSerializer::computeSerializedDataLenBytes(&partitionsTableAttributeAndValues);
+        void *data = malloc(dataSize);
+        assert(nullptr != data);
+        AttributeAndValueSerializer::serialize(partitionsTableAttributeAndValues, data);
+
+        RID rid;
+        RC rc = m_rbfm->insertRecord(partitionsFileHandle, CatalogueConstants::partitionsTableAttributes, data, rid);
+        free(data);
+        m_rbfm->closeFile(partitionsFileHandle);
+
+        return rc;
+    }
+
+    RC RelationManager::deletePartitioningFromCatalog(int tableId) {
+        FileHandle partitionsFileHandle;
+        if (0 != m_rbfm->openFile(CatalogueConstants::PARTITIONS_FILE_NAME, partitionsFileHandle)) {
+            ERROR("Error while opening %s file", CatalogueConstants::PARTITIONS_FILE_NAME.c_str());
+            return -1;
+        }
+
+        std::vector<std::string> attrsToRead = {PARTITIONS_ATTR_NAME_TABLE_ID};
+        RBFM_ScanIterator rbfmsi;
+        if (0 != m_rbfm->scan(partitionsFileHandle, CatalogueConstants::partitionsTableAttributes,
+                              PARTITIONS_ATTR_NAME_TABLE_ID, EQ_OP, &tableId, attrsToRead, rbfmsi)) {
+            m_rbfm->closeFile(partitionsFileHandle);
+            return -1;
+        }
+
+        // nullflags + table-id
+        char data[1 + 4];
+        RID rid;
+        std::vector<RID> ridsToDelete;
+        while (RBFM_EOF != rbfmsi.getNextRecord(rid, data)) {
+            ridsToDelete.push_back(rid);
+        }
+        rbfmsi.close();
+
+        RC rc = 0;
+        for (auto &ridToDelete : ridsToDelete) {
+            if (0 != m_rbfm->deleteRecord(partitionsFileHandle, CatalogueConstants::partitionsTableAttributes,
+                                          ridToDelete)) {
+                rc = -1;
+            }
+        }
+        m_rbfm->closeFile(partitionsFileHandle);
+
+        return rc;
+    }
+
+    RC RelationManager::readPartitioningFromCatalog(int tableId, PartitionSpec &spec) {
+        if (!file_exists(CatalogueConstants::PARTITIONS_FILE_NAME)) {
+            // catalog created before there was a Partitions table, nothing is partitioned
+            return 0;
+        }
+
+        FileHandle partitionsFileHandle;
+        if (0 != m_rbfm->openFile(CatalogueConstants::PARTITIONS_FILE_NAME, partitionsFileHandle)) {
+            ERROR("Error while opening %s file", CatalogueConstants::PARTITIONS_FILE_NAME.c_str());
+            return -1;
+        }
+
+        std::vector<std::string> attrsToRead = {PARTITIONS_ATTR_NAME_ATTR_NAME, PARTITIONS_ATTR_NAME_METHOD,
+                                                PARTITIONS_ATTR_NAME_COUNT, PARTITIONS_ATTR_NAME_BOUNDS};
+        RBFM_ScanIterator rbfmsi;
+        if (0 != m_rbfm->scan(partitionsFileHandle, CatalogueConstants::partitionsTableAttributes,
+                              PARTITIONS_ATTR_NAME_TABLE_ID, EQ_OP, &tableId, attrsToRead, rbfmsi)) {
+            m_rbfm->closeFile(partitionsFileHandle);
+            return -1;
+        }
+
+        // nullflags + column name + method + count + bounds
+        std::vector<char> data(1 + 4 + ATTRIBUTE_NAME_MAX_LENGTH + 4 + 4 + 4 + PARTITION_BOUNDS_MAX_LENGTH);
+        RID rid;
+        if (RBFM_EOF != rbfmsi.getNextRecord(rid, data.data())) {
+            const char *field = data.data() + 1;
+            uint32_t nameLength;
+            memcpy(&nameLength, field, sizeof(uint32_t));
+            spec.attribute.assign(field + 4, nameLength);
+            field += 4 + nameLength;
+
+            int method, count;
+            memcpy(&method, field, sizeof(int));
+            memcpy(&count, field + 4, sizeof(int));
+            spec.method = (PartitionMethod) method;
+            spec.count = count;
+            field += 4 + 4;
+
+            uint32_t boundsLength;
+            memcpy(&boundsLength, field, sizeof(uint32_t));
+            spec.bounds.clear();
+            deserializeValues(std::string(field + 4, boundsLength), spec.bounds);
+        }
+        rbfmsi.close();
+        m_rbfm->closeFile(partitionsFileHandle);
 
         return 0;
     }
 
-    void RelationManager::insertIntoIndex(const std::string& tableName,
-                                          const std::vector<Attribute>& attrs,
-                                          const void* recordData, const RID& rid) {
-        // insert the entry into indexes created on this table
-        std::vector<std::string> indexNames;
-        getIndexNames(tableName, indexNames);
+    void RelationManager::initTablespacesTable() {
+        INFO("Initializing \"Tablespaces\"\n");
+        // Create a file for table "Tablespaces", it has no rows until a tablespace is created
+        m_rbfm->createFile(CatalogueConstants::TABLESPACES_FILE_NAME);
 
-        std::string tableName_, attrName;
-        Attribute attrDef;
-        for (auto& indexFname: indexNames) {
-            // get Attribute from index name, and create the index key
-            // that needs to be inserted into the index file
-            std::tie(tableName_, attrName) = getTableAndAttrFromIndexFileName(indexFname);
-            assert(tableName == tableName_);
+        // insert its row into "Tables"
+        std::vector<AttributeAndValue> tablesTableAttributeAndValues;
+        CatalogueConstantsBuilder::buildTablespacesTableAttributeAndValues(tablesTableAttributeAndValues);
+        size_t tablesTableAttributeAndValuesDataSize = AttributeAndValueSerializer::computeSerializedDataLenBytes(
+                &tablesTableAttributeAndValues);
+        void *tablesTableAttributeAndValuesData = malloc(tablesTableAttributeAndValuesDataSize);
+        AttributeAndValueSerializer::serialize(tablesTableAttributeAndValues, tablesTableAttributeAndValuesData);
 
-            attrDef = getAttributeDefn(tableName, attrName);
+        RID rid;
+        FileHandle tablesFileHandle;
+        m_rbfm->openFile(CatalogueConstants::TABLES_FILE_NAME, tablesFileHandle);
+        m_rbfm->insertRecord(tablesFileHandle, CatalogueConstants::tablesTableAttributes,
+                             tablesTableAttributeAndValuesData, rid);
+        m_rbfm->closeFile(tablesFileHandle);
+        free(tablesTableAttributeAndValuesData);
 
-            void* key = getKeyFromRecord(recordData, attrs, attrDef);
+        // and its attributes into "Attributes"
+        buildAndInsertAttributesIntoAttributesTable(CatalogueConstants::tablespacesTableAttributes,
+                                                    CatalogueConstants::TABLESPACES_TABLE_ID);
+    }
 
-            IXFileHandle ixFileHandle;
-            m_ix->openFile(indexFname, ixFileHandle);
-            m_ix->insertEntry(ixFileHandle, attrDef, key, rid);
-            m_ix->closeFile(ixFileHandle);
+    RC RelationManager::createTablespace(const std::string &tablespace, const std::vector<std::string> &directories) {
+        LatchedCall latched(m_latch);
+        if (!m_catalogCreated) return -1;
 
-            free(key);
+        std::vector<std::string> existingDirectories;
+        if (tablespace.empty() || tablespace.size() > TABLESPACE_NAME_MAX_LENGTH ||
+            std::string::npos != tablespace.find('/') || directories.empty() ||
+            0 == readTablespaceFromCatalog(tablespace, existingDirectories)) {
+            ERROR("Cannot create tablespace %s\n", tablespace.c_str());
+            return -1;
+        }
+        for (auto &directory : directories) {
+            if (directory.empty() || directory.size() > TABLESPACE_DIRECTORY_MAX_LENGTH || !file_exists(directory)) {
+                ERROR("Directory %s of tablespace %s does not exist\n", directory.c_str(), tablespace.c_str());
+                return -1;
+            }
         }
-    }
 
-    RC RelationManager::deleteTuple(const std::string &tableName, const RID &rid) {
-        if (tableName == CatalogueConstants::TABLES_FILE_NAME ||
-            tableName == CatalogueConstants::ATTRIBUTES_FILE_NAME) {
+        FileHandle tablespacesFileHandle;
+        if (0 != m_rbfm->openFile(CatalogueConstants::TABLESPACES_FILE_NAME, tablespacesFileHandle)) {
+            ERROR("Error while opening %s file", CatalogueConstants::TABLESPACES_FILE_NAME.c_str());
             return -1;
         }
 
-        std::vector<Attribute> attrs;
-        FileHandle fh;
+        RC rc = 0;
+        for (int position = 0; 0 == rc && position < (int) directories.size(); position++) {
+            std::vector<AttributeAndValue> tablespacesTableAttributeAndValues;
+            tablespacesTableAttributeAndValues.push_back(AttributeAndValue{TablespacesAttributeConstants::NAME, (void *) &tablespace});
+            tablespacesTableAttributeAndValues.push_back(AttributeAndValue{TablespacesAttributeConstants::DIRECTORY, (void *) &directories[position]});
+            tablespacesTableAttributeAndValues.push_back(AttributeAndValue{TablespacesAttributeConstants::POSITION, &position});
 
-        if (0 != getFileHandleAndAttributes(tableName, fh, attrs)) {
-            ERROR("Error while getting filehandle and attributes for table %s", tableName);
-            return -1;
+            size_t dataSize = AttributeAndValueSerializer::computeSerializedDataLenBytes(&tablespacesTableAttributeAndValues);
+            void *data = malloc(dataSize);
+            assert(nullptr != data);
+            AttributeAndValueSerializer::serialize(tablespacesTableAttributeAndValues, data);
+
+            RID rid;
+            rc = m_rbfm->insertRecord(tablespacesFileHandle, CatalogueConstants::tablespacesTableAttributes, data, rid);
+            free(data);
         }
+        m_rbfm->closeFile(tablespacesFileHandle);
 
-        // before deleting the record, read the record to get the record data
-        // this is used to delete the entries in the index files
-        int maxSpaceRequired = 0;
-        for (auto &attr: attrs) {
-            maxSpaceRequired += 4;
-            if (TypeVarChar == attr.type) maxSpaceRequired += attr.length;
+        if (0 != rc) {
+            return -1;
         }
-        void* data = malloc(maxSpaceRequired);
-        assert(nullptr != data);
-        memset(data, 0, maxSpaceRequired);
+        return PagedFileManager::instance().setTablespace(tablespace, directories);
+    }
 
-        assert(0 == readTuple(tableName, rid, data));
+    RC RelationManager::dropTablespace(const std::string &tablespace) {
+        LatchedCall latched(m_latch);
+        if (!m_catalogCreated) return -1;
 
-        if ( 0 != m_rbfm->deleteRecord(fh, attrs, rid)) {
-            ERROR("Error while deleting the record from table %s", tableName);
-            m_rbfm->closeFile(fh);
+        if (isTablespaceInUse(tablespace)) {
+            ERROR("Tablespace %s still has tables or indexes\n", tablespace.c_str());
             return -1;
         }
-        m_rbfm->closeFile(fh);
 
-        deleteFromIndex(tableName, attrs, data, rid);
+        FileHandle tablespacesFileHandle;
+        if (0 != m_rbfm->openFile(CatalogueConstants::TABLESPACES_FILE_NAME, tablespacesFileHandle)) {
+            ERROR("Error while opening %s file", CatalogueConstants::TABLESPACES_FILE_NAME.c_str());
+            return -1;
+        }
 
-        free(data);
-        return 0;
-    }
+        std::vector<char> conditionValue(4 + tablespace.size());
+        uint32_t nameLength = tablespace.size();
+        memcpy(conditionValue.data(), &nameLength, sizeof(uint32_t));
+        memcpy(conditionValue.data() + 4, tablespace.data(), tablespace.size());
 
-    void RelationManager::deleteFromIndex(const std::string& tableName,
-                                          const std::vector<Attribute>& attrs,
-                                          const void* recordData, const RID& rid) {
-        // insert the entry into indexes created on this table
-        std::vector<std::string> indexNames;
-        getIndexNames(tableName, indexNames);
+        std::vector<std::string> attrsToRead = {TABLESPACES_ATTR_NAME_POSITION};
+        RBFM_ScanIterator rbfmsi;
+        if (0 != m_rbfm->scan(tablespacesFileHandle, CatalogueConstants::tablespacesTableAttributes,
+                              TABLESPACES_ATTR_NAME_NAME, EQ_OP, conditionValue.data(), attrsToRead, rbfmsi)) {
+            m_rbfm->closeFile(tablespacesFileHandle);
+            return -1;
+        }
 
-        std::string tableName_, attrName;
-        Attribute attrDef;
-        for (auto& indexFname: indexNames) {
-            // get Attribute from index name, and create the index key
-            // that needs to be inserted into the index file
-            std::tie(tableName_, attrName) = getTableAndAttrFromIndexFileName(indexFname);
-            assert(tableName == tableName_);
+        // nullflags + position
+        char data[1 + 4];
+        RID rid;
+        std::vector<RID> ridsToDelete;
+        while (RBFM_EOF != rbfmsi.getNextRecord(rid, data)) {
+            ridsToDelete.push_back(rid);
+        }
+        rbfmsi.close();
 
-            attrDef = getAttributeDefn(tableName, attrName);
+        RC rc = ridsToDelete.empty() ? -1 : 0;
+        for (auto &ridToDelete : ridsToDelete) {
+            if (0 != m_rbfm->deleteRecord(tablespacesFileHandle, CatalogueConstants::tablespacesTableAttributes,
+                                          ridToDelete)) {
+                rc = -1;
+            }
+        }
+        m_rbfm->closeFile(tablespacesFileHandle);
 
-            void* key = getKeyFromRecord(recordData, attrs, attrDef);
+        if (0 == rc) {
+            PagedFileManager::instance().removeTablespace(tablespace);
+        }
+        return rc;
+    }
 
-            IXFileHandle ixFileHandle;
-            m_ix->openFile(indexFname, ixFileHandle);
-            m_ix->deleteEntry(ixFileHandle, attrDef, key, rid);
-            m_ix->closeFile(ixFileHandle);
+    RC RelationManager::getTablespace(const std::string &tablespace, std::vector<std::string> &directories) {
+        LatchedCall latched(m_latch);
+        if (!m_catalogCreated) return -1;
 
-            free(key);
-        }
+        return readTablespaceFromCatalog(tablespace, directories);
     }
 
-    RC RelationManager::updateTuple(const std::string &tableName, const void *data, const RID &rid) {
-        if (tableName == CatalogueConstants::TABLES_FILE_NAME ||
-            tableName == CatalogueConstants::ATTRIBUTES_FILE_NAME) {
+    RC RelationManager::readTablespaceFromCatalog(const std::string &tablespace, std::vector<std::string> &directories) {
+        if (!file_exists(CatalogueConstants::TABLESPACES_FILE_NAME)) {
+            // catalog created before there was a Tablespaces table, there are none
             return -1;
         }
 
-        std::vector<Attribute> attrs;
-        FileHandle fh;
+        FileHandle tablespacesFileHandle;
+        if (0 != m_rbfm->openFile(CatalogueConstants::TABLESPACES_FILE_NAME, tablespacesFileHandle)) {
+            ERROR("Error while opening %s file", CatalogueConstants::TABLESPACES_FILE_NAME.c_str());
+            return -1;
+        }
 
-        if (0 != getFileHandleAndAttributes(tableName, fh, attrs)) {
-            ERROR("Error while getting filehandle and attributes for table %s", tableName);
+        std::vector<char> conditionValue(4 + tablespace.size());
+        uint32_t nameLength = tablespace.size();
+        memcpy(conditionValue.data(), &nameLength, sizeof(uint32_t));
+        memcpy(conditionValue.data() + 4, tablespace.data(), tablespace.size());
+
+        std::vector<std::string> attrsToRead = {TABLESPACES_ATTR_NAME_DIRECTORY, TABLESPACES_ATTR_NAME_POSITION};
+        RBFM_ScanIterator rbfmsi;
+        if (0 != m_rbfm->scan(tablespacesFileHandle, CatalogueConstants::tablespacesTableAttributes,
+                              TABLESPACES_ATTR_NAME_NAME, EQ_OP, conditionValue.data(), attrsToRead, rbfmsi)) {
+            m_rbfm->closeFile(tablespacesFileHandle);
             return -1;
         }
 
-        // before updating the record, read the record to get the record data
-        // this is used to delete the entries in the index files
-        int maxSpaceRequired = 0;
-        for (auto &attr: attrs) {
-            maxSpaceRequired += 4;
-            if (TypeVarChar == attr.type) maxSpaceRequired += attr.length;
+        // nullflags + directory + position, the rows come in any order
+        std::map<int, std::string> positionedDirectories;
+        char data[1 + 4 + TABLESPACE_DIRECTORY_MAX_LENGTH + 4];
+        RID rid;
+        while (RBFM_EOF != rbfmsi.getNextRecord(rid, data)) {
+            uint32_t directoryLength;
+            memcpy(&directoryLength, data + 1, sizeof(uint32_t));
+            int position;
+            memcpy(&position, data + 1 + 4 + directoryLength, sizeof(int));
+            positionedDirectories[position] = std::string(data + 1 + 4, directoryLength);
         }
-        void* oldRecordData = malloc(maxSpaceRequired);
-        assert(nullptr != data);
-        memset(oldRecordData, 0, maxSpaceRequired);
+        rbfmsi.close();
+        m_rbfm->closeFile(tablespacesFileHandle);
 
-        assert(0 == readTuple(tableName, rid, oldRecordData));
+        if (positionedDirectories.empty()) {
+            return -1;
+        }
+        directories.clear();
+        for (auto &directory : positionedDirectories) {
+            directories.push_back(directory.second);
+        }
+        return 0;
+    }
 
-        if ( 0 != m_rbfm->updateRecord(fh, attrs, data, rid)) {
-            ERROR("Error while updating the record in table %s", tableName);
-            m_rbfm->closeFile(fh);
-            free(oldRecordData);
+    RC RelationManager::loadTablespace(const std::string &tablespace) {
+        std::vector<std::string> directories;
+        if (0 != readTablespaceFromCatalog(tablespace, directories)) {
+            ERROR("Tablespace %s not found\n", tablespace.c_str());
             return -1;
         }
-        m_rbfm->closeFile(fh);
+        return PagedFileManager::instance().setTablespace(tablespace, directories);
+    }
 
-        deleteFromIndex(tableName, attrs, oldRecordData, rid);
-        insertIntoIndex(tableName, attrs, data, rid);
+    RC RelationManager::useTablespace(const std::string &fileName) {
+        std::string tablespace = PagedFileManager::tablespaceOf(fileName);
+        if (tablespace.empty() || PagedFileManager::instance().hasTablespace(tablespace)) {
+            return 0;
+        }
+        return loadTablespace(tablespace);
+    }
 
-        free(oldRecordData);
-        return 0;
+    bool RelationManager::isTablespaceInUse(const std::string &tablespace) {
+        // the files of partitioned tables, which have none, too: their partitions are in the tablespace
+        for (auto &table : m_tablesCreated) {
+            if (tablespace == PagedFileManager::tablespaceOf(table.second)) {
+                return true;
+            }
+        }
+
+        FileHandle indexesFileHandle;
+        if (0 != m_rbfm->openFile(CatalogueConstants::INDEXES_FILE_NAME, indexesFileHandle)) {
+            ERROR("Error while opening %s file", CatalogueConstants::INDEXES_FILE_NAME.c_str());
+            return true;
+        }
+        std::vector<std::string> attrsToRead = {INDEXES_ATTR_NAME_FNAME};
+        RBFM_ScanIterator rbfmsi;
+        if (0 != m_rbfm->scan(indexesFileHandle, CatalogueConstants::indexesTableAttributes, "", NO_OP, nullptr,
+                              attrsToRead, rbfmsi)) {
+            m_rbfm->closeFile(indexesFileHandle);
+            return true;
+        }
+
+        // nullflags + length of the file name + file name
+        char data[1 + 4 + INDEX_FILE_NAME_MAX_LENGTH];
+        RID rid;
+        bool inUse = false;
+        while (!inUse && RBFM_EOF != rbfmsi.getNextRecord(rid, data)) {
+            uint32_t fileNameLength;
+            memcpy(&fileNameLength, data + 1, sizeof(uint32_t));
+            inUse = tablespace == PagedFileManager::tablespaceOf(std::string(data + 1 + 4, fileNameLength));
+        }
+        rbfmsi.close();
+        m_rbfm->closeFile(indexesFileHandle);
+
+        return inUse;
     }
 
-    RC RelationManager::readTuple(const std::string &tableName, const RID &rid, void *data) {
-        std::vector<Attribute> attrs;
-        FileHandle fh;
+    // the column of a materialized aggregate holding one of its ops, named as Aggregate names its output
+    static std::string aggregateColumnName(const AggregateView &view, AggregateOp op) {
+        static const char *opNames[] = {"MIN", "MAX", "COUNT", "SUM", "AVG"};
+        return std::string(opNames[op]) + "(" + view.baseTable + "." + view.attribute + ")";
+    }
 
-        if (0 != getFileHandleAndAttributes(tableName, fh, attrs)) {
-            ERROR("Error while getting filehandle and attributes for table %s", tableName);
-            return -1;
+    // ops are kept in the Aggregates table as one bit per AggregateOp
+    static int aggregateOpBits(const std::vector<AggregateOp> &ops) {
+        int bits = 0;
+        for (auto op : ops) {
+            bits |= 1 << op;
         }
+        return bits;
+    }
 
-        if (0 != m_rbfm->readRecord(fh, attrs, rid, data)) {
-            ERROR("Error while reading the record from table %s", tableName);
-            m_rbfm->closeFile(fh);
-            return -1;
+    static std::vector<AggregateOp> aggregateOpsOf(int bits) {
+        std::vector<AggregateOp> ops;
+        for (int op = MIN; op <= AVG; op++) {
+            if (0 != (bits & (1 << op))) {
+                ops.push_back((AggregateOp) op);
+            }
         }
-        m_rbfm->closeFile(fh);
-        return 0;
+        return ops;
     }
 
-    RC RelationManager::printTuple(const std::vector<Attribute> &attrs, const void *data, std::ostream &out) {
-        return m_rbfm->printRecord(attrs, data, out);
+    static bool hasAggregateOp(const AggregateView &view, AggregateOp op) {
+        return view.ops.end() != std::find(view.ops.begin(), view.ops.end(), op);
     }
 
-    RC RelationManager::readAttribute(const std::string &tableName, const RID &rid,
-                                      const std::string &attributeName, void *data) {
-        std::vector<Attribute> attrs;
-        FileHandle fh;
+    // adds a value to the state of a group
+    static void addToAggregate(AggOutput &state, float value) {
+        state.min = 0 == state.cnt ? value : std::min(state.min, value);
+        state.max = 0 == state.cnt ? value : std::max(state.max, value);
+        state.cnt++;
+        state.sum += value;
+    }
 
-        if (0 != getFileHandleAndAttributes(tableName, fh, attrs)) {
-            ERROR("Error while getting filehandle and attributes for table %s", tableName);
-            return -1;
+    // the group (in the key format, empty for views without one) a tuple is in, and the value it adds to it.
+    // false for tuples left out of the view, where either is NULL
+    static bool aggregateValueOf(const void *data, const std::vector<Attribute> &attrs, const Attribute &attr,
+                                 const Attribute *groupAttr, std::string &group, float &value) {
+        void *key = getKeyFromRecord(data, attrs, attr);
+        if (nullptr == key) {
+            return false;
+        }
+        value = TypeInt == attr.type ? (float) *((int *) key) : *((float *) key);
+        free(key);
+
+        group.clear();
+        if (nullptr != groupAttr) {
+            key = getKeyFromRecord(data, attrs, *groupAttr);
+            if (nullptr == key) {
+                return false;
+            }
+            group = keyToString(groupAttr->type, key);
+            free(key);
+        }
+        return true;
+    }
+
+    // the row of a group of a materialized aggregate: the group attribute (unless there is none), then the ops
+    static std::string aggregateRow(const AggregateView &view, const std::string &group, AggOutput state) {
+        unsigned columns = view.ops.size() + (view.groupAttribute.empty() ? 0 : 1);
+        std::string row((columns + 7) / 8, '\0');
+        row += group;
+        for (auto op : view.ops) {
+            float value = state.getVal(op);
+            row.append((const char *) &value, sizeof(float));
+        }
+        return row;
+    }
+
+    static void readAggregateRow(const AggregateView &view, AttrType groupType, const char *row,
+                                 std::string &group, AggOutput &state) {
+        unsigned columns = view.ops.size() + (view.groupAttribute.empty() ? 0 : 1);
+        const char *field = row + (columns + 7) / 8;
+        group.clear();
+        if (!view.groupAttribute.empty()) {
+            group = keyToString(groupType, field);
+            field += group.size();
+        }
+        for (auto op : view.ops) {
+            float value;
+            memcpy(&value, field, sizeof(float));
+            field += sizeof(float);
+            switch (op) {
+                case MIN:
+                    state.min = value;
+                    break;
+                case MAX:
+                    state.max = value;
+                    break;
+                case COUNT:
+                    state.cnt = value;
+                    break;
+                case SUM:
+                    state.sum = value;
+                    break;
+                case AVG:
+                    break;
+            }
         }
+    }
 
-        if (0 != m_rbfm->readAttribute(fh, attrs, rid, attributeName, data)) {
-            ERROR("Error while reading an attribute from table %s", tableName);
-            m_rbfm->closeFile(fh);
+    RC RelationManager::createMaterializedAggregate(const std::string &name, const std::string &baseTable,
+                                                    const std::string &attribute, const std::string &groupAttribute,
+                                                    const std::vector<AggregateOp> &ops) {
+        // the base table doesn't change while the view is filled from it
+        TransactionScope transaction;
+        if (0 != transaction.lockTable(baseTable, Shared) || 0 != transaction.lockTable(name, Exclusive)) {
             return -1;
         }
-        m_rbfm->closeFile(fh);
-        return 0;
+
+        // the others are computed out of COUNT and SUM
+        std::vector<AggregateOp> keptOps(ops);
+        keptOps.push_back(COUNT);
+        if (ops.end() != std::find(ops.begin(), ops.end(), AVG)) {
+            keptOps.push_back(SUM);
+        }
+
+        AggregateView view;
+        view.name = name;
+        view.baseTable = baseTable;
+        view.attribute = attribute;
+        view.groupAttribute = groupAttribute;
+        view.ops = aggregateOpsOf(aggregateOpBits(keptOps));
+
+        RC rc;
+        {
+            LatchedCall latched(m_latch);
+            beginWriteSpan();
+            rc = createMaterializedAggregateLatched(view);
+        }
+        return transaction.commit(rc);
     }
 
-    RC RelationManager::scan(const std::string &tableName,
-                             const std::string &conditionAttribute,
-                             const CompOp compOp,
-                             const void *value,
-                             const std::vector<std::string> &attributeNames,
-                             RM_ScanIterator &rm_ScanIterator) {
-        if (m_tablesCreated.end() == m_tablesCreated.find(tableName)) {
-            ERROR("Scan: Table %s not found\n", tableName);
+    RC RelationManager::createMaterializedAggregateLatched(const AggregateView &view) {
+        CatalogEntry *entry = nullptr;
+        if (!m_catalogCreated || isCatalogTable(view.baseTable) || 0 != getCatalogEntry(view.baseTable, entry) ||
+            !entry->aggregateOf.empty()) {
+            ERROR("Cannot create a materialized aggregate of table %s\n", view.baseTable.c_str());
             return -1;
         }
-        if (0 != rm_ScanIterator.init(this, m_rbfm, tableName)) {
+        if (view.name.empty() || isCatalogTable(view.name)) {
+            ERROR("Cannot create the materialized aggregate %s\n", view.name.c_str());
             return -1;
         }
-        return rm_ScanIterator.initRbfmsi(conditionAttribute, compOp, value, attributeNames);
-    }
 
-    RM_ScanIterator::RM_ScanIterator() = default;
+        auto attr = std::find_if(entry->attrs.begin(), entry->attrs.end(), [&](const Attribute &a) {
+            return a.name == view.attribute;
+        });
+        auto groupAttr = std::find_if(entry->attrs.begin(), entry->attrs.end(), [&](const Attribute &a) {
+            return a.name == view.groupAttribute;
+        });
+        if (entry->attrs.end() == attr || TypeVarChar == attr->type ||
+            (!view.groupAttribute.empty() && entry->attrs.end() == groupAttr)) {
+            ERROR("Cannot aggregate %s of table %s by %s\n", view.attribute.c_str(), view.baseTable.c_str(),
+                  view.groupAttribute.c_str());
+            return -1;
+        }
 
-    RM_ScanIterator::~RM_ScanIterator() = default;
+        std::vector<Attribute> viewAttrs;
+        if (!view.groupAttribute.empty()) {
+            viewAttrs.push_back(*groupAttr);
+        }
+        for (auto op : view.ops) {
+            viewAttrs.push_back(Attribute{aggregateColumnName(view, op), TypeReal, 4});
+            if (viewAttrs.back().name.size() > ATTRIBUTE_NAME_MAX_LENGTH) {
+                ERROR("Attribute name %s is too long\n", viewAttrs.back().name.c_str());
+                return -1;
+            }
+        }
 
-    void RM_ScanIterator::reset() {
-        m_initDone = false;
-        m_rm = nullptr;
-        m_rbfm = nullptr;
-        m_attrs.clear();
-    }
+        // the tables keeping the view up to date: the base table, or each of its partitions
+        std::vector<int> tableIds(1, entry->tableId);
+        unsigned partitionCount = entry->partitioning.partitionCount();
+        for (unsigned p = 0; p < partitionCount; p++) {
+            CatalogEntry *partitionEntry = nullptr;
+            if (0 != getCatalogEntry(partitionTableName(view.baseTable, p), partitionEntry)) {
+                return -1;
+            }
+            tableIds.push_back(partitionEntry->tableId);
+        }
 
-    RC RM_ScanIterator::init(RelationManager *rm, RecordBasedFileManager *rbfm, const std::string &tableName) {
-        reset(); // in case of reusing the same iterator object
-                 // we need to reset the info inside the object, so that
-                 // it wont be corrupt
-        m_initDone = true;
-        m_rm = rm;
-        m_rbfm = rbfm;
+        std::map<std::string, AggOutput> groups;
+        if (0 != computeAggregate(view, nullptr, groups) || 0 != createTable(view.name, viewAttrs) ||
+            (!view.groupAttribute.empty() && 0 != createIndex(view.name, view.groupAttribute))) {
+            ERROR("Error while creating the materialized aggregate %s\n", view.name.c_str());
+            return -1;
+        }
 
-        if (0 != m_rm->getFileHandleAndAttributes(tableName, m_fh, m_attrs)) {
-            ERROR("Error while initialising a scan iterator. Failed while creating file handle");
+        if (0 != insertAggregateRows(view, groups)) {
             return -1;
         }
+
+        for (auto tableId : tableIds) {
+            if (0 != insertAggregateIntoCatalog(tableId, view)) {
+                ERROR("Error while inserting the materialized aggregate %s into the catalog\n", view.name.c_str());
+                return -1;
+            }
+        }
+        invalidateCatalogEntry(view.name);
+        invalidateCatalogEntry(view.baseTable);
+        for (unsigned p = 0; p < partitionCount; p++) {
+            invalidateCatalogEntry(partitionTableName(view.baseTable, p));
+        }
         return 0;
     }
 
-    RC RM_ScanIterator::initRbfmsi(const std::string &conditionAttribute,
-                                   const CompOp compOp,
-                                   const void *value,
-                                   const std::vector<std::string> &attributeNames) {
-        assert(m_initDone == true);
+    RC RelationManager::insertAggregateRows(const AggregateView &view, const std::map<std::string, AggOutput> &groups) {
+        std::vector<std::string> rows;
+        for (auto &group : groups) {
+            rows.push_back(aggregateRow(view, group.first, group.second));
+        }
+        std::vector<const void *> data;
+        for (auto &row : rows) {
+            data.push_back(row.data());
+        }
+        std::vector<RID> rids;
+        return data.empty() ? 0 : insertTuplesLatched(view.name, data, rids);
+    }
 
-        if (0 != m_rbfm->scan(m_fh, m_attrs, conditionAttribute, compOp, value, attributeNames, m_rbfmsi)) {
-            ERROR("Error while init'ing RBFM scan iterator");
+    RC RelationManager::refreshMaterializedAggregate(const AggregateView &view) {
+        std::map<std::string, AggOutput> groups;
+        unsigned count = 0;
+        if (0 != computeAggregate(view, nullptr, groups) ||
+            0 != deleteWhereLatched(view.name, "", NO_OP, nullptr, count) || 0 != insertAggregateRows(view, groups)) {
+            ERROR("Error while refreshing the materialized aggregate %s\n", view.name.c_str());
             return -1;
         }
         return 0;
-   }
+    }
 
-    RC RM_ScanIterator::getNextTuple(RID &rid, void *data) {
-        assert(true == m_initDone);
+    bool RelationManager::isMaterializedAggregate(const std::string &tableName) {
+        CatalogEntry *entry = nullptr;
+        return 0 == getCatalogEntry(tableName, entry) && !entry->aggregateOf.empty();
+    }
 
-        if (RBFM_EOF != m_rbfmsi.getNextRecord(rid, data)) {
+    std::vector<std::string> RelationManager::getAggregateViewNames(const std::string &tableName) {
+        std::vector<std::string> viewNames;
+        readLatched(tableName, [&]() {
+            CatalogEntry *entry = nullptr;
+            if (0 == getCatalogEntry(tableName, entry)) {
+                for (auto &view : entry->aggregateViews) {
+                    viewNames.push_back(view.name);
+                }
+            }
             return 0;
-        }
-        return RM_EOF;
+        });
+        return viewNames;
     }
 
-    RC RM_ScanIterator::close() {
-        if (m_initDone) {
-            m_initDone = false;
-            m_rbfmsi.close();
-            return m_rbfm->closeFile(m_fh);
+    RC RelationManager::maintainAggregates(const std::string &tableName, const std::vector<Attribute> &attrs,
+                                           const std::vector<const void *> &removed,
+                                           const std::vector<const void *> &added) {
+        CatalogEntry *entry = nullptr;
+        if (0 != getCatalogEntry(tableName, entry)) {
+            return -1;
+        }
+        // the entry is read again once the views are changed
+        std::vector<AggregateView> views = entry->aggregateViews;
+        bool updated = removed.size() == added.size();
+
+        for (auto &view : views) {
+            auto attr = std::find_if(attrs.begin(), attrs.end(), [&](const Attribute &a) {
+                return a.name == view.attribute;
+            });
+            auto groupAttr = std::find_if(attrs.begin(), attrs.end(), [&](const Attribute &a) {
+                return a.name == view.groupAttribute;
+            });
+            if (attrs.end() == attr) {
+                return -1;
+            }
+            const Attribute *group = attrs.end() == groupAttr ? nullptr : &*groupAttr;
+
+            // what the tuples take from and add to each group, keyed by group. updates leaving both
+            // values of a tuple as they were change nothing
+            std::map<std::string, AggOutput> removedFrom, addedTo;
+            std::string removedGroup, addedGroup;
+            float removedValue = 0, addedValue = 0;
+            for (size_t i = 0; i < removed.size(); i++) {
+                bool hasRemoved = aggregateValueOf(removed[i], attrs, *attr, group, removedGroup, removedValue);
+                if (updated) {
+                    bool hasAdded = aggregateValueOf(added[i], attrs, *attr, group, addedGroup, addedValue);
+                    if (hasRemoved == hasAdded &&
+                        (!hasRemoved || (removedGroup == addedGroup && removedValue == addedValue))) {
+                        continue;
+                    }
+                    if (hasAdded) {
+                        addToAggregate(addedTo[addedGroup], addedValue);
+                    }
+                }
+                if (hasRemoved) {
+                    addToAggregate(removedFrom[removedGroup], removedValue);
+                }
+            }
+            for (size_t i = 0; !updated && i < added.size(); i++) {
+                if (aggregateValueOf(added[i], attrs, *attr, group, addedGroup, addedValue)) {
+                    addToAggregate(addedTo[addedGroup], addedValue);
+                }
+            }
+            if (removedFrom.empty() && addedTo.empty()) {
+                continue;
+            }
+
+            // the current rows of the changed groups
+            FileHandle *fh = nullptr;
+            std::vector<Attribute> viewAttrs;
+            if (0 != getFileHandleAndAttributes(view.name, fh, viewAttrs)) {
+                return -1;
+            }
+            AttrType groupType = view.groupAttribute.empty() ? TypeInt : viewAttrs[0].type;
+            std::map<std::string, std::pair<RID, std::string> > rows;
+            std::vector<char> row(maxTupleSize(viewAttrs));
+            if (!view.groupAttribute.empty() && doesIndexExist(view.name, view.groupAttribute)) {
+                IXFileHandle *ixFileHandle = nullptr;
+                if (0 != getIndexFileHandle(view.name, view.groupAttribute, ixFileHandle)) {
+                    releaseFileHandle(view.name);
+                    return -1;
+                }
+                Attribute keyAttr = getIndexKeyAttribute(view.name, view.groupAttribute);
+                std::vector<std::string> groups;
+                for (auto &change : removedFrom) {
+                    groups.push_back(change.first);
+                }
+                for (auto &change : addedTo) {
+                    groups.push_back(change.first);
+                }
+                for (auto &groupKey : groups) {
+                    IX_ScanIterator ixsi;
+                    RID rid;
+                    if (rows.end() == rows.find(groupKey) &&
+                        0 == m_ix->scan(*ixFileHandle, keyAttr, groupKey.data(), groupKey.data(), true, true, ixsi)) {
+                        if (0 == ixsi.getNextEntry(rid, row.data()) &&
+                            0 == m_rbfm->readRecord(*fh, viewAttrs, rid, row.data())) {
+                            rows[groupKey] = std::make_pair(rid, std::string(row.data(), tupleSize(row.data(), viewAttrs)));
+                        }
+                        ixsi.close();
+                    }
+                }
+            } else {
+                // without an index on the group attribute, the whole view is read
+                std::vector<RID> rids;
+                std::vector<std::string> tuples;
+                if (0 != scanMatchingTuples(*fh, viewAttrs, "", NO_OP, nullptr, rids, tuples)) {
+                    releaseFileHandle(view.name);
+                    return -1;
+                }
+                for (size_t i = 0; i < rids.size(); i++) {
+                    std::string groupKey;
+                    AggOutput state;
+                    readAggregateRow(view, groupType, tuples[i].data(), groupKey, state);
+                    rows[groupKey] = std::make_pair(rids[i], tuples[i]);
+                }
+            }
+            releaseFileHandle(view.name);
+
+            // the new state of each changed group
+            std::map<std::string, AggOutput> states;
+            for (auto &change : removedFrom) {
+                states[change.first];
+            }
+            for (auto &change : addedTo) {
+                states[change.first];
+            }
+            std::vector<RID> deletedRids, updatedRids;
+            std::vector<std::string> updatedRows, insertedRows;
+            for (auto &state : states) {
+                auto row = rows.find(state.first);
+                auto removedState = removedFrom.find(state.first);
+                auto addedState = addedTo.find(state.first);
+                bool hasRemoved = removedFrom.end() != removedState;
+                bool hasAdded = addedTo.end() != addedState;
+
+                std::string groupKey;
+                bool recompute = rows.end() == row && hasRemoved;
+                if (rows.end() != row) {
+                    readAggregateRow(view, groupType, row->second.second.data(), groupKey, state.second);
+                }
+                AggOutput old = state.second;
+                if (hasAdded) {
+                    state.second.cnt += addedState->second.cnt;
+                    state.second.sum += addedState->second.sum;
+                    state.second.min = 0 == old.cnt ? addedState->second.min
+                                                    : std::min(old.min, addedState->second.min);
+                    state.second.max = 0 == old.cnt ? addedState->second.max
+                                                    : std::max(old.max, addedState->second.max);
+                }
+                if (hasRemoved) {
+                    state.second.cnt -= removedState->second.cnt;
+                    state.second.sum -= removedState->second.sum;
+
+                    // the min (max) is only known again if something as small (large) was added
+                    recompute = recompute ||
+                                (hasAggregateOp(view, MIN) && removedState->second.min <= old.min &&
+                                 (!hasAdded || addedState->second.min > removedState->second.min)) ||
+                                (hasAggregateOp(view, MAX) && removedState->second.max >= old.max &&
+                                 (!hasAdded || addedState->second.max < removedState->second.max));
+                }
+                if (recompute && (rows.end() == row || 0 < state.second.cnt)) {
+                    std::map<std::string, AggOutput> groups;
+                    if (0 != computeAggregate(view, view.groupAttribute.empty() ? nullptr : state.first.data(),
+                                              groups)) {
+                        return -1;
+                    }
+                    state.second = groups[state.first];
+                }
+
+                if (0 >= state.second.cnt) {
+                    if (rows.end() != row) {
+                        deletedRids.push_back(row->second.first);
+                    }
+                } else if (rows.end() != row) {
+                    updatedRids.push_back(row->second.first);
+                    updatedRows.push_back(aggregateRow(view, state.first, state.second));
+                } else {
+                    insertedRows.push_back(aggregateRow(view, state.first, state.second));
+                }
+            }
+
+            std::vector<const void *> updatedData, insertedData;
+            for (auto &updatedRow : updatedRows) {
+                updatedData.push_back(updatedRow.data());
+            }
+            for (auto &insertedRow : insertedRows) {
+                insertedData.push_back(insertedRow.data());
+            }
+            std::vector<RID> insertedRids;
+            if ((!deletedRids.empty() && 0 != deleteTuplesLatched(view.name, deletedRids)) ||
+                (!updatedRids.empty() && 0 != updateTuplesLatched(view.name, updatedData, updatedRids)) ||
+                (!insertedData.empty() && 0 != insertTuplesLatched(view.name, insertedData, insertedRids))) {
+                ERROR("Error while updating the materialized aggregate %s\n", view.name.c_str());
+                return -1;
+            }
         }
         return 0;
     }
 
-    // Extra credit work
-    RC RelationManager::dropAttribute(const std::string &tableName, const std::string &attributeName) {
-        return -1;
-    }
+    RC RelationManager::computeAggregate(const AggregateView &view, const void *groupKey,
+                                         std::map<std::string, AggOutput> &groups) {
+        CatalogEntry *entry = nullptr;
+        if (0 != getCatalogEntry(view.baseTable, entry)) {
+            return -1;
+        }
 
-    void RelationManager::retrospectivelyInsertExistingKeysIntoIndex(const std::string &table_name,
-        const std::string &attribute_name) {
-        const std::string indexFileName = buildIndexFilename(table_name, attribute_name);
-        IXFileHandle ixFileHandle;
-        m_ix->openFile(indexFileName, ixFileHandle);
+        // the partitions which can hold tuples of the group
+        std::vector<std::string> tableNames;
+        if (NoPartitioning == entry->partitioning.method) {
+            tableNames.push_back(view.baseTable);
+        } else {
+            for (unsigned p : prunePartitions(*entry, view.groupAttribute, nullptr == groupKey ? NO_OP : EQ_OP,
+                                              groupKey)) {
+                tableNames.push_back(partitionTableName(view.baseTable, p));
+            }
+        }
+
+        std::vector<std::string> attributeNames(1, view.attribute);
+        if (!view.groupAttribute.empty()) {
+            attributeNames.push_back(view.groupAttribute);
+        }
+        for (auto &tableName : tableNames) {
+            FileHandle *fh = nullptr;
+            std::vector<Attribute> attrs;
+            if (0 != getFileHandleAndAttributes(tableName, fh, attrs)) {
+                return -1;
+            }
+            auto attr = std::find_if(attrs.begin(), attrs.end(), [&](const Attribute &a) {
+                return a.name == view.attribute;
+            });
+            auto groupAttr = std::find_if(attrs.begin(), attrs.end(), [&](const Attribute &a) {
+                return a.name == view.groupAttribute;
+            });
+            if (attrs.end() == attr || (!view.groupAttribute.empty() && attrs.end() == groupAttr)) {
+                releaseFileHandle(tableName);
+                return -1;
+            }
+            std::vector<Attribute> projectedAttrs(1, *attr);
+            if (!view.groupAttribute.empty()) {
+                projectedAttrs.push_back(*groupAttr);
+            }
 
-        // prepare attr names of table = tableName
-        Attribute indexAttribute;
-        std::vector<Attribute> attributes;
-        getAttributes(table_name, attributes);
-        for (const auto &attribute: attributes) {
-            if (strcmp(attribute.name.c_str(), attribute_name.c_str()) == 0) {
-                indexAttribute = attribute;
-                break;
+            RBFM_ScanIterator rbfmsi;
+            if (0 != m_rbfm->scan(*fh, attrs, nullptr == groupKey ? "" : view.groupAttribute,
+                                  nullptr == groupKey ? NO_OP : EQ_OP, groupKey, attributeNames, rbfmsi)) {
+                releaseFileHandle(tableName);
+                return -1;
+            }
+            std::vector<char> tuple(maxTupleSize(projectedAttrs));
+            RID rid;
+            std::string group;
+            float value;
+            while (RBFM_EOF != rbfmsi.getNextRecord(rid, tuple.data())) {
+                if (aggregateValueOf(tuple.data(), projectedAttrs, projectedAttrs[0],
+                                     view.groupAttribute.empty() ? nullptr : &projectedAttrs[1], group, value)) {
+                    addToAggregate(groups[group], value);
+                }
             }
+            rbfmsi.close();
+            releaseFileHandle(tableName);
         }
+        return 0;
+    }
 
-        std::vector<std::string> attributeNames;
-        attributeNames.push_back(attribute_name);
-
-        // scan for existing records
-        RM_ScanIterator scan_iter;
-        void *recordData = malloc(30);
-        scan(table_name, attribute_name, NO_OP, nullptr, attributeNames, scan_iter);
-
-        RID recordRid;
-        RC scanRC;
-        do {
-            scanRC = scan_iter.getNextTuple(recordRid, recordData);
-            if (scanRC == RM_EOF) {
-                break;
-            }
-            m_ix->insertEntry(ixFileHandle, indexAttribute, recordData, recordRid);
-            INFO("Added rid to index\n");
-        } while (true);
+    void RelationManager::initAggregatesTable() {
+        INFO("Initializing \"Aggregates\"\n");
+        // Create a file for table "Aggregates", it has no rows until a materialized aggregate is created
+        m_rbfm->createFile(CatalogueConstants::AGGREGATES_FILE_NAME);
 
-        scan_iter.close();
-        m_ix->closeFile(ixFileHandle);
-        free(recordData);
-    }
+        // insert its row into "Tables"
+        std::vector<AttributeAndValue> tablesTableAttributeAndValues;
+        CatalogueConstantsBuilder::buildAggregatesTableAttributeAndValues(tablesTableAttributeAndValues);
+        size_t tablesTableAttributeAndValuesDataSize = AttributeAndValueSerializer::computeSerializedDataLenBytes(
+                &tablesTableAttributeAndValues);
+        void *tablesTableAttributeAndValuesData = malloc(tablesTableAttributeAndValuesDataSize);
+        AttributeAndValueSerializer::serialize(tablesTableAttributeAndValues, tablesTableAttributeAndValuesData);
 
+        RID rid;
+        FileHandle tablesFileHandle;
+        m_rbfm->openFile(CatalogueConstants::TABLES_FILE_NAME, tablesFileHandle);
+        m_rbfm->insertRecord(tablesFileHandle, CatalogueConstants::tablesTableAttributes,
+                             tablesTableAttributeAndValuesData, rid);
+        m_rbfm->closeFile(tablesFileHandle);
+        free(tablesTableAttributeAndValuesData);
 
-    // Extra credit work
-    RC RelationManager::addAttribute(const std::string &tableName, const Attribute &attr) {
-        return -1;
+        // and its attributes into "Attributes"
+        buildAndInsertAttributesIntoAttributesTable(CatalogueConstants::aggregatesTableAttributes,
+                                                    CatalogueConstants::AGGREGATES_TABLE_ID);
     }
 
-    // QE IX related
-    RC RelationManager::createIndex(const std::string &tableName, const std::string &attributeName) {
-        INFO("Creaitng index for tableName=%s on attribute=%s\n",
-             tableName, attributeName);
-        // check if index already exists (currently, just check for filename on disk)
-        if (doesIndexExist(tableName, attributeName)) {
-            ERROR("Index for table=%s, attribute=%s already exists",
-                  tableName.data(), attributeName.data());
+    RC RelationManager::insertAggregateIntoCatalog(int tableId, const AggregateView &view) {
+        FileHandle aggregatesFileHandle;
+        if (0 != m_rbfm->openFile(CatalogueConstants::AGGREGATES_FILE_NAME, aggregatesFileHandle)) {
+            ERROR("Error while opening %s file", CatalogueConstants::AGGREGATES_FILE_NAME.c_str());
             return -1;
         }
 
-        // IndexFilename format: <tableName>_<attrName>_index
-        const std::string indexFileName = buildIndexFilename(tableName, attributeName);
-        if (0 != m_ix->createFile(indexFileName)) {
-            ERROR("Error while creating index file for table=%s, attribute=%s \n", tableName.c_str(), attributeName.c_str());
-            return -1;
-        }
+        int ops = aggregateOpBits(view.ops);
+        std::vector<AttributeAndValue> aggregatesTableAttributeAndValues;
+        aggregatesTableAttributeAndValues.push_back(AttributeAndValue{AggregatesAttributeConstants::TABLE_ID, &tableId});
+        aggregatesTableAttributeAndValues.push_back(AttributeAndValue{AggregatesAttributeConstants::VIEW_NAME, (void *) &view.name});
+        aggregatesTableAttributeAndValues.push_back(AttributeAndValue{AggregatesAttributeConstants::BASE_TABLE, (void *) &view.baseTable});
+        aggregatesTableAttributeAndValues.push_back(AttributeAndValue{AggregatesAttributeConstants::ATTRIBUTE_NAME, (void *) &view.attribute});
+        aggregatesTableAttributeAndValues.push_back(AttributeAndValue{AggregatesAttributeConstants::GROUP_ATTRIBUTE_NAME, (void *) &view.groupAttribute});
+        aggregatesTableAttributeAndValues.push_back(AttributeAndValue{AggregatesAttributeConstants::OPS, &ops});
+
+        size_t dataSize = AttributeAndValueSerializer::computeSerializedDataLenBytes(&aggregatesTableAttributeAndValues);
+        void *data = malloc(dataSize);
+        assert(nullptr != data);
+        AttributeAndValueSerializer::serialize(aggregatesTableAttributeAndValues, data);
 
-        // bulk load previously inserted tuples
-        retrospectivelyInsertExistingKeysIntoIndex(tableName, attributeName);
+        RID rid;
+        RC rc = m_rbfm->insertRecord(aggregatesFileHandle, CatalogueConstants::aggregatesTableAttributes, data, rid);
+        free(data);
+        m_rbfm->closeFile(aggregatesFileHandle);
 
-        return 0;
+        return rc;
     }
 
-    RC RelationManager::destroyIndex(const std::string &tableName, const std::string &attributeName) {
-        // check if index even exists (currently, just check for filename on disk)
-        if (!doesIndexExist(tableName, attributeName)) {
-            ERROR("Index for table=%s, attribute=%s does not even exist",
-                  tableName.data(), attributeName.data());
+    RC RelationManager::deleteAggregateFromCatalog(const std::string &viewName) {
+        FileHandle aggregatesFileHandle;
+        if (0 != m_rbfm->openFile(CatalogueConstants::AGGREGATES_FILE_NAME, aggregatesFileHandle)) {
+            ERROR("Error while opening %s file", CatalogueConstants::AGGREGATES_FILE_NAME.c_str());
             return -1;
         }
 
-        const std::string indexFileName = buildIndexFilename(tableName, attributeName);
-        return m_ix->destroyFile(indexFileName);
-    }
+        std::string conditionValue;
+        uint32_t nameLength = viewName.size();
+        conditionValue.append((const char *) &nameLength, sizeof(uint32_t));
+        conditionValue.append(viewName);
+        std::vector<std::string> attrsToRead = {AGGREGATES_ATTR_NAME_TABLE_ID};
+        RBFM_ScanIterator rbfmsi;
+        if (0 != m_rbfm->scan(aggregatesFileHandle, CatalogueConstants::aggregatesTableAttributes,
+                              AGGREGATES_ATTR_NAME_VIEW_NAME, EQ_OP, conditionValue.data(), attrsToRead, rbfmsi)) {
+            m_rbfm->closeFile(aggregatesFileHandle);
+            return -1;
+        }
 
-    void RelationManager::destroyIndex(const std::string &tableName) {
-        std::vector<Attribute> tableAttributes;
-        getAttributes(tableName, tableAttributes);
-        for (const auto &tableAttribute: tableAttributes) {
-            // if an index exists for this (tableName, attrName), it shall be destroyed
-            // if one does not exist, destoryIndex(...) will simply return -1 which is OK
-            destroyIndex(tableName, tableAttribute.name);
+        // nullflags + table-id
+        char data[1 + 4];
+        RID rid;
+        std::vector<RID> ridsToDelete;
+        while (RBFM_EOF != rbfmsi.getNextRecord(rid, data)) {
+            ridsToDelete.push_back(rid);
         }
+        rbfmsi.close();
+
+        RC rc = 0;
+        for (auto &ridToDelete : ridsToDelete) {
+            if (0 != m_rbfm->deleteRecord(aggregatesFileHandle, CatalogueConstants::aggregatesTableAttributes,
+                                          ridToDelete)) {
+                rc = -1;
+            }
+        }
+        m_rbfm->closeFile(aggregatesFileHandle);
+
+        // the base table and its partitions no longer update the view
+        for (auto it = m_catalogCache.begin(); m_catalogCache.end() != it;) {
+            auto &views = it->second.aggregateViews;
+            bool updatesView = views.end() != std::find_if(views.begin(), views.end(), [&](const AggregateView &v) {
+                return v.name == viewName;
+            });
+            it = updatesView || it->first == viewName ? m_catalogCache.erase(it) : std::next(it);
+        }
+        return rc;
     }
 
-    // indexScan returns an iterator to allow the caller to go through qualified entries in index
-    RC RelationManager::indexScan(const std::string &tableName,
-                                  const std::string &attributeName,
-                                  const void *lowKey,
-                                  const void *highKey,
-                                  bool lowKeyInclusive,
-                                  bool highKeyInclusive,
-                                  RM_IndexScanIterator &rm_IndexScanIterator) {
-        /*
-         * wrapper around ix.scan()
-         */
+    RC RelationManager::readAggregatesFromCatalog(int tableId, const std::string &tableName,
+                                                  std::vector<AggregateView> &views, std::string &aggregateOf) {
+        if (!file_exists(CatalogueConstants::AGGREGATES_FILE_NAME)) {
+            // catalog created before there was an Aggregates table, nothing is materialized
+            return 0;
+        }
 
-        // check if index even exists (currently, just check for filename on disk)
-        if (!doesIndexExist(tableName, attributeName)) {
-            ERROR("Index for table=%s, attribute=%s does not even exist",
-                  tableName.data(), attributeName.data());
+        FileHandle aggregatesFileHandle;
+        if (0 != m_rbfm->openFile(CatalogueConstants::AGGREGATES_FILE_NAME, aggregatesFileHandle)) {
+            ERROR("Error while opening %s file", CatalogueConstants::AGGREGATES_FILE_NAME.c_str());
             return -1;
         }
 
-        // open the file associated with this index
-        const std::string indexFilename = buildIndexFilename(tableName, attributeName);
-        IXFileHandle &ixFileHandle = rm_IndexScanIterator.getIxFileHandle();
-        m_ix->openFile(indexFilename, ixFileHandle);
-
-        m_ix->scan(ixFileHandle,
-                   getAttributeDefn(tableName, attributeName),
-                   lowKey,
-                   highKey,
-                   lowKeyInclusive,
-                   highKeyInclusive,
-                   rm_IndexScanIterator.getIxScanIterator());
+        // the rows of the views the table updates, and the ones of the view it may be
+        std::vector<std::string> attrsToRead = {AGGREGATES_ATTR_NAME_TABLE_ID, AGGREGATES_ATTR_NAME_VIEW_NAME,
+                                                AGGREGATES_ATTR_NAME_BASE_TABLE, AGGREGATES_ATTR_NAME_ATTR_NAME,
+                                                AGGREGATES_ATTR_NAME_GROUP_ATTR_NAME, AGGREGATES_ATTR_NAME_OPS};
+        RBFM_ScanIterator rbfmsi;
+        if (0 != m_rbfm->scan(aggregatesFileHandle, CatalogueConstants::aggregatesTableAttributes, "", NO_OP,
+                              nullptr, attrsToRead, rbfmsi)) {
+            m_rbfm->closeFile(aggregatesFileHandle);
+            return -1;
+        }
 
-        return 0;
-    }
+        // nullflags + table-id + 4 names + ops
+        std::vector<char> data(1 + 4 + 4 * (4 + ATTRIBUTE_NAME_MAX_LENGTH) + 4);
+        RID rid;
+        while (RBFM_EOF != rbfmsi.getNextRecord(rid, data.data())) {
+            const char *field = data.data() + 1;
+            int rowTableId;
+            memcpy(&rowTableId, field, sizeof(int));
+            field += sizeof(int);
+
+            std::string names[4];
+            for (auto &name : names) {
+                uint32_t nameLength;
+                memcpy(&nameLength, field, sizeof(uint32_t));
+                name.assign(field + 4, nameLength);
+                field += 4 + nameLength;
+            }
+            int ops;
+            memcpy(&ops, field, sizeof(int));
 
-    Attribute RelationManager::getAttributeDefn(const std::string &tableName, const std::string &attributeName) {
-        std::vector<Attribute> tableAttributes;
-        getAttributes(tableName, tableAttributes);
-        for (const Attribute &attribute: tableAttributes) {
-            if (strcmp(attribute.name.data(), attributeName.data()) == 0) {
-                return attribute;
+            if (rowTableId == tableId) {
+                views.push_back(AggregateView{names[0], names[1], names[2], names[3], aggregateOpsOf(ops)});
+            }
+            if (names[0] == tableName) {
+                aggregateOf = names[1];
             }
         }
-        ERROR("Table=%s contains no attribute named %s\n",
-              tableName, attributeName);
-        return {};
+        rbfmsi.close();
+        m_rbfm->closeFile(aggregatesFileHandle);
+
+        return 0;
     }
 
     void RelationManager::initTablesTable() {
@@ -916,8 +5124,10 @@ namespace PeterDB {
 
     void RelationManager::buildAttributesForAttributesTable(int tableId,
                                                             const std::vector<Attribute> &attributes,
-                                                            std::vector<std::vector<AttributeAndValue>> &attrsAndValuesForAttrsTable) {
-        int attributePosition = 1;
+                                                            std::vector<std::vector<AttributeAndValue>> &attrsAndValuesForAttrsTable,
+                                                            int firstPosition, int schemaVersion) {
+        int attributePosition = firstPosition;
+        int notDropped = 0;
         for (const Attribute &attribute: attributes) {
             std::vector<AttributeAndValue> attrsAndValues;
 
@@ -937,15 +5147,20 @@ namespace PeterDB {
             // attr position
             attrsAndValues.push_back(AttributeAndValue{AttributesAttributeConstants::ATTRIBUTE_POSITION, (void*) &attributePosition});
 
+            // schema versions the attr was added and dropped in
+            attrsAndValues.push_back(AttributeAndValue{AttributesAttributeConstants::SCHEMA_VERSION_ADDED, (void*) &schemaVersion});
+            attrsAndValues.push_back(AttributeAndValue{AttributesAttributeConstants::SCHEMA_VERSION_DROPPED, (void*) &notDropped});
+
             attrsAndValuesForAttrsTable.push_back(attrsAndValues);
             attributePosition++;
         }
     }
 
-    void RelationManager::buildAndInsertAttributesIntoAttributesTable(const std::vector<Attribute> &attrs, int tid) {
+    void RelationManager::buildAndInsertAttributesIntoAttributesTable(const std::vector<Attribute> &attrs, int tid,
+                                                                      int firstPosition, int schemaVersion) {
         // 1. build AttributesAndValues for attributes table
         std::vector<std::vector<AttributeAndValue>> attributesForAttributesTable;
-        buildAttributesForAttributesTable(tid, attrs, attributesForAttributesTable);
+        buildAttributesForAttributesTable(tid, attrs, attributesForAttributesTable, firstPosition, schemaVersion);
 
         // 2. Insert AttributesAndValues into "Attributes" table
 
@@ -966,58 +5181,481 @@ namespace PeterDB {
     }
 
     std::string RelationManager::buildIndexFilename(const std::string &tableName, const std::string &attributeName) {
-        return tableName + "_" + attributeName + "_index" + INDEX_FILETYPE;
+        // composite index names have commas, which don't go into file names
+        std::string fileAttributeName = attributeName;
+        std::replace(fileAttributeName.begin(), fileAttributeName.end(), ',', '+');
+        return tableName + "_" + fileAttributeName + "_index" + INDEX_FILETYPE;
+    }
+
+    std::string RelationManager::getIndexFileName(const std::string &tableName, const std::string &attributeName) {
+        CatalogEntry *entry = nullptr;
+        if (0 != getCatalogEntry(tableName, entry)) {
+            return buildIndexFilename(tableName, attributeName);
+        }
+        auto indexFileName = entry->indexFileNames.find(attributeName);
+        if (entry->indexFileNames.end() != indexFileName) {
+            return indexFileName->second;
+        }
+        return indexFileNameOf(entry->fileName, attributeName);
+    }
+
+    std::string RelationManager::movedIndexFileName(const std::string &tableName, const std::string &attributeName,
+                                                    const std::string &tableFileName) {
+        std::string indexFileName = indexFileNameOf(tableFileName, attributeName);
+        CatalogEntry *entry = nullptr;
+        if (0 != getCatalogEntry(tableName, entry)) {
+            return indexFileName;
+        }
+        std::string tablespace = PagedFileManager::tablespaceOf(getIndexFileName(tableName, attributeName));
+        if (tablespace == PagedFileManager::tablespaceOf(entry->fileName)) {
+            return indexFileName;
+        }
+        return PagedFileManager::tablespaceFileName(tablespace, indexFileName);
+    }
+
+    std::string RelationManager::indexFileNameOf(const std::string &tableFileName, const std::string &attributeName) {
+        // tables never clustered are in files named after them, and so are their indexes
+        std::string indexFileName = buildIndexFilename(withoutMemoryPrefix(tableFileName), attributeName);
+        if (PagedFileManager::isMemoryFile(tableFileName)) {
+            return PagedFileManager::memoryFileName(indexFileName);
+        }
+        return indexFileName;
     }
 
-    std::pair<std::string, std::string> RelationManager::getTableAndAttrFromIndexFileName(const std::string& indexFname) {
-        size_t firstUnderscore = indexFname.find('_');
-        size_t lastUnderscore = indexFname.rfind('_');
+    std::string RelationManager::joinAttributeNames(const std::vector<std::string> &attributeNames) {
+        std::string joined;
+        for (auto &attributeName : attributeNames) {
+            joined += (joined.empty() ? "" : ",") + attributeName;
+        }
+        return joined;
+    }
 
-        if (firstUnderscore == std::string::npos || lastUnderscore == std::string::npos || firstUnderscore == lastUnderscore) {
-            // Format does not match expected pattern
-            throw std::invalid_argument("Filename does not match expected format: tableName_attributeName_index");
+    std::vector<std::string> RelationManager::splitAttributeNames(const std::string &joined) {
+        std::vector<std::string> attributeNames;
+        size_t start = 0;
+        while (start < joined.size()) {
+            size_t end = joined.find(',', start);
+            if (std::string::npos == end) {
+                end = joined.size();
+            }
+            attributeNames.push_back(joined.substr(start, end - start));
+            start = end + 1;
         }
+        return attributeNames;
+    }
 
-        std::string tableName = indexFname.substr(0, firstUnderscore);
-        std::string attributeName = indexFname.substr(firstUnderscore + 1, lastUnderscore - firstUnderscore - 1);
+    std::vector<Attribute> RelationManager::getIndexKeyAttributes(const std::string &tableName,
+                                                                  const std::string &indexName) {
+        std::vector<Attribute> keyAttributes;
+        for (auto &attributeName : splitAttributeNames(indexName)) {
+            keyAttributes.push_back(getAttributeDefn(tableName, attributeName));
+        }
+        return keyAttributes;
+    }
 
-        return {tableName, attributeName};
+    Attribute RelationManager::getIndexKeyAttribute(const std::string &tableName, const std::string &indexName) {
+        std::vector<Attribute> keyAttributes = getIndexKeyAttributes(tableName, indexName);
+        if (1 == keyAttributes.size()) {
+            return keyAttributes[0];
+        }
+        return CompositeKey::keyAttribute(keyAttributes);
     }
 
     bool RelationManager::doesIndexExist(const std::string &tableName, const std::string &attributeName) {
-        const std::string indexFilename = buildIndexFilename(tableName, attributeName);
-        return file_exists(indexFilename);
+        CatalogEntry *entry = nullptr;
+        if (0 != getCatalogEntry(tableName, entry)) {
+            return false;
+        }
+        return entry->indexedAttrs.end() !=
+               std::find(entry->indexedAttrs.begin(), entry->indexedAttrs.end(), attributeName);
+    }
+
+    std::vector<Attribute> RelationManager::getIncludedAttributes(const std::string &tableName,
+                                                                  const std::string &attributeName) {
+        std::vector<Attribute> includedAttributes;
+        CatalogEntry *entry = nullptr;
+        if (0 != getCatalogEntry(tableName, entry)) {
+            return includedAttributes;
+        }
+        auto included = entry->includedAttrs.find(attributeName);
+        if (entry->includedAttrs.end() == included) {
+            return includedAttributes;
+        }
+        for (auto &includedAttributeName : included->second) {
+            includedAttributes.push_back(getAttributeDefn(tableName, includedAttributeName));
+        }
+        return includedAttributes;
     }
 
-    void RelationManager::getIndexNames(const std::string& tableName, std::vector<std::string>& indexFiles) {
-        DIR* dir;
-        struct dirent* ent;
+    bool RelationManager::isCatalogTable(const std::string &tableName) {
+        return tableName == CatalogueConstants::TABLES_FILE_NAME ||
+               tableName == CatalogueConstants::ATTRIBUTES_FILE_NAME ||
+               tableName == CatalogueConstants::INDEXES_FILE_NAME ||
+               tableName == CatalogueConstants::STATISTICS_FILE_NAME ||
+               tableName == CatalogueConstants::PARTITIONS_FILE_NAME ||
+               tableName == CatalogueConstants::TABLESPACES_FILE_NAME ||
+               tableName == CatalogueConstants::AGGREGATES_FILE_NAME;
+    }
 
-        std::string directory = "."; // Current directory; change as needed
-        if ((dir = opendir(directory.c_str())) != nullptr) {
-            while ((ent = readdir(dir)) != nullptr) {
-                std::string filename = ent->d_name;
-                // Check if the filename starts with tableName and ends with "_index"
-                if (filename.rfind(tableName + "_", 0) == 0 && filename.find("_index") != std::string::npos) {
-                    indexFiles.push_back(filename);
-                }
+    void RelationManager::initIndexesTable() {
+        INFO("Initializing \"Indexes\"\n");
+        // Create a file for table "Indexes", it has no rows until an index is created
+        m_rbfm->createFile(CatalogueConstants::INDEXES_FILE_NAME);
+
+        // insert its row into "Tables"
+        std::vector<AttributeAndValue> tablesTableAttributeAndValues;
+        CatalogueConstantsBuilder::buildIndexesTableAttributeAndValues(tablesTableAttributeAndValues);
+        size_t tablesTableAttributeAndValuesDataSize = AttributeAndValueSerializer::computeSerializedDataLenBytes(
+                &tablesTableAttributeAndValues);
+        void *tablesTableAttributeAndValuesData = malloc(tablesTableAttributeAndValuesDataSize);
+        AttributeAndValueSerializer::serialize(tablesTableAttributeAndValues, tablesTableAttributeAndValuesData);
+
+        RID rid;
+        FileHandle tablesFileHandle;
+        m_rbfm->openFile(CatalogueConstants::TABLES_FILE_NAME, tablesFileHandle);
+        m_rbfm->insertRecord(tablesFileHandle, CatalogueConstants::tablesTableAttributes,
+                             tablesTableAttributeAndValuesData, rid);
+        m_rbfm->closeFile(tablesFileHandle);
+        free(tablesTableAttributeAndValuesData);
+
+        // and its attributes into "Attributes"
+        buildAndInsertAttributesIntoAttributesTable(CatalogueConstants::indexesTableAttributes,
+                                                    CatalogueConstants::INDEXES_TABLE_ID);
+    }
+
+    RC RelationManager::insertIndexIntoCatalog(int tableId, const std::string &attributeName,
+                                               const std::string &indexFileName,
+                                               const std::vector<std::string> &includedAttributeNames) {
+        std::string includedColumns = joinAttributeNames(includedAttributeNames);
+
+        std::vector<AttributeAndValue> indexesTableAttributeAndValues;
+        indexesTableAttributeAndValues.push_back(AttributeAndValue{IndexesAttributeConstants::TABLE_ID, &tableId});
+        indexesTableAttributeAndValues.push_back(AttributeAndValue{IndexesAttributeConstants::ATTRIBUTE_NAME, (void*) &attributeName});
+        indexesTableAttributeAndValues.push_back(AttributeAndValue{IndexesAttributeConstants::FILE_NAME, (void*) &indexFileName});
+        indexesTableAttributeAndValues.push_back(AttributeAndValue{IndexesAttributeConstants::INCLUDED_COLUMNS, (void*) &includedColumns});
+
+        size_t dataSize = AttributeAndValueSerializer::computeSerializedDataLenBytes(&indexesTableAttributeAndValues);
+        void *data = malloc(dataSize);
+        assert(nullptr != data);
+        AttributeAndValueSerializer::serialize(indexesTableAttributeAndValues, data);
+
+        RID rid;
+        FileHandle indexesFileHandle;
+        if (0 != m_rbfm->openFile(CatalogueConstants::INDEXES_FILE_NAME, indexesFileHandle)) {
+            ERROR("Error while opening %s file", CatalogueConstants::INDEXES_FILE_NAME.c_str());
+            free(data);
+            return -1;
+        }
+        auto ir = m_rbfm->insertRecord(indexesFileHandle, CatalogueConstants::indexesTableAttributes, data, rid);
+        m_rbfm->closeFile(indexesFileHandle);
+        free(data);
+
+        return ir;
+    }
+
+    RC RelationManager::deleteIndexFromCatalog(int tableId, const std::string &attributeName) {
+        FileHandle indexesFileHandle;
+        if (0 != m_rbfm->openFile(CatalogueConstants::INDEXES_FILE_NAME, indexesFileHandle)) {
+            ERROR("Error while opening %s file", CatalogueConstants::INDEXES_FILE_NAME.c_str());
+            return -1;
+        }
+
+        // find the rows of the table, then delete the one of the attribute
+        std::vector<std::string> attrsToRead = {INDEXES_ATTR_NAME_ATTR_NAME};
+        RBFM_ScanIterator rbfmsi;
+        if (0 != m_rbfm->scan(indexesFileHandle, CatalogueConstants::indexesTableAttributes,
+                              INDEXES_ATTR_NAME_TABLE_ID, EQ_OP, &tableId, attrsToRead, rbfmsi)) {
+            m_rbfm->closeFile(indexesFileHandle);
+            return -1;
+        }
+
+        // nullflags + length of varchar attr + varchar attr
+        char data[1 + 4 + ATTRIBUTE_NAME_MAX_LENGTH];
+        RID rid;
+        std::vector<RID> ridsToDelete;
+        while (RBFM_EOF != rbfmsi.getNextRecord(rid, data)) {
+            uint32_t nameLength = *((uint32_t*) (data + 1));
+            if (attributeName == std::string(data + 1 + 4, nameLength)) {
+                ridsToDelete.push_back(rid);
+            }
+        }
+        rbfmsi.close();
+
+        RC rc = ridsToDelete.empty() ? -1 : 0;
+        for (auto &ridToDelete : ridsToDelete) {
+            if (0 != m_rbfm->deleteRecord(indexesFileHandle, CatalogueConstants::indexesTableAttributes, ridToDelete)) {
+                rc = -1;
+            }
+        }
+        m_rbfm->closeFile(indexesFileHandle);
+
+        return rc;
+    }
+
+    RC RelationManager::readIndexesFromCatalog(int tableId, std::vector<std::string> &indexedAttrs,
+                                               std::unordered_map<std::string, std::vector<std::string> > &includedAttrs,
+                                               std::unordered_map<std::string, std::string> &indexFileNames) {
+        if (!file_exists(CatalogueConstants::INDEXES_FILE_NAME)) {
+            // catalog created before there was an Indexes table
+            return 0;
+        }
+
+        FileHandle indexesFileHandle;
+        if (0 != m_rbfm->openFile(CatalogueConstants::INDEXES_FILE_NAME, indexesFileHandle)) {
+            ERROR("Error while opening %s file", CatalogueConstants::INDEXES_FILE_NAME.c_str());
+            return -1;
+        }
+
+        std::vector<std::string> attrsToRead = {INDEXES_ATTR_NAME_ATTR_NAME, INDEXES_ATTR_NAME_FNAME,
+                                                INDEXES_ATTR_NAME_INCLUDED};
+        RBFM_ScanIterator rbfmsi;
+        if (0 != m_rbfm->scan(indexesFileHandle, CatalogueConstants::indexesTableAttributes,
+                              INDEXES_ATTR_NAME_TABLE_ID, EQ_OP, &tableId, attrsToRead, rbfmsi)) {
+            m_rbfm->closeFile(indexesFileHandle);
+            return -1;
+        }
+
+        // nullflags + length of varchar attr + varchar attr, for the three attrs
+        char data[1 + 4 + ATTRIBUTE_NAME_MAX_LENGTH + 4 + INDEX_FILE_NAME_MAX_LENGTH + 4 +
+                  INDEX_INCLUDED_COLUMNS_MAX_LENGTH];
+        RID rid;
+        while (RBFM_EOF != rbfmsi.getNextRecord(rid, data)) {
+            const char *field = data + 1;
+            uint32_t nameLength = *((uint32_t*) field);
+            std::string name(field + 4, nameLength);
+            indexedAttrs.push_back(name);
+            field += 4 + nameLength;
+
+            uint32_t fileNameLength = *((uint32_t*) field);
+            indexFileNames[name] = std::string(field + 4, fileNameLength);
+            field += 4 + fileNameLength;
+
+            // included columns, comma separated
+            uint32_t includedLength = *((uint32_t*) field);
+            if (0 != includedLength) {
+                includedAttrs[name] = splitAttributeNames(std::string(field + 4, includedLength));
             }
-            closedir(dir);
-        } else {
-            assert(0);
         }
+        rbfmsi.close();
+        m_rbfm->closeFile(indexesFileHandle);
+
+        return 0;
     }
 
     RM_IndexScanIterator::RM_IndexScanIterator() = default;
 
-    RM_IndexScanIterator::~RM_IndexScanIterator() = default;
+    RM_IndexScanIterator::~RM_IndexScanIterator() {
+        close();
+        delete m_partitionScan;
+    }
+
+    RC RM_IndexScanIterator::init(RelationManager *rm, const std::string &tableName, IXFileHandle *ixFileHandle) {
+        close();
+
+        m_rm = rm;
+        m_tableName = tableName;
+        m_ix_fileHandle = ixFileHandle;
+        return 0;
+    }
+
+    void RM_IndexScanIterator::initProjection(const std::vector<Attribute> &attrs,
+                                              const std::vector<Attribute> &keyAttrs,
+                                              const std::vector<Attribute> &includedAttrs,
+                                              const std::vector<std::string> &attributeNames) {
+        m_attrs = attrs;
+        m_keyAttrCount = keyAttrs.size();
+        m_entryAttrs = keyAttrs;
+        m_entryAttrs.insert(m_entryAttrs.end(), includedAttrs.begin(), includedAttrs.end());
+
+        // no attributes given means all of them
+        m_attributeNames = attributeNames;
+        if (m_attributeNames.empty()) {
+            for (auto &attr : attrs) {
+                m_attributeNames.push_back(attr.name);
+            }
+        }
+
+        // the entries alone are enough when they hold every projected attribute
+        m_indexOnly = true;
+        for (auto &attributeName : m_attributeNames) {
+            auto entryAttr = std::find_if(m_entryAttrs.begin(), m_entryAttrs.end(), [&](const Attribute &a) {
+                return a.name == attributeName;
+            });
+            m_indexOnly = m_indexOnly && m_entryAttrs.end() != entryAttr;
+        }
+
+        m_buffer.assign(maxTupleSize(attrs), 0);
+        m_entryTuple.assign(maxTupleSize(m_entryAttrs), 0);
+    }
+
+    RC RM_IndexScanIterator::initPartitions(RelationManager *rm, const std::string &tableName,
+                                            const std::vector<unsigned> &partitions,
+                                            const std::string &attributeName, const std::string &lowKey,
+                                            const std::string &highKey, bool lowKeyInclusive, bool highKeyInclusive,
+                                            const std::vector<std::string> &attributeNames) {
+        close();
+
+        m_rm = rm;
+        m_tableName = tableName;
+        m_partitioned = true;
+        m_partitions = partitions;
+        m_nextPartition = 0;
+        m_indexName = attributeName;
+        m_lowKey = lowKey;
+        m_highKey = highKey;
+        m_lowKeyInclusive = lowKeyInclusive;
+        m_highKeyInclusive = highKeyInclusive;
+        m_attributeNames = attributeNames;
+        if (nullptr == m_partitionScan) {
+            m_partitionScan = new RM_IndexScanIterator();
+        }
+
+        if (!m_partitions.empty() && 0 != openNextPartition()) {
+            close();
+            return -1;
+        }
+        return 0;
+    }
+
+    RC RM_IndexScanIterator::openNextPartition() {
+        m_partitionScan->close();
+        if (m_nextPartition == m_partitions.size()) {
+            return RM_EOF;
+        }
+
+        m_partition = m_partitions[m_nextPartition++];
+        return m_rm->indexScan(RelationManager::partitionTableName(m_tableName, m_partition), m_indexName,
+                               m_lowKey.empty() ? nullptr : m_lowKey.data(),
+                               m_highKey.empty() ? nullptr : m_highKey.data(),
+                               m_lowKeyInclusive, m_highKeyInclusive, m_attributeNames, *m_partitionScan);
+    }
+
+    bool RM_IndexScanIterator::isIndexOnly() const {
+        if (m_partitioned) {
+            return nullptr != m_partitionScan && m_partitionScan->isIndexOnly();
+        }
+        return m_indexOnly;
+    }
+
+    void RM_IndexScanIterator::holdLocks(TxnId txn) {
+        if (0 != txn) {
+            m_lockOwner = txn;
+        }
+    }
 
     RC RM_IndexScanIterator::getNextEntry(RID &rid, void *key){
+        if (nullptr == m_rm) {
+            return RM_EOF;
+        }
+        LatchedCall latched(m_rm->m_latch);
+        if (m_partitioned) {
+            // entries come partition by partition, in key order within each partition
+            while (0 != m_nextPartition) {
+                if (RM_EOF != m_partitionScan->getNextEntry(rid, key)) {
+                    rid = toPartitionRid(rid, m_partition);
+                    return 0;
+                }
+                if (0 != openNextPartition()) {
+                    return RM_EOF;
+                }
+            }
+            return RM_EOF;
+        }
+
+        if (nullptr == m_ix_fileHandle) {
+            return RM_EOF;
+        }
         return m_ix_scan_iterator.getNextEntry(rid, key);
     }
 
+    RC RM_IndexScanIterator::getNextTuple(RID &rid, void *data) {
+        if (nullptr == m_rm) {
+            return RM_EOF;
+        }
+        LatchedCall latched(m_rm->m_latch);
+        if (m_partitioned) {
+            while (0 != m_nextPartition) {
+                RC rc = m_partitionScan->getNextTuple(rid, data);
+                if (0 == rc) {
+                    rid = toPartitionRid(rid, m_partition);
+                    return 0;
+                }
+                if (0 != openNextPartition()) {
+                    return RM_EOF;
+                }
+            }
+            return RM_EOF;
+        }
+
+        if (nullptr == m_ix_fileHandle || IX_EOF == m_ix_scan_iterator.getNextEntry(rid, m_buffer.data())) {
+            return RM_EOF;
+        }
+
+        if (!m_indexOnly) {
+            if (0 != m_rm->readTuple(m_tableName, rid, m_buffer.data())) {
+                return -1;
+            }
+            projectTuple(m_buffer.data(), m_attrs, m_attributeNames, data);
+            return 0;
+        }
+
+        // put the entry together as a tuple of the key attributes, which are never NULL, and the
+        // included attributes, which the payload has in the insertTuple() format
+        const std::string &payload = m_ix_scan_iterator.getPayload();
+        unsigned includedCount = m_entryAttrs.size() - m_keyAttrCount;
+        unsigned payloadNullBytes = (includedCount + 7) / 8;
+        unsigned nullBytes = (m_entryAttrs.size() + 7) / 8;
+        char *tuple = m_entryTuple.data();
+
+        memset(tuple, 0, nullBytes);
+        for (unsigned i = 0; i < includedCount && !payload.empty(); i++) {
+            if (isAttrNull(payload.data(), i)) {
+                unsigned attrNum = m_keyAttrCount + i;
+                tuple[attrNum / 8] |= (char) (0x80 >> (attrNum % 8));
+            }
+        }
+
+        unsigned keySize = 4;
+        if (m_keyAttrCount > 1) {
+            std::vector<Attribute> keyAttrs(m_entryAttrs.begin(), m_entryAttrs.begin() + m_keyAttrCount);
+            keySize = CompositeKey::decode(keyAttrs, m_buffer.data(), tuple + nullBytes);
+        } else {
+            if (TypeVarChar == m_entryAttrs[0].type) {
+                keySize += *((uint32_t *) m_buffer.data());
+            }
+            memcpy(tuple + nullBytes, m_buffer.data(), keySize);
+        }
+        if (payload.size() > payloadNullBytes) {
+            memcpy(tuple + nullBytes + keySize, payload.data() + payloadNullBytes, payload.size() - payloadNullBytes);
+        }
+
+        projectTuple(tuple, m_entryAttrs, m_attributeNames, data);
+        return 0;
+    }
+
     RC RM_IndexScanIterator::close(){
-        return m_ix_scan_iterator.close();
+        if (0 != m_lockOwner) {
+            LockManager::instance().releaseAll(m_lockOwner);
+            m_lockOwner = 0;
+        }
+        if (nullptr == m_rm) {
+            return m_ix_scan_iterator.close();
+        }
+        LatchedCall latched(m_rm->m_latch);
+
+        if (m_partitioned) {
+            m_partitioned = false;
+            m_partitions.clear();
+            m_nextPartition = 0;
+            m_partitionScan->close();
+        }
+
+        RC rc = m_ix_scan_iterator.close();
+        if (nullptr != m_ix_fileHandle) {
+            m_rm->releaseFileHandle(m_tableName);
+            m_ix_fileHandle = nullptr;
+        }
+        return rc;
     }
 
     IX_ScanIterator &RM_IndexScanIterator::getIxScanIterator() {
@@ -1028,12 +5666,9 @@ namespace PeterDB {
         m_ix_scan_iterator = mIxScanIterator;
     }
 
-    void RM_IndexScanIterator::setIxFileHandle(const IXFileHandle &mIxFileHandle) {
-        m_ix_fileHandle = mIxFileHandle;
-    }
-
     IXFileHandle &RM_IndexScanIterator::getIxFileHandle(){
-        return m_ix_fileHandle;
+        assert(nullptr != m_ix_fileHandle);
+        return *m_ix_fileHandle;
     }
 
 } // namespace PeterDB
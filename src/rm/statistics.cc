@@ -0,0 +1,272 @@
+#include "src/include/statistics.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace PeterDB {
+
+    // 64 bit hash of the value bytes, with the bits mixed well enough for HyperLogLog
+    static uint64_t hashValue(const void *value, unsigned length) {
+        uint64_t hash = std::hash<std::string>()(std::string((const char *) value, length));
+        hash ^= hash >> 33;
+        hash *= 0xff51afd7ed558ccdULL;
+        hash ^= hash >> 33;
+        hash *= 0xc4ceb9fe1a85ec53ULL;
+        hash ^= hash >> 33;
+        return hash;
+    }
+
+    HyperLogLog::HyperLogLog() : m_registers(1u << STATS_HLL_PRECISION, 0) {
+    }
+
+    void HyperLogLog::add(const void *value, unsigned length) {
+        uint64_t hash = hashValue(value, length);
+
+        // the first bits pick the register, which keeps the longest run of leading zeros seen in the rest
+        unsigned registerNum = hash >> (64 - STATS_HLL_PRECISION);
+        uint64_t rest = (hash << STATS_HLL_PRECISION) | (1ULL << (STATS_HLL_PRECISION - 1));
+        auto rank = (uint8_t) (__builtin_clzll(rest) + 1);
+
+        m_registers[registerNum] = std::max(m_registers[registerNum], rank);
+    }
+
+    double HyperLogLog::estimate() const {
+        double registerCount = m_registers.size();
+        double sum = 0;
+        unsigned emptyRegisters = 0;
+        for (auto rank : m_registers) {
+            sum += std::ldexp(1.0, -rank);
+            if (0 == rank) {
+                emptyRegisters++;
+            }
+        }
+
+        double alpha = 0.7213 / (1 + 1.079 / registerCount);
+        double estimate = alpha * registerCount * registerCount / sum;
+
+        // small cardinalities are better estimated by linear counting
+        if (estimate <= 2.5 * registerCount && 0 != emptyRegisters) {
+            estimate = registerCount * std::log(registerCount / emptyRegisters);
+        }
+        return estimate;
+    }
+
+    int ColumnStatistics::compareValues(AttrType type, const std::string &first, const std::string &second) {
+        switch (type) {
+            case TypeInt: {
+                int firstInt, secondInt;
+                memcpy(&firstInt, first.data(), sizeof(int));
+                memcpy(&secondInt, second.data(), sizeof(int));
+                return firstInt < secondInt ? -1 : (firstInt > secondInt ? 1 : 0);
+            }
+            case TypeReal: {
+                float firstFloat, secondFloat;
+                memcpy(&firstFloat, first.data(), sizeof(float));
+                memcpy(&secondFloat, second.data(), sizeof(float));
+                return firstFloat < secondFloat ? -1 : (firstFloat > secondFloat ? 1 : 0);
+            }
+            case TypeVarChar:
+                return first.compare(sizeof(uint32_t), std::string::npos, second, sizeof(uint32_t), std::string::npos);
+        }
+        assert(0);
+        return 0;
+    }
+
+    std::string ColumnStatistics::toValue(AttrType type, const void *key) {
+        if (TypeVarChar != type) {
+            return std::string((const char *) key, sizeof(int));
+        }
+
+        uint32_t length;
+        memcpy(&length, key, sizeof(uint32_t));
+        length = std::min(length, (uint32_t) STATS_VALUE_MAX_LENGTH);
+
+        std::string value((const char *) &length, sizeof(uint32_t));
+        value.append((const char *) key + sizeof(uint32_t), length);
+        return value;
+    }
+
+    float ColumnStatistics::fractionBelow(const std::string &value) const {
+        if (histogramBounds.empty() || compareValues(type, value, histogramBounds.front()) <= 0) {
+            return 0;
+        }
+
+        // buckets entirely below the value
+        unsigned buckets = histogramBounds.size() - 1;
+        unsigned bucket = 0;
+        while (bucket < buckets && compareValues(type, histogramBounds[bucket + 1], value) < 0) {
+            bucket++;
+        }
+        if (bucket == buckets) {
+            return 1;
+        }
+
+        // and the part of the bucket the value falls into, assuming its values are spread evenly
+        float partial = 0.5;
+        if (TypeInt == type || TypeReal == type) {
+            float low, high, point;
+            if (TypeInt == type) {
+                int lowInt, highInt, pointInt;
+                memcpy(&lowInt, histogramBounds[bucket].data(), sizeof(int));
+                memcpy(&highInt, histogramBounds[bucket + 1].data(), sizeof(int));
+                memcpy(&pointInt, value.data(), sizeof(int));
+                low = lowInt, high = highInt, point = pointInt;
+            } else {
+                memcpy(&low, histogramBounds[bucket].data(), sizeof(float));
+                memcpy(&high, histogramBounds[bucket + 1].data(), sizeof(float));
+                memcpy(&point, value.data(), sizeof(float));
+            }
+            partial = (point - low) / (high - low);
+        }
+        return (bucket + partial) / buckets;
+    }
+
+    float ColumnStatistics::estimateSelectivity(CompOp compOp, const void *value) const {
+        if (NO_OP == compOp) {
+            return 1;
+        }
+        if (minValue.empty() || nullptr == value) {
+            // nothing matches a NULL, and NULLs don't match anything
+            return 0;
+        }
+
+        std::string point = toValue(type, value);
+        float equal = 0;
+        if (compareValues(type, point, minValue) >= 0 && compareValues(type, point, maxValue) <= 0) {
+            equal = 1.0f / std::max(distinctCount, 1u);
+        }
+        float below = fractionBelow(point);
+
+        float selectivity = 0;
+        switch (compOp) {
+            case EQ_OP:
+                selectivity = equal;
+                break;
+            case NE_OP:
+                selectivity = 1 - equal;
+                break;
+            case LT_OP:
+                selectivity = below;
+                break;
+            case LE_OP:
+                selectivity = below + equal;
+                break;
+            case GT_OP:
+                selectivity = 1 - below - equal;
+                break;
+            case GE_OP:
+                selectivity = 1 - below;
+                break;
+            case NO_OP:
+                break;
+        }
+        selectivity = std::min(std::max(selectivity, 0.0f), 1.0f);
+        return selectivity * (1 - nullFraction);
+    }
+
+    const ColumnStatistics *TableStatistics::getColumn(const std::string &name) const {
+        for (auto &column : columns) {
+            if (column.name == name) {
+                return &column;
+            }
+        }
+        return nullptr;
+    }
+
+    StatisticsCollector::StatisticsCollector(const std::vector<Attribute> &attrs)
+            : m_attrs(attrs), m_columns(attrs.size()), m_random(STATS_SAMPLE_SEED) {
+    }
+
+    void StatisticsCollector::addTuple(const void *data) {
+        auto *tuple = (const char *) data;
+        unsigned offset = (m_attrs.size() + 7) / 8;
+
+        for (unsigned i = 0; i < m_attrs.size(); i++) {
+            if (tuple[i / 8] & (0x80 >> (i % 8))) {
+                m_columns[i].nullCount++;
+                continue;
+            }
+
+            unsigned keySize = sizeof(int);
+            if (TypeVarChar == m_attrs[i].type) {
+                uint32_t length;
+                memcpy(&length, tuple + offset, sizeof(uint32_t));
+                keySize += length;
+            }
+            addValue(m_columns[i], m_attrs[i].type, tuple + offset, keySize);
+            offset += keySize;
+        }
+
+        m_tupleCount++;
+        m_tupleBytes += offset;
+    }
+
+    void StatisticsCollector::addValue(ColumnCollector &column, AttrType type, const char *key, unsigned keySize) {
+        column.valueCount++;
+        column.distinct.add(key, keySize);
+
+        std::string value = ColumnStatistics::toValue(type, key);
+        if (column.minValue.empty() || ColumnStatistics::compareValues(type, value, column.minValue) < 0) {
+            column.minValue = value;
+        }
+        if (column.maxValue.empty() || ColumnStatistics::compareValues(type, value, column.maxValue) > 0) {
+            column.maxValue = value;
+        }
+
+        // keep a uniform sample of the values for the histogram
+        if (column.reservoir.size() < STATS_HISTOGRAM_SAMPLE_SIZE) {
+            column.reservoir.push_back(value);
+            return;
+        }
+        unsigned pos = std::uniform_int_distribution<unsigned>(0, column.valueCount - 1)(m_random);
+        if (pos < STATS_HISTOGRAM_SAMPLE_SIZE) {
+            column.reservoir[pos] = value;
+        }
+    }
+
+    void StatisticsCollector::finish(unsigned pageCount, double rowScale, TableStatistics &stats) {
+        stats.rowCount = (unsigned) std::lround(m_tupleCount * rowScale);
+        stats.pageCount = pageCount;
+        stats.avgRecordSize = 0 == m_tupleCount ? 0 : (float) m_tupleBytes / m_tupleCount;
+        stats.columns.clear();
+
+        for (unsigned i = 0; i < m_attrs.size(); i++) {
+            ColumnCollector &column = m_columns[i];
+            ColumnStatistics columnStats;
+            columnStats.name = m_attrs[i].name;
+            columnStats.type = m_attrs[i].type;
+
+            unsigned seen = column.nullCount + column.valueCount;
+            columnStats.nullFraction = 0 == seen ? 0 : (float) column.nullCount / seen;
+
+            if (0 != column.valueCount) {
+                columnStats.minValue = column.minValue;
+                columnStats.maxValue = column.maxValue;
+
+                double distinct = std::min(std::max(column.distinct.estimate(), 1.0), (double) column.valueCount);
+                // a sample in which nearly every value is different is taken to come from a unique column,
+                // otherwise the sample is assumed to have seen every value there is
+                if (rowScale > 1 && distinct >= 0.9 * column.valueCount) {
+                    distinct *= rowScale;
+                }
+                columnStats.distinctCount = (unsigned) std::lround(distinct);
+
+                // bounds at evenly spaced ranks of the sorted values
+                AttrType type = columnStats.type;
+                std::sort(column.reservoir.begin(), column.reservoir.end(),
+                          [type](const std::string &a, const std::string &b) {
+                              return ColumnStatistics::compareValues(type, a, b) < 0;
+                          });
+                size_t valueCount = column.reservoir.size();
+                unsigned buckets = std::max(std::min((size_t) STATS_HISTOGRAM_BUCKETS, valueCount - 1), (size_t) 1);
+                for (unsigned bucket = 0; bucket <= buckets; bucket++) {
+                    columnStats.histogramBounds.push_back(column.reservoir[bucket * (valueCount - 1) / buckets]);
+                }
+                columnStats.histogramBounds.front() = column.minValue;
+                columnStats.histogramBounds.back() = column.maxValue;
+            }
+
+            stats.columns.push_back(columnStats);
+        }
+    }
+} // namespace PeterDB
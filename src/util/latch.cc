@@ -0,0 +1,46 @@
+#include "src/include/latch.h"
+
+namespace PeterDB {
+
+    void SharedLatch::lock() {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_waitingWriters++;
+        m_released.wait(lock, [this] { return !m_writer && 0 == m_readers; });
+        m_waitingWriters--;
+        m_writer = true;
+    }
+
+    void SharedLatch::unlock() {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_writer = false;
+        }
+        m_released.notify_all();
+    }
+
+    void SharedLatch::lock_shared() {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_released.wait(lock, [this] { return !m_writer && 0 == m_waitingWriters; });
+        m_readers++;
+    }
+
+    void SharedLatch::unlock_shared() {
+        bool lastReader;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            lastReader = 0 == --m_readers;
+        }
+        if (lastReader) {
+            m_released.notify_all();
+        }
+    }
+
+    SharedLatchGuard::SharedLatchGuard(SharedLatch &latch) : m_latch(latch) {
+        m_latch.lock_shared();
+    }
+
+    SharedLatchGuard::~SharedLatchGuard() {
+        m_latch.unlock_shared();
+    }
+
+} // namespace PeterDB
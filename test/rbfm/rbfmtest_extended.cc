@@ -0,0 +1,625 @@
+#include <algorithm>
+#include <atomic>
+#include <map>
+#include <set>
+#include <thread>
+
+#include "src/include/rbfm.h"
+#include "test/utils/rbfm_test_utils.h"
+
+namespace PeterDBTesting {
+
+    TEST_F(RBFM_Test, sample_scan) {
+        // Functions tested
+        // 1. Insert records spanning many pages
+        // 2. Sample scan with a fraction of pages
+        // 3. Sample scan is repeatable for the same seed
+        // 4. Sample scan over all pages returns every record
+
+        PeterDB::RID rid;
+        size_t recordSize = 0;
+        inBuffer = malloc(1000);
+        outBuffer = malloc(1000);
+
+        std::vector<PeterDB::Attribute> recordDescriptor;
+        createRecordDescriptor(recordDescriptor);
+        nullsIndicator = initializeNullFieldsIndicator(recordDescriptor);
+
+        unsigned numRecords = 3000;
+        for (unsigned i = 0; i < numRecords; i++) {
+            prepareRecord((int) recordDescriptor.size(), nullsIndicator, 8, "Anteater", (int) i, 177.8, 6200,
+                          inBuffer, recordSize);
+            ASSERT_EQ(rbfm.insertRecord(fileHandle, recordDescriptor, inBuffer, rid), success)
+                                        << "Inserting a record should succeed.";
+        }
+
+        std::vector<std::string> attributeNames{"Age"};
+        PeterDB::RBFM_ScanIterator rbfmsi;
+
+        // sample 10% of the pages
+        ASSERT_EQ(rbfm.sampleScan(fileHandle, recordDescriptor, 0.1, 42, "", PeterDB::NO_OP, nullptr,
+                                  attributeNames, rbfmsi), success) << "Sample scan should succeed.";
+
+        unsigned dataPages = rbfmsi.getDataPageCount();
+        unsigned sampledPages = rbfmsi.getScannedPageCount();
+        ASSERT_EQ(dataPages, fileHandle.getNumberOfPages());
+        ASSERT_GT(sampledPages, 0u);
+        ASSERT_LT(sampledPages, dataPages);
+
+        std::set<unsigned> pagesSeen;
+        std::vector<unsigned> firstSample;
+        while (rbfmsi.getNextRecord(rid, outBuffer) != RBFM_EOF) {
+            ASSERT_TRUE(rbfm.isValidDataPage(fileHandle, rid.pageNum)) << "Sampled page should be a data page.";
+            pagesSeen.insert(rid.pageNum);
+            firstSample.push_back(*(unsigned *) ((char *) outBuffer + 1));
+        }
+        rbfmsi.close();
+
+        ASSERT_LE(pagesSeen.size(), sampledPages);
+
+        // records are spread evenly over the pages, so scaling the sample up should be close to the real count
+        double estimate = (double) firstSample.size() * dataPages / sampledPages;
+        ASSERT_NEAR(estimate, numRecords, numRecords * 0.1) << "Scaled sample count should approximate the real count.";
+
+        // the same seed picks the same pages
+        ASSERT_EQ(rbfm.sampleScan(fileHandle, recordDescriptor, 0.1, 42, "", PeterDB::NO_OP, nullptr,
+                                  attributeNames, rbfmsi), success) << "Sample scan should succeed.";
+        std::vector<unsigned> secondSample;
+        while (rbfmsi.getNextRecord(rid, outBuffer) != RBFM_EOF) {
+            secondSample.push_back(*(unsigned *) ((char *) outBuffer + 1));
+        }
+        rbfmsi.close();
+        ASSERT_EQ(firstSample, secondSample) << "Sample scan with the same seed should return the same records.";
+
+        // sampling all the pages returns every record, exactly once
+        ASSERT_EQ(rbfm.sampleScan(fileHandle, recordDescriptor, 1.0, 7, "", PeterDB::NO_OP, nullptr,
+                                  attributeNames, rbfmsi), success) << "Sample scan should succeed.";
+        std::set<unsigned> ages;
+        while (rbfmsi.getNextRecord(rid, outBuffer) != RBFM_EOF) {
+            ages.insert(*(unsigned *) ((char *) outBuffer + 1));
+        }
+        rbfmsi.close();
+        ASSERT_EQ(ages.size(), numRecords) << "Sampling every page should return every record.";
+
+        // an out of range fraction is rejected
+        ASSERT_NE(rbfm.sampleScan(fileHandle, recordDescriptor, 1.5, 7, "", PeterDB::NO_OP, nullptr,
+                                  attributeNames, rbfmsi), success) << "Sample fraction above 1 should fail.";
+    }
+
+    TEST_F(RBFM_Test, append_only_file_with_zone_map) {
+        // Functions tested
+        // 1. Make the file append-only with a zone map on Age
+        // 2. Insert records in Age order, the tail page is only written once it is full
+        // 3. Scan with a condition on Age only reads the matching pages
+        // 4. Delete and update are rejected
+        // 5. Records and zone map survive closing and re-opening the file
+
+        PeterDB::RID rid;
+        size_t recordSize = 0;
+        inBuffer = malloc(1000);
+        outBuffer = malloc(1000);
+
+        std::vector<PeterDB::Attribute> recordDescriptor;
+        createRecordDescriptor(recordDescriptor);
+        nullsIndicator = initializeNullFieldsIndicator(recordDescriptor);
+
+        ASSERT_NE(rbfm.enableAppendOnly(fileHandle, recordDescriptor, "EmpName"), success)
+                                    << "Zone map on a varchar attribute should fail.";
+        ASSERT_EQ(rbfm.enableAppendOnly(fileHandle, recordDescriptor, "Age"), success)
+                                    << "Making an empty file append-only should succeed.";
+        ASSERT_TRUE(rbfm.isAppendOnly(fileHandle));
+
+        unsigned readCount, writeCount, appendCount;
+        unsigned readCountAfter, writeCountAfter, appendCountAfter;
+        fileHandle.collectCounterValues(readCount, writeCount, appendCount);
+
+        unsigned numRecords = 3000;
+        PeterDB::RID firstRid;
+        for (unsigned i = 0; i < numRecords; i++) {
+            prepareRecord((int) recordDescriptor.size(), nullsIndicator, 8, "Anteater", (int) i, 177.8, 6200,
+                          inBuffer, recordSize);
+            ASSERT_EQ(rbfm.insertRecord(fileHandle, recordDescriptor, inBuffer, rid), success)
+                                        << "Inserting a record should succeed.";
+            if (0 == i) {
+                firstRid = rid;
+            }
+        }
+
+        fileHandle.collectCounterValues(readCountAfter, writeCountAfter, appendCountAfter);
+        unsigned dataPages = fileHandle.getNumberOfPages();
+        ASSERT_LE(writeCountAfter - writeCount, dataPages) << "Each data page should be written about once.";
+
+        ASSERT_NE(rbfm.deleteRecord(fileHandle, recordDescriptor, firstRid), success)
+                                    << "Deleting from an append-only file should fail.";
+        ASSERT_NE(rbfm.updateRecord(fileHandle, recordDescriptor, inBuffer, firstRid), success)
+                                    << "Updating an append-only file should fail.";
+
+        // re-open the file, so that everything is read back from disk
+        ASSERT_EQ(rbfm.closeFile(fileHandle), success);
+        ASSERT_EQ(rbfm.openFile(fileName, fileHandle), success);
+        ASSERT_TRUE(rbfm.isAppendOnly(fileHandle));
+
+        int ageLimit = 2950;
+        std::vector<std::string> attributeNames{"Age"};
+        PeterDB::RBFM_ScanIterator rbfmsi;
+        fileHandle.collectCounterValues(readCount, writeCount, appendCount);
+        ASSERT_EQ(rbfm.scan(fileHandle, recordDescriptor, "Age", PeterDB::GE_OP, &ageLimit, attributeNames, rbfmsi),
+                  success) << "Scan should succeed.";
+
+        unsigned matches = 0;
+        while (rbfmsi.getNextRecord(rid, outBuffer) != RBFM_EOF) {
+            ASSERT_GE(*(int *) ((char *) outBuffer + 1), ageLimit);
+            matches++;
+        }
+        rbfmsi.close();
+        fileHandle.collectCounterValues(readCountAfter, writeCountAfter, appendCountAfter);
+
+        ASSERT_EQ(matches, numRecords - ageLimit) << "Scan should return every matching record.";
+        ASSERT_LE(readCountAfter - readCount, 3u) << "Scan should skip the pages outside the zone.";
+
+        // a scan without a condition still reads everything
+        ASSERT_EQ(rbfm.scan(fileHandle, recordDescriptor, "", PeterDB::NO_OP, nullptr, attributeNames, rbfmsi),
+                  success) << "Scan should succeed.";
+        unsigned count = 0;
+        while (rbfmsi.getNextRecord(rid, outBuffer) != RBFM_EOF) {
+            count++;
+        }
+        rbfmsi.close();
+        ASSERT_EQ(count, numRecords);
+    }
+
+    TEST_F(RBFM_Test, concurrent_readers_scans_and_inserts) {
+        // Functions tested
+        // 1. Insert records spanning many pages
+        // 2. Read records and scan the file from several threads, while another thread inserts
+        // 3. Every thread sees the records inserted before it started, with their values
+        // 4. The file holds every record afterwards
+
+        PeterDB::RID rid;
+        size_t recordSize = 0;
+        inBuffer = malloc(1000);
+
+        std::vector<PeterDB::Attribute> recordDescriptor;
+        createRecordDescriptor(recordDescriptor);
+        nullsIndicator = initializeNullFieldsIndicator(recordDescriptor);
+
+        unsigned numRecords = 2000;
+        std::vector<PeterDB::RID> rids;
+        for (unsigned i = 0; i < numRecords; i++) {
+            prepareRecord((int) recordDescriptor.size(), nullsIndicator, 8, "Anteater", (int) i, 177.8, 6200,
+                          inBuffer, recordSize);
+            ASSERT_EQ(rbfm.insertRecord(fileHandle, recordDescriptor, inBuffer, rid), success)
+                                        << "Inserting a record should succeed.";
+            rids.push_back(rid);
+        }
+
+        unsigned numInserted = 500;
+        std::atomic<unsigned> failures(0);
+        std::vector<std::thread> threads;
+
+        // readers go through the records inserted before, each from a different place
+        for (unsigned t = 0; t < 3; t++) {
+            threads.emplace_back([&, t]() {
+                char value[PAGE_SIZE];
+                for (unsigned i = 0; i < numRecords; i++) {
+                    unsigned pos = (i + t * numRecords / 3) % numRecords;
+                    if (success != rbfm.readAttribute(fileHandle, recordDescriptor, rids[pos], "Age", value) ||
+                        pos != *(unsigned *) (value + 1)) {
+                        failures++;
+                    }
+                }
+            });
+        }
+
+        // scans see the records inserted before, and may see some of the ones inserted meanwhile
+        for (unsigned t = 0; t < 2; t++) {
+            threads.emplace_back([&]() {
+                char value[PAGE_SIZE];
+                unsigned ageThreshold = numRecords / 2;
+                PeterDB::RBFM_ScanIterator rbfmsi;
+                PeterDB::RID scanRid;
+                if (success != rbfm.scan(fileHandle, recordDescriptor, "Age", PeterDB::GE_OP, &ageThreshold,
+                                         {"Age"}, rbfmsi)) {
+                    failures++;
+                    return;
+                }
+                std::set<unsigned> ages;
+                while (rbfmsi.getNextRecord(scanRid, value) != RBFM_EOF) {
+                    unsigned age = *(unsigned *) (value + 1);
+                    if (age < ageThreshold || !ages.insert(age).second) {
+                        failures++;
+                    }
+                }
+                rbfmsi.close();
+                for (unsigned age = ageThreshold; age < numRecords; age++) {
+                    if (0 == ages.count(age)) {
+                        failures++;
+                    }
+                }
+            });
+        }
+
+        threads.emplace_back([&]() {
+            char record[1000];
+            size_t size = 0;
+            PeterDB::RID insertedRid;
+            for (unsigned i = numRecords; i < numRecords + numInserted; i++) {
+                prepareRecord((int) recordDescriptor.size(), nullsIndicator, 8, "Anteater", (int) i, 177.8, 6200,
+                              record, size);
+                if (success != rbfm.insertRecord(fileHandle, recordDescriptor, record, insertedRid)) {
+                    failures++;
+                }
+            }
+        });
+
+        for (auto &thread : threads) {
+            thread.join();
+        }
+        ASSERT_EQ(failures.load(), 0u) << "Concurrent reads, scans and inserts should not interfere.";
+
+        // every record is found, exactly once
+        PeterDB::RBFM_ScanIterator rbfmsi;
+        outBuffer = malloc(1000);
+        ASSERT_EQ(rbfm.scan(fileHandle, recordDescriptor, "", PeterDB::NO_OP, nullptr, {"Age"}, rbfmsi), success);
+        std::set<unsigned> ages;
+        while (rbfmsi.getNextRecord(rid, outBuffer) != RBFM_EOF) {
+            ages.insert(*(unsigned *) ((char *) outBuffer + 1));
+        }
+        rbfmsi.close();
+        ASSERT_EQ(ages.size(), numRecords + numInserted) << "Every inserted record should be found.";
+    }
+
+    TEST_F(RBFM_Test, calls_on_another_file_go_on_during_a_long_insert) {
+        // Functions tested
+        // 1. A thread inserts a large batch of records into a file, in one call
+        // 2. Meanwhile, another thread inserts and reads records of another file, its calls return while
+        //    the first file is growing
+        // 3. Every record of both files is there afterwards
+
+        size_t recordSize = 0;
+        inBuffer = malloc(1000);
+        outBuffer = malloc(1000);
+        std::vector<PeterDB::Attribute> recordDescriptor;
+        createRecordDescriptor(recordDescriptor);
+        nullsIndicator = initializeNullFieldsIndicator(recordDescriptor);
+
+        std::string otherFileName = "rbfm_test_other_file";
+        PeterDB::FileHandle otherFileHandle;
+        remove(otherFileName.c_str());
+        ASSERT_EQ(rbfm.createFile(otherFileName), success) << "Creating the file should not fail.";
+        ASSERT_EQ(rbfm.openFile(otherFileName, otherFileHandle), success) << "Opening the file should not fail.";
+
+        unsigned numRecords = 50000;
+        std::vector<std::vector<char>> batch(numRecords, std::vector<char>(1000));
+        std::vector<const void *> batchData;
+        for (unsigned i = 0; i < numRecords; i++) {
+            prepareRecord((int) recordDescriptor.size(), nullsIndicator, 8, "Anteater", (int) i, 177.8, 6200,
+                          batch[i].data(), recordSize);
+            batchData.push_back(batch[i].data());
+        }
+
+        std::atomic<bool> started(false), done(false);
+        std::vector<PeterDB::RID> batchRids;
+        PeterDB::RC batchRc = -1;
+        std::thread inserter([&]() {
+            started = true;
+            batchRc = rbfm.insertRecords(fileHandle, recordDescriptor, batchData, batchRids);
+            done = true;
+        });
+
+        // the size of the first file as each call returns: the calls seeing a part of the batch written
+        // went on alongside it, not before nor after it
+        size_t sizeBefore = getFileSize(fileName);
+        std::vector<size_t> returned;
+        unsigned failures = 0, otherRecords = 0;
+        while (!started) {
+            std::this_thread::yield();
+        }
+        prepareRecord((int) recordDescriptor.size(), nullsIndicator, 8, "Anteater", -1, 177.8, 6200, inBuffer,
+                      recordSize);
+        while (!done) {
+            PeterDB::RID otherRid;
+            if (success != rbfm.insertRecord(otherFileHandle, recordDescriptor, inBuffer, otherRid) ||
+                success != rbfm.readRecord(otherFileHandle, recordDescriptor, otherRid, outBuffer) ||
+                0 != memcmp(inBuffer, outBuffer, recordSize)) {
+                failures++;
+            }
+            otherRecords++;
+            returned.push_back(getFileSize(fileName));
+        }
+        inserter.join();
+
+        ASSERT_EQ(batchRc, success) << "Inserting the batch should succeed.";
+        ASSERT_EQ(batchRids.size(), numRecords);
+        ASSERT_EQ(failures, 0u) << "Every call on the other file should succeed.";
+        size_t sizeAfter = getFileSize(fileName);
+        ASSERT_GT(std::count_if(returned.begin(), returned.end(), [&](size_t size) {
+            return size > sizeBefore && size < sizeAfter;
+        }), 10) << "Calls on another file should not wait for the batch.";
+
+        // the last record of the batch, and every record of the other file
+        ASSERT_EQ(rbfm.readRecord(fileHandle, recordDescriptor, batchRids[numRecords - 1], outBuffer), success);
+        ASSERT_EQ(memcmp(batch[numRecords - 1].data(), outBuffer, recordSize), 0);
+        PeterDB::RBFM_ScanIterator rbfmsi;
+        PeterDB::RID rid;
+        ASSERT_EQ(rbfm.scan(otherFileHandle, recordDescriptor, "", PeterDB::NO_OP, nullptr, {"Age"}, rbfmsi),
+                  success);
+        unsigned scanned = 0;
+        while (rbfmsi.getNextRecord(rid, outBuffer) != RBFM_EOF) {
+            scanned++;
+        }
+        rbfmsi.close();
+        ASSERT_EQ(scanned, otherRecords);
+
+        ASSERT_EQ(rbfm.closeFile(otherFileHandle), success) << "Closing the file should not fail.";
+        ASSERT_EQ(rbfm.destroyFile(otherFileName), success) << "Destroying the file should not fail.";
+    }
+
+    TEST_F(RBFM_Test, snapshot_scans_see_records_as_of_their_start) {
+        // Functions tested
+        // 1. Insert records, then begin a snapshot
+        // 2. Update (moving some records to other pages), delete and insert records
+        // 3. A scan of the snapshot returns the records as they were, a plain scan returns them as they are,
+        //    both under the RIDs the records were inserted with
+        // 4. A snapshot begun after the changes sees them
+
+        PeterDB::RID rid;
+        size_t recordSize = 0;
+        inBuffer = malloc(1000);
+        outBuffer = malloc(1000);
+
+        std::vector<PeterDB::Attribute> recordDescriptor;
+        createRecordDescriptor(recordDescriptor);
+        nullsIndicator = initializeNullFieldsIndicator(recordDescriptor);
+
+        unsigned numRecords = 300;
+        std::vector<PeterDB::RID> rids;
+        for (unsigned i = 0; i < numRecords; i++) {
+            prepareRecord((int) recordDescriptor.size(), nullsIndicator, 8, "Anteater", (int) i, 177.8, 6200,
+                          inBuffer, recordSize);
+            ASSERT_EQ(rbfm.insertRecord(fileHandle, recordDescriptor, inBuffer, rid), success)
+                                        << "Inserting a record should succeed.";
+            rids.push_back(rid);
+        }
+
+        PeterDB::Timestamp snapshot = rbfm.beginSnapshot();
+
+        // every third record gets a longer name, which doesn't fit into its full page, then is updated once
+        // more. the next ones are deleted, and new records are inserted
+        std::map<unsigned, unsigned> expected;
+        std::string longName(30, 'x');
+        for (unsigned i = 0; i < numRecords; i++) {
+            if (0 == i % 3) {
+                prepareRecord((int) recordDescriptor.size(), nullsIndicator, (int) longName.length(), longName,
+                              (int) (i + 1000), 177.8, 6200, inBuffer, recordSize);
+                ASSERT_EQ(rbfm.updateRecord(fileHandle, recordDescriptor, inBuffer, rids[i]), success);
+                prepareRecord((int) recordDescriptor.size(), nullsIndicator, (int) longName.length(), longName,
+                              (int) (i + 2000), 177.8, 6200, inBuffer, recordSize);
+                ASSERT_EQ(rbfm.updateRecord(fileHandle, recordDescriptor, inBuffer, rids[i]), success);
+                expected[i + 2000] = i;
+            } else if (1 == i % 3) {
+                ASSERT_EQ(rbfm.deleteRecord(fileHandle, recordDescriptor, rids[i]), success);
+            } else {
+                expected[i] = i;
+            }
+        }
+        for (unsigned i = 0; i < 100; i++) {
+            prepareRecord((int) recordDescriptor.size(), nullsIndicator, 8, "Anteater", (int) (i + 5000), 177.8, 6200,
+                          inBuffer, recordSize);
+            ASSERT_EQ(rbfm.insertRecord(fileHandle, recordDescriptor, inBuffer, rid), success);
+        }
+
+        // the snapshot, with a condition on the values it sees
+        PeterDB::RBFM_ScanIterator rbfmsi;
+        unsigned ageThreshold = numRecords / 2;
+        ASSERT_EQ(rbfm.scan(fileHandle, recordDescriptor, "Age", PeterDB::LT_OP, &ageThreshold, {"Age"}, rbfmsi),
+                  success);
+        rbfmsi.setSnapshot(snapshot);
+        std::set<unsigned> ages;
+        while (rbfmsi.getNextRecord(rid, outBuffer) != RBFM_EOF) {
+            unsigned age = *(unsigned *) ((char *) outBuffer + 1);
+            ASSERT_LT(age, ageThreshold);
+            ASSERT_EQ(rid.pageNum, rids[age].pageNum) << "The record should be returned under its own RID.";
+            ASSERT_EQ(rid.slotNum, rids[age].slotNum) << "The record should be returned under its own RID.";
+            ASSERT_TRUE(ages.insert(age).second) << "Every record should be returned once.";
+        }
+        rbfmsi.close();
+        ASSERT_EQ(ages.size(), ageThreshold) << "The snapshot should see the records as they were.";
+
+        // the records as they are, but for the ones inserted last
+        ageThreshold = 5000;
+        ASSERT_EQ(rbfm.scan(fileHandle, recordDescriptor, "Age", PeterDB::LT_OP, &ageThreshold, {"Age"}, rbfmsi),
+                  success);
+        unsigned returned = 0;
+        while (rbfmsi.getNextRecord(rid, outBuffer) != RBFM_EOF) {
+            unsigned age = *(unsigned *) ((char *) outBuffer + 1);
+            ASSERT_EQ(expected.count(age), 1u) << "Age " << age << " should not be there any more.";
+            ASSERT_EQ(rid.pageNum, rids[expected[age]].pageNum) << "The record should be returned under its own RID.";
+            ASSERT_EQ(rid.slotNum, rids[expected[age]].slotNum) << "The record should be returned under its own RID.";
+            returned++;
+        }
+        rbfmsi.close();
+        ASSERT_EQ(returned, (unsigned) expected.size()) << "A scan should see the records as they are.";
+        rbfm.endSnapshot(snapshot);
+
+        // the moved records read through their tombstones
+        ASSERT_EQ(rbfm.readRecord(fileHandle, recordDescriptor, rids[3], outBuffer), success);
+        prepareRecord((int) recordDescriptor.size(), nullsIndicator, (int) longName.length(), longName, 2003, 177.8,
+                      6200, inBuffer, recordSize);
+        ASSERT_EQ(memcmp(inBuffer, outBuffer, recordSize), 0) << "The moved record should read as updated.";
+
+        // a snapshot begun now sees the changes, and not the records deleted after it
+        snapshot = rbfm.beginSnapshot();
+        ASSERT_EQ(rbfm.deleteRecord(fileHandle, recordDescriptor, rids[3]), success);
+        ASSERT_EQ(rbfm.scan(fileHandle, recordDescriptor, "", PeterDB::NO_OP, nullptr, {"Age"}, rbfmsi), success);
+        rbfmsi.setSnapshot(snapshot);
+        returned = 0;
+        while (rbfmsi.getNextRecord(rid, outBuffer) != RBFM_EOF) {
+            returned++;
+        }
+        rbfmsi.close();
+        rbfm.endSnapshot(snapshot);
+        ASSERT_EQ(returned, (unsigned) expected.size() + 100) << "The snapshot should see the earlier changes.";
+    }
+
+    TEST_F(RBFM_Test_2, open_and_close_touch_only_changed_metadata) {
+        // Functions tested
+        // 1. Insert records filling more pages than one hidden page keeps track of
+        // 2. Re-opening the file only reads the metadata page
+        // 3. Closing an unchanged file writes nothing
+        // 4. After a delete and an insert, only the changed pages are written back
+
+        PeterDB::RID rid;
+        size_t recordSize = 0;
+        inBuffer = malloc(3000);
+        outBuffer = malloc(3000);
+
+        std::vector<PeterDB::Attribute> recordDescriptor;
+        createLargeRecordDescriptor4(recordDescriptor);
+        nullsIndicator = initializeNullFieldsIndicator(recordDescriptor);
+
+        // each record takes a page of its own
+        unsigned numRecords = 1200;
+        PeterDB::RID firstRid;
+        for (unsigned i = 0; i < numRecords; i++) {
+            prepareLargeRecord4((int) recordDescriptor.size(), nullsIndicator, 2061, inBuffer, recordSize);
+            ASSERT_EQ(rbfm.insertRecord(fileHandle, recordDescriptor, inBuffer, rid), success)
+                                        << "Inserting a record should succeed.";
+            if (0 == i) {
+                firstRid = rid;
+            }
+        }
+        ASSERT_EQ(fileHandle.getNumberOfPages(), numRecords);
+
+        unsigned readCount, writeCount, appendCount;
+        unsigned readCountAfter, writeCountAfter, appendCountAfter;
+
+        fileHandle.collectCounterValues(readCount, writeCount, appendCount);
+        ASSERT_EQ(rbfm.closeFile(fileHandle), success);
+        ASSERT_EQ(rbfm.openFile(fileName, fileHandle), success);
+        fileHandle.collectCounterValues(readCountAfter, writeCountAfter, appendCountAfter);
+        ASSERT_EQ(readCountAfter - readCount, 1u) << "Opening the file should only read the metadata page.";
+        ASSERT_EQ(fileHandle.getNumberOfPages(), numRecords);
+
+        fileHandle.collectCounterValues(readCount, writeCount, appendCount);
+        ASSERT_EQ(rbfm.closeFile(fileHandle), success);
+        ASSERT_EQ(rbfm.openFile(fileName, fileHandle), success);
+        fileHandle.collectCounterValues(readCountAfter, writeCountAfter, appendCountAfter);
+        ASSERT_EQ(writeCountAfter - writeCount, 0u) << "Closing an unchanged file should write nothing.";
+
+        // the freed page is found again, without appending a new one
+        ASSERT_EQ(rbfm.deleteRecord(fileHandle, recordDescriptor, firstRid), success)
+                                    << "Deleting a record should succeed.";
+        ASSERT_EQ(rbfm.insertRecord(fileHandle, recordDescriptor, inBuffer, rid), success)
+                                    << "Inserting a record should succeed.";
+        ASSERT_EQ(rid.pageNum, firstRid.pageNum) << "The record should go to the page freed by the delete.";
+        ASSERT_EQ(fileHandle.getNumberOfPages(), numRecords);
+
+        // two data page writes, then one hidden page and the metadata page on close
+        fileHandle.collectCounterValues(readCount, writeCount, appendCount);
+        ASSERT_EQ(rbfm.closeFile(fileHandle), success);
+        ASSERT_EQ(rbfm.openFile(fileName, fileHandle), success);
+        fileHandle.collectCounterValues(readCountAfter, writeCountAfter, appendCountAfter);
+        ASSERT_EQ(writeCountAfter - writeCount, 2u) << "Closing should only write the changed metadata pages.";
+
+        ASSERT_EQ(rbfm.readRecord(fileHandle, recordDescriptor, rid, outBuffer), success)
+                                    << "Reading a record should succeed.";
+        ASSERT_EQ(memcmp(inBuffer, outBuffer, recordSize), 0);
+    }
+
+    TEST_F(RBFM_Test_2, older_metadata_page_is_converted_on_open) {
+        // Functions tested
+        // 1. Insert records filling more pages than one hidden page keeps track of
+        // 2. Rewrite the metadata page in the older layout, [count][pageNum...] of the hidden pages
+        // 3. Opening the file converts it, and every record is still read
+        // 4. Inserts after the conversion, and re-opening the converted file
+        // 5. A metadata page in no known layout fails the open, instead of aborting
+
+        PeterDB::RID rid;
+        size_t recordSize = 0;
+        inBuffer = malloc(3000);
+        outBuffer = malloc(3000);
+
+        std::vector<PeterDB::Attribute> recordDescriptor;
+        createLargeRecordDescriptor4(recordDescriptor);
+        nullsIndicator = initializeNullFieldsIndicator(recordDescriptor);
+
+        // each record takes a page of its own
+        unsigned numRecords = 1200;
+        std::vector<PeterDB::RID> rids;
+        for (unsigned i = 0; i < numRecords; i++) {
+            prepareLargeRecord4((int) recordDescriptor.size(), nullsIndicator, 2061, inBuffer, recordSize);
+            ASSERT_EQ(rbfm.insertRecord(fileHandle, recordDescriptor, inBuffer, rid), success)
+                                        << "Inserting a record should succeed.";
+            rids.push_back(rid);
+        }
+        ASSERT_EQ(rbfm.closeFile(fileHandle), success);
+
+        // the older layout lists the hidden pages in the metadata page, and its entries have no record counts
+        PeterDB::PagedFileManager &pfm = PeterDB::PagedFileManager::instance();
+        PeterDB::FileHandle pfHandle;
+        ASSERT_EQ(pfm.openFile(fileName, pfHandle), success);
+
+        std::vector<uint32_t> metadata(PAGE_SIZE / sizeof(uint32_t));
+        std::vector<uint32_t> page(PAGE_SIZE / sizeof(uint32_t));
+        ASSERT_EQ(pfHandle.readPage(PAGE_OCCUPANCY_METADATA_PAGE, metadata.data()), success);
+        ASSERT_EQ(metadata[1], 0u) << "The directory should fit in the metadata page.";
+
+        unsigned numHiddenPages = metadata[0];
+        ASSERT_EQ(numHiddenPages, 3u);
+        std::vector<uint32_t> olderMetadata(PAGE_SIZE / sizeof(uint32_t), 0);
+        olderMetadata[0] = numHiddenPages;
+        for (unsigned i = 0; i < numHiddenPages; i++) {
+            PeterDB::OccupancyPageSummary summary;
+            memcpy(&summary, (char*) metadata.data() + 2 * sizeof(uint32_t) + i * sizeof(summary), sizeof(summary));
+            olderMetadata[1 + i] = summary.pageNum;
+
+            ASSERT_EQ(pfHandle.readPage(summary.pageNum, page.data()), success);
+            PeterDB::PageOccupancy *entries = (PeterDB::PageOccupancy*) (page.data() + 1);
+            for (unsigned j = 0; j < page[0]; j++) {
+                entries[j].recordCount = 0;
+            }
+            ASSERT_EQ(pfHandle.writePage(summary.pageNum, page.data()), success);
+        }
+        ASSERT_EQ(pfHandle.writePage(PAGE_OCCUPANCY_METADATA_PAGE, olderMetadata.data()), success);
+        ASSERT_EQ(pfm.closeFile(pfHandle), success);
+
+        ASSERT_EQ(rbfm.openFile(fileName, fileHandle), success) << "Opening a file in the older layout should succeed.";
+        ASSERT_EQ(fileHandle.getNumberOfPages(), numRecords);
+        for (auto &r : rids) {
+            ASSERT_EQ(rbfm.readRecord(fileHandle, recordDescriptor, r, outBuffer), success)
+                                        << "Reading a record should succeed.";
+            ASSERT_EQ(memcmp(inBuffer, outBuffer, recordSize), 0);
+        }
+
+        ASSERT_EQ(rbfm.insertRecord(fileHandle, recordDescriptor, inBuffer, rid), success)
+                                    << "Inserting a record should succeed.";
+        ASSERT_EQ(rid.pageNum, numRecords + numHiddenPages + 1) << "The record should go to a page appended after the others.";
+        ASSERT_EQ(rbfm.closeFile(fileHandle), success);
+
+        ASSERT_EQ(rbfm.openFile(fileName, fileHandle), success) << "Opening the converted file should succeed.";
+        ASSERT_EQ(fileHandle.getNumberOfPages(), numRecords + 1);
+        ASSERT_EQ(rbfm.readRecord(fileHandle, recordDescriptor, rid, outBuffer), success)
+                                    << "Reading a record should succeed.";
+        ASSERT_EQ(memcmp(inBuffer, outBuffer, recordSize), 0);
+        ASSERT_EQ(rbfm.closeFile(fileHandle), success);
+
+        // a list of more hidden pages than the file has
+        ASSERT_EQ(pfm.openFile(fileName, pfHandle), success);
+        ASSERT_EQ(pfHandle.readPage(PAGE_OCCUPANCY_METADATA_PAGE, metadata.data()), success);
+        std::vector<uint32_t> corruptMetadata(PAGE_SIZE / sizeof(uint32_t), 0);
+        corruptMetadata[0] = 5;
+        corruptMetadata[1] = 1;
+        corruptMetadata[2] = 256;
+        ASSERT_EQ(pfHandle.writePage(PAGE_OCCUPANCY_METADATA_PAGE, corruptMetadata.data()), success);
+        ASSERT_EQ(pfm.closeFile(pfHandle), success);
+
+        ASSERT_NE(rbfm.openFile(fileName, fileHandle), success) << "Opening a file in no known layout should fail.";
+
+        ASSERT_EQ(pfm.openFile(fileName, pfHandle), success);
+        ASSERT_EQ(pfHandle.writePage(PAGE_OCCUPANCY_METADATA_PAGE, metadata.data()), success);
+        ASSERT_EQ(pfm.closeFile(pfHandle), success);
+        ASSERT_EQ(rbfm.openFile(fileName, fileHandle), success);
+    }
+
+} // namespace PeterDBTesting
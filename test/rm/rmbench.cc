@@ -0,0 +1,199 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <future>
+#include <iostream>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "src/include/asyncRelationManager.h"
+#include "src/include/rm.h"
+
+// Throughput of RelationManager calls made by several threads at once. Nothing is checked, the numbers
+// are printed: they only show calls going on side by side on a machine with as many cores as threads,
+// on a single core the threads take turns whatever RelationManager does.
+namespace PeterDBBench {
+
+    const unsigned TUPLES_PER_WRITER = 20000;
+    const unsigned MAX_WRITERS = 8;
+    const unsigned BATCH_TUPLES = 50000;
+    const unsigned READ_TUPLES = 50000;
+
+    std::vector<PeterDB::Attribute> benchAttributes() {
+        return {PeterDB::Attribute{"name", PeterDB::TypeVarChar, 50}, PeterDB::Attribute{"age", PeterDB::TypeInt, 4}};
+    }
+
+    // a tuple of benchAttributes(), in the format RelationManager takes
+    std::vector<char> benchTuple(int age) {
+        std::string name = "Anteater";
+        unsigned length = name.size();
+        std::vector<char> tuple(1 + sizeof(length) + length + sizeof(age), 0);
+        memcpy(&tuple[1], &length, sizeof(length));
+        memcpy(&tuple[1 + sizeof(length)], name.data(), length);
+        memcpy(&tuple[1 + sizeof(length) + length], &age, sizeof(age));
+        return tuple;
+    }
+
+    double secondsSince(std::chrono::steady_clock::time_point start) {
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    // inserts per second of writers threads, each inserting TUPLES_PER_WRITER tuples one call at a time,
+    // writer w into tables[w % tables.size()]
+    double insertRate(unsigned writers, const std::vector<std::string> &tables) {
+        PeterDB::RelationManager &rm = PeterDB::RelationManager::instance();
+        std::atomic<unsigned> failures(0);
+        auto start = std::chrono::steady_clock::now();
+        std::vector<std::thread> threads;
+        for (unsigned w = 0; w < writers; w++) {
+            threads.emplace_back([&, w]() {
+                std::vector<char> tuple = benchTuple((int) w);
+                PeterDB::RID rid;
+                for (unsigned i = 0; i < TUPLES_PER_WRITER; i++) {
+                    if (0 != rm.insertTuple(tables[w % tables.size()], tuple.data(), rid)) {
+                        failures++;
+                    }
+                }
+            });
+        }
+        for (auto &thread : threads) {
+            thread.join();
+        }
+        double seconds = secondsSince(start);
+        if (0 != failures) {
+            std::cerr << failures << " inserts failed" << std::endl;
+        }
+        return writers * TUPLES_PER_WRITER / seconds;
+    }
+
+    // the longest a single insert into tables[1] takes while a batch of BATCH_TUPLES tuples goes into
+    // tables[0], in one call, and how long the batch takes
+    void sideCallLatency(const std::vector<std::string> &tables, double &longestCall, double &batchSeconds) {
+        PeterDB::RelationManager &rm = PeterDB::RelationManager::instance();
+        std::vector<std::vector<char>> batch;
+        std::vector<const void *> batchData;
+        for (unsigned i = 0; i < BATCH_TUPLES; i++) {
+            batch.push_back(benchTuple((int) i));
+        }
+        for (auto &tuple : batch) {
+            batchData.push_back(tuple.data());
+        }
+
+        std::atomic<bool> done(false);
+        std::thread inserter([&]() {
+            std::vector<PeterDB::RID> rids;
+            auto start = std::chrono::steady_clock::now();
+            if (0 != rm.insertTuples(tables[0], batchData, rids)) {
+                std::cerr << "The batch insert failed" << std::endl;
+            }
+            batchSeconds = secondsSince(start);
+            done = true;
+        });
+
+        longestCall = 0;
+        std::vector<char> tuple = benchTuple(0);
+        PeterDB::RID rid;
+        while (!done) {
+            auto start = std::chrono::steady_clock::now();
+            rm.insertTuple(tables[1], tuple.data(), rid);
+            longestCall = std::max(longestCall, secondsSince(start));
+        }
+        inserter.join();
+    }
+
+    // reads per second of every tuple of rids, in the order given: synchronously when outstanding is 0,
+    // otherwise through an AsyncRelationManager with that many reads waited for at once. reads per
+    // batch tells how many reads a readTuples() call served on average
+    double readRate(const std::string &table, const std::vector<PeterDB::RID> &rids, unsigned outstanding,
+                    unsigned workers, double &readsPerBatch) {
+        PeterDB::RelationManager &rm = PeterDB::RelationManager::instance();
+        auto start = std::chrono::steady_clock::now();
+        readsPerBatch = 1;
+        if (0 == outstanding) {
+            std::vector<char> tuple(100);
+            for (auto &rid : rids) {
+                rm.readTuple(table, rid, tuple.data());
+            }
+            return rids.size() / secondsSince(start);
+        }
+
+        PeterDB::AsyncRelationManager async(workers);
+        std::vector<std::future<PeterDB::RC>> pending(outstanding);
+        std::vector<std::vector<char>> buffers(outstanding, std::vector<char>(100));
+        for (unsigned n = 0; n < rids.size() + outstanding; n++) {
+            // the read made outstanding reads ago is waited for, then its slot gets the next read
+            unsigned slot = n % outstanding;
+            if (n >= outstanding) {
+                pending[slot].get();
+            }
+            if (n < rids.size()) {
+                pending[slot] = async.readTupleAsync(table, rids[n], buffers[slot].data());
+            }
+        }
+        double seconds = secondsSince(start);
+        readsPerBatch = async.getBatchedReadCount() / (double) async.getBatchCount();
+        return rids.size() / seconds;
+    }
+}
+
+int main() {
+    using namespace PeterDBBench;
+    PeterDB::RelationManager &rm = PeterDB::RelationManager::instance();
+    rm.deleteCatalog();
+    if (0 != rm.createCatalog()) {
+        std::cerr << "Error while creating the catalog" << std::endl;
+        return 1;
+    }
+
+    // every table is known to RelationManager before the clock starts
+    std::vector<std::string> tables;
+    std::vector<char> tuple = benchTuple(0);
+    PeterDB::RID rid;
+    for (unsigned t = 0; t < MAX_WRITERS; t++) {
+        tables.push_back("rm_bench_" + std::to_string(t));
+        rm.deleteTable(tables.back());
+        if (0 != rm.createTable(tables.back(), benchAttributes()) ||
+            0 != rm.insertTuple(tables.back(), tuple.data(), rid)) {
+            std::cerr << "Error while creating table " << tables.back() << std::endl;
+            return 1;
+        }
+    }
+
+    std::cout << std::thread::hardware_concurrency() << " hardware thread(s)" << std::endl;
+    for (unsigned writers = 1; writers <= MAX_WRITERS; writers *= 2) {
+        double oneTable = insertRate(writers, {tables[0]});
+        double tableEach = insertRate(writers, std::vector<std::string>(tables.begin(), tables.begin() + writers));
+        std::cout << writers << " writer(s): " << (unsigned) oneTable << " inserts/s into one table, "
+                  << (unsigned) tableEach << " inserts/s into a table each" << std::endl;
+    }
+
+    double longestCall = 0, batchSeconds = 0;
+    sideCallLatency(tables, longestCall, batchSeconds);
+    std::cout << "insert of " << BATCH_TUPLES << " tuples in one call: " << batchSeconds * 1000
+              << " ms, longest insert into another table meanwhile: " << longestCall * 1000 << " ms" << std::endl;
+
+    // reads of every tuple of a table, in an order spread over its pages
+    std::vector<PeterDB::RID> rids;
+    std::vector<const void *> data(READ_TUPLES, tuple.data());
+    rm.insertTuples(tables[2], data, rids);
+    std::shuffle(rids.begin(), rids.end(), std::default_random_engine(44));
+    double readsPerBatch = 0;
+    std::cout << "synchronous reads: " << (unsigned) readRate(tables[2], rids, 0, 0, readsPerBatch)
+              << " reads/s" << std::endl;
+    for (unsigned workers : {1u, (unsigned) ASYNC_RM_WORKERS}) {
+        for (unsigned outstanding : {1u, 8u, 64u}) {
+            double rate = readRate(tables[2], rids, outstanding, workers, readsPerBatch);
+            std::cout << "asynchronous reads, " << workers << " worker(s), " << outstanding << " outstanding: "
+                      << (unsigned) rate << " reads/s, " << readsPerBatch << " reads per batch" << std::endl;
+        }
+    }
+
+    for (auto &table : tables) {
+        rm.deleteTable(table);
+    }
+    rm.deleteCatalog();
+    return 0;
+}
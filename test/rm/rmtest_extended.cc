@@ -0,0 +1,2821 @@
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <random>
+#include <thread>
+
+#include "src/include/asyncRelationManager.h"
+#include "src/include/externalSorter.h"
+#include "test/utils/rm_test_util.h"
+
+namespace PeterDBTesting {
+
+    // sum of the read, write and append counters of a file, as of its last close
+    unsigned catalogFileIO(const std::string &fileName) {
+        PeterDB::RecordBasedFileManager &rbfm = PeterDB::RecordBasedFileManager::instance();
+        PeterDB::FileHandle fileHandle;
+        unsigned readCount = 0, writeCount = 0, appendCount = 0;
+
+        EXPECT_EQ(rbfm.openFile(fileName, fileHandle), success);
+        fileHandle.collectCounterValues(readCount, writeCount, appendCount);
+        EXPECT_EQ(rbfm.closeFile(fileHandle), success);
+
+        return readCount + writeCount + appendCount;
+    }
+
+    TEST_F(RM_Tuple_Test, point_operations_do_not_read_the_catalog) {
+        // Functions tested
+        // 1. Insert and read tuples, the catalog is read only for the first one
+        // 2. Create an index, later inserts go to the index
+        // 3. Destroy the index, later inserts still succeed
+
+        size_t tupleSize = 0;
+        inBuffer = malloc(200);
+        outBuffer = malloc(200);
+
+        ASSERT_EQ(rm.getAttributes(tableName, attrs), success) << "RelationManager::getAttributes() should succeed.";
+        nullsIndicator = initializeNullFieldsIndicator(attrs);
+
+        std::string name = "Peter Anteater";
+        prepareTuple((int) attrs.size(), nullsIndicator, name.length(), name, 27, 169.2, 9999.99, inBuffer,
+                     tupleSize);
+        ASSERT_EQ(rm.insertTuple(tableName, inBuffer, rid), success);
+
+        // opening and closing a catalog file to look at its counters costs some I/O of its own
+        unsigned tablesIO = catalogFileIO("Tables");
+        unsigned attributesIO = catalogFileIO("Columns");
+        unsigned tablesOverhead = catalogFileIO("Tables") - tablesIO;
+        unsigned attributesOverhead = catalogFileIO("Columns") - attributesIO;
+        tablesIO = catalogFileIO("Tables");
+        attributesIO = catalogFileIO("Columns");
+
+        for (unsigned i = 0; i < 100; i++) {
+            prepareTuple((int) attrs.size(), nullsIndicator, name.length(), name, 28 + i, 169.2, 9999.99, inBuffer,
+                         tupleSize);
+            ASSERT_EQ(rm.insertTuple(tableName, inBuffer, rid), success);
+            ASSERT_EQ(rm.readTuple(tableName, rid, outBuffer), success);
+            ASSERT_EQ(memcmp(inBuffer, outBuffer, tupleSize), 0);
+        }
+
+        ASSERT_EQ(catalogFileIO("Tables") - tablesIO, tablesOverhead)
+                                    << "Inserting and reading tuples should not touch the Tables table.";
+        ASSERT_EQ(catalogFileIO("Columns") - attributesIO, attributesOverhead)
+                                    << "Inserting and reading tuples should not touch the Columns table.";
+
+        // an index created after the table was used is still kept up to date
+        ASSERT_EQ(rm.createIndex(tableName, "age"), success) << "RelationManager::createIndex() should succeed.";
+
+        int age = 500;
+        prepareTuple((int) attrs.size(), nullsIndicator, name.length(), name, age, 169.2, 9999.99, inBuffer,
+                     tupleSize);
+        PeterDB::RID insertedRid;
+        ASSERT_EQ(rm.insertTuple(tableName, inBuffer, insertedRid), success);
+
+        PeterDB::RM_IndexScanIterator rmisi;
+        ASSERT_EQ(rm.indexScan(tableName, "age", &age, &age, true, true, rmisi), success);
+        int key;
+        ASSERT_EQ(rmisi.getNextEntry(rid, &key), success) << "The new tuple should be in the index.";
+        ASSERT_EQ(rid.pageNum, insertedRid.pageNum);
+        ASSERT_EQ(rid.slotNum, insertedRid.slotNum);
+        ASSERT_EQ(rmisi.getNextEntry(rid, &key), RM_EOF);
+        rmisi.close();
+
+        ASSERT_EQ(rm.destroyIndex(tableName, "age"), success) << "RelationManager::destroyIndex() should succeed.";
+        ASSERT_EQ(rm.insertTuple(tableName, inBuffer, rid), success)
+                                    << "Inserting after the index is destroyed should succeed.";
+    }
+
+    TEST_F(RM_Tuple_Test, table_file_stays_open_across_calls) {
+        // Functions tested
+        // 1. Each single-row insert writes just the data page
+        // 2. Tables beyond the open file limit are closed and re-opened transparently
+        // 3. Checkpoint succeeds, tuples can be read back
+
+        size_t tupleSize = 0;
+        inBuffer = malloc(200);
+        outBuffer = malloc(200);
+
+        ASSERT_EQ(rm.getAttributes(tableName, attrs), success) << "RelationManager::getAttributes() should succeed.";
+        nullsIndicator = initializeNullFieldsIndicator(attrs);
+
+        std::string name = "Peter Anteater";
+        prepareTuple((int) attrs.size(), nullsIndicator, name.length(), name, 27, 169.2, 9999.99, inBuffer,
+                     tupleSize);
+        ASSERT_EQ(rm.insertTuple(tableName, inBuffer, rid), success);
+
+        PeterDB::FileHandle *fileHandle = nullptr;
+        std::vector<PeterDB::Attribute> tableAttrs;
+        unsigned readCount, writeCount, appendCount;
+        unsigned readCountAfter, writeCountAfter, appendCountAfter;
+
+        std::vector<PeterDB::RID> rids;
+        for (unsigned i = 0; i < 50; i++) {
+            ASSERT_EQ(rm.getFileHandleAndAttributes(tableName, fileHandle, tableAttrs), success);
+            fileHandle->collectCounterValues(readCount, writeCount, appendCount);
+            rm.releaseFileHandle(tableName);
+
+            ASSERT_EQ(rm.insertTuple(tableName, inBuffer, rid), success);
+            rids.push_back(rid);
+
+            ASSERT_EQ(rm.getFileHandleAndAttributes(tableName, fileHandle, tableAttrs), success);
+            fileHandle->collectCounterValues(readCountAfter, writeCountAfter, appendCountAfter);
+            rm.releaseFileHandle(tableName);
+
+            ASSERT_EQ(writeCountAfter - writeCount + appendCountAfter - appendCount, 1u)
+                                        << "Inserting a tuple should write a single page.";
+        }
+
+        // more tables than are kept open
+        std::vector<std::string> otherTables;
+        for (unsigned i = 0; i < MAX_OPEN_TABLE_HANDLES + 5; i++) {
+            std::string otherTable = "rm_open_table_" + std::to_string(i);
+            remove(otherTable.c_str());
+            ASSERT_EQ(rm.createTable(otherTable, attrs), success);
+            ASSERT_EQ(rm.insertTuple(otherTable, inBuffer, rid), success);
+            otherTables.push_back(otherTable);
+        }
+
+        ASSERT_EQ(rm.checkpoint(), success) << "RelationManager::checkpoint() should succeed.";
+
+        for (auto &otherTable : otherTables) {
+            ASSERT_EQ(rm.readTuple(otherTable, rid, outBuffer), success);
+            ASSERT_EQ(memcmp(inBuffer, outBuffer, tupleSize), 0);
+            ASSERT_EQ(rm.deleteTable(otherTable), success);
+        }
+
+        for (auto &insertedRid : rids) {
+            ASSERT_EQ(rm.readTuple(tableName, insertedRid, outBuffer), success);
+            ASSERT_EQ(memcmp(inBuffer, outBuffer, tupleSize), 0);
+        }
+    }
+
+    TEST_F(RM_Tuple_Test, indexes_are_kept_in_the_catalog) {
+        // Functions tested
+        // 1. Indexes system table is part of the catalog
+        // 2. createIndex and destroyIndex add and remove its rows
+        // 3. Indexes table can't be modified by a user call
+
+        inBuffer = malloc(200);
+        outBuffer = malloc(200);
+
+        std::vector<PeterDB::Attribute> indexesAttrs;
+        ASSERT_EQ(rm.getAttributes("Indexes", indexesAttrs), success)
+                                    << "RelationManager::getAttributes() should succeed.";
+        ASSERT_EQ(indexesAttrs.size(), 4u);
+        ASSERT_EQ(indexesAttrs[0].name, "table-id");
+        ASSERT_EQ(indexesAttrs[1].name, "column-name");
+        ASSERT_EQ(indexesAttrs[2].name, "file-name");
+        ASSERT_EQ(indexesAttrs[3].name, "included-columns");
+
+        ASSERT_EQ(rm.createIndex(tableName, "age"), success) << "RelationManager::createIndex() should succeed.";
+        ASSERT_EQ(rm.createIndex(tableName, "height"), success) << "RelationManager::createIndex() should succeed.";
+        ASSERT_NE(rm.createIndex(tableName, "age"), success) << "Creating the same index twice should fail.";
+
+        std::vector<std::string> projected{"column-name"};
+        PeterDB::RM_ScanIterator rmsi;
+        ASSERT_EQ(rm.scan("Indexes", "", PeterDB::NO_OP, nullptr, projected, rmsi), success);
+        std::set<std::string> indexedColumns;
+        while (rmsi.getNextTuple(rid, outBuffer) != RM_EOF) {
+            unsigned length = *(unsigned *) ((char *) outBuffer + 1);
+            indexedColumns.insert(std::string((char *) outBuffer + 1 + 4, length));
+        }
+        rmsi.close();
+        ASSERT_EQ(indexedColumns, std::set<std::string>({"age", "height"}));
+
+        ASSERT_EQ(rm.destroyIndex(tableName, "age"), success) << "RelationManager::destroyIndex() should succeed.";
+        ASSERT_NE(rm.destroyIndex(tableName, "age"), success) << "Destroying a missing index should fail.";
+
+        ASSERT_EQ(rm.scan("Indexes", "", PeterDB::NO_OP, nullptr, projected, rmsi), success);
+        indexedColumns.clear();
+        while (rmsi.getNextTuple(rid, outBuffer) != RM_EOF) {
+            unsigned length = *(unsigned *) ((char *) outBuffer + 1);
+            indexedColumns.insert(std::string((char *) outBuffer + 1 + 4, length));
+        }
+        rmsi.close();
+        ASSERT_EQ(indexedColumns, std::set<std::string>({"height"}));
+
+        ASSERT_NE(rm.insertTuple("Indexes", inBuffer, rid), success)
+                                    << "The system catalog should not be modified by a user call.";
+        ASSERT_NE(rm.deleteTable("Indexes"), success)
+                                    << "The system catalog should not be deleted by a user call.";
+    }
+
+    TEST_F(RM_Tuple_Test, index_files_stay_open_across_calls) {
+        // Functions tested
+        // 1. Each single-row insert into an indexed table only reads and writes the index leaf
+        // 2. Root pointer changes are written out on checkpoint
+        // 3. Index can be scanned through another handle after the checkpoint
+
+        size_t tupleSize = 0;
+        inBuffer = malloc(200);
+        outBuffer = malloc(200);
+
+        ASSERT_EQ(rm.getAttributes(tableName, attrs), success) << "RelationManager::getAttributes() should succeed.";
+        nullsIndicator = initializeNullFieldsIndicator(attrs);
+        ASSERT_EQ(rm.createIndex(tableName, "age"), success) << "RelationManager::createIndex() should succeed.";
+
+        std::string name = "Peter Anteater";
+        prepareTuple((int) attrs.size(), nullsIndicator, name.length(), name, 0, 169.2, 9999.99, inBuffer,
+                     tupleSize);
+        ASSERT_EQ(rm.insertTuple(tableName, inBuffer, rid), success);
+
+        PeterDB::FileHandle *fileHandle = nullptr;
+        PeterDB::IXFileHandle *ixFileHandle = nullptr;
+        std::vector<PeterDB::Attribute> tableAttrs;
+        unsigned readCount, writeCount, appendCount;
+        unsigned readCountAfter, writeCountAfter, appendCountAfter;
+
+        unsigned numTuples = 1;
+        for (; numTuples < 50; numTuples++) {
+            ASSERT_EQ(rm.getFileHandleAndAttributes(tableName, fileHandle, tableAttrs), success);
+            ASSERT_EQ(rm.getIndexFileHandle(tableName, "age", ixFileHandle), success);
+            ixFileHandle->collectCounterValues(readCount, writeCount, appendCount);
+            rm.releaseFileHandle(tableName);
+
+            prepareTuple((int) attrs.size(), nullsIndicator, name.length(), name, (int) numTuples, 169.2, 9999.99,
+                         inBuffer, tupleSize);
+            ASSERT_EQ(rm.insertTuple(tableName, inBuffer, rid), success);
+
+            ASSERT_EQ(rm.getFileHandleAndAttributes(tableName, fileHandle, tableAttrs), success);
+            ASSERT_EQ(rm.getIndexFileHandle(tableName, "age", ixFileHandle), success);
+            ixFileHandle->collectCounterValues(readCountAfter, writeCountAfter, appendCountAfter);
+            rm.releaseFileHandle(tableName);
+
+            ASSERT_EQ(readCountAfter - readCount, 1u) << "Inserting a tuple should only read the index leaf.";
+            ASSERT_EQ(writeCountAfter - writeCount, 1u) << "Inserting a tuple should only write the index leaf.";
+            ASSERT_EQ(appendCountAfter - appendCount, 0u);
+        }
+
+        // enough entries to split the root
+        for (; numTuples < 3000; numTuples++) {
+            prepareTuple((int) attrs.size(), nullsIndicator, name.length(), name, (int) numTuples, 169.2, 9999.99,
+                         inBuffer, tupleSize);
+            ASSERT_EQ(rm.insertTuple(tableName, inBuffer, rid), success);
+        }
+        ASSERT_EQ(rm.checkpoint(), success) << "RelationManager::checkpoint() should succeed.";
+
+        PeterDB::IndexManager &ix = PeterDB::IndexManager::instance();
+        PeterDB::IXFileHandle otherIxFileHandle;
+        PeterDB::IX_ScanIterator ixScanIterator;
+        PeterDB::Attribute ageAttr = attrs[1];
+        ASSERT_EQ(ix.openFile(tableName + "_age_index.idx", otherIxFileHandle), success);
+        ASSERT_EQ(ix.scan(otherIxFileHandle, ageAttr, nullptr, nullptr, true, true, ixScanIterator), success);
+        int key;
+        unsigned count = 0;
+        while (ixScanIterator.getNextEntry(rid, &key) != IX_EOF) {
+            ASSERT_EQ(key, (int) count);
+            count++;
+        }
+        ixScanIterator.close();
+        ASSERT_EQ(ix.closeFile(otherIxFileHandle), success);
+        ASSERT_EQ(count, numTuples) << "Every entry should be found from the persisted root.";
+
+        ASSERT_EQ(rm.destroyIndex(tableName, "age"), success) << "RelationManager::destroyIndex() should succeed.";
+    }
+
+    TEST_F(RM_Tuple_Test, batched_insert_update_and_delete) {
+        // Functions tested
+        // 1. Insert a batch of tuples, each data and index page is written about once
+        // 2. Tuples can be read back, and are found through the index
+        // 3. Update a batch of tuples, the index follows
+        // 4. Delete a batch of tuples, the index follows
+
+        size_t tupleSize = 0;
+        outBuffer = malloc(200);
+
+        ASSERT_EQ(rm.getAttributes(tableName, attrs), success) << "RelationManager::getAttributes() should succeed.";
+        nullsIndicator = initializeNullFieldsIndicator(attrs);
+        ASSERT_EQ(rm.createIndex(tableName, "age"), success) << "RelationManager::createIndex() should succeed.";
+
+        // ages arrive out of order
+        unsigned numTuples = 2000;
+        std::string name = "Peter Anteater";
+        std::vector<std::vector<char>> tuples(numTuples, std::vector<char>(200));
+        std::vector<const void *> data;
+        for (unsigned i = 0; i < numTuples; i++) {
+            unsigned age = (i * 7919) % numTuples;
+            prepareTuple((int) attrs.size(), nullsIndicator, name.length(), name, age, 169.2, 9999.99,
+                         tuples[i].data(), tupleSize);
+            data.push_back(tuples[i].data());
+        }
+
+        // the first insert creates the index root
+        ASSERT_EQ(rm.insertTuple(tableName, data[0], rid), success);
+        data.erase(data.begin());
+
+        PeterDB::FileHandle *fileHandle = nullptr;
+        PeterDB::IXFileHandle *ixFileHandle = nullptr;
+        std::vector<PeterDB::Attribute> tableAttrs;
+        unsigned readCount, writeCount, appendCount, ixReadCount, ixWriteCount, ixAppendCount;
+        unsigned readCountAfter, writeCountAfter, appendCountAfter, ixReadCountAfter, ixWriteCountAfter,
+                ixAppendCountAfter;
+
+        ASSERT_EQ(rm.getFileHandleAndAttributes(tableName, fileHandle, tableAttrs), success);
+        ASSERT_EQ(rm.getIndexFileHandle(tableName, "age", ixFileHandle), success);
+        fileHandle->collectCounterValues(readCount, writeCount, appendCount);
+        ixFileHandle->collectCounterValues(ixReadCount, ixWriteCount, ixAppendCount);
+        rm.releaseFileHandle(tableName);
+
+        std::vector<PeterDB::RID> rids;
+        ASSERT_EQ(rm.insertTuples(tableName, data, rids), success) << "RelationManager::insertTuples() should succeed.";
+        ASSERT_EQ(rids.size(), data.size());
+
+        ASSERT_EQ(rm.getFileHandleAndAttributes(tableName, fileHandle, tableAttrs), success);
+        ASSERT_EQ(rm.getIndexFileHandle(tableName, "age", ixFileHandle), success);
+        fileHandle->collectCounterValues(readCountAfter, writeCountAfter, appendCountAfter);
+        ixFileHandle->collectCounterValues(ixReadCountAfter, ixWriteCountAfter, ixAppendCountAfter);
+        unsigned dataPages = fileHandle->getNumberOfPages();
+        rm.releaseFileHandle(tableName);
+
+        ASSERT_LE(writeCountAfter - writeCount + appendCountAfter - appendCount, 2 * dataPages)
+                                    << "Each data page should be written about once.";
+        ASSERT_LT(ixWriteCountAfter - ixWriteCount + ixAppendCountAfter - ixAppendCount, numTuples / 10)
+                                    << "Index entries going to the same leaf should be written together.";
+
+        data.insert(data.begin(), tuples[0].data());
+        rids.insert(rids.begin(), rid);
+        for (unsigned i = 0; i < numTuples; i++) {
+            ASSERT_EQ(rm.readTuple(tableName, rids[i], outBuffer), success);
+            ASSERT_EQ(memcmp(data[i], outBuffer, tupleSize), 0);
+        }
+
+        // every age once, in order
+        PeterDB::RM_IndexScanIterator rmisi;
+        ASSERT_EQ(rm.indexScan(tableName, "age", nullptr, nullptr, true, true, rmisi), success);
+        int key;
+        unsigned count = 0;
+        while (rmisi.getNextEntry(rid, &key) != RM_EOF) {
+            ASSERT_EQ(key, (int) count);
+            count++;
+        }
+        rmisi.close();
+        ASSERT_EQ(count, numTuples);
+
+        // move the first half to larger ages
+        std::vector<const void *> updatedData;
+        std::vector<PeterDB::RID> updatedRids;
+        std::vector<std::vector<char>> updatedTuples(numTuples / 2, std::vector<char>(200));
+        for (unsigned i = 0; i < numTuples / 2; i++) {
+            unsigned age = numTuples + (i * 7919) % numTuples;
+            prepareTuple((int) attrs.size(), nullsIndicator, name.length(), name, age, 169.2, 9999.99,
+                         updatedTuples[i].data(), tupleSize);
+            updatedData.push_back(updatedTuples[i].data());
+            updatedRids.push_back(rids[i]);
+        }
+        ASSERT_EQ(rm.updateTuples(tableName, updatedData, updatedRids), success)
+                                    << "RelationManager::updateTuples() should succeed.";
+
+        int limit = (int) numTuples;
+        ASSERT_EQ(rm.indexScan(tableName, "age", &limit, nullptr, true, true, rmisi), success);
+        count = 0;
+        while (rmisi.getNextEntry(rid, &key) != RM_EOF) {
+            count++;
+        }
+        rmisi.close();
+        ASSERT_EQ(count, numTuples / 2) << "Updated tuples should be found by their new age.";
+
+        ASSERT_EQ(rm.indexScan(tableName, "age", nullptr, &limit, true, false, rmisi), success);
+        count = 0;
+        while (rmisi.getNextEntry(rid, &key) != RM_EOF) {
+            count++;
+        }
+        rmisi.close();
+        ASSERT_EQ(count, numTuples / 2) << "Updated tuples should not be found by their old age.";
+
+        // delete everything
+        ASSERT_EQ(rm.deleteTuples(tableName, rids), success) << "RelationManager::deleteTuples() should succeed.";
+        ASSERT_EQ(rm.indexScan(tableName, "age", nullptr, nullptr, true, true, rmisi), success);
+        ASSERT_EQ(rmisi.getNextEntry(rid, &key), RM_EOF) << "The index should be empty now.";
+        rmisi.close();
+        ASSERT_NE(rm.readTuple(tableName, rids[0], outBuffer), success);
+        ASSERT_NE(rm.deleteTuples(tableName, rids), success) << "Deleting deleted tuples should fail.";
+
+        ASSERT_EQ(rm.destroyIndex(tableName, "age"), success) << "RelationManager::destroyIndex() should succeed.";
+    }
+
+    TEST_F(RM_Tuple_Test, create_index_bulk_loads_existing_tuples) {
+        // Functions tested
+        // 1. External sort spills and merges runs, entries come back in (key, RID) order
+        // 2. Create indexes on a populated table, each index page is written once
+        // 3. Bulk loaded indexes return every non-NULL key in order
+        // 4. Bulk loaded indexes keep working for inserts and deletes
+
+        size_t tupleSize = 0;
+        outBuffer = malloc(200);
+
+        ASSERT_EQ(rm.getAttributes(tableName, attrs), success) << "RelationManager::getAttributes() should succeed.";
+        nullsIndicator = initializeNullFieldsIndicator(attrs);
+        unsigned char *nullAgeIndicator = initializeNullFieldsIndicator(attrs);
+        nullAgeIndicator[0] = 0x40;
+
+        // a tiny memory budget, so that there are more runs than can be merged at once
+        unsigned numKeys = 3000;
+        PeterDB::Attribute nameAttr = attrs[0];
+        {
+            PeterDB::ExternalSorter sorter(nameAttr, "rm_test_sort", 1024);
+            char key[PAGE_SIZE];
+            for (unsigned i = 0; i < numKeys; i++) {
+                std::string name = "Anteater" + std::to_string((i * 7919) % numKeys);
+                unsigned length = name.length();
+                memcpy(key, &length, sizeof(unsigned));
+                memcpy(key + sizeof(unsigned), name.c_str(), length);
+                ASSERT_EQ(sorter.addEntry(key, PeterDB::RID{i, 0}), success);
+            }
+            ASSERT_EQ(sorter.finish(), success);
+            ASSERT_GT(sorter.getNumRuns(), (unsigned) EXTERNAL_SORT_MAX_FAN_IN) << "Entries should be spilled.";
+
+            std::string previous;
+            unsigned count = 0;
+            while (sorter.getNextEntry(rid, key) != IX_EOF) {
+                unsigned length;
+                memcpy(&length, key, sizeof(unsigned));
+                std::string name(key + sizeof(unsigned), length);
+                ASSERT_LE(previous, name) << "Entries should come back sorted.";
+                previous = name;
+                count++;
+            }
+            ASSERT_EQ(count, numKeys) << "Every entry should come back once.";
+        }
+
+        // ages arrive out of order, every tenth one is NULL
+        unsigned numTuples = 5000;
+        std::vector<std::vector<char>> tuples(numTuples, std::vector<char>(200));
+        std::vector<const void *> data;
+        for (unsigned i = 0; i < numTuples; i++) {
+            unsigned age = (i * 7919) % numTuples;
+            std::string name = "Anteater" + std::to_string(age);
+            prepareTuple((int) attrs.size(), 0 == age % 10 ? nullAgeIndicator : nullsIndicator, name.length(), name,
+                         age, 169.2, 9999.99, tuples[i].data(), tupleSize);
+            data.push_back(tuples[i].data());
+        }
+        std::vector<PeterDB::RID> rids;
+        ASSERT_EQ(rm.insertTuples(tableName, data, rids), success) << "RelationManager::insertTuples() should succeed.";
+        free(nullAgeIndicator);
+
+        ASSERT_EQ(rm.createIndex(tableName, "age"), success) << "RelationManager::createIndex() should succeed.";
+        ASSERT_EQ(rm.createIndex(tableName, "emp_name"), success) << "RelationManager::createIndex() should succeed.";
+
+        // the handle was opened by createIndex, so its counters cover the whole load
+        PeterDB::FileHandle *fileHandle = nullptr;
+        PeterDB::IXFileHandle *ixFileHandle = nullptr;
+        std::vector<PeterDB::Attribute> tableAttrs;
+        unsigned readCount, writeCount, appendCount;
+        ASSERT_EQ(rm.getFileHandleAndAttributes(tableName, fileHandle, tableAttrs), success);
+        ASSERT_EQ(rm.getIndexFileHandle(tableName, "age", ixFileHandle), success);
+        ixFileHandle->collectCounterValues(readCount, writeCount, appendCount);
+        rm.releaseFileHandle(tableName);
+        ASSERT_EQ(readCount, 0u) << "Bulk loading should not read index pages back.";
+        ASSERT_LT(writeCount + appendCount, numTuples / 100) << "Each index page should be written once.";
+
+        PeterDB::RM_IndexScanIterator rmisi;
+        ASSERT_EQ(rm.indexScan(tableName, "age", nullptr, nullptr, true, true, rmisi), success);
+        int key;
+        int previousKey = -1;
+        unsigned count = 0;
+        while (rmisi.getNextEntry(rid, &key) != RM_EOF) {
+            ASSERT_GT(key, previousKey) << "Keys should come back in order.";
+            ASSERT_NE(key % 10, 0) << "NULL ages should not be indexed.";
+            previousKey = key;
+            count++;
+        }
+        rmisi.close();
+        ASSERT_EQ(count, numTuples - numTuples / 10) << "Every non-NULL age should be indexed.";
+
+        std::string lowName = "Anteater4990";
+        std::vector<char> lowKey(sizeof(unsigned) + lowName.length());
+        unsigned lowLength = lowName.length();
+        memcpy(lowKey.data(), &lowLength, sizeof(unsigned));
+        memcpy(lowKey.data() + sizeof(unsigned), lowName.c_str(), lowLength);
+        char nameKey[PAGE_SIZE];
+        ASSERT_EQ(rm.indexScan(tableName, "emp_name", lowKey.data(), nullptr, true, true, rmisi), success);
+        count = 0;
+        while (rmisi.getNextEntry(rid, nameKey) != RM_EOF) {
+            ASSERT_EQ(rm.readTuple(tableName, rid, outBuffer), success);
+            ASSERT_EQ(memcmp((char *) outBuffer + 1, nameKey, sizeof(unsigned) + *(unsigned *) nameKey), 0)
+                                        << "Index entries should point at their tuples.";
+            count++;
+        }
+        rmisi.close();
+        // Anteater4990 to Anteater4999, then Anteater5 to Anteater999 (111 names for each leading digit)
+        ASSERT_EQ(count, 10u + 5 * 111u);
+
+        // the loaded tree takes further changes
+        ASSERT_EQ(rm.deleteTuples(tableName, std::vector<PeterDB::RID>(rids.begin(), rids.begin() + numTuples / 2)),
+                  success) << "RelationManager::deleteTuples() should succeed.";
+        std::vector<PeterDB::RID> newRids;
+        ASSERT_EQ(rm.insertTuples(tableName, std::vector<const void *>(data.begin(), data.begin() + numTuples / 2),
+                                  newRids), success) << "RelationManager::insertTuples() should succeed.";
+
+        ASSERT_EQ(rm.indexScan(tableName, "age", nullptr, nullptr, true, true, rmisi), success);
+        previousKey = -1;
+        count = 0;
+        while (rmisi.getNextEntry(rid, &key) != RM_EOF) {
+            ASSERT_GT(key, previousKey) << "Keys should come back in order.";
+            previousKey = key;
+            count++;
+        }
+        rmisi.close();
+        ASSERT_EQ(count, numTuples - numTuples / 10);
+
+        ASSERT_EQ(rm.destroyIndex(tableName, "age"), success) << "RelationManager::destroyIndex() should succeed.";
+        ASSERT_EQ(rm.destroyIndex(tableName, "emp_name"), success) << "RelationManager::destroyIndex() should succeed.";
+    }
+
+    TEST_F(RM_Tuple_Test, analyze_gathers_table_and_column_statistics) {
+        // Functions tested
+        // 1. Analyze a table, row/page counts and per-column statistics are close to the real ones
+        // 2. Selectivity estimates from the histogram
+        // 3. Statistics are kept in the Statistics catalog table, one row for the table and one per column
+        // 4. Analyze a sample of the pages, the counts are scaled up
+
+        size_t tupleSize = 0;
+        outBuffer = malloc(200);
+
+        ASSERT_EQ(rm.getAttributes(tableName, attrs), success) << "RelationManager::getAttributes() should succeed.";
+        nullsIndicator = initializeNullFieldsIndicator(attrs);
+        unsigned char *nullAgeIndicator = initializeNullFieldsIndicator(attrs);
+        nullAgeIndicator[0] = 0x40;
+
+        PeterDB::TableStatistics stats;
+        ASSERT_NE(rm.getStatistics(tableName, stats), success) << "A table never analyzed has no statistics.";
+
+        // every tenth age is NULL, there are 100 different names
+        unsigned numTuples = 5000;
+        std::vector<std::vector<char>> tuples(numTuples, std::vector<char>(200));
+        std::vector<const void *> data;
+        for (unsigned i = 0; i < numTuples; i++) {
+            unsigned age = (i * 7919) % numTuples;
+            std::string name = "Anteater" + std::to_string(age % 100);
+            prepareTuple((int) attrs.size(), 0 == age % 10 ? nullAgeIndicator : nullsIndicator, name.length(), name,
+                         age, 169.2, (float) i, tuples[i].data(), tupleSize);
+            data.push_back(tuples[i].data());
+        }
+        std::vector<PeterDB::RID> rids;
+        ASSERT_EQ(rm.insertTuples(tableName, data, rids), success) << "RelationManager::insertTuples() should succeed.";
+        free(nullAgeIndicator);
+
+        ASSERT_EQ(rm.analyze(tableName), success) << "RelationManager::analyze() should succeed.";
+        ASSERT_EQ(rm.getStatistics(tableName, stats), success) << "RelationManager::getStatistics() should succeed.";
+
+        PeterDB::FileHandle *fileHandle = nullptr;
+        std::vector<PeterDB::Attribute> tableAttrs;
+        ASSERT_EQ(rm.getFileHandleAndAttributes(tableName, fileHandle, tableAttrs), success);
+        unsigned dataPages = fileHandle->getNumberOfPages();
+        rm.releaseFileHandle(tableName);
+
+        ASSERT_FALSE(stats.sampled);
+        ASSERT_EQ(stats.rowCount, numTuples);
+        ASSERT_EQ(stats.pageCount, dataPages);
+        ASSERT_GT(stats.avgRecordSize, 0);
+        ASSERT_EQ(stats.columns.size(), attrs.size());
+
+        const PeterDB::ColumnStatistics *age = stats.getColumn("age");
+        ASSERT_NE(age, nullptr);
+        ASSERT_NEAR(age->nullFraction, 0.1, 0.001);
+        ASSERT_NEAR(age->distinctCount, numTuples * 0.9, numTuples * 0.9 * 0.05) << "Distinct ages are off.";
+        ASSERT_EQ(*(int *) age->minValue.data(), 1);
+        ASSERT_EQ(*(int *) age->maxValue.data(), 4999);
+
+        const PeterDB::ColumnStatistics *name = stats.getColumn("emp_name");
+        ASSERT_NE(name, nullptr);
+        ASSERT_NEAR(name->distinctCount, 100, 5) << "Distinct names are off.";
+        ASSERT_EQ(name->minValue.substr(4), "Anteater0");
+        ASSERT_EQ(name->maxValue.substr(4), "Anteater99");
+
+        // 900 non-NULL ages below 1000, and one tuple in 5000 for each value
+        int limit = 1000;
+        ASSERT_NEAR(age->estimateSelectivity(PeterDB::LT_OP, &limit), 0.18, 0.02);
+        ASSERT_NEAR(age->estimateSelectivity(PeterDB::GE_OP, &limit), 0.72, 0.02);
+        ASSERT_NEAR(age->estimateSelectivity(PeterDB::EQ_OP, &limit), 1.0 / numTuples, 0.0001);
+        limit = 10000;
+        ASSERT_EQ(age->estimateSelectivity(PeterDB::EQ_OP, &limit), 0);
+        ASSERT_NEAR(age->estimateSelectivity(PeterDB::LT_OP, &limit), 0.9, 0.001);
+
+        const PeterDB::ColumnStatistics *salary = stats.getColumn("salary");
+        ASSERT_NE(salary, nullptr);
+        float salaryLimit = 1250;
+        ASSERT_NEAR(salary->estimateSelectivity(PeterDB::LE_OP, &salaryLimit), 0.25, 0.02);
+
+        // analyzing again replaces the rows
+        ASSERT_EQ(rm.analyze(tableName), success) << "RelationManager::analyze() should succeed.";
+        PeterDB::RM_ScanIterator rmsi;
+        std::vector<std::string> projected{"column-name", "row-count"};
+        ASSERT_EQ(rm.scan("Statistics", "", PeterDB::NO_OP, nullptr, projected, rmsi), success);
+        unsigned count = 0;
+        while (rmsi.getNextTuple(rid, outBuffer) != RM_EOF) {
+            unsigned nameLength = *(unsigned *) ((char *) outBuffer + 1);
+            if (0 == nameLength) {
+                ASSERT_EQ(*(unsigned *) ((char *) outBuffer + 1 + 4), numTuples) << "Table row should hold the count.";
+            }
+            count++;
+        }
+        rmsi.close();
+        ASSERT_EQ(count, attrs.size() + 1) << "Statistics should have a row for the table and one per column.";
+        ASSERT_NE(rm.deleteTable("Statistics"), success) << "The Statistics table can't be deleted.";
+
+        // a sample of about a third of the pages
+        ASSERT_EQ(rm.analyze(tableName, dataPages / 3), success) << "RelationManager::analyze() should succeed.";
+        ASSERT_EQ(rm.getStatistics(tableName, stats), success) << "RelationManager::getStatistics() should succeed.";
+        ASSERT_TRUE(stats.sampled);
+        ASSERT_NEAR(stats.rowCount, numTuples, numTuples * 0.1) << "Scaled up row count is off.";
+        ASSERT_NEAR(stats.getColumn("age")->distinctCount, numTuples * 0.9, numTuples * 0.9 * 0.15);
+        ASSERT_NEAR(stats.getColumn("emp_name")->distinctCount, 100, 5);
+        ASSERT_NEAR(stats.getColumn("age")->nullFraction, 0.1, 0.03);
+    }
+
+
+    TEST_F(RM_Tuple_Test, covering_index_answers_scans_without_reading_the_table) {
+        // Functions tested
+        // 1. Create a covering index on a populated table, the included columns are kept in the catalog
+        // 2. Index scans projecting on the key and included columns don't read the table
+        // 3. Other projections read the tuples
+        // 4. Inserts and updates keep the included values of the entries up to date
+
+        size_t tupleSize = 0;
+        outBuffer = malloc(200);
+
+        ASSERT_EQ(rm.getAttributes(tableName, attrs), success) << "RelationManager::getAttributes() should succeed.";
+        nullsIndicator = initializeNullFieldsIndicator(attrs);
+        unsigned char *nullHeightIndicator = initializeNullFieldsIndicator(attrs);
+        nullHeightIndicator[0] = 0x20;
+
+        // every seventh height is NULL
+        unsigned numTuples = 2000;
+        std::vector<std::vector<char>> tuples(numTuples, std::vector<char>(200));
+        std::vector<const void *> data;
+        for (unsigned age = 0; age < numTuples; age++) {
+            std::string name = "Anteater" + std::to_string(age);
+            prepareTuple((int) attrs.size(), 0 == age % 7 ? nullHeightIndicator : nullsIndicator, name.length(),
+                         name, age, age * 0.5f, 9999.99, tuples[age].data(), tupleSize);
+            data.push_back(tuples[age].data());
+        }
+        std::vector<PeterDB::RID> rids;
+        ASSERT_EQ(rm.insertTuples(tableName, data, rids), success) << "RelationManager::insertTuples() should succeed.";
+
+        ASSERT_NE(rm.createIndex(tableName, "age", {"weight"}), success) << "Unknown included columns should fail.";
+        ASSERT_NE(rm.createIndex(tableName, "age", {"age"}), success) << "The key can't be included.";
+        ASSERT_EQ(rm.createIndex(tableName, "age", {"height", "emp_name"}), success)
+                                    << "RelationManager::createIndex() should succeed.";
+
+        std::vector<std::string> projected{"included-columns"};
+        PeterDB::RM_ScanIterator rmsi;
+        ASSERT_EQ(rm.scan("Indexes", "", PeterDB::NO_OP, nullptr, projected, rmsi), success);
+        ASSERT_NE(rmsi.getNextTuple(rid, outBuffer), RM_EOF);
+        unsigned length = *(unsigned *) ((char *) outBuffer + 1);
+        ASSERT_EQ(std::string((char *) outBuffer + 1 + 4, length), "height,emp_name");
+        rmsi.close();
+
+        // checks what a scan over ages [100, 199] returns, projected on (age, height, emp_name)
+        auto checkScan = [&](float updatedHeight) {
+            int lowAge = 100, highAge = 199;
+            PeterDB::RM_IndexScanIterator rmisi;
+            ASSERT_EQ(rm.indexScan(tableName, "age", &lowAge, &highAge, true, true,
+                                   {"age", "height", "emp_name"}, rmisi), success);
+            ASSERT_TRUE(rmisi.isIndexOnly()) << "The index covers the projection.";
+
+            PeterDB::FileHandle *fileHandle = nullptr;
+            std::vector<PeterDB::Attribute> tableAttrs;
+            unsigned readCount, writeCount, appendCount;
+            unsigned readCountAfter, writeCountAfter, appendCountAfter;
+            ASSERT_EQ(rm.getFileHandleAndAttributes(tableName, fileHandle, tableAttrs), success);
+            fileHandle->collectCounterValues(readCount, writeCount, appendCount);
+
+            int expectedAge = lowAge;
+            while (rmisi.getNextTuple(rid, outBuffer) != RM_EOF) {
+                char *tuple = (char *) outBuffer;
+                ASSERT_EQ(*(int *) (tuple + 1), expectedAge);
+                unsigned offset = 1 + sizeof(int);
+                if (0 == expectedAge % 7) {
+                    ASSERT_EQ(tuple[0], (char) 0x40) << "NULL heights should come back NULL.";
+                } else {
+                    ASSERT_EQ(tuple[0], 0);
+                    float height = 150 == expectedAge ? updatedHeight : expectedAge * 0.5f;
+                    ASSERT_FLOAT_EQ(*(float *) (tuple + offset), height);
+                    offset += sizeof(float);
+                }
+                std::string name = "Anteater" + std::to_string(expectedAge);
+                ASSERT_EQ(*(unsigned *) (tuple + offset), name.length());
+                ASSERT_EQ(std::string(tuple + offset + 4, name.length()), name);
+                expectedAge++;
+            }
+            ASSERT_EQ(expectedAge, highAge + 1) << "Every age in the range should come back.";
+
+            fileHandle->collectCounterValues(readCountAfter, writeCountAfter, appendCountAfter);
+            rm.releaseFileHandle(tableName);
+            ASSERT_EQ(readCountAfter, readCount) << "Index-only scans should not read the table.";
+            rmisi.close();
+        };
+        checkScan(150 * 0.5f);
+
+        // salary is not in the index, it comes from the tuples
+        int lowAge = 1990;
+        PeterDB::RM_IndexScanIterator rmisi;
+        ASSERT_EQ(rm.indexScan(tableName, "age", &lowAge, nullptr, true, true, {"salary", "age"}, rmisi), success);
+        ASSERT_FALSE(rmisi.isIndexOnly());
+        unsigned count = 0;
+        while (rmisi.getNextTuple(rid, outBuffer) != RM_EOF) {
+            ASSERT_EQ(((char *) outBuffer)[0], 0);
+            ASSERT_FLOAT_EQ(*(float *) ((char *) outBuffer + 1), 9999.99f);
+            ASSERT_EQ(*(int *) ((char *) outBuffer + 1 + sizeof(float)), lowAge + (int) count);
+            count++;
+        }
+        rmisi.close();
+        ASSERT_EQ(count, 10u);
+
+        // the entries follow updates, and single inserts
+        prepareTuple((int) attrs.size(), nullsIndicator, 11, "Anteater150", 150, 1234.5, 9999.99, outBuffer,
+                     tupleSize);
+        ASSERT_EQ(rm.updateTuple(tableName, outBuffer, rids[150]), success);
+        checkScan(1234.5f);
+
+        prepareTuple((int) attrs.size(), nullsIndicator, 12, "Anteater5000", 5000, 2500, 9999.99, outBuffer,
+                     tupleSize);
+        ASSERT_EQ(rm.insertTuple(tableName, outBuffer, rid), success);
+        lowAge = 5000;
+        ASSERT_EQ(rm.indexScan(tableName, "age", &lowAge, &lowAge, true, true, {"emp_name", "age"}, rmisi), success);
+        ASSERT_NE(rmisi.getNextTuple(rid, outBuffer), RM_EOF);
+        ASSERT_EQ(std::string((char *) outBuffer + 1 + 4, 12), "Anteater5000");
+        ASSERT_EQ(*(int *) ((char *) outBuffer + 1 + 4 + 12), 5000);
+        ASSERT_EQ(rmisi.getNextTuple(rid, outBuffer), RM_EOF);
+        rmisi.close();
+
+        free(nullHeightIndicator);
+        ASSERT_EQ(rm.destroyIndex(tableName, "age"), success) << "RelationManager::destroyIndex() should succeed.";
+    }
+
+    TEST_F(RM_Tuple_Test, composite_index_scans_by_prefix) {
+        // Functions tested
+        // 1. Create an index on (age, height) of a populated table
+        // 2. Scans by age alone, and by age and a range of heights, come back ordered by age then height
+        // 3. Index-only scans decode both key attributes
+        // 4. Deletes and inserts keep the index up to date, tuples with a NULL key attribute are not indexed
+
+        size_t tupleSize = 0;
+        outBuffer = malloc(200);
+
+        ASSERT_EQ(rm.getAttributes(tableName, attrs), success) << "RelationManager::getAttributes() should succeed.";
+        nullsIndicator = initializeNullFieldsIndicator(attrs);
+        unsigned char *nullHeightIndicator = initializeNullFieldsIndicator(attrs);
+        nullHeightIndicator[0] = 0x20;
+
+        // 50 ages, each with heights -10 to 9, inserted height first; the last one has a NULL height
+        unsigned numTuples = 1000;
+        std::vector<std::vector<char>> tuples(numTuples, std::vector<char>(200));
+        std::vector<const void *> data;
+        for (unsigned i = 0; i < numTuples; i++) {
+            int age = (int) (i % 50);
+            float height = (float) (i / 50) - 10;
+            std::string name = "Anteater" + std::to_string(i);
+            prepareTuple((int) attrs.size(), numTuples - 1 == i ? nullHeightIndicator : nullsIndicator,
+                         name.length(), name, age, height, 9999.99, tuples[i].data(), tupleSize);
+            data.push_back(tuples[i].data());
+        }
+        std::vector<PeterDB::RID> rids;
+        ASSERT_EQ(rm.insertTuples(tableName, data, rids), success) << "RelationManager::insertTuples() should succeed.";
+
+        ASSERT_NE(rm.createIndex(tableName, std::vector<std::string>{"age", "age"}), success)
+                                    << "An attribute can't be in the key twice.";
+        ASSERT_NE(rm.createIndex(tableName, std::vector<std::string>{"age", "shoe_size"}), success)
+                                    << "Unknown attributes should fail.";
+        ASSERT_EQ(rm.createIndex(tableName, std::vector<std::string>{"age", "height"}), success)
+                                    << "RelationManager::createIndex() should succeed.";
+
+        // scans (age, height) between low and high, checking the entries come back in order
+        auto checkScan = [&](const std::vector<const void *> &low, const std::vector<const void *> &high,
+                             bool lowInclusive, bool highInclusive, int firstAge, float firstHeight,
+                             unsigned expectedCount) {
+            PeterDB::RM_IndexScanIterator rmisi;
+            ASSERT_EQ(rm.indexScan(tableName, {"age", "height"}, low, high, lowInclusive, highInclusive,
+                                   {"age", "height"}, rmisi), success);
+            ASSERT_TRUE(rmisi.isIndexOnly()) << "The index covers the projection.";
+
+            int age = firstAge;
+            float height = firstHeight;
+            unsigned count = 0;
+            while (rmisi.getNextTuple(rid, outBuffer) != RM_EOF) {
+                char *tuple = (char *) outBuffer;
+                ASSERT_EQ(tuple[0], 0);
+                ASSERT_EQ(*(int *) (tuple + 1), age);
+                ASSERT_FLOAT_EQ(*(float *) (tuple + 1 + sizeof(int)), height);
+                count++;
+                height++;
+                if (height > 9 || (49 == age && height > 8)) {
+                    age++;
+                    height = -10;
+                }
+            }
+            rmisi.close();
+            ASSERT_EQ(count, expectedCount);
+        };
+
+        int age = 7;
+        float lowHeight = -3, highHeight = 2;
+        checkScan({&age}, {&age}, true, true, 7, -10, 20);
+        checkScan({&age, &lowHeight}, {&age, &highHeight}, true, true, 7, -3, 6);
+        checkScan({&age, &lowHeight}, {&age, &highHeight}, false, false, 7, -2, 4);
+        checkScan({&age}, {&age, &lowHeight}, true, false, 7, -10, 7);
+
+        // past age 47, the NULL height is not there
+        int lastAges = 47;
+        checkScan({&lastAges}, {}, false, true, 48, -10, 39);
+        checkScan({}, {&age}, true, false, 0, -10, 140);
+
+        // the index follows deletes and inserts
+        for (unsigned i = 7; i < numTuples / 2; i += 50) {
+            ASSERT_EQ(rm.deleteTuple(tableName, rids[i]), success);
+        }
+        checkScan({&age}, {&age}, true, true, 7, 0, 10);
+
+        float height = -20;
+        prepareTuple((int) attrs.size(), nullsIndicator, 4, "Ant7", 7, height, 9999.99, outBuffer, tupleSize);
+        ASSERT_EQ(rm.insertTuple(tableName, outBuffer, rid), success);
+        checkScan({&age, &height}, {&age, &height}, true, true, 7, -20, 1);
+
+        free(nullHeightIndicator);
+        ASSERT_EQ(rm.destroyIndex(tableName, "age,height"), success) << "RelationManager::destroyIndex() should succeed.";
+    }
+
+    TEST_F(RM_Tuple_Test, partitioned_tables_route_tuples_and_prune_scans) {
+        // Functions tested
+        // 1. Create tables range and hash partitioned on age, inserts go to the partition of their age
+        // 2. Tuples are read, updated and deleted through the RIDs handed out by the table
+        // 3. Scans with a condition on age skip the partitions which can't match
+        // 4. Indexes are created in every partition, index scans go through them
+
+        size_t tupleSize = 0;
+        outBuffer = malloc(200);
+
+        ASSERT_EQ(rm.getAttributes(tableName, attrs), success) << "RelationManager::getAttributes() should succeed.";
+        nullsIndicator = initializeNullFieldsIndicator(attrs);
+
+        auto ageBound = [](int age) { return std::string((char *) &age, sizeof(int)); };
+        PeterDB::TableOptions options;
+        options.partitioning.method = PeterDB::RangePartitioning;
+        options.partitioning.attribute = "age";
+        options.partitioning.bounds = {ageBound(200), ageBound(100)};
+        std::string rangeTable = "rm_partitioned_range";
+        ASSERT_NE(rm.createTable(rangeTable, attrs, options), success) << "Bounds should be in ascending order.";
+        options.partitioning.bounds = {ageBound(100), ageBound(200)};
+        ASSERT_EQ(rm.createTable(rangeTable, attrs, options), success) << "RelationManager::createTable() should succeed.";
+
+        unsigned numTuples = 300;
+        std::vector<std::vector<char>> tuples(numTuples, std::vector<char>(200));
+        std::vector<const void *> data;
+        for (unsigned age = 0; age < numTuples; age++) {
+            std::string name = "Anteater" + std::to_string(age);
+            prepareTuple((int) attrs.size(), nullsIndicator, name.length(), name, age, age * 0.5f, 9999.99,
+                         tuples[age].data(), tupleSize);
+            data.push_back(tuples[age].data());
+        }
+        std::vector<PeterDB::RID> rids;
+        ASSERT_EQ(rm.insertTuples(rangeTable, data, rids), success) << "RelationManager::insertTuples() should succeed.";
+
+        // counts the tuples of a scan with the given condition on age
+        auto countScan = [&](const std::string &table, PeterDB::CompOp compOp, int age) {
+            PeterDB::RM_ScanIterator rmsi;
+            EXPECT_EQ(rm.scan(table, "age", compOp, &age, {"age"}, rmsi), success);
+            unsigned count = 0;
+            while (rmsi.getNextTuple(rid, outBuffer) != RM_EOF) {
+                EXPECT_EQ(rm.readTuple(table, rid, outBuffer), success);
+                count++;
+            }
+            rmsi.close();
+            return count;
+        };
+        for (unsigned p = 0; p < 3; p++) {
+            ASSERT_EQ(countScan(PeterDB::RelationManager::partitionTableName(rangeTable, p), PeterDB::NO_OP, 0), 100u)
+                                        << "Each partition should get the tuples of its range.";
+        }
+
+        // the last partition is not even opened by scans below 100
+        PeterDB::FileHandle *fileHandle = nullptr;
+        std::vector<PeterDB::Attribute> tableAttrs;
+        unsigned readCount, writeCount, appendCount;
+        unsigned readCountAfter, writeCountAfter, appendCountAfter;
+        std::string lastPartition = PeterDB::RelationManager::partitionTableName(rangeTable, 2);
+        ASSERT_EQ(rm.getFileHandleAndAttributes(lastPartition, fileHandle, tableAttrs), success);
+        fileHandle->collectCounterValues(readCount, writeCount, appendCount);
+        ASSERT_EQ(countScan(rangeTable, PeterDB::LT_OP, 50), 50u);
+        ASSERT_EQ(countScan(rangeTable, PeterDB::EQ_OP, 100), 1u);
+        fileHandle->collectCounterValues(readCountAfter, writeCountAfter, appendCountAfter);
+        rm.releaseFileHandle(lastPartition);
+        ASSERT_EQ(readCountAfter, readCount) << "Scans should skip the partitions which can't match.";
+        ASSERT_EQ(countScan(rangeTable, PeterDB::GE_OP, 150), 150u);
+        ASSERT_EQ(countScan(rangeTable, PeterDB::NE_OP, 150), 299u);
+
+        // tuples are found through their RIDs, and stay in their partition
+        ASSERT_EQ(rm.readTuple(rangeTable, rids[150], outBuffer), success);
+        ASSERT_EQ(memcmp(outBuffer, tuples[150].data(), tupleSize), 0);
+        std::string name = "Anteater5";
+        prepareTuple((int) attrs.size(), nullsIndicator, name.length(), name, 6, 1.5, 9999.99, outBuffer, tupleSize);
+        ASSERT_EQ(rm.updateTuple(rangeTable, outBuffer, rids[5]), success);
+        prepareTuple((int) attrs.size(), nullsIndicator, name.length(), name, 150, 1.5, 9999.99, outBuffer, tupleSize);
+        ASSERT_NE(rm.updateTuple(rangeTable, outBuffer, rids[5]), success)
+                                    << "Tuples can't move to another partition.";
+        ASSERT_EQ(rm.deleteTuple(rangeTable, rids[250]), success);
+        ASSERT_NE(rm.readTuple(rangeTable, rids[250], outBuffer), success);
+        ASSERT_EQ(countScan(rangeTable, PeterDB::GE_OP, 200), 99u);
+
+        // an index in every partition, scans across the partition bounds
+        ASSERT_EQ(rm.createIndex(rangeTable, "age"), success) << "RelationManager::createIndex() should succeed.";
+        int lowAge = 90, highAge = 260;
+        PeterDB::RM_IndexScanIterator rmisi;
+        ASSERT_EQ(rm.indexScan(rangeTable, "age", &lowAge, &highAge, true, false, {"age"}, rmisi), success);
+        int expectedAge = lowAge;
+        while (rmisi.getNextTuple(rid, outBuffer) != RM_EOF) {
+            expectedAge += 250 == expectedAge ? 1 : 0;
+            ASSERT_EQ(*(int *) ((char *) outBuffer + 1), expectedAge);
+            ASSERT_EQ(rm.readTuple(rangeTable, rid, outBuffer), success);
+            expectedAge++;
+        }
+        rmisi.close();
+        ASSERT_EQ(expectedAge, highAge) << "Every age in the range should come back, in order.";
+
+        // hash partitions get a share of the tuples each, and equality scans only read one of them
+        PeterDB::TableOptions hashOptions;
+        hashOptions.partitioning.method = PeterDB::HashPartitioning;
+        hashOptions.partitioning.attribute = "age";
+        hashOptions.partitioning.count = 4;
+        std::string hashTable = "rm_partitioned_hash";
+        ASSERT_EQ(rm.createTable(hashTable, attrs, hashOptions), success);
+        ASSERT_EQ(rm.createIndex(hashTable, "age"), success);
+        ASSERT_EQ(rm.insertTuples(hashTable, data, rids), success);
+        unsigned total = 0;
+        for (unsigned p = 0; p < 4; p++) {
+            unsigned count = countScan(PeterDB::RelationManager::partitionTableName(hashTable, p), PeterDB::NO_OP, 0);
+            ASSERT_GT(count, 0u) << "Every hash partition should get some tuples.";
+            total += count;
+        }
+        ASSERT_EQ(total, numTuples);
+        for (int age = 0; age < 20; age++) {
+            ASSERT_EQ(countScan(hashTable, PeterDB::EQ_OP, age), 1u);
+            ASSERT_EQ(rm.indexScan(hashTable, "age", &age, &age, true, true, rmisi), success);
+            ASSERT_NE(rmisi.getNextEntry(rid, outBuffer), RM_EOF);
+            ASSERT_EQ(rm.readTuple(hashTable, rid, outBuffer), success);
+            ASSERT_EQ(memcmp(outBuffer, tuples[age].data(), tupleSize), 0);
+            ASSERT_EQ(rmisi.getNextEntry(rid, outBuffer), RM_EOF);
+            rmisi.close();
+        }
+
+        ASSERT_EQ(rm.deleteTable(hashTable), success) << "RelationManager::deleteTable() should succeed.";
+        ASSERT_EQ(rm.deleteTable(rangeTable), success) << "RelationManager::deleteTable() should succeed.";
+    }
+
+    TEST_F(RM_Tuple_Test, write_ahead_log_redoes_committed_changes_after_a_crash) {
+        // Functions tested
+        // 1. With the log open, tuple changes are committed to the log, the table and index files are not written
+        // 2. A process dying before writing them back leaves its committed changes in the log
+        // 3. Opening the log again redoes them, tuples and index entries are back
+        // 4. Closing the log writes everything back and removes it
+
+        size_t tupleSize = 0;
+        outBuffer = malloc(200);
+        std::string logFileName = "rm_test_wal";
+        remove(logFileName.c_str());
+
+        ASSERT_EQ(rm.getAttributes(tableName, attrs), success) << "RelationManager::getAttributes() should succeed.";
+        nullsIndicator = initializeNullFieldsIndicator(attrs);
+        ASSERT_EQ(rm.createIndex(tableName, "age"), success) << "RelationManager::createIndex() should succeed.";
+
+        unsigned numTuples = 200;
+        std::vector<std::vector<char>> tuples(numTuples, std::vector<char>(200));
+        std::vector<const void *> data;
+        size_t firstTupleSize = 0;
+        for (unsigned i = 0; i < numTuples; i++) {
+            std::string name = "Anteater" + std::to_string(i);
+            prepareTuple((int) attrs.size(), nullsIndicator, name.length(), name, i, i * 0.5f, 9999.99,
+                         tuples[i].data(), tupleSize);
+            data.push_back(tuples[i].data());
+            firstTupleSize = 0 == i ? tupleSize : firstTupleSize;
+        }
+        std::vector<char> updated(200);
+        prepareTuple((int) attrs.size(), nullsIndicator, 7, "Updated", 1000, 1.5, 9999.99, updated.data(), tupleSize);
+
+        // what the files hold before, the crashing process starts from it
+        ASSERT_EQ(rm.checkpoint(), success) << "RelationManager::checkpoint() should succeed.";
+        auto tableFileSize = getFileSize(tableName);
+
+        pid_t pid = fork();
+        ASSERT_NE(pid, -1) << "fork() should succeed.";
+        if (0 == pid) {
+            std::vector<PeterDB::RID> rids;
+            bool committed = success == rm.openLog(logFileName) &&
+                             success == rm.insertTuples(tableName, data, rids) &&
+                             success == rm.deleteTuple(tableName, rids[0]) &&
+                             success == rm.updateTuple(tableName, updated.data(), rids[1]);
+            // no checkpoint, no close: the changes are only in the log
+            _exit(committed ? 0 : 1);
+        }
+        int status = 0;
+        ASSERT_EQ(waitpid(pid, &status, 0), pid);
+        ASSERT_TRUE(WIFEXITED(status) && 0 == WEXITSTATUS(status)) << "The changes should be committed.";
+        ASSERT_EQ(getFileSize(tableName), tableFileSize) << "The table file should not be written to.";
+        ASSERT_TRUE(fileExists(logFileName)) << "The log should be left behind.";
+
+        ASSERT_EQ(rm.openLog(logFileName), success) << "RelationManager::openLog() should succeed.";
+
+        auto countScan = [&](PeterDB::CompOp compOp, int age) {
+            PeterDB::RM_ScanIterator rmsi;
+            EXPECT_EQ(rm.scan(tableName, "age", compOp, &age, {"age"}, rmsi), success);
+            unsigned count = 0;
+            while (rmsi.getNextTuple(rid, outBuffer) != RM_EOF) {
+                count++;
+            }
+            rmsi.close();
+            return count;
+        };
+        auto countIndexScan = [&](int age) {
+            PeterDB::RM_IndexScanIterator rmisi;
+            EXPECT_EQ(rm.indexScan(tableName, "age", &age, &age, true, true, rmisi), success);
+            unsigned count = 0;
+            while (rmisi.getNextEntry(rid, outBuffer) != RM_EOF) {
+                count++;
+            }
+            rmisi.close();
+            return count;
+        };
+        ASSERT_EQ(countScan(PeterDB::NO_OP, 0), numTuples - 1) << "The inserted tuples should be redone.";
+        ASSERT_EQ(countScan(PeterDB::EQ_OP, 1000), 1u) << "The updated tuple should be redone.";
+        ASSERT_EQ(countIndexScan(0), 0u) << "The deleted index entry should stay deleted.";
+        ASSERT_EQ(countIndexScan(1000), 1u) << "The updated index entry should be redone.";
+        ASSERT_EQ(countIndexScan(150), 1u) << "The inserted index entries should be redone.";
+
+        // changes made with the log open are read back before they are written back
+        std::vector<PeterDB::RID> rids;
+        ASSERT_EQ(rm.insertTuples(tableName, {data[0]}, rids), success);
+        ASSERT_EQ(rm.readTuple(tableName, rids[0], outBuffer), success);
+        ASSERT_EQ(memcmp(outBuffer, data[0], firstTupleSize), 0);
+        ASSERT_EQ(countIndexScan(0), 1u);
+
+        ASSERT_EQ(rm.closeLog(), success) << "RelationManager::closeLog() should succeed.";
+        ASSERT_FALSE(fileExists(logFileName)) << "The log should be removed once written back.";
+        ASSERT_GT(getFileSize(tableName), tableFileSize) << "The pages should be written back.";
+        ASSERT_EQ(countScan(PeterDB::NO_OP, 0), numTuples);
+        ASSERT_EQ(countIndexScan(0), 1u);
+    }
+
+    TEST_F(RM_Tuple_Test, write_ahead_log_drops_operations_cut_short_by_a_crash) {
+        // Functions tested
+        // 1. A process dies in the middle of an operation, after its pages reached the log on disk
+        // 2. Opening the log again redoes the operations committed before it only
+        // 3. Tuples and index entries of the torn operation are not brought back, nor is its update
+
+        size_t tupleSize = 0;
+        outBuffer = malloc(200);
+        std::string logFileName = "rm_test_wal_torn";
+        remove(logFileName.c_str());
+
+        ASSERT_EQ(rm.getAttributes(tableName, attrs), success) << "RelationManager::getAttributes() should succeed.";
+        nullsIndicator = initializeNullFieldsIndicator(attrs);
+        ASSERT_EQ(rm.createIndex(tableName, "age"), success) << "RelationManager::createIndex() should succeed.";
+
+        auto prepareTuples = [&](unsigned count, int firstAge, std::vector<std::vector<char>> &tuples) {
+            std::vector<const void *> data;
+            tuples.assign(count, std::vector<char>(200));
+            for (unsigned i = 0; i < count; i++) {
+                std::string name = "Anteater" + std::to_string(firstAge + i);
+                prepareTuple((int) attrs.size(), nullsIndicator, name.length(), name, firstAge + (int) i, 0.5,
+                             9999.99, tuples[i].data(), tupleSize);
+                data.push_back(tuples[i].data());
+            }
+            return data;
+        };
+        std::vector<std::vector<char>> committedTuples, tornTuples;
+        std::vector<const void *> committed = prepareTuples(20, 0, committedTuples);
+        std::vector<const void *> torn = prepareTuples(300, 1000, tornTuples);
+        std::vector<char> updated(200);
+        prepareTuple((int) attrs.size(), nullsIndicator, 7, "Updated", 5000, 1.5, 9999.99, updated.data(), tupleSize);
+
+        ASSERT_EQ(rm.checkpoint(), success) << "RelationManager::checkpoint() should succeed.";
+
+        pid_t pid = fork();
+        ASSERT_NE(pid, -1) << "fork() should succeed.";
+        if (0 == pid) {
+            PeterDB::WriteAheadLog &wal = PeterDB::WriteAheadLog::instance();
+            std::vector<PeterDB::RID> rids, tornRids;
+            bool logged = success == rm.openLog(logFileName) &&
+                          success == rm.insertTuples(tableName, committed, rids);
+
+            // an operation still in progress, its tuple changes are part of it
+            wal.beginOperation();
+            logged = logged && success == rm.beginTransaction() &&
+                     success == rm.insertTuples(tableName, torn, tornRids) &&
+                     success == rm.updateTuple(tableName, updated.data(), rids[0]) &&
+                     success == wal.flush();
+            _exit(logged ? 0 : 1);
+        }
+        int status = 0;
+        ASSERT_EQ(waitpid(pid, &status, 0), pid);
+        ASSERT_TRUE(WIFEXITED(status) && 0 == WEXITSTATUS(status)) << "The changes should reach the log.";
+
+        ASSERT_EQ(rm.openLog(logFileName), success) << "RelationManager::openLog() should succeed.";
+
+        auto countScan = [&](PeterDB::CompOp compOp, int age) {
+            PeterDB::RM_ScanIterator rmsi;
+            EXPECT_EQ(rm.scan(tableName, "age", compOp, &age, {"age"}, rmsi), success);
+            unsigned count = 0;
+            while (rmsi.getNextTuple(rid, outBuffer) != RM_EOF) {
+                count++;
+            }
+            rmsi.close();
+            return count;
+        };
+        auto countIndexScan = [&](int low, int high) {
+            PeterDB::RM_IndexScanIterator rmisi;
+            EXPECT_EQ(rm.indexScan(tableName, "age", &low, &high, true, true, rmisi), success);
+            unsigned count = 0;
+            while (rmisi.getNextEntry(rid, outBuffer) != RM_EOF) {
+                count++;
+            }
+            rmisi.close();
+            return count;
+        };
+        ASSERT_EQ(countScan(PeterDB::NO_OP, 0), committed.size()) << "Only the committed tuples should be redone.";
+        ASSERT_EQ(countScan(PeterDB::EQ_OP, 0), 1u) << "The torn update should not be redone.";
+        ASSERT_EQ(countIndexScan(0, 5000), committed.size()) << "Only the committed index entries should be redone.";
+
+        // the table goes on from its committed state
+        std::vector<PeterDB::RID> rids;
+        ASSERT_EQ(rm.insertTuples(tableName, torn, rids), success);
+        ASSERT_EQ(countIndexScan(1000, 1299), torn.size());
+
+        ASSERT_EQ(rm.closeLog(), success) << "RelationManager::closeLog() should succeed.";
+        ASSERT_FALSE(fileExists(logFileName)) << "The log should be removed once written back.";
+        ASSERT_EQ(countScan(PeterDB::NO_OP, 0), committed.size() + torn.size());
+    }
+
+    TEST_F(RM_Tuple_Test, schema_changes_leave_existing_tuples_in_place) {
+        // Functions tested
+        // 1. Adding and dropping attributes only changes the catalog, the table file is not rewritten
+        // 2. Tuples written before a change read NULL for added attributes, and leave dropped ones out
+        // 3. Updating an old tuple rewrites it with the current attributes, scans see the new values
+        // 4. Attributes used by an index can't be dropped, a dropped and re-added attribute starts out NULL
+
+        outBuffer = malloc(200);
+
+        // [null indicator][emp_name][age][height?][salary][ssn?], NULL attributes left out
+        auto buildTuple = [](const std::string &name, int age, const float *height, float salary, const int *ssn,
+                             void *buffer) {
+            char *writePtr = (char *) buffer + 1;
+            uint32_t length = name.size();
+            memcpy(writePtr, &length, sizeof(length));
+            memcpy(writePtr + sizeof(length), name.data(), length);
+            writePtr += sizeof(length) + length;
+            memcpy(writePtr, &age, sizeof(age));
+            writePtr += sizeof(age);
+            if (nullptr != height) {
+                memcpy(writePtr, height, sizeof(*height));
+                writePtr += sizeof(*height);
+            }
+            memcpy(writePtr, &salary, sizeof(salary));
+            writePtr += sizeof(salary);
+            if (nullptr != ssn) {
+                memcpy(writePtr, ssn, sizeof(*ssn));
+                writePtr += sizeof(*ssn);
+            }
+            *(char *) buffer = 0;
+            return (size_t) (writePtr - (char *) buffer);
+        };
+
+        unsigned numTuples = 100;
+        std::vector<std::vector<char>> tuples(numTuples, std::vector<char>(200));
+        std::vector<size_t> tupleSizes;
+        std::vector<const void *> data;
+        for (unsigned i = 0; i < numTuples; i++) {
+            float height = i * 0.5f;
+            tupleSizes.push_back(buildTuple("Anteater" + std::to_string(i), i, &height, 9999.99, nullptr,
+                                            tuples[i].data()));
+            data.push_back(tuples[i].data());
+        }
+        std::vector<PeterDB::RID> rids;
+        ASSERT_EQ(rm.insertTuples(tableName, data, rids), success) << "RelationManager::insertTuples() should succeed.";
+        ASSERT_EQ(rm.createIndex(tableName, "age"), success) << "RelationManager::createIndex() should succeed.";
+        ASSERT_EQ(rm.checkpoint(), success);
+        auto tableFileSize = getFileSize(tableName);
+
+        // added attributes read as NULL in the tuples already there
+        ASSERT_NE(rm.addAttribute(tableName, PeterDB::Attribute{"age", PeterDB::TypeInt, 4}), success)
+                                    << "Attribute names should be unique.";
+        ASSERT_EQ(rm.addAttribute(tableName, PeterDB::Attribute{"ssn", PeterDB::TypeInt, 4}), success)
+                                    << "RelationManager::addAttribute() should succeed.";
+        ASSERT_EQ(rm.getAttributes(tableName, attrs), success);
+        ASSERT_EQ(attrs.size(), 5u);
+        ASSERT_EQ(attrs[4].name, "ssn");
+        ASSERT_EQ(rm.readTuple(tableName, rids[3], outBuffer), success);
+        ASSERT_EQ(*(unsigned char *) outBuffer, 0x08) << "ssn should be NULL in the tuples written before it was added.";
+        ASSERT_EQ(memcmp((char *) outBuffer + 1, tuples[3].data() + 1, tupleSizes[3] - 1), 0);
+
+        // new tuples and updated ones have it
+        int ssn = 42;
+        float height = 1.5;
+        std::vector<char> tuple(200);
+        size_t tupleSize = buildTuple("Anteater3", 3, &height, 9999.99, &ssn, tuple.data());
+        ASSERT_EQ(rm.updateTuple(tableName, tuple.data(), rids[3]), success);
+        ASSERT_EQ(rm.readTuple(tableName, rids[3], outBuffer), success);
+        ASSERT_EQ(memcmp(outBuffer, tuple.data(), tupleSize), 0);
+        ASSERT_EQ(rm.insertTuple(tableName, tuple.data(), rid), success);
+
+        auto countScan = [&](const std::string &attribute, PeterDB::CompOp compOp, const void *value) {
+            PeterDB::RM_ScanIterator rmsi;
+            EXPECT_EQ(rm.scan(tableName, attribute, compOp, value, {"age", "ssn"}, rmsi), success);
+            unsigned count = 0;
+            PeterDB::RID scanRid;
+            while (rmsi.getNextTuple(scanRid, outBuffer) != RM_EOF) {
+                count++;
+            }
+            rmsi.close();
+            return count;
+        };
+        ASSERT_EQ(countScan("ssn", PeterDB::EQ_OP, &ssn), 2u);
+        ASSERT_EQ(countScan("", PeterDB::NO_OP, nullptr), numTuples + 1);
+
+        // dropped attributes are left out of the tuples written before
+        ASSERT_NE(rm.dropAttribute(tableName, "age"), success) << "Indexed attributes can't be dropped.";
+        ASSERT_NE(rm.dropAttribute(tableName, "weight"), success) << "Only existing attributes can be dropped.";
+        ASSERT_EQ(rm.dropAttribute(tableName, "height"), success) << "RelationManager::dropAttribute() should succeed.";
+        attrs.clear();
+        ASSERT_EQ(rm.getAttributes(tableName, attrs), success);
+        ASSERT_EQ(attrs.size(), 4u);
+        ASSERT_EQ(rm.readTuple(tableName, rids[5], outBuffer), success);
+        ASSERT_EQ(*(unsigned char *) outBuffer, 0x10) << "ssn should still be NULL.";
+        tupleSize = buildTuple("Anteater5", 5, nullptr, 9999.99, nullptr, tuple.data());
+        ASSERT_EQ(memcmp((char *) outBuffer + 1, tuple.data() + 1, tupleSize - 1), 0);
+        ASSERT_EQ(rm.readTuple(tableName, rids[3], outBuffer), success);
+        tupleSize = buildTuple("Anteater3", 3, nullptr, 9999.99, &ssn, tuple.data());
+        ASSERT_EQ(memcmp(outBuffer, tuple.data(), tupleSize), 0);
+
+        // salary dropped then added again is another attribute, NULL in every tuple there
+        ASSERT_EQ(rm.dropAttribute(tableName, "salary"), success);
+        ASSERT_EQ(rm.addAttribute(tableName, PeterDB::Attribute{"salary", PeterDB::TypeReal, 4}), success);
+        ASSERT_EQ(rm.readAttribute(tableName, rids[3], "salary", outBuffer), success);
+        ASSERT_EQ(*(unsigned char *) outBuffer, 0x80) << "The re-added salary should be NULL.";
+        ASSERT_EQ(rm.readAttribute(tableName, rids[3], "ssn", outBuffer), success);
+        ASSERT_EQ(*(int *) ((char *) outBuffer + 1), ssn);
+
+        ASSERT_EQ(rm.checkpoint(), success);
+        ASSERT_EQ(getFileSize(tableName), tableFileSize) << "Schema changes should not rewrite the table.";
+    }
+
+    TEST_F(RM_Tuple_Test, transactions_lock_tuples_and_detect_deadlocks) {
+        // Functions tested
+        // 1. Two transactions updating the same two tuples in opposite orders deadlock, one of them fails
+        // 2. The failed transaction takes no more locks and its commit fails, the other one goes on once
+        //    the failed one commits, and its commit succeeds
+        // 3. A scan in a transaction keeps writers of the table waiting until the transaction commits
+        // 4. A thread can update a table it has a scan of open
+
+        size_t tupleSize = 0;
+        outBuffer = malloc(200);
+        ASSERT_EQ(rm.getAttributes(tableName, attrs), success) << "RelationManager::getAttributes() should succeed.";
+        nullsIndicator = initializeNullFieldsIndicator(attrs);
+
+        std::vector<std::vector<char>> tuples(2, std::vector<char>(200));
+        std::vector<PeterDB::RID> rids(2);
+        for (unsigned i = 0; i < 2; i++) {
+            prepareTuple((int) attrs.size(), nullsIndicator, 8, "Anteater", i, 177.8, 6200, tuples[i].data(),
+                         tupleSize);
+            ASSERT_EQ(rm.insertTuple(tableName, tuples[i].data(), rids[i]), success);
+        }
+
+        PeterDB::LockManager &lockManager = PeterDB::LockManager::instance();
+        unsigned long deadlocks = lockManager.getDeadlockCount();
+
+        // each transaction updates its first tuple, waits for the other one to do the same, then goes for
+        // the tuple the other one has locked
+        std::atomic<unsigned> firstUpdates(0);
+        PeterDB::RC secondUpdate[2] = {success, success};
+        PeterDB::RC thirdUpdate[2] = {success, success};
+        PeterDB::RC commits[2] = {-1, -1};
+        auto transaction = [&](unsigned first) {
+            std::vector<char> tuple(200);
+            size_t size = 0;
+            prepareTuple((int) attrs.size(), nullsIndicator, 7, "Updated", 100 + first, 177.8, 6200, tuple.data(),
+                         size);
+            EXPECT_EQ(rm.beginTransaction(), success);
+            EXPECT_EQ(rm.updateTuple(tableName, tuple.data(), rids[first]), success);
+            firstUpdates++;
+            while (firstUpdates < 2) {
+                std::this_thread::yield();
+            }
+            secondUpdate[first] = rm.updateTuple(tableName, tuple.data(), rids[1 - first]);
+            thirdUpdate[first] = rm.updateTuple(tableName, tuple.data(), rids[first]);
+            commits[first] = rm.commitTransaction();
+        };
+        std::thread first(transaction, 0), second(transaction, 1);
+        first.join();
+        second.join();
+
+        ASSERT_EQ(lockManager.getDeadlockCount(), deadlocks + 1) << "The deadlock should be found.";
+        ASSERT_NE(secondUpdate[0], secondUpdate[1]) << "Exactly one of the transactions should fail.";
+        unsigned survivor = success == secondUpdate[0] ? 0 : 1;
+        ASSERT_NE(thirdUpdate[1 - survivor], success) << "A failed transaction should not go on.";
+        ASSERT_NE(commits[1 - survivor], success) << "A failed transaction should not commit.";
+        ASSERT_EQ(thirdUpdate[survivor], success);
+        ASSERT_EQ(commits[survivor], success);
+
+        // the transaction that went on updated both tuples last
+        for (auto &updatedRid : rids) {
+            ASSERT_EQ(rm.readAttribute(tableName, updatedRid, "age", outBuffer), success);
+            ASSERT_EQ(*(unsigned *) ((char *) outBuffer + 1), 100 + survivor);
+        }
+
+        // writers wait for a transaction scanning the table
+        ASSERT_EQ(rm.beginTransaction(), success);
+        PeterDB::RM_ScanIterator rmsi;
+        ASSERT_EQ(rm.scan(tableName, "", PeterDB::NO_OP, nullptr, {"age"}, rmsi), success);
+        std::atomic<bool> updated(false);
+        std::thread writer([&]() {
+            EXPECT_EQ(rm.updateTuple(tableName, tuples[0].data(), rids[0]), success);
+            updated = true;
+        });
+        std::this_thread::sleep_for(std::chrono::milliseconds(200));
+        ASSERT_FALSE(updated) << "The update should wait for the scanning transaction.";
+        while (rmsi.getNextTuple(rid, outBuffer) != RM_EOF) {
+        }
+        rmsi.close();
+        ASSERT_FALSE(updated) << "Closing the scan should leave the table locked until the commit.";
+        ASSERT_EQ(rm.commitTransaction(), success);
+        writer.join();
+        ASSERT_TRUE(updated);
+
+        // outside of a transaction, the scan has locks of its own, which don't keep the thread waiting
+        ASSERT_EQ(rm.scan(tableName, "", PeterDB::NO_OP, nullptr, {"age"}, rmsi), success);
+        ASSERT_EQ(rmsi.getNextTuple(rid, outBuffer), success);
+        ASSERT_EQ(rm.updateTuple(tableName, tuples[1].data(), rids[1]), success);
+        rmsi.close();
+    }
+
+    TEST_F(RM_Tuple_Test, writers_on_disjoint_tuples_do_not_wait_for_each_other) {
+        // Functions tested
+        // 1. Stress: several threads update disjoint ranges of the tuples of one table, with the log open
+        // 2. None of them waits for a lock, nor deadlocks, and every update is there afterwards
+
+        size_t tupleSize = 0;
+        outBuffer = malloc(200);
+        std::string logFileName = "rm_test_lock_wal";
+        remove(logFileName.c_str());
+        ASSERT_EQ(rm.getAttributes(tableName, attrs), success) << "RelationManager::getAttributes() should succeed.";
+        nullsIndicator = initializeNullFieldsIndicator(attrs);
+
+        unsigned numTuples = 400;
+        std::vector<PeterDB::RID> rids(numTuples);
+        std::vector<char> tuple(200);
+        for (unsigned i = 0; i < numTuples; i++) {
+            prepareTuple((int) attrs.size(), nullsIndicator, 8, "Anteater", i, 177.8, 6200, tuple.data(), tupleSize);
+            ASSERT_EQ(rm.insertTuple(tableName, tuple.data(), rids[i]), success);
+        }
+        ASSERT_EQ(rm.openLog(logFileName), success) << "RelationManager::openLog() should succeed.";
+
+        PeterDB::LockManager &lockManager = PeterDB::LockManager::instance();
+        unsigned long deadlocks = lockManager.getDeadlockCount();
+        unsigned long waits = lockManager.getWaitCount();
+
+        // every round updates each tuple once, split over the writers, the ages tell the round apart
+        unsigned round = 0;
+        for (unsigned writers : {1u, 2u, 4u, 8u}) {
+            round++;
+            std::atomic<unsigned> failures(0);
+            std::vector<std::thread> threads;
+            for (unsigned w = 0; w < writers; w++) {
+                threads.emplace_back([&, w]() {
+                    std::vector<char> updated(200);
+                    size_t size = 0;
+                    for (unsigned i = w * numTuples / writers; i < (w + 1) * numTuples / writers; i++) {
+                        prepareTuple((int) attrs.size(), nullsIndicator, 8, "Anteater", round * numTuples + i,
+                                     177.8, 6200, updated.data(), size);
+                        if (success != rm.updateTuple(tableName, updated.data(), rids[i])) {
+                            failures++;
+                        }
+                    }
+                });
+            }
+            for (auto &thread : threads) {
+                thread.join();
+            }
+            ASSERT_EQ(failures.load(), 0u) << "Every update should succeed.";
+        }
+        ASSERT_EQ(lockManager.getDeadlockCount(), deadlocks) << "Writers of disjoint tuples should not deadlock.";
+        ASSERT_EQ(lockManager.getWaitCount(), waits) << "Writers of disjoint tuples should not wait for locks.";
+
+        for (unsigned i = 0; i < numTuples; i++) {
+            ASSERT_EQ(rm.readAttribute(tableName, rids[i], "age", outBuffer), success);
+            ASSERT_EQ(*(unsigned *) ((char *) outBuffer + 1), round * numTuples + i);
+        }
+
+        ASSERT_EQ(rm.closeLog(), success) << "RelationManager::closeLog() should succeed.";
+        ASSERT_FALSE(fileExists(logFileName));
+    }
+
+    TEST_F(RM_Tuple_Test, calls_on_another_table_go_on_during_a_long_call) {
+        // Functions tested
+        // 1. A thread inserts a large batch of tuples into a table, in one call
+        // 2. Meanwhile, another thread inserts and reads tuples of another table, its calls return while
+        //    the file of the first table is growing
+
+        size_t tupleSize = 0;
+        outBuffer = malloc(200);
+        std::string otherTable = "rm_side_table";
+        remove(otherTable.c_str());
+        ASSERT_EQ(rm.getAttributes(tableName, attrs), success) << "RelationManager::getAttributes() should succeed.";
+        ASSERT_EQ(rm.createTable(otherTable, attrs), success) << "RelationManager::createTable() should succeed.";
+        nullsIndicator = initializeNullFieldsIndicator(attrs);
+
+        // both tables are known to RelationManager before the threads start
+        std::vector<char> tuple(200);
+        prepareTuple((int) attrs.size(), nullsIndicator, 8, "Anteater", 0, 177.8, 6200, tuple.data(), tupleSize);
+        ASSERT_EQ(rm.insertTuple(tableName, tuple.data(), rid), success);
+        ASSERT_EQ(rm.insertTuple(otherTable, tuple.data(), rid), success);
+
+        unsigned numTuples = 50000;
+        std::vector<std::vector<char>> batch(numTuples, std::vector<char>(200));
+        std::vector<const void *> batchData;
+        for (unsigned i = 0; i < numTuples; i++) {
+            prepareTuple((int) attrs.size(), nullsIndicator, 8, "Anteater", (int) i, 177.8, 6200, batch[i].data(),
+                         tupleSize);
+            batchData.push_back(batch[i].data());
+        }
+
+        std::atomic<bool> started(false), done(false);
+        std::vector<PeterDB::RID> batchRids;
+        PeterDB::RC batchRc = -1;
+        std::thread inserter([&]() {
+            started = true;
+            batchRc = rm.insertTuples(tableName, batchData, batchRids);
+            done = true;
+        });
+
+        // the size of the table file as each call returns: the calls seeing a part of the batch written
+        // went on alongside it, not before nor after it
+        size_t sizeBefore = getFileSize(tableName);
+        std::vector<size_t> returned;
+        unsigned failures = 0;
+        while (!started) {
+            std::this_thread::yield();
+        }
+        std::vector<char> read(200);
+        while (!done) {
+            PeterDB::RID otherRid;
+            if (success != rm.insertTuple(otherTable, tuple.data(), otherRid) ||
+                success != rm.readTuple(otherTable, otherRid, read.data()) ||
+                0 != memcmp(read.data(), tuple.data(), tupleSize)) {
+                failures++;
+            }
+            returned.push_back(getFileSize(tableName));
+        }
+        inserter.join();
+
+        ASSERT_EQ(batchRc, success) << "RelationManager::insertTuples() should succeed.";
+        ASSERT_EQ(batchRids.size(), numTuples);
+        ASSERT_EQ(failures, 0u) << "Every call on the other table should succeed.";
+        size_t sizeAfter = getFileSize(tableName);
+        ASSERT_GT(std::count_if(returned.begin(), returned.end(), [&](size_t size) {
+            return size > sizeBefore && size < sizeAfter;
+        }), 10) << "Calls on another table should not wait for the batch.";
+
+        ASSERT_EQ(rm.readTuple(tableName, batchRids[numTuples - 1], read.data()), success);
+        ASSERT_EQ(memcmp(read.data(), batch[numTuples - 1].data(), tupleSize), 0);
+        ASSERT_EQ(rm.deleteTable(otherTable), success) << "RelationManager::deleteTable() should succeed.";
+    }
+
+    TEST_F(RM_Tuple_Test, changes_of_a_failed_transaction_are_undone) {
+        // Functions tested
+        // 1. A transaction inserts, updates and deletes tuples, then waits too long for a lock and fails
+        // 2. Its commit fails and undoes its changes: the table holds what it held before the transaction
+        // 3. The transaction holding the lock goes on, and commits
+
+        size_t tupleSize = 0;
+        outBuffer = malloc(200);
+        ASSERT_EQ(rm.getAttributes(tableName, attrs), success) << "RelationManager::getAttributes() should succeed.";
+        nullsIndicator = initializeNullFieldsIndicator(attrs);
+
+        std::vector<std::vector<char>> tuples(3, std::vector<char>(200));
+        std::vector<PeterDB::RID> rids(3);
+        for (unsigned i = 0; i < 3; i++) {
+            prepareTuple((int) attrs.size(), nullsIndicator, 8, "Anteater", (int) i, 177.8, 6200, tuples[i].data(),
+                         tupleSize);
+            ASSERT_EQ(rm.insertTuple(tableName, tuples[i].data(), rids[i]), success);
+        }
+
+        // another transaction holds the last tuple until the failed one is done
+        std::atomic<bool> locked(false), failed(false);
+        PeterDB::RC otherCommit = -1;
+        std::thread other([&]() {
+            std::vector<char> updated(200);
+            size_t size = 0;
+            prepareTuple((int) attrs.size(), nullsIndicator, 8, "Anteater", 200, 177.8, 6200, updated.data(), size);
+            EXPECT_EQ(rm.beginTransaction(), success);
+            EXPECT_EQ(rm.updateTuple(tableName, updated.data(), rids[2]), success);
+            locked = true;
+            while (!failed) {
+                std::this_thread::yield();
+            }
+            otherCommit = rm.commitTransaction();
+        });
+        while (!locked) {
+            std::this_thread::yield();
+        }
+
+        PeterDB::LockManager &lockManager = PeterDB::LockManager::instance();
+        lockManager.setWaitTimeout(100);
+        std::vector<char> changed(200);
+        prepareTuple((int) attrs.size(), nullsIndicator, 8, "Anteater", 100, 177.8, 6200, changed.data(), tupleSize);
+        PeterDB::RID insertedRid;
+        ASSERT_EQ(rm.beginTransaction(), success);
+        ASSERT_EQ(rm.insertTuple(tableName, changed.data(), insertedRid), success);
+        ASSERT_EQ(rm.updateTuple(tableName, changed.data(), rids[0]), success);
+        ASSERT_EQ(rm.deleteTuple(tableName, rids[1]), success);
+        ASSERT_NE(rm.updateTuple(tableName, changed.data(), rids[2]), success) << "The lock wait should time out.";
+        ASSERT_NE(rm.commitTransaction(), success) << "A failed transaction should not commit.";
+        lockManager.setWaitTimeout(LOCK_WAIT_TIMEOUT_MS);
+        failed = true;
+        other.join();
+        ASSERT_EQ(otherCommit, success);
+
+        // the tuples as they were, the deleted one back under a RID of its own, and the other transaction's update
+        ASSERT_EQ(rm.readTuple(tableName, rids[0], outBuffer), success);
+        ASSERT_EQ(memcmp(outBuffer, tuples[0].data(), tupleSize), 0) << "The update should be undone.";
+        std::vector<int> ages;
+        PeterDB::RM_ScanIterator rmsi;
+        ASSERT_EQ(rm.scan(tableName, "", PeterDB::NO_OP, nullptr, {"age"}, rmsi), success);
+        while (rmsi.getNextTuple(rid, outBuffer) != RM_EOF) {
+            ages.push_back(*(int *) ((char *) outBuffer + 1));
+        }
+        rmsi.close();
+        std::sort(ages.begin(), ages.end());
+        ASSERT_EQ(ages, std::vector<int>({0, 1, 200})) << "The insert and the delete should be undone.";
+    }
+
+    TEST_F(RM_Tuple_Test, snapshot_scans_do_not_wait_for_writers_nor_see_half_of_a_transaction) {
+        // Functions tested
+        // 1. A thread moves amounts between tuples, two updates per transaction or per call, the total stays put
+        // 2. Scans outside of a transaction see the total every time, whatever runs meanwhile
+        // 3. The writer goes on while a scan is held open, without waiting for a lock
+
+        size_t tupleSize = 0;
+        outBuffer = malloc(200);
+        ASSERT_EQ(rm.getAttributes(tableName, attrs), success) << "RelationManager::getAttributes() should succeed.";
+        nullsIndicator = initializeNullFieldsIndicator(attrs);
+
+        unsigned numTuples = 200;
+        int balance = 100;
+        std::vector<PeterDB::RID> rids(numTuples);
+        std::vector<char> tuple(200);
+        for (unsigned i = 0; i < numTuples; i++) {
+            prepareTuple((int) attrs.size(), nullsIndicator, 8, "Anteater", balance, 177.8, 6200, tuple.data(),
+                         tupleSize);
+            ASSERT_EQ(rm.insertTuple(tableName, tuple.data(), rids[i]), success);
+        }
+
+        PeterDB::LockManager &lockManager = PeterDB::LockManager::instance();
+        unsigned long waits = lockManager.getWaitCount();
+
+        // every transfer takes one from a tuple and gives it to the next one, in a transaction of two calls
+        // or in one call updating both
+        std::atomic<bool> stop(false);
+        std::atomic<unsigned> transfers(0);
+        std::atomic<unsigned> failures(0);
+        std::thread writer([&]() {
+            std::vector<int> balances(numTuples, balance);
+            std::vector<char> from(200), to(200);
+            size_t size = 0;
+            for (unsigned t = 0; !stop; t++) {
+                unsigned a = t % numTuples, b = (t + 1) % numTuples;
+                balances[a]--;
+                balances[b]++;
+                prepareTuple((int) attrs.size(), nullsIndicator, 8, "Anteater", balances[a], 177.8, 6200,
+                             from.data(), size);
+                prepareTuple((int) attrs.size(), nullsIndicator, 8, "Anteater", balances[b], 177.8, 6200,
+                             to.data(), size);
+                if (0 == t % 2) {
+                    if (success != rm.beginTransaction() ||
+                        success != rm.updateTuple(tableName, from.data(), rids[a]) ||
+                        success != rm.updateTuple(tableName, to.data(), rids[b]) ||
+                        success != rm.commitTransaction()) {
+                        failures++;
+                    }
+                } else if (success != rm.updateTuples(tableName, {from.data(), to.data()}, {rids[a], rids[b]})) {
+                    failures++;
+                }
+                transfers++;
+            }
+        });
+
+        auto scanTotal = [&](PeterDB::RM_ScanIterator &rmsi, unsigned &count) {
+            int total = 0;
+            while (rmsi.getNextTuple(rid, outBuffer) != RM_EOF) {
+                total += *(int *) ((char *) outBuffer + 1);
+                count++;
+            }
+            rmsi.close();
+            return total;
+        };
+
+        // scans one after the other while the transfers go on
+        for (unsigned scans = 0; scans < 50; scans++) {
+            PeterDB::RM_ScanIterator rmsi;
+            ASSERT_EQ(rm.scan(tableName, "", PeterDB::NO_OP, nullptr, {"age"}, rmsi), success);
+            unsigned count = 0;
+            ASSERT_EQ(scanTotal(rmsi, count), balance * (int) numTuples) << "A scan should see whole transfers.";
+            ASSERT_EQ(count, numTuples);
+        }
+
+        // a scan held open over many transfers
+        PeterDB::RM_ScanIterator rmsi;
+        ASSERT_EQ(rm.scan(tableName, "", PeterDB::NO_OP, nullptr, {"age"}, rmsi), success);
+        ASSERT_EQ(rmsi.getNextTuple(rid, outBuffer), success);
+        int total = *(int *) ((char *) outBuffer + 1);
+        unsigned count = 1;
+        unsigned transfersBefore = transfers;
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(30);
+        while (transfers < transfersBefore + 2 * numTuples && std::chrono::steady_clock::now() < deadline) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        ASSERT_GE(transfers.load(), transfersBefore + 2 * numTuples) << "The writer should not wait for the scan.";
+        total += scanTotal(rmsi, count);
+
+        stop = true;
+        writer.join();
+        ASSERT_EQ(total, balance * (int) numTuples) << "A scan held open should see the tuples as they were.";
+        ASSERT_EQ(count, numTuples);
+        ASSERT_EQ(failures.load(), 0u) << "Every transfer should succeed.";
+        ASSERT_EQ(lockManager.getWaitCount(), waits) << "Scans and the writer should not wait for each other.";
+
+        // the last transfers are seen once they are done
+        ASSERT_EQ(rm.scan(tableName, "", PeterDB::NO_OP, nullptr, {"age"}, rmsi), success);
+        count = 0;
+        ASSERT_EQ(scanTotal(rmsi, count), balance * (int) numTuples);
+        ASSERT_EQ(rm.readAttribute(tableName, rids[0], "age", outBuffer), success);
+        ASSERT_NE(*(int *) ((char *) outBuffer + 1), balance) << "The transfers should have been made.";
+    }
+
+    TEST_F(RM_Tuple_Test, async_calls_return_their_results_and_batch_reads) {
+        // Functions tested
+        // 1. Insert, update and delete tuples through AsyncRelationManager, and through submit()
+        // 2. Read every tuple synchronously, then asynchronously with 1, 8 and 64 reads outstanding
+        // 3. Every read returns its tuple, reads waiting together are served together
+
+        size_t tupleSize = 0;
+        ASSERT_EQ(rm.getAttributes(tableName, attrs), success) << "RelationManager::getAttributes() should succeed.";
+        nullsIndicator = initializeNullFieldsIndicator(attrs);
+
+        unsigned numTuples = 2000;
+        std::vector<std::vector<char>> tuples(numTuples, std::vector<char>(200));
+        std::vector<PeterDB::RID> rids(numTuples);
+        {
+            PeterDB::AsyncRelationManager async;
+            std::vector<std::future<PeterDB::RC>> inserted;
+            for (unsigned i = 0; i < numTuples; i++) {
+                prepareTuple((int) attrs.size(), nullsIndicator, 8, "Anteater", (int) i, 177.8, 6200,
+                             tuples[i].data(), tupleSize);
+                inserted.push_back(async.insertTupleAsync(tableName, tuples[i].data(), rids[i]));
+            }
+            for (auto &rc : inserted) {
+                ASSERT_EQ(rc.get(), success) << "An asynchronous insert should succeed.";
+            }
+
+            // the last tuple is updated, then deleted, the one before it is updated through submit()
+            prepareTuple((int) attrs.size(), nullsIndicator, 8, "Anteater", -1, 177.8, 6200,
+                         tuples[numTuples - 1].data(), tupleSize);
+            ASSERT_EQ(async.updateTupleAsync(tableName, tuples[numTuples - 1].data(), rids[numTuples - 1]).get(),
+                      success);
+            ASSERT_EQ(async.deleteTupleAsync(tableName, rids[numTuples - 1]).get(), success);
+            numTuples--;
+
+            std::atomic<int> submitted(-1);
+            std::vector<char> updated(200);
+            prepareTuple((int) attrs.size(), nullsIndicator, 8, "Anteater", (int) numTuples - 1, 177.8, 6200,
+                         updated.data(), tupleSize);
+            async.submit([&](PeterDB::RelationManager &relationManager) {
+                return relationManager.updateTuple(tableName, updated.data(), rids[numTuples - 1]);
+            }, [&](PeterDB::RC rc) {
+                submitted = rc;
+            });
+            async.drain();
+            ASSERT_EQ(submitted.load(), success) << "A submitted call should succeed.";
+            ASSERT_NE(async.readTupleAsync(tableName, rids[numTuples], tuples[numTuples].data()).get(), success)
+                                        << "Reading a deleted tuple should fail.";
+        }
+
+        // every tuple once, in an order spread over the pages
+        std::vector<unsigned> order(numTuples);
+        for (unsigned i = 0; i < numTuples; i++) {
+            order[i] = i;
+        }
+        std::shuffle(order.begin(), order.end(), std::default_random_engine(44));
+
+        std::vector<char> tuple(200);
+        for (unsigned i : order) {
+            ASSERT_EQ(rm.readTuple(tableName, rids[i], tuple.data()), success);
+            ASSERT_EQ(*(int *) (tuple.data() + 1 + 4 + 8), (int) i);
+        }
+
+        for (unsigned outstanding : {1u, 8u, 64u}) {
+            PeterDB::AsyncRelationManager async;
+            std::vector<std::future<PeterDB::RC>> pending(outstanding);
+            std::vector<unsigned> pendingTuple(outstanding);
+            std::vector<std::vector<char>> buffers(outstanding, std::vector<char>(200));
+            unsigned failures = 0;
+
+            for (unsigned n = 0; n < numTuples + outstanding; n++) {
+                // the read made outstanding requests ago is waited for, then its slot gets the next read
+                unsigned slot = n % outstanding;
+                if (n >= outstanding && (success != pending[slot].get() ||
+                                         (int) pendingTuple[slot] !=
+                                         *(int *) (buffers[slot].data() + 1 + 4 + 8))) {
+                    failures++;
+                }
+                if (n < numTuples) {
+                    pendingTuple[slot] = order[n];
+                    pending[slot] = async.readTupleAsync(tableName, rids[order[n]], buffers[slot].data());
+                }
+            }
+
+            ASSERT_EQ(failures, 0u) << "Every asynchronous read should return its tuple.";
+            ASSERT_EQ(async.getBatchedReadCount(), numTuples);
+            if (1 == outstanding) {
+                ASSERT_EQ(async.getBatchCount(), numTuples) << "A read waited for alone is served alone.";
+            }
+            if (64 == outstanding) {
+                ASSERT_LT(async.getBatchCount(), numTuples) << "Reads waiting together should be batched.";
+            }
+        }
+    }
+
+    TEST_F(RM_Tuple_Test, memory_tables_work_like_disk_tables_without_touching_the_disk) {
+        // Functions tested
+        // 1. Create a memory table, insert, update, delete and read tuples through their RIDs
+        // 2. Scans and index scans of the memory table return what those of a disk table with the same tuples do
+        // 3. Neither the table nor its index has a file on disk
+        // 4. A memory table can be deleted and created again, empty
+
+        size_t tupleSize = 0;
+        outBuffer = malloc(200);
+        void *diskBuffer = malloc(200);
+
+        ASSERT_EQ(rm.getAttributes(tableName, attrs), success) << "RelationManager::getAttributes() should succeed.";
+        nullsIndicator = initializeNullFieldsIndicator(attrs);
+
+        PeterDB::TableOptions options;
+        options.storage = PeterDB::MemoryStorage;
+        std::string memoryTable = "rm_memory_table";
+        ASSERT_EQ(rm.createTable(memoryTable, attrs, options), success) << "RelationManager::createTable() should succeed.";
+        ASSERT_EQ(rm.createIndex(memoryTable, "age"), success) << "RelationManager::createIndex() should succeed.";
+        ASSERT_EQ(rm.createIndex(tableName, "age"), success) << "RelationManager::createIndex() should succeed.";
+
+        unsigned numTuples = 3000;
+        std::vector<PeterDB::RID> memoryRids(numTuples), diskRids(numTuples);
+        for (unsigned i = 0; i < numTuples; i++) {
+            std::string name = "Anteater" + std::to_string(i);
+            prepareTuple((int) attrs.size(), nullsIndicator, name.length(), name, (int) (i * 7 % numTuples),
+                         177.8, (float) i, outBuffer, tupleSize);
+            ASSERT_EQ(rm.insertTuple(memoryTable, outBuffer, memoryRids[i]), success);
+            ASSERT_EQ(rm.insertTuple(tableName, outBuffer, diskRids[i]), success);
+        }
+        auto sameRid = [](const PeterDB::RID &a, const PeterDB::RID &b) {
+            return a.pageNum == b.pageNum && a.slotNum == b.slotNum;
+        };
+        ASSERT_TRUE(std::equal(memoryRids.begin(), memoryRids.end(), diskRids.begin(), sameRid))
+                                    << "Tuples should get the RIDs they would get in a disk table.";
+
+        // tuples grown past their page, and deleted ones, keep or free their RIDs as on disk
+        std::string longName(150, 'a');
+        for (unsigned i = 0; i < numTuples; i += 10) {
+            prepareTuple((int) attrs.size(), nullsIndicator, longName.length(), longName, (int) i, 177.8, (float) i,
+                         outBuffer, tupleSize);
+            ASSERT_EQ(rm.updateTuple(memoryTable, outBuffer, memoryRids[i]), success);
+            ASSERT_EQ(rm.updateTuple(tableName, outBuffer, diskRids[i]), success);
+            ASSERT_EQ(rm.deleteTuple(memoryTable, memoryRids[i + 1]), success);
+            ASSERT_EQ(rm.deleteTuple(tableName, diskRids[i + 1]), success);
+        }
+        for (unsigned i = 0; i < numTuples; i++) {
+            memset(outBuffer, 0, 200);
+            memset(diskBuffer, 0, 200);
+            PeterDB::RC rc = rm.readTuple(memoryTable, memoryRids[i], outBuffer);
+            ASSERT_EQ(rc, rm.readTuple(tableName, diskRids[i], diskBuffer));
+            if (success == rc) {
+                ASSERT_EQ(memcmp(outBuffer, diskBuffer, 200), 0) << "Tuple " << i << " should read the same.";
+            }
+        }
+
+        // scans return the same tuples, in the same order
+        int age = 1500;
+        PeterDB::RM_ScanIterator memoryScan, diskScan;
+        ASSERT_EQ(rm.scan(memoryTable, "age", PeterDB::LT_OP, &age, {"emp_name", "age"}, memoryScan), success);
+        ASSERT_EQ(rm.scan(tableName, "age", PeterDB::LT_OP, &age, {"emp_name", "age"}, diskScan), success);
+        PeterDB::RID diskRid;
+        unsigned scanned = 0;
+        memset(outBuffer, 0, 200);
+        memset(diskBuffer, 0, 200);
+        while (memoryScan.getNextTuple(rid, outBuffer) != RM_EOF) {
+            ASSERT_NE(diskScan.getNextTuple(diskRid, diskBuffer), RM_EOF);
+            ASSERT_TRUE(sameRid(rid, diskRid));
+            ASSERT_EQ(memcmp(outBuffer, diskBuffer, 200), 0);
+            scanned++;
+        }
+        ASSERT_EQ(diskScan.getNextTuple(diskRid, diskBuffer), RM_EOF);
+        memoryScan.close();
+        diskScan.close();
+        ASSERT_GT(scanned, 0u);
+
+        int lowAge = 100, highAge = 2000;
+        PeterDB::RM_IndexScanIterator memoryIndexScan, diskIndexScan;
+        ASSERT_EQ(rm.indexScan(memoryTable, "age", &lowAge, &highAge, true, false, memoryIndexScan), success);
+        ASSERT_EQ(rm.indexScan(tableName, "age", &lowAge, &highAge, true, false, diskIndexScan), success);
+        scanned = 0;
+        while (memoryIndexScan.getNextEntry(rid, outBuffer) != RM_EOF) {
+            ASSERT_NE(diskIndexScan.getNextEntry(diskRid, diskBuffer), RM_EOF);
+            ASSERT_TRUE(sameRid(rid, diskRid));
+            ASSERT_EQ(*(int *) outBuffer, *(int *) diskBuffer);
+            scanned++;
+        }
+        ASSERT_EQ(diskIndexScan.getNextEntry(diskRid, diskBuffer), RM_EOF);
+        memoryIndexScan.close();
+        diskIndexScan.close();
+        ASSERT_GT(scanned, 0u);
+
+        // nothing of the memory table reached the disk
+        std::string indexFileName = memoryTable + "_age_index" + INDEX_FILETYPE;
+        for (auto &fileName : {memoryTable, indexFileName, PeterDB::PagedFileManager::memoryFileName(memoryTable),
+                               PeterDB::PagedFileManager::memoryFileName(indexFileName)}) {
+            ASSERT_FALSE(fileExists(fileName)) << "No file " << fileName << " should be on disk.";
+        }
+
+        ASSERT_EQ(rm.deleteTable(memoryTable), success) << "RelationManager::deleteTable() should succeed.";
+        ASSERT_NE(rm.readTuple(memoryTable, memoryRids[0], outBuffer), success);
+        ASSERT_EQ(rm.createTable(memoryTable, attrs, options), success);
+        ASSERT_NE(rm.readTuple(memoryTable, memoryRids[0], outBuffer), success)
+                                    << "A memory table should be empty once created again.";
+        ASSERT_EQ(rm.deleteTable(memoryTable), success);
+        ASSERT_EQ(rm.destroyIndex(tableName, "age"), success);
+        free(diskBuffer);
+    }
+
+    TEST_F(RM_Tuple_Test, memory_tables_come_back_empty_in_the_next_process) {
+        // Functions tested
+        // 1. A memory table created by a process which is gone is still in the catalog, with its attributes
+        // 2. Its tuples, index entries and the rows of its materialized aggregates are gone
+        // 3. Tuples can be inserted into it again, the index and the view follow them
+        // 4. It can be deleted, with or without being used first, and created again
+
+        size_t tupleSize = 0;
+        outBuffer = malloc(200);
+
+        ASSERT_EQ(rm.getAttributes(tableName, attrs), success) << "RelationManager::getAttributes() should succeed.";
+        nullsIndicator = initializeNullFieldsIndicator(attrs);
+
+        PeterDB::TableOptions options;
+        options.storage = PeterDB::MemoryStorage;
+        std::string memoryTable = "rm_memory_table";
+        std::string viewName = "rm_memory_salary_by_age";
+
+        // the process which creates the memory table exits, and takes its tuples along
+        auto createInAnotherProcess = [&](bool withView) {
+            pid_t pid = fork();
+            ASSERT_NE(pid, -1) << "fork() should succeed.";
+            if (0 == pid) {
+                bool created = success == rm.createTable(memoryTable, attrs, options) &&
+                               success == rm.createIndex(memoryTable, "age") &&
+                               (!withView || success == rm.createMaterializedAggregate(viewName, memoryTable,
+                                                                                       "salary", "age",
+                                                                                       {PeterDB::SUM}));
+                for (unsigned i = 0; created && i < 100; i++) {
+                    prepareTuple((int) attrs.size(), nullsIndicator, 8, "Anteater", (int) (i % 10), 177.8,
+                                 (float) i, outBuffer, tupleSize);
+                    created = success == rm.insertTuple(memoryTable, outBuffer, rid);
+                }
+                // what a shutdown writes out
+                _exit(created && success == rm.checkpoint() ? 0 : 1);
+            }
+            int status = 0;
+            ASSERT_EQ(waitpid(pid, &status, 0), pid);
+            ASSERT_TRUE(WIFEXITED(status) && 0 == WEXITSTATUS(status)) << "The memory table should be created.";
+        };
+        auto countScan = [&](const std::string &table) {
+            PeterDB::RM_ScanIterator rmsi;
+            EXPECT_EQ(rm.scan(table, "", PeterDB::NO_OP, nullptr, {"age"}, rmsi), success);
+            unsigned count = 0;
+            while (rmsi.getNextTuple(rid, outBuffer) != RM_EOF) {
+                count++;
+            }
+            rmsi.close();
+            return count;
+        };
+        auto countIndexScan = [&](int age) {
+            PeterDB::RM_IndexScanIterator rmisi;
+            EXPECT_EQ(rm.indexScan(memoryTable, "age", &age, &age, true, true, rmisi), success);
+            unsigned count = 0;
+            while (rmisi.getNextEntry(rid, outBuffer) != RM_EOF) {
+                count++;
+            }
+            rmisi.close();
+            return count;
+        };
+
+        createInAnotherProcess(true);
+        std::vector<PeterDB::Attribute> memoryAttrs;
+        ASSERT_EQ(rm.getAttributes(memoryTable, memoryAttrs), success)
+                                    << "The memory table should still be in the catalog.";
+        ASSERT_EQ(memoryAttrs.size(), attrs.size());
+        ASSERT_EQ(countScan(memoryTable), 0u) << "The tuples of the memory table should be gone.";
+        ASSERT_EQ(countIndexScan(0), 0u) << "The index entries of the memory table should be gone.";
+        ASSERT_EQ(countScan(viewName), 0u) << "The view should no longer have the groups of the tuples.";
+
+        for (unsigned i = 0; i < 10; i++) {
+            prepareTuple((int) attrs.size(), nullsIndicator, 8, "Anteater", (int) (i % 2), 177.8, (float) i,
+                         outBuffer, tupleSize);
+            ASSERT_EQ(rm.insertTuple(memoryTable, outBuffer, rid), success)
+                                    << "RelationManager::insertTuple() should succeed.";
+        }
+        ASSERT_EQ(rm.readTuple(memoryTable, rid, outBuffer), success);
+        ASSERT_EQ(countScan(memoryTable), 10u);
+        ASSERT_EQ(countIndexScan(0), 5u);
+        ASSERT_EQ(countScan(viewName), 2u) << "The view should follow the tuples inserted again.";
+
+        ASSERT_EQ(rm.deleteTable(memoryTable), success) << "RelationManager::deleteTable() should succeed.";
+        ASSERT_NE(rm.getAttributes(viewName, memoryAttrs), success) << "The view should go along with its table.";
+        ASSERT_NE(rm.getAttributes(memoryTable, memoryAttrs), success);
+        ASSERT_EQ(rm.createTable(memoryTable, attrs, options), success);
+        ASSERT_EQ(countScan(memoryTable), 0u);
+        ASSERT_EQ(rm.deleteTable(memoryTable), success);
+
+        // deleted before anything else is done with it
+        createInAnotherProcess(false);
+        ASSERT_EQ(rm.deleteTable(memoryTable), success) << "RelationManager::deleteTable() should succeed.";
+        ASSERT_NE(rm.deleteTable(memoryTable), success);
+        ASSERT_EQ(rm.createTable(memoryTable, attrs, options), success);
+        ASSERT_EQ(countScan(memoryTable), 0u);
+        ASSERT_EQ(rm.deleteTable(memoryTable), success);
+    }
+
+    TEST_F(RM_Tuple_Test, delete_and_update_where_change_each_page_once) {
+        // Functions tested
+        // 1. deleteWhere() deletes the tuples matching a condition, writing each page it deletes from once
+        // 2. updateWhere() sets attributes of the matching tuples, growing ones moving out of their page
+        // 3. Index entries follow, only the indexes on assigned attributes are changed
+        // 4. Partitioned tables are changed in the partitions which can match
+
+        size_t tupleSize = 0;
+        outBuffer = malloc(200);
+
+        ASSERT_EQ(rm.getAttributes(tableName, attrs), success) << "RelationManager::getAttributes() should succeed.";
+        nullsIndicator = initializeNullFieldsIndicator(attrs);
+        ASSERT_EQ(rm.createIndex(tableName, "age"), success) << "RelationManager::createIndex() should succeed.";
+        ASSERT_EQ(rm.createIndex(tableName, "salary"), success) << "RelationManager::createIndex() should succeed.";
+
+        unsigned numTuples = 2000;
+        std::vector<std::vector<char>> tuples(numTuples, std::vector<char>(200));
+        std::vector<const void *> data;
+        for (unsigned i = 0; i < numTuples; i++) {
+            prepareTuple((int) attrs.size(), nullsIndicator, 8, "Anteater", (int) i, 177.8, (float) i,
+                         tuples[i].data(), tupleSize);
+            data.push_back(tuples[i].data());
+        }
+        std::vector<PeterDB::RID> rids;
+        ASSERT_EQ(rm.insertTuples(tableName, data, rids), success) << "RelationManager::insertTuples() should succeed.";
+
+        auto countScan = [&](const std::string &table, const std::string &attribute, PeterDB::CompOp compOp,
+                             const void *value) {
+            PeterDB::RM_ScanIterator rmsi;
+            EXPECT_EQ(rm.scan(table, attribute, compOp, value, {"age"}, rmsi), success);
+            unsigned count = 0;
+            while (rmsi.getNextTuple(rid, outBuffer) != RM_EOF) {
+                count++;
+            }
+            rmsi.close();
+            return count;
+        };
+        auto countIndexScan = [&](const std::string &table, const std::string &attribute, const void *low,
+                                  const void *high) {
+            PeterDB::RM_IndexScanIterator rmisi;
+            EXPECT_EQ(rm.indexScan(table, attribute, low, high, true, true, rmisi), success);
+            unsigned count = 0;
+            while (rmisi.getNextEntry(rid, outBuffer) != RM_EOF) {
+                EXPECT_EQ(rm.readTuple(table, rid, outBuffer), success) << "Index entries should point to tuples.";
+                count++;
+            }
+            rmisi.close();
+            return count;
+        };
+
+        // every page holds tuples with ages below 1000, they're all deleted from once
+        PeterDB::FileHandle *fileHandle = nullptr;
+        std::vector<PeterDB::Attribute> tableAttrs;
+        unsigned readCount, writeCount, appendCount;
+        unsigned readCountAfter, writeCountAfter, appendCountAfter;
+        ASSERT_EQ(rm.getFileHandleAndAttributes(tableName, fileHandle, tableAttrs), success);
+        unsigned numPages = fileHandle->getNumberOfPages();
+        fileHandle->collectCounterValues(readCount, writeCount, appendCount);
+        rm.releaseFileHandle(tableName);
+
+        int age = 1000;
+        unsigned count = 0;
+        ASSERT_EQ(rm.deleteWhere(tableName, "age", PeterDB::LT_OP, &age, count), success)
+                                    << "RelationManager::deleteWhere() should succeed.";
+        ASSERT_EQ(count, 1000u);
+
+        ASSERT_EQ(rm.getFileHandleAndAttributes(tableName, fileHandle, tableAttrs), success);
+        fileHandle->collectCounterValues(readCountAfter, writeCountAfter, appendCountAfter);
+        rm.releaseFileHandle(tableName);
+        ASSERT_LE(writeCountAfter - writeCount, numPages) << "Each page should be written at most once.";
+        ASSERT_EQ(countScan(tableName, "age", PeterDB::NO_OP, nullptr), 1000u);
+        ASSERT_EQ(countScan(tableName, "age", PeterDB::LT_OP, &age), 0u);
+        ASSERT_NE(rm.readTuple(tableName, rids[0], outBuffer), success);
+        int lowAge = 0, highAge = 1999;
+        ASSERT_EQ(countIndexScan(tableName, "age", &lowAge, &highAge), 1000u);
+        float lowSalary = 0, highSalary = 1999;
+        ASSERT_EQ(countIndexScan(tableName, "salary", &lowSalary, &highSalary), 1000u);
+        ASSERT_EQ(rm.deleteWhere(tableName, "age", PeterDB::LT_OP, &age, count), success);
+        ASSERT_EQ(count, 0u) << "Nothing should be left to delete.";
+
+        // set salary, only its index changes
+        PeterDB::IXFileHandle *ixFileHandle = nullptr;
+        ASSERT_EQ(rm.getFileHandleAndAttributes(tableName, fileHandle, tableAttrs), success);
+        ASSERT_EQ(rm.getIndexFileHandle(tableName, "age", ixFileHandle), success);
+        ixFileHandle->collectCounterValues(readCount, writeCount, appendCount);
+        rm.releaseFileHandle(tableName);
+
+        age = 1500;
+        float salary = 50000;
+        ASSERT_EQ(rm.updateWhere(tableName, "age", PeterDB::GE_OP, &age, {{"salary", &salary}}, count), success)
+                                    << "RelationManager::updateWhere() should succeed.";
+        ASSERT_EQ(count, 500u);
+
+        ASSERT_EQ(rm.getFileHandleAndAttributes(tableName, fileHandle, tableAttrs), success);
+        ASSERT_EQ(rm.getIndexFileHandle(tableName, "age", ixFileHandle), success);
+        ixFileHandle->collectCounterValues(readCountAfter, writeCountAfter, appendCountAfter);
+        rm.releaseFileHandle(tableName);
+        ASSERT_EQ(writeCountAfter, writeCount) << "The index on age should be left alone.";
+        ASSERT_EQ(countScan(tableName, "salary", PeterDB::EQ_OP, &salary), 500u);
+        ASSERT_EQ(countIndexScan(tableName, "salary", &salary, &salary), 500u);
+        ASSERT_EQ(countIndexScan(tableName, "salary", &lowSalary, &highSalary), 500u);
+
+        // longer names move tuples out of their pages, NULL heights
+        std::string longName(60, 'x');
+        std::vector<char> nameValue(sizeof(uint32_t) + longName.size());
+        *(uint32_t *) nameValue.data() = longName.size();
+        memcpy(nameValue.data() + sizeof(uint32_t), longName.data(), longName.size());
+        ASSERT_EQ(rm.updateWhere(tableName, "age", PeterDB::GE_OP, &age,
+                                 {{"emp_name", nameValue.data()}, {"height", nullptr}}, count), success);
+        ASSERT_EQ(count, 500u);
+        ASSERT_EQ(rm.readTuple(tableName, rids[1999], outBuffer), success);
+        ASSERT_EQ(*(uint32_t *) ((char *) outBuffer + 1), longName.size());
+        ASSERT_EQ(memcmp((char *) outBuffer + 5, longName.data(), longName.size()), 0);
+        ASSERT_NE(*(unsigned char *) outBuffer & 0x20, 0) << "Height should be NULL.";
+        ASSERT_EQ(*(int *) ((char *) outBuffer + 5 + longName.size()), 1999);
+        ASSERT_EQ(*(float *) ((char *) outBuffer + 9 + longName.size()), salary);
+        ASSERT_EQ(countScan(tableName, "age", PeterDB::GE_OP, &age), 500u);
+        ASSERT_EQ(countIndexScan(tableName, "age", &lowAge, &highAge), 1000u);
+        ASSERT_NE(rm.updateWhere(tableName, "age", PeterDB::GE_OP, &age, {{"bonus", &salary}}), success)
+                                    << "Unknown attributes can't be assigned.";
+
+        // partitioned tables, pruned by the condition
+        PeterDB::TableOptions options;
+        options.partitioning.method = PeterDB::HashPartitioning;
+        options.partitioning.attribute = "age";
+        options.partitioning.count = 4;
+        std::string partitionedTable = "rm_where_partitioned";
+        ASSERT_EQ(rm.createTable(partitionedTable, attrs, options), success);
+        ASSERT_EQ(rm.insertTuples(partitionedTable, data, rids), success);
+        age = 10;
+        ASSERT_EQ(rm.deleteWhere(partitionedTable, "age", PeterDB::EQ_OP, &age, count), success);
+        ASSERT_EQ(count, 1u);
+        ASSERT_EQ(rm.deleteWhere(partitionedTable, "age", PeterDB::LT_OP, &age, count), success);
+        ASSERT_EQ(count, 10u);
+        ASSERT_NE(rm.updateWhere(partitionedTable, "age", PeterDB::NO_OP, nullptr, {{"age", &age}}), success)
+                                    << "Tuples can't move to another partition.";
+        ASSERT_EQ(rm.updateWhere(partitionedTable, "age", PeterDB::NO_OP, nullptr, {{"salary", &salary}}, count),
+                  success);
+        ASSERT_EQ(count, numTuples - 11);
+        ASSERT_EQ(countScan(partitionedTable, "salary", PeterDB::EQ_OP, &salary), numTuples - 11);
+        ASSERT_EQ(rm.deleteTable(partitionedTable), success);
+
+        ASSERT_EQ(rm.destroyIndex(tableName, "age"), success);
+        ASSERT_EQ(rm.destroyIndex(tableName, "salary"), success);
+    }
+
+    TEST_F(RM_Tuple_Test, row_counts_follow_inserts_and_deletes_without_reading_tuples) {
+        // Functions tested
+        // 1. getRowCount() follows inserts and deletes, updates moving tuples leave it as it is
+        // 2. The count reads no page
+        // 3. Counts with a condition on an indexed attribute come from the index
+        // 4. Full scans skip the pages left without tuples
+        // 5. Partitioned tables add up their partitions
+
+        size_t tupleSize = 0;
+        outBuffer = malloc(200);
+
+        ASSERT_EQ(rm.getAttributes(tableName, attrs), success) << "RelationManager::getAttributes() should succeed.";
+        nullsIndicator = initializeNullFieldsIndicator(attrs);
+        ASSERT_EQ(rm.createIndex(tableName, "age"), success) << "RelationManager::createIndex() should succeed.";
+
+        unsigned count = 0;
+        ASSERT_EQ(rm.getRowCount(tableName, count), success) << "RelationManager::getRowCount() should succeed.";
+        ASSERT_EQ(count, 0u);
+
+        unsigned numTuples = 2000;
+        std::vector<std::vector<char>> tuples(numTuples, std::vector<char>(200));
+        std::vector<const void *> data;
+        for (unsigned i = 0; i < numTuples; i++) {
+            prepareTuple((int) attrs.size(), nullsIndicator, 8, "Anteater", (int) i, 177.8, (float) i,
+                         tuples[i].data(), tupleSize);
+            data.push_back(tuples[i].data());
+        }
+        std::vector<PeterDB::RID> rids;
+        ASSERT_EQ(rm.insertTuples(tableName, data, rids), success) << "RelationManager::insertTuples() should succeed.";
+        ASSERT_EQ(rm.insertTuple(tableName, data[0], rid), success) << "RelationManager::insertTuple() should succeed.";
+
+        PeterDB::FileHandle *fileHandle = nullptr;
+        std::vector<PeterDB::Attribute> tableAttrs;
+        unsigned readCount, writeCount, appendCount;
+        unsigned readCountAfter, writeCountAfter, appendCountAfter;
+        ASSERT_EQ(rm.getFileHandleAndAttributes(tableName, fileHandle, tableAttrs), success);
+        unsigned numPages = fileHandle->getNumberOfPages();
+        fileHandle->collectCounterValues(readCount, writeCount, appendCount);
+        ASSERT_EQ(rm.getRowCount(tableName, count), success);
+        fileHandle->collectCounterValues(readCountAfter, writeCountAfter, appendCountAfter);
+        rm.releaseFileHandle(tableName);
+        ASSERT_EQ(count, numTuples + 1);
+        ASSERT_EQ(readCountAfter, readCount) << "Counting rows should read no page.";
+
+        ASSERT_EQ(rm.deleteTuple(tableName, rid), success) << "RelationManager::deleteTuple() should succeed.";
+        int age = 500;
+        ASSERT_EQ(rm.deleteWhere(tableName, "age", PeterDB::LT_OP, &age, count), success);
+        ASSERT_EQ(count, 500u);
+        ASSERT_EQ(rm.getRowCount(tableName, count), success);
+        ASSERT_EQ(count, numTuples - 500);
+
+        // the first pages only had tuples with ages below 500, a full scan doesn't read them
+        ASSERT_EQ(rm.getFileHandleAndAttributes(tableName, fileHandle, tableAttrs), success);
+        fileHandle->collectCounterValues(readCount, writeCount, appendCount);
+        rm.releaseFileHandle(tableName);
+        ASSERT_EQ(rm.beginTransaction(), success);
+        PeterDB::RM_ScanIterator rmsi;
+        ASSERT_EQ(rm.scan(tableName, "", PeterDB::NO_OP, nullptr, {"age"}, rmsi), success);
+        count = 0;
+        while (rmsi.getNextTuple(rid, outBuffer) != RM_EOF) {
+            ASSERT_GE(*(int *) ((char *) outBuffer + 1), 500);
+            count++;
+        }
+        rmsi.close();
+        ASSERT_EQ(rm.commitTransaction(), success);
+        ASSERT_EQ(count, numTuples - 500);
+        ASSERT_EQ(rm.getFileHandleAndAttributes(tableName, fileHandle, tableAttrs), success);
+        fileHandle->collectCounterValues(readCountAfter, writeCountAfter, appendCountAfter);
+        rm.releaseFileHandle(tableName);
+        ASSERT_LT(readCountAfter - readCount, numPages) << "Pages without tuples should be skipped.";
+
+        // longer names move tuples out of their pages, they are still counted once
+        std::string longName(50, 'x');
+        std::vector<char> nameValue(sizeof(uint32_t) + longName.size());
+        *(uint32_t *) nameValue.data() = longName.size();
+        memcpy(nameValue.data() + sizeof(uint32_t), longName.data(), longName.size());
+        age = 1500;
+        ASSERT_EQ(rm.updateWhere(tableName, "age", PeterDB::GE_OP, &age, {{"emp_name", nameValue.data()}}, count),
+                  success);
+        ASSERT_EQ(count, 500u);
+        ASSERT_EQ(rm.getRowCount(tableName, count), success);
+        ASSERT_EQ(count, numTuples - 500);
+        ASSERT_EQ(rm.deleteTuple(tableName, rids[1999]), success);
+        ASSERT_EQ(rm.getRowCount(tableName, count), success);
+        ASSERT_EQ(count, numTuples - 501);
+
+        // ages 500 to 1998 are left
+        age = 1000;
+        ASSERT_EQ(rm.getRowCount(tableName, "age", PeterDB::LT_OP, &age, count), success)
+                                    << "RelationManager::getRowCount() on an indexed attribute should succeed.";
+        ASSERT_EQ(count, 500u);
+        ASSERT_EQ(rm.getRowCount(tableName, "age", PeterDB::LE_OP, &age, count), success);
+        ASSERT_EQ(count, 501u);
+        ASSERT_EQ(rm.getRowCount(tableName, "age", PeterDB::GT_OP, &age, count), success);
+        ASSERT_EQ(count, 998u);
+        ASSERT_EQ(rm.getRowCount(tableName, "age", PeterDB::EQ_OP, &age, count), success);
+        ASSERT_EQ(count, 1u);
+        ASSERT_EQ(rm.getRowCount(tableName, "age", PeterDB::NE_OP, &age, count), success);
+        ASSERT_EQ(count, 1498u);
+        ASSERT_EQ(rm.getRowCount(tableName, "age", PeterDB::NO_OP, nullptr, count), success);
+        ASSERT_EQ(count, 1499u);
+        float salary = 1000;
+        ASSERT_NE(rm.getRowCount(tableName, "salary", PeterDB::LT_OP, &salary, count), success)
+                                    << "Attributes without an index can't be counted from one.";
+
+        // partitioned tables
+        PeterDB::TableOptions options;
+        options.partitioning.method = PeterDB::HashPartitioning;
+        options.partitioning.attribute = "age";
+        options.partitioning.count = 4;
+        std::string partitionedTable = "rm_count_partitioned";
+        ASSERT_EQ(rm.createTable(partitionedTable, attrs, options), success);
+        ASSERT_EQ(rm.createIndex(partitionedTable, "age"), success);
+        ASSERT_EQ(rm.insertTuples(partitionedTable, data, rids), success);
+        ASSERT_EQ(rm.getRowCount(partitionedTable, count), success);
+        ASSERT_EQ(count, numTuples);
+        ASSERT_EQ(rm.getRowCount(partitionedTable, "age", PeterDB::LT_OP, &age, count), success);
+        ASSERT_EQ(count, 1000u);
+        ASSERT_EQ(rm.deleteWhere(partitionedTable, "age", PeterDB::GE_OP, &age, count), success);
+        ASSERT_EQ(rm.getRowCount(partitionedTable, count), success);
+        ASSERT_EQ(count, 1000u);
+        ASSERT_EQ(rm.deleteTable(partitionedTable), success);
+
+        ASSERT_EQ(rm.destroyIndex(tableName, "age"), success);
+    }
+
+    TEST_F(RM_Tuple_Test, cluster_rewrites_the_table_in_attribute_order) {
+        // Functions tested
+        // 1. Clustering a table brings its tuples back in the order of the attribute, NULLs last, in fewer pages
+        // 2. Its indexes are rebuilt, and find every tuple at its new RID
+        // 3. Reads go on while the table is rewritten, the switch waits for the open scan
+        // 4. The table is in new files afterwards, and takes inserts as before
+
+        size_t tupleSize = 0;
+        outBuffer = malloc(200);
+
+        ASSERT_EQ(rm.getAttributes(tableName, attrs), success) << "RelationManager::getAttributes() should succeed.";
+        nullsIndicator = initializeNullFieldsIndicator(attrs);
+        unsigned char *nullAgeIndicator = initializeNullFieldsIndicator(attrs);
+        nullAgeIndicator[0] = 0x40;
+        ASSERT_EQ(rm.createIndex(tableName, "age"), success) << "RelationManager::createIndex() should succeed.";
+        ASSERT_EQ(rm.createIndex(tableName, "salary"), success) << "RelationManager::createIndex() should succeed.";
+
+        // ages in a scrambled order, every 50th one NULL, then a third of the tuples deleted
+        unsigned numTuples = 2000;
+        std::vector<PeterDB::RID> rids(numTuples);
+        std::vector<char> tuple(200);
+        for (unsigned i = 0; i < numTuples; i++) {
+            prepareTuple((int) attrs.size(), 0 == i % 50 ? nullAgeIndicator : nullsIndicator, 8, "Anteater",
+                         (int) ((i * 7919) % numTuples), 177.8, (float) i, tuple.data(), tupleSize);
+            ASSERT_EQ(rm.insertTuple(tableName, tuple.data(), rids[i]), success);
+        }
+        unsigned remaining = 0, remainingNulls = 0;
+        for (unsigned i = 0; i < numTuples; i++) {
+            if (0 == i % 3) {
+                ASSERT_EQ(rm.deleteTuple(tableName, rids[i]), success);
+            } else {
+                remaining++;
+                remainingNulls += 0 == i % 50 ? 1 : 0;
+            }
+        }
+        free(nullAgeIndicator);
+
+        PeterDB::FileHandle *fileHandle = nullptr;
+        std::vector<PeterDB::Attribute> tableAttrs;
+        ASSERT_EQ(rm.getFileHandleAndAttributes(tableName, fileHandle, tableAttrs), success);
+        unsigned numPages = fileHandle->getNumberOfPages();
+        rm.releaseFileHandle(tableName);
+
+        ASSERT_NE(rm.cluster(tableName, "bonus"), success) << "Clustering on a missing attribute should fail.";
+
+        // a scan is held open while the table is clustered on another thread
+        PeterDB::LockManager &lockManager = PeterDB::LockManager::instance();
+        unsigned long waits = lockManager.getWaitCount();
+        PeterDB::RM_ScanIterator rmsi;
+        ASSERT_EQ(rm.scan(tableName, "", PeterDB::NO_OP, nullptr, {"salary"}, rmsi), success);
+        ASSERT_EQ(rmsi.getNextTuple(rid, outBuffer), success);
+        std::atomic<bool> clustered(false);
+        PeterDB::RC clusterRc = -1;
+        std::thread clusterer([&]() {
+            clusterRc = rm.cluster(tableName, "age");
+            clustered = true;
+        });
+
+        // once the new files are written, the switch waits for the scan
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(30);
+        while (lockManager.getWaitCount() == waits && !clustered && std::chrono::steady_clock::now() < deadline) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        ASSERT_GT(lockManager.getWaitCount(), waits) << "Clustering should wait for the open scan.";
+        ASSERT_FALSE(clustered.load());
+        ASSERT_TRUE(fileExists(tableName + "#1")) << "The clustered file should be written meanwhile.";
+        ASSERT_EQ(rm.readTuple(tableName, rids[1], outBuffer), success) << "Reads should not wait for clustering.";
+        unsigned count = 1;
+        while (rmsi.getNextTuple(rid, outBuffer) != RM_EOF) {
+            count++;
+        }
+        rmsi.close();
+        clusterer.join();
+        ASSERT_EQ(clusterRc, success) << "RelationManager::cluster() should succeed.";
+        ASSERT_EQ(count, remaining) << "The open scan should see every tuple of the old file.";
+        ASSERT_FALSE(fileExists(tableName)) << "The old file should be removed.";
+
+        // the tuples come back by age, NULLs last
+        ASSERT_EQ(rm.scan(tableName, "", PeterDB::NO_OP, nullptr, {"age", "salary"}, rmsi), success);
+        count = 0;
+        int previousAge = -1;
+        unsigned nulls = 0;
+        std::vector<PeterDB::RID> clusteredRids;
+        std::vector<float> salaries;
+        while (rmsi.getNextTuple(rid, outBuffer) != RM_EOF) {
+            if (0 != (*(unsigned char *) outBuffer & 0x80)) {
+                nulls++;
+                continue;
+            }
+            ASSERT_EQ(nulls, 0u) << "Tuples with a NULL age should come last.";
+            int age = *(int *) ((char *) outBuffer + 1);
+            ASSERT_LT(previousAge, age) << "Tuples should come back by age.";
+            previousAge = age;
+            clusteredRids.push_back(rid);
+            salaries.push_back(*(float *) ((char *) outBuffer + 1 + 4));
+            count++;
+        }
+        rmsi.close();
+        ASSERT_EQ(count + nulls, remaining);
+        ASSERT_EQ(nulls, remainingNulls);
+        ASSERT_TRUE(std::is_sorted(clusteredRids.begin(), clusteredRids.end(),
+                                   [](const PeterDB::RID &a, const PeterDB::RID &b) {
+                                       return a.pageNum < b.pageNum ||
+                                              (a.pageNum == b.pageNum && a.slotNum < b.slotNum);
+                                   })) << "Tuples should be in pages in the order of their ages.";
+
+        ASSERT_EQ(rm.getFileHandleAndAttributes(tableName, fileHandle, tableAttrs), success);
+        ASSERT_LT(fileHandle->getNumberOfPages(), numPages) << "Tuples should be packed into fewer pages.";
+        rm.releaseFileHandle(tableName);
+        ASSERT_EQ(rm.getRowCount(tableName, count), success);
+        ASSERT_EQ(count, remaining);
+
+        // both indexes find the tuples at their new RIDs
+        PeterDB::RM_IndexScanIterator rmisi;
+        ASSERT_EQ(rm.indexScan(tableName, "age", nullptr, nullptr, true, true, rmisi), success);
+        count = 0;
+        char key[PAGE_SIZE];
+        while (rmisi.getNextEntry(rid, key) != RM_EOF) {
+            ASSERT_EQ(rid.pageNum, clusteredRids[count].pageNum) << "The index should follow the clustered order.";
+            ASSERT_EQ(rid.slotNum, clusteredRids[count].slotNum);
+            count++;
+        }
+        rmisi.close();
+        ASSERT_EQ(count, remaining - remainingNulls);
+
+        float salary = salaries[10];
+        ASSERT_EQ(rm.indexScan(tableName, "salary", &salary, &salary, true, true, rmisi), success);
+        ASSERT_EQ(rmisi.getNextEntry(rid, key), success);
+        ASSERT_EQ(rmisi.getNextEntry(rid, key), RM_EOF);
+        rmisi.close();
+        ASSERT_EQ(rm.readAttribute(tableName, rid, "salary", outBuffer), success);
+        ASSERT_EQ(*(float *) ((char *) outBuffer + 1), salary);
+        ASSERT_EQ(rid.pageNum, clusteredRids[10].pageNum);
+        ASSERT_EQ(rid.slotNum, clusteredRids[10].slotNum);
+
+        // inserts go on as before, and a second clustering moves to yet another file
+        prepareTuple((int) attrs.size(), nullsIndicator, 8, "Anteater", -1, 177.8, 1e6, tuple.data(), tupleSize);
+        ASSERT_EQ(rm.insertTuple(tableName, tuple.data(), rid), success);
+        int age = -1;
+        ASSERT_EQ(rm.getRowCount(tableName, "age", PeterDB::EQ_OP, &age, count), success);
+        ASSERT_EQ(count, 1u);
+        ASSERT_EQ(rm.cluster(tableName, "age"), success);
+        ASSERT_TRUE(fileExists(tableName + "#2"));
+        ASSERT_FALSE(fileExists(tableName + "#1"));
+        ASSERT_EQ(rm.scan(tableName, "", PeterDB::NO_OP, nullptr, {"age"}, rmsi), success);
+        ASSERT_EQ(rmsi.getNextTuple(rid, outBuffer), success);
+        ASSERT_EQ(*(int *) ((char *) outBuffer + 1), -1) << "The inserted tuple should come first.";
+        rmsi.close();
+
+        ASSERT_EQ(rm.destroyIndex(tableName, "age"), success);
+        ASSERT_EQ(rm.destroyIndex(tableName, "salary"), success);
+    }
+
+    // size of a file on disk, 0 if there is none
+    size_t sizeOnDisk(const std::string &path) {
+        struct stat statBuffer{};
+        return 0 == stat(path.c_str(), &statBuffer) ? statBuffer.st_size : 0;
+    }
+
+    TEST_F(RM_Tuple_Test, tablespaces_place_and_stripe_table_files_over_directories) {
+        // Functions tested
+        // 1. Tables are created in the first directory of their tablespace, and deleted from there
+        // 2. A striped table has its pages spread over all the directories of the tablespace, extent after extent
+        // 3. Indexes can go to another tablespace than their table, and stay there when the table is clustered
+        // 4. Tablespaces still holding tables or indexes can't be dropped
+
+        size_t tupleSize = 0;
+        outBuffer = malloc(200);
+
+        ASSERT_EQ(rm.getAttributes(tableName, attrs), success) << "RelationManager::getAttributes() should succeed.";
+        nullsIndicator = initializeNullFieldsIndicator(attrs);
+
+        std::vector<std::string> directories = {"rm_tablespace_a", "rm_tablespace_b", "rm_tablespace_c"};
+        for (auto &directory : directories) {
+            mkdir(directory.c_str(), 0755);
+        }
+        ASSERT_NE(rm.createTablespace("fast", {"rm_tablespace_missing"}), success)
+                                    << "Tablespaces should only have existing directories.";
+        ASSERT_EQ(rm.createTablespace("fast", {directories[0], directories[1]}), success)
+                                    << "RelationManager::createTablespace() should succeed.";
+        ASSERT_EQ(rm.createTablespace("archive", {directories[2]}), success);
+        ASSERT_NE(rm.createTablespace("fast", {directories[2]}), success) << "Tablespace names should be unique.";
+        std::vector<std::string> tablespaceDirectories;
+        ASSERT_EQ(rm.getTablespace("fast", tablespaceDirectories), success);
+        ASSERT_EQ(tablespaceDirectories, std::vector<std::string>({directories[0], directories[1]}));
+
+        PeterDB::TableOptions options;
+        options.tablespace = "fast";
+        options.storage = PeterDB::MemoryStorage;
+        std::string stripedTable = "rm_striped";
+        ASSERT_NE(rm.createTable(stripedTable, attrs, options), success) << "Memory tables have no directory.";
+        options.storage = PeterDB::DiskStorage;
+        options.striped = true;
+        ASSERT_EQ(rm.createTable(stripedTable, attrs, options), success)
+                                    << "RelationManager::createTable() in a tablespace should succeed.";
+        ASSERT_TRUE(fileExists(directories[0] + "/" + stripedTable));
+        ASSERT_FALSE(fileExists(stripedTable)) << "The table should not be in the working directory.";
+        ASSERT_EQ(rm.createIndex(stripedTable, {"age"}, {}, "archive"), success)
+                                    << "RelationManager::createIndex() in a tablespace should succeed.";
+        ASSERT_TRUE(fileExists(directories[2] + "/" + stripedTable + "_age_index.idx"));
+
+        // enough tuples for several extents
+        unsigned numTuples = 8000;
+        std::string name(50, 'n');
+        std::vector<std::vector<char> > tuples(numTuples, std::vector<char>(200));
+        std::vector<const void *> data;
+        for (unsigned i = 0; i < numTuples; i++) {
+            prepareTuple((int) attrs.size(), nullsIndicator, name.length(), name, (int) (numTuples - i), 177.8,
+                         (float) i, tuples[i].data(), tupleSize);
+            data.push_back(tuples[i].data());
+        }
+        std::vector<PeterDB::RID> rids;
+        ASSERT_EQ(rm.insertTuples(stripedTable, data, rids), success);
+
+        PeterDB::FileHandle *fileHandle = nullptr;
+        std::vector<PeterDB::Attribute> tableAttrs;
+        ASSERT_EQ(rm.getFileHandleAndAttributes(stripedTable, fileHandle, tableAttrs), success);
+        ASSERT_EQ(fileHandle->getStripeCount(), 2u);
+        unsigned numPages = fileHandle->getNextPageNum();
+        rm.releaseFileHandle(stripedTable);
+        ASSERT_GT(numPages, 2u * STRIPE_EXTENT_PAGES) << "The table should take more than an extent per stripe.";
+        rm.checkpoint();
+
+        // the header page stays in the table file, the other pages go to the stripes in turn
+        size_t firstStripe = sizeOnDisk(directories[0] + "/" + stripedTable + STRIPE_FILE_SUFFIX + "0");
+        size_t secondStripe = sizeOnDisk(directories[1] + "/" + stripedTable + STRIPE_FILE_SUFFIX + "1");
+        ASSERT_EQ(sizeOnDisk(directories[0] + "/" + stripedTable), (size_t) PAGE_SIZE);
+        ASSERT_EQ(firstStripe + secondStripe, (size_t) PAGE_SIZE * numPages);
+        ASSERT_GE(firstStripe, (size_t) PAGE_SIZE * STRIPE_EXTENT_PAGES);
+        ASSERT_GE(secondStripe, (size_t) PAGE_SIZE * STRIPE_EXTENT_PAGES);
+
+        for (unsigned i = 0; i < numTuples; i += 97) {
+            ASSERT_EQ(rm.readTuple(stripedTable, rids[i], outBuffer), success);
+            ASSERT_EQ(memcmp(outBuffer, data[i], tupleSize), 0) << "Tuples should read back from the stripes.";
+        }
+        PeterDB::RM_ScanIterator rmsi;
+        ASSERT_EQ(rm.scan(stripedTable, "", PeterDB::NO_OP, nullptr, {"age"}, rmsi), success);
+        unsigned count = 0;
+        while (rmsi.getNextTuple(rid, outBuffer) != RM_EOF) {
+            count++;
+        }
+        rmsi.close();
+        ASSERT_EQ(count, numTuples);
+
+        // clustering writes a new striped file, the index stays in its own tablespace
+        ASSERT_EQ(rm.cluster(stripedTable, "age"), success);
+        ASSERT_FALSE(fileExists(directories[0] + "/" + stripedTable + STRIPE_FILE_SUFFIX + "0"));
+        ASSERT_TRUE(fileExists(directories[0] + "/" + stripedTable + "#1" + STRIPE_FILE_SUFFIX + "0"));
+        ASSERT_TRUE(fileExists(directories[1] + "/" + stripedTable + "#1" + STRIPE_FILE_SUFFIX + "1"));
+        ASSERT_FALSE(fileExists(directories[2] + "/" + stripedTable + "_age_index.idx"));
+        ASSERT_TRUE(fileExists(directories[2] + "/" + stripedTable + "#1_age_index.idx"));
+        int lowAge = 1001, highAge = 2000;
+        PeterDB::RM_IndexScanIterator rmisi;
+        ASSERT_EQ(rm.indexScan(stripedTable, "age", &lowAge, &highAge, true, true, {"age"}, rmisi), success);
+        count = 0;
+        while (rmisi.getNextTuple(rid, outBuffer) != RM_EOF) {
+            ASSERT_EQ(*(int *) ((char *) outBuffer + 1), lowAge + (int) count);
+            count++;
+        }
+        rmisi.close();
+        ASSERT_EQ(count, 1000u);
+
+        // partitions go to the tablespace of their table
+        PeterDB::TableOptions partitionedOptions;
+        partitionedOptions.tablespace = "archive";
+        partitionedOptions.partitioning.method = PeterDB::HashPartitioning;
+        partitionedOptions.partitioning.attribute = "age";
+        partitionedOptions.partitioning.count = 2;
+        std::string partitionedTable = "rm_tablespace_partitioned";
+        ASSERT_EQ(rm.createTable(partitionedTable, attrs, partitionedOptions), success);
+        ASSERT_EQ(rm.insertTuples(partitionedTable, data, rids), success);
+        ASSERT_TRUE(fileExists(directories[2] + "/" + PeterDB::RelationManager::partitionTableName(partitionedTable, 0)));
+        ASSERT_TRUE(fileExists(directories[2] + "/" + PeterDB::RelationManager::partitionTableName(partitionedTable, 1)));
+        ASSERT_EQ(rm.getRowCount(partitionedTable, count), success);
+        ASSERT_EQ(count, numTuples);
+
+        ASSERT_NE(rm.dropTablespace("archive"), success) << "Tablespaces in use should not be dropped.";
+        ASSERT_EQ(rm.deleteTable(partitionedTable), success);
+        ASSERT_NE(rm.dropTablespace("archive"), success) << "The index of the striped table is still in there.";
+        ASSERT_EQ(rm.destroyIndex(stripedTable, "age"), success);
+        ASSERT_FALSE(fileExists(directories[2] + "/" + stripedTable + "#1_age_index.idx"));
+        ASSERT_EQ(rm.dropTablespace("archive"), success) << "RelationManager::dropTablespace() should succeed.";
+        ASSERT_NE(rm.getTablespace("archive", tablespaceDirectories), success);
+
+        ASSERT_NE(rm.dropTablespace("fast"), success);
+        ASSERT_EQ(rm.deleteTable(stripedTable), success);
+        ASSERT_FALSE(fileExists(directories[0] + "/" + stripedTable + "#1"));
+        ASSERT_FALSE(fileExists(directories[0] + "/" + stripedTable + "#1" + STRIPE_FILE_SUFFIX + "0"));
+        ASSERT_FALSE(fileExists(directories[1] + "/" + stripedTable + "#1" + STRIPE_FILE_SUFFIX + "1"));
+        ASSERT_EQ(rm.dropTablespace("fast"), success);
+
+        for (auto &directory : directories) {
+            ASSERT_EQ(rmdir(directory.c_str()), 0) << "Every file should be gone from " << directory;
+        }
+    }
+
+    TEST_F(RM_Tuple_Test, materialized_aggregates_follow_inserts_deletes_and_updates) {
+        // Functions tested
+        // 1. A materialized aggregate starts with a row per group of the tuples already in its base table
+        // 2. Inserts, deletes and updates, by RID or by condition, keep every group up to date, deleting the
+        //    min or max of a group included, and groups left empty are removed
+        // 3. The view can't be written to, nor can the attributes it aggregates be dropped
+        // 4. Partitioned tables keep views up to date, also with the whole table as a single group
+        // 5. Deleting the base table deletes its views
+
+        size_t tupleSize = 0;
+        outBuffer = malloc(200);
+
+        ASSERT_EQ(rm.getAttributes(tableName, attrs), success) << "RelationManager::getAttributes() should succeed.";
+        nullsIndicator = initializeNullFieldsIndicator(attrs);
+        unsigned char *nullSalaryIndicator = initializeNullFieldsIndicator(attrs);
+        nullSalaryIndicator[0] = 0x10;
+
+        // ages 0 to 9 are the groups, every 100th salary is NULL and left out
+        unsigned numTuples = 1000;
+        std::vector<std::vector<char>> tuples(numTuples, std::vector<char>(200));
+        std::vector<const void *> data;
+        for (unsigned i = 0; i < numTuples; i++) {
+            prepareTuple((int) attrs.size(), 0 == i % 100 ? nullSalaryIndicator : nullsIndicator, 8, "Anteater",
+                         (int) (i % 10), 177.8, (float) i, tuples[i].data(), tupleSize);
+            data.push_back(tuples[i].data());
+        }
+        free(nullSalaryIndicator);
+        std::vector<PeterDB::RID> rids;
+        ASSERT_EQ(rm.insertTuples(tableName, std::vector<const void *>(data.begin(), data.begin() + 500), rids),
+                  success);
+
+        std::string viewName = "rm_salary_by_age";
+        ASSERT_NE(rm.createMaterializedAggregate(viewName, tableName, "emp_name", "age", {PeterDB::SUM}), success)
+                                    << "Varchars can't be aggregated.";
+        ASSERT_NE(rm.createMaterializedAggregate(viewName, tableName, "salary", "bonus", {PeterDB::SUM}), success);
+        ASSERT_EQ(rm.createMaterializedAggregate(viewName, tableName, "salary", "age",
+                                                 {PeterDB::MAX, PeterDB::MIN, PeterDB::AVG}), success)
+                                    << "RelationManager::createMaterializedAggregate() should succeed.";
+        ASSERT_NE(rm.createMaterializedAggregate(viewName, tableName, "salary", "age", {PeterDB::SUM}), success)
+                                    << "The view should already exist.";
+
+        // the group, then the ops in the order of AggregateOp, COUNT and SUM being kept for AVG
+        std::vector<PeterDB::Attribute> viewAttrs;
+        ASSERT_EQ(rm.getAttributes(viewName, viewAttrs), success);
+        std::vector<std::string> viewAttrNames;
+        for (auto &attr : viewAttrs) {
+            viewAttrNames.push_back(attr.name);
+        }
+        ASSERT_EQ(viewAttrNames, std::vector<std::string>({"age", "MIN(" + tableName + ".salary)",
+                                                           "MAX(" + tableName + ".salary)",
+                                                           "COUNT(" + tableName + ".salary)",
+                                                           "SUM(" + tableName + ".salary)",
+                                                           "AVG(" + tableName + ".salary)"}));
+
+        // the view has the same rows as an aggregation of the base table
+        auto expectViewOfTable = [&](const std::string &baseTable, const std::string &view, bool grouped) {
+            std::map<int, std::vector<float>> groups;
+            PeterDB::RM_ScanIterator rmsi;
+            ASSERT_EQ(rm.scan(baseTable, "", PeterDB::NO_OP, nullptr, {"age", "salary"}, rmsi), success);
+            while (rmsi.getNextTuple(rid, outBuffer) != RM_EOF) {
+                unsigned char nulls = *(unsigned char *) outBuffer;
+                if (0 == (nulls & 0x40) && (!grouped || 0 == (nulls & 0x80))) {
+                    int age = grouped ? *(int *) ((char *) outBuffer + 1) : 0;
+                    groups[age].push_back(*(float *) ((char *) outBuffer + 1 + 4));
+                }
+            }
+            rmsi.close();
+
+            std::vector<PeterDB::Attribute> attributes;
+            ASSERT_EQ(rm.getAttributes(view, attributes), success);
+            std::vector<std::string> names;
+            for (auto &attr : attributes) {
+                names.push_back(attr.name);
+            }
+            ASSERT_EQ(rm.scan(view, "", PeterDB::NO_OP, nullptr, names, rmsi), success);
+            unsigned rows = 0;
+            while (rmsi.getNextTuple(rid, outBuffer) != RM_EOF) {
+                rows++;
+                const char *field = (char *) outBuffer + 1;
+                int age = 0;
+                if (grouped) {
+                    age = *(int *) field;
+                    field += 4;
+                }
+                ASSERT_TRUE(groups.end() != groups.find(age)) << "Group " << age << " should have tuples.";
+                std::vector<float> &values = groups[age];
+                float sum = 0;
+                for (float value : values) {
+                    sum += value;
+                }
+                for (unsigned i = grouped ? 1 : 0; i < names.size(); i++, field += 4) {
+                    float value = *(float *) field;
+                    if (0 == names[i].find("MIN(")) {
+                        ASSERT_EQ(value, *std::min_element(values.begin(), values.end())) << "age " << age;
+                    } else if (0 == names[i].find("MAX(")) {
+                        ASSERT_EQ(value, *std::max_element(values.begin(), values.end())) << "age " << age;
+                    } else if (0 == names[i].find("COUNT(")) {
+                        ASSERT_EQ(value, (float) values.size()) << "age " << age;
+                    } else if (0 == names[i].find("SUM(")) {
+                        ASSERT_EQ(value, sum) << "age " << age;
+                    } else {
+                        ASSERT_FLOAT_EQ(value, sum / values.size()) << "age " << age;
+                    }
+                }
+            }
+            rmsi.close();
+            ASSERT_EQ(rows, groups.size()) << "The view should have a row per group.";
+        };
+        expectViewOfTable(tableName, viewName, true);
+
+        // inserts, one by one and batched
+        ASSERT_EQ(rm.insertTuple(tableName, data[500], rid), success);
+        rids.push_back(rid);
+        std::vector<PeterDB::RID> insertedRids;
+        ASSERT_EQ(rm.insertTuples(tableName, std::vector<const void *>(data.begin() + 501, data.end()), insertedRids),
+                  success);
+        rids.insert(rids.end(), insertedRids.begin(), insertedRids.end());
+        expectViewOfTable(tableName, viewName, true);
+
+        // deleting the min and max of age 3 (salaries 3 and 993), and more
+        ASSERT_EQ(rm.deleteTuple(tableName, rids[3]), success);
+        ASSERT_EQ(rm.deleteTuples(tableName, {rids[993], rids[13], rids[14]}), success);
+        expectViewOfTable(tableName, viewName, true);
+
+        // moving tuples to another group, and changing their salary within it
+        prepareTuple((int) attrs.size(), nullsIndicator, 8, "Anteater", 3, 177.8, -5, tuples[0].data(), tupleSize);
+        ASSERT_EQ(rm.updateTuple(tableName, tuples[0].data(), rids[25]), success);
+        prepareTuple((int) attrs.size(), nullsIndicator, 8, "Anteater", 6, 177.8, 5000, tuples[1].data(), tupleSize);
+        ASSERT_EQ(rm.updateTuple(tableName, tuples[1].data(), rids[996]), success);
+        expectViewOfTable(tableName, viewName, true);
+
+        // by condition, emptying age 9 on the way
+        int age = 9;
+        unsigned count = 0;
+        ASSERT_EQ(rm.deleteWhere(tableName, "age", PeterDB::EQ_OP, &age, count), success);
+        ASSERT_EQ(count, 100u);
+        float salary = 900;
+        ASSERT_EQ(rm.deleteWhere(tableName, "salary", PeterDB::GE_OP, &salary, count), success);
+        expectViewOfTable(tableName, viewName, true);
+        age = 7;
+        salary = 100;
+        ASSERT_EQ(rm.updateWhere(tableName, "salary", PeterDB::LT_OP, &salary, {{"age", &age}}, count), success);
+        expectViewOfTable(tableName, viewName, true);
+        float newSalary = 1;
+        ASSERT_EQ(rm.updateWhere(tableName, "age", PeterDB::EQ_OP, &age, {{"salary", &newSalary}}, count), success);
+        expectViewOfTable(tableName, viewName, true);
+
+        // only the base table changes the view
+        PeterDB::RM_ScanIterator rmsi;
+        ASSERT_EQ(rm.scan(viewName, "", PeterDB::NO_OP, nullptr, viewAttrNames, rmsi), success);
+        ASSERT_EQ(rmsi.getNextTuple(rid, outBuffer), success);
+        rmsi.close();
+        ASSERT_NE(rm.insertTuple(viewName, outBuffer, rid), success) << "Views should not be written to.";
+        ASSERT_NE(rm.updateTuple(viewName, outBuffer, rid), success);
+        ASSERT_NE(rm.deleteTuple(viewName, rid), success);
+        ASSERT_NE(rm.deleteWhere(viewName, "", PeterDB::NO_OP, nullptr), success);
+        ASSERT_NE(rm.dropAttribute(tableName, "salary"), success) << "Aggregated attributes can't be dropped.";
+        ASSERT_NE(rm.dropAttribute(tableName, "age"), success);
+        ASSERT_EQ(rm.dropAttribute(tableName, "height"), success);
+        std::vector<char> tupleWithoutHeight(1 + 4 + 8 + 4 + 4, 0);
+        memcpy(tupleWithoutHeight.data() + 1, "\x08\0\0\0Anteater", 12);
+        age = 2;
+        salary = 12345;
+        memcpy(tupleWithoutHeight.data() + 1 + 12, &age, 4);
+        memcpy(tupleWithoutHeight.data() + 1 + 12 + 4, &salary, 4);
+        ASSERT_EQ(rm.insertTuple(tableName, tupleWithoutHeight.data(), rid), success);
+        expectViewOfTable(tableName, viewName, true);
+
+        // a partitioned table, with a view of the whole table and one by its partition key
+        PeterDB::TableOptions options;
+        options.partitioning.method = PeterDB::HashPartitioning;
+        options.partitioning.attribute = "age";
+        options.partitioning.count = 3;
+        std::string partitionedTable = "rm_agg_partitioned";
+        ASSERT_EQ(rm.createTable(partitionedTable, attrs, options), success);
+        ASSERT_EQ(rm.insertTuples(partitionedTable, std::vector<const void *>(data.begin(), data.begin() + 500),
+                                  rids), success);
+        ASSERT_EQ(rm.createMaterializedAggregate("rm_agg_total", partitionedTable, "salary", "",
+                                                 {PeterDB::MIN, PeterDB::COUNT}), success);
+        ASSERT_EQ(rm.createMaterializedAggregate("rm_agg_by_age", partitionedTable, "salary", "age",
+                                                 {PeterDB::MAX, PeterDB::SUM}), success);
+        ASSERT_EQ(rm.insertTuples(partitionedTable, std::vector<const void *>(data.begin() + 500, data.end()),
+                                  insertedRids), success);
+        ASSERT_EQ(rm.deleteTuples(partitionedTable, {rids[1], rids[2], insertedRids[499]}), success);
+        salary = 300;
+        ASSERT_EQ(rm.deleteWhere(partitionedTable, "salary", PeterDB::LT_OP, &salary, count), success);
+        expectViewOfTable(partitionedTable, "rm_agg_total", false);
+        expectViewOfTable(partitionedTable, "rm_agg_by_age", true);
+
+        // the views go along with their table, a view deleted on its own is no longer updated
+        ASSERT_EQ(rm.deleteTable("rm_agg_total"), success);
+        ASSERT_EQ(rm.insertTuple(partitionedTable, data[3], rid), success);
+        expectViewOfTable(partitionedTable, "rm_agg_by_age", true);
+        ASSERT_EQ(rm.deleteTable(partitionedTable), success);
+        ASSERT_FALSE(fileExists("rm_agg_by_age")) << "The view should be deleted.";
+        ASSERT_EQ(rm.deleteTable(tableName), success);
+        ASSERT_FALSE(fileExists(viewName));
+        ASSERT_FALSE(fileExists(viewName + "_age_index.idx"));
+        destroyFile = false;
+    }
+
+    TEST_F(RM_Tuple_Test, materialized_aggregate_of_an_empty_table_follows_its_first_tuples) {
+        // Functions tested
+        // 1. A materialized aggregate of an empty table is empty, as is the index on its group attribute
+        // 2. The first tuples inserted into the table give the view its first rows
+
+        size_t tupleSize = 0;
+        outBuffer = malloc(200);
+
+        ASSERT_EQ(rm.getAttributes(tableName, attrs), success) << "RelationManager::getAttributes() should succeed.";
+        nullsIndicator = initializeNullFieldsIndicator(attrs);
+
+        std::string viewName = "rm_salary_by_age";
+        ASSERT_EQ(rm.createMaterializedAggregate(viewName, tableName, "salary", "age", {PeterDB::SUM}), success)
+                                    << "RelationManager::createMaterializedAggregate() should succeed.";
+        int age = 1;
+        PeterDB::RM_IndexScanIterator rmisi;
+        ASSERT_EQ(rm.indexScan(viewName, "age", &age, &age, true, true, rmisi), success);
+        ASSERT_EQ(rmisi.getNextEntry(rid, outBuffer), RM_EOF) << "The view should have no rows yet.";
+        rmisi.close();
+
+        for (unsigned i = 0; i < 10; i++) {
+            prepareTuple((int) attrs.size(), nullsIndicator, 8, "Anteater", (int) (i % 2), 177.8, (float) i,
+                         outBuffer, tupleSize);
+            ASSERT_EQ(rm.insertTuple(tableName, outBuffer, rid), success)
+                                    << "RelationManager::insertTuple() should succeed.";
+        }
+
+        // ages 0 and 1, the salaries of age 1 summing up to 1 + 3 + 5 + 7 + 9
+        PeterDB::RM_ScanIterator rmsi;
+        ASSERT_EQ(rm.scan(viewName, "age", PeterDB::EQ_OP, &age, {"SUM(" + tableName + ".salary)"}, rmsi), success);
+        ASSERT_NE(rmsi.getNextTuple(rid, outBuffer), RM_EOF);
+        ASSERT_EQ(*(float *) ((char *) outBuffer + 1), 25.0f);
+        ASSERT_EQ(rmsi.getNextTuple(rid, outBuffer), RM_EOF);
+        rmsi.close();
+        ASSERT_EQ(rm.indexScan(viewName, "age", nullptr, nullptr, true, true, rmisi), success);
+        unsigned rows = 0;
+        while (rmisi.getNextEntry(rid, outBuffer) != RM_EOF) {
+            rows++;
+        }
+        rmisi.close();
+        ASSERT_EQ(rows, 2u);
+    }
+
+    TEST_F(RM_Tuple_Test, append_only_tables_keep_a_zone_map_without_a_time_attribute) {
+        // Functions tested
+        // 1. An append-only table created without a time attribute keeps its zone map on its first int/real attribute
+        // 2. Scans with a condition on that attribute return the matching tuples
+        // 3. The zone map attribute can't be dropped, a time attribute given at creation is used instead
+
+        size_t tupleSize = 0;
+        outBuffer = malloc(200);
+
+        ASSERT_EQ(rm.getAttributes(tableName, attrs), success) << "RelationManager::getAttributes() should succeed.";
+        nullsIndicator = initializeNullFieldsIndicator(attrs);
+
+        PeterDB::TableOptions options;
+        options.appendOnly = true;
+        std::string eventTable = "rm_event_log";
+        ASSERT_EQ(rm.createTable(eventTable, attrs, options), success) << "RelationManager::createTable() should succeed.";
+
+        unsigned numTuples = 2000;
+        for (unsigned i = 0; i < numTuples; i++) {
+            prepareTuple((int) attrs.size(), nullsIndicator, 8, "Anteater", (int) i, 177.8, (float) i, outBuffer,
+                         tupleSize);
+            ASSERT_EQ(rm.insertTuple(eventTable, outBuffer, rid), success)
+                                        << "RelationManager::insertTuple() should succeed.";
+        }
+
+        PeterDB::RecordBasedFileManager &rbfm = PeterDB::RecordBasedFileManager::instance();
+        PeterDB::FileHandle fileHandle;
+        ASSERT_EQ(rbfm.openFile(eventTable, fileHandle), success);
+        ASSERT_TRUE(rbfm.isAppendOnly(fileHandle));
+        ASSERT_EQ(rbfm.getZoneMapAttribute(fileHandle), "age") << "The zone map should be on the first int attribute.";
+        ASSERT_EQ(rbfm.closeFile(fileHandle), success);
+
+        int age = (int) numTuples - 10;
+        PeterDB::RM_ScanIterator rmsi;
+        ASSERT_EQ(rm.scan(eventTable, "age", PeterDB::GE_OP, &age, {"age"}, rmsi), success);
+        unsigned count = 0;
+        while (rmsi.getNextTuple(rid, outBuffer) != RM_EOF) {
+            ASSERT_GE(*(int *) ((char *) outBuffer + 1), age);
+            count++;
+        }
+        rmsi.close();
+        ASSERT_EQ(count, 10u);
+
+        ASSERT_NE(rm.dropAttribute(eventTable, "age"), success) << "The zone map attribute can't be dropped.";
+        ASSERT_EQ(rm.deleteTable(eventTable), success);
+
+        options.timeAttribute = "salary";
+        ASSERT_EQ(rm.createTable(eventTable, attrs, options), success) << "RelationManager::createTable() should succeed.";
+        ASSERT_EQ(rbfm.openFile(eventTable, fileHandle), success);
+        ASSERT_EQ(rbfm.getZoneMapAttribute(fileHandle), "salary");
+        ASSERT_EQ(rbfm.closeFile(fileHandle), success);
+        ASSERT_EQ(rm.deleteTable(eventTable), success);
+    }
+
+} // namespace PeterDBTesting